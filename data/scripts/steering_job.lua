@@ -0,0 +1,31 @@
+-- job script, attach it as `Lua job script` component
+-- update runs in parallel on worker threads, so it must only use the `Job` API:
+-- reads see the state at the beginning of the frame, writes are applied after all job scripts finish
+-- only the script's own entity can be read, properties read by Job.getProperty must be listed in `inputs`,
+-- e.g. inputs = { "rigid_actor.velocity" }
+
+local speed = 3
+local turn_speed = 2
+local radius = 20
+
+function update(entity, dt)
+    local x, y, z = Job.getPosition(entity)
+    local qx, qy, qz, qw = Job.getRotation(entity)
+
+    -- current heading from rotation around Y
+    local heading = 2 * math.atan2(qy, qw)
+
+    -- seek a point on a circle around the origin, each entity has its own phase
+    local phase = entity * 0.618
+    local tx = math.cos(phase) * radius - x
+    local tz = math.sin(phase) * radius - z
+    local desired = math.atan2(tx, tz)
+
+    local diff = (desired - heading + math.pi) % (2 * math.pi) - math.pi
+    local max_turn = turn_speed * dt
+    if diff > max_turn then diff = max_turn elseif diff < -max_turn then diff = -max_turn end
+    heading = heading + diff
+
+    Job.setPosition(entity, x + math.sin(heading) * speed * dt, y, z + math.cos(heading) * speed * dt)
+    Job.setRotation(entity, 0, math.sin(heading * 0.5), 0, math.cos(heading * 0.5))
+end
@@ -19,6 +19,7 @@ end
 local ROOT_DIR = path.getabsolute("../")
 local BINARY_DIR = LOCATION .. "/bin/"
 build_app = false
+build_benchmark = false
 build_studio = true
 local working_dir = nil
 local debug_args = nil
@@ -59,6 +60,11 @@ function linkPlugin(plugin_name)
 		project "app"
 			links {plugin_name}
 	end
+
+	if build_benchmark then
+		project "benchmark"
+			links {plugin_name}
+	end
 end
 
 newoption {
@@ -151,6 +157,11 @@ newoption {
 	description = "Do not build Studio."
 }
 
+newoption {
+	trigger = "with-benchmark",
+	description = "Build benchmarks of engine primitives."
+}
+
 if _OPTIONS["plugins"] then
 	plugins = string.explode( _OPTIONS["plugins"], ",")
 end
@@ -215,6 +226,10 @@ if _OPTIONS["with-app"] then
 	build_app = true
 end
 
+if _OPTIONS["with-benchmark"] then
+	build_benchmark = true
+end
+
 function detect_plugins()
 	local f = io.popen([[if exist ..\plugins dir /B ..\plugins]])
 	if not f then return end
@@ -546,18 +561,13 @@ if has_plugin("renderer") then
 		files { "../src/renderer/**.h", "../src/renderer/**.cpp", "../src/renderer/**.c", "../external/meshoptimizer/**.*" }
 		files { "../data/pipelines/**.*" }
 		excludes { 
-			"../external/meshoptimizer/clusterizer.cpp",
 			"../external/meshoptimizer/overdrawanalyzer.cpp",
 			"../external/meshoptimizer/overdrawoptimizer.cpp",
-			"../external/meshoptimizer/simplifier.cpp",
 			"../external/meshoptimizer/spatialorder.cpp",
 			"../external/meshoptimizer/stripifier.cpp",
 			"../external/meshoptimizer/vcacheanalyzer.cpp",
-			"../external/meshoptimizer/vcacheoptimizer.cpp",
-			"../external/meshoptimizer/vertexcodec.cpp",
 			"../external/meshoptimizer/vertexfilter.cpp",
-			"../external/meshoptimizer/vfetchanalyzer.cpp",
-			"../external/meshoptimizer/vfetchoptimizer.cpp"
+			"../external/meshoptimizer/vfetchanalyzer.cpp"
 		}
 		
 		includedirs { "../src", "../external/nvtt/include", "../external/freetype/include", "../external/" }
@@ -776,6 +786,58 @@ if build_app then
 		defaultConfigurations()
 end
 
+if build_benchmark then
+	project "benchmark"
+		kind "ConsoleApp"
+		debugdir "../data"
+
+		files { "../src/benchmark/**.h", "../src/benchmark/**.cpp" }
+		includedirs { "../src" }
+		if build_studio then
+			-- benchmarks in src/benchmark/editor
+			links { "editor" }
+			defines { "LUMIX_BENCHMARK_EDITOR" }
+		end
+		if has_plugin("lua_script") then
+			-- benchmarks in src/benchmark/lua_script
+			defines { "LUMIX_BENCHMARK_LUA_SCRIPT" }
+		else
+			removefiles { "../src/benchmark/lua_script/*" }
+		end
+		if has_plugin("renderer") and not _OPTIONS["dynamic-plugins"] then
+			-- benchmarks in src/benchmark/renderer, they call renderer's functions directly
+			defines { "LUMIX_BENCHMARK_RENDERER" }
+			includedirs { "../external" }
+		else
+			removefiles { "../src/benchmark/renderer/*" }
+		end
+		-- engine creates static plugins, so benchmarks creating an engine link the same libraries as the app
+		if not _OPTIONS["dynamic-plugins"] then
+			if has_plugin("renderer") then
+				linkOpenGL()
+			end
+			if has_plugin("physics") then
+				linkPhysX()
+			end
+		end
+		links { "engine" }
+		linkLib "nvtt"
+		linkLib "freetype"
+		linkLib "luajit"
+		linkLib "recast"
+
+		configuration { "vs*" }
+			links { "psapi", "dxguid", "winmm" }
+
+		configuration { "linux" }
+			links { "X11", "dl", "rt" }
+
+		configuration {}
+
+		useLua()
+		defaultConfigurations()
+end
+
 -- write plugins.inl
 for _, plugin in ipairs(base_plugins) do
 	linkPlugin(plugin)
@@ -356,6 +356,9 @@ struct AnimationSceneImpl final : AnimationScene
 	}
 
 
+	bool isDeserializeIndependent() const override { return true; }
+
+
 	void deserialize(InputMemoryStream& serializer, const EntityMap& entity_map, i32 version) override
 	{
 		u32 count;
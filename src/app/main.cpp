@@ -17,12 +17,15 @@
 #include "engine/resource_manager.h"
 #include "engine/thread.h"
 #include "engine/universe.h"
+#include "engine/universe_streamer.h"
 #include "gui/gui_system.h"
 #include "lua_script/lua_script_system.h"
 #include "renderer/pipeline.h"
 #include "renderer/render_scene.h"
 #include "renderer/renderer.h"
 
+#include <stdio.h>
+
 using namespace Lumix;
 
 static const ComponentType ENVIRONMENT_TYPE = reflection::getComponentType("environment");
@@ -161,9 +164,21 @@ struct Runner final
 		m_gui_interface.pipeline = m_pipeline.get();
 		gui->setInterface(&m_gui_interface);
 
-		if (!loadUniverse("universes/main.unv")) {
+		if (m_engine->getFileSystem().fileExists("universes/main/sectors.lsm")) {
+			m_universe->setName("main");
+			m_streamer = UniverseStreamer::create(*m_engine, *m_universe, m_allocator);
+			if (!m_streamer->load("main")) {
+				m_streamer.reset();
+				initDemoScene();
+			}
+		}
+		else if (!loadUniverse("universes/main.unv")) {
 			initDemoScene();
 		}
+		while (m_streamer.get() && m_streamer->isLoading()) {
+			m_engine->getFileSystem().processCallbacks();
+			m_streamer->update();
+		}
 		os::showCursor(false);
 		while (m_engine->getFileSystem().hasWork()) {
 			os::sleep(10);
@@ -177,6 +192,7 @@ struct Runner final
 	}
 
 	void shutdown() {
+		m_streamer.reset();
 		m_engine->destroyUniverse(*m_universe);
 		auto* gui = static_cast<GUISystem*>(m_engine->getPluginManager().getPlugin("gui"));
 		gui->setInterface(nullptr);
@@ -225,6 +241,10 @@ struct Runner final
 	}
 
 	void onIdle() {
+		if (m_streamer.get()) {
+			m_streamer->setFocusPoints(Span(&m_viewport.pos, 1));
+			m_streamer->update();
+		}
 		m_engine->update(*m_universe);
 
 		EntityPtr camera = m_pipeline->getScene()->getActiveCamera();
@@ -247,6 +267,7 @@ struct Runner final
 	Renderer* m_renderer = nullptr;
 	Universe* m_universe = nullptr;
 	UniquePtr<Pipeline> m_pipeline;
+	UniquePtr<UniverseStreamer> m_streamer;
 
 	Viewport m_viewport;
 	bool m_finished = false;
@@ -254,9 +275,101 @@ struct Runner final
 	GUIInterface m_gui_interface;
 };
 
+// -profiler_export capture.lpc trace.json
+// runs before the engine and its log sinks exist, so errors go to stderr
+// returns process exit code, or -1 if there is nothing to export
+static int exportProfilerCapture() {
+	char cmd_line[2048];
+	os::getCommandLine(Span(cmd_line));
+
+	CommandLineParser parser(cmd_line);
+	while (parser.next()) {
+		if (!parser.currentEquals("-profiler_export")) continue;
+
+		char src_path[LUMIX_MAX_PATH];
+		char dst_path[LUMIX_MAX_PATH];
+		if (!parser.next()) {
+			fprintf(stderr, "Usage: -profiler_export capture.lpc trace.json\n");
+			return 1;
+		}
+		parser.getCurrent(src_path, lengthOf(src_path));
+		if (!parser.next()) {
+			fprintf(stderr, "Usage: -profiler_export capture.lpc trace.json\n");
+			return 1;
+		}
+		parser.getCurrent(dst_path, lengthOf(dst_path));
+
+		DefaultAllocator allocator;
+		OutputMemoryStream capture(allocator);
+		os::InputFile src;
+		if (!src.open(src_path)) {
+			fprintf(stderr, "Could not open %s\n", src_path);
+			return 1;
+		}
+		capture.resize(src.size());
+		const bool read = src.read(capture.getMutableData(), capture.size());
+		src.close();
+		if (!read) {
+			fprintf(stderr, "Could not read %s\n", src_path);
+			return 1;
+		}
+
+		OutputMemoryStream json(allocator);
+		bool success = profiler::exportChromeTrace(Span(capture.data(), (u32)capture.size()), json);
+		if (!success) fprintf(stderr, "%s is not a valid profiler capture, exported only a part of it\n", src_path);
+
+		os::OutputFile dst;
+		if (!dst.open(dst_path)) {
+			fprintf(stderr, "Could not create %s\n", dst_path);
+			return 1;
+		}
+		if (!dst.write(json.data(), json.size())) {
+			fprintf(stderr, "Could not write %s\n", dst_path);
+			success = false;
+		}
+		dst.close();
+		return success ? 0 : 1;
+	}
+	return -1;
+}
+
+// -profiler_capture path, -profiler_outlier path frame_ms
+static void startProfilerCapture() {
+	char cmd_line[2048];
+	os::getCommandLine(Span(cmd_line));
+
+	char path[LUMIX_MAX_PATH] = "";
+	char outlier_path[LUMIX_MAX_PATH] = "";
+	profiler::CaptureConfig config;
+	CommandLineParser parser(cmd_line);
+	while (parser.next()) {
+		if (parser.currentEquals("-profiler_capture")) {
+			if (!parser.next()) break;
+			parser.getCurrent(path, lengthOf(path));
+			config.path = path;
+		}
+		else if (parser.currentEquals("-profiler_outlier")) {
+			if (!parser.next()) break;
+			parser.getCurrent(outlier_path, lengthOf(outlier_path));
+			config.outlier_path = outlier_path;
+			if (!parser.next()) break;
+			char tmp[32];
+			parser.getCurrent(tmp, lengthOf(tmp));
+			u32 frame_ms;
+			if (fromCString(Span(tmp, stringLength(tmp)), frame_ms)) config.outlier_frame_ms = (float)frame_ms;
+		}
+	}
+	if (!config.path && !config.outlier_path) return;
+	if (!profiler::startCapture(config)) logError("Failed to start profiler capture");
+}
+
 int main(int args, char* argv[])
 {
+	const int export_result = exportProfilerCapture();
+	if (export_result >= 0) return export_result;
+
 	profiler::setThreadName("Main thread");
+	startProfilerCapture();
 	struct Data {
 		Data() : semaphore(0, 1) {}
 		Runner app;
@@ -280,9 +393,12 @@ int main(int args, char* argv[])
 		data->semaphore.signal();
 	}, nullptr, jobs::INVALID_HANDLE, 0);
 	
-	PROFILE_BLOCK("sleeping");
-	data.semaphore.wait();
+	{
+		PROFILE_BLOCK("sleeping");
+		data.semaphore.wait();
+	}
 
+	profiler::stopCapture();
 	return 0;
 }
 
@@ -332,6 +332,8 @@ struct AudioSceneImpl final : AudioScene
 	}
 
 
+	bool isDeserializeIndependent() const override { return true; }
+
 	void deserialize(InputMemoryStream& serializer, const EntityMap& entity_map, i32 version) override
 	{
 		serializer.read(m_listener.entity);
@@ -2,6 +2,7 @@
 #include "audio_device.h"
 #include "audio_scene.h"
 #include "clip.h"
+#include "engine/allocators.h"
 #include "engine/engine.h"
 #include "engine/plugin.h"
 #include "engine/resource_manager.h"
@@ -35,8 +36,9 @@ struct ClipManager final : ResourceManager
 struct AudioSystemImpl final : AudioSystem
 {
 	explicit AudioSystemImpl(Engine& engine)
-		: m_engine(engine)
-		, m_manager(engine.getAllocator())
+		: m_allocator(engine.getAllocator(), "audio")
+		, m_engine(engine)
+		, m_manager(m_allocator)
 	{
 		AudioScene::reflect(engine);
 	}
@@ -67,11 +69,12 @@ struct AudioSystemImpl final : AudioSystem
 
 	void createScenes(Universe& ctx) override
 	{
-		UniquePtr<AudioScene> scene = AudioScene::createInstance(*this, ctx, m_engine.getAllocator());
+		UniquePtr<AudioScene> scene = AudioScene::createInstance(*this, ctx, m_allocator);
 		ctx.addScene(scene.move());
 	}
 
 
+	TagAllocator m_allocator;
 	ClipManager m_manager;
 	Engine& m_engine;
 	UniquePtr<AudioDevice> m_device;
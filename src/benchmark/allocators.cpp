@@ -0,0 +1,88 @@
+#include "benchmark/benchmark.h"
+#include "engine/allocators.h"
+#include "engine/os.h"
+
+#include <stdio.h>
+
+// LinearAllocator (per-frame render arenas) compared with the default heap on render job sized blocks,
+// TagAllocator (per-subsystem accounting) compared with the allocator it forwards to
+
+namespace Lumix::benchmark {
+
+static constexpr u32 BLOCKS_COUNT = 100'000;
+static constexpr u32 BLOCK_SIZE = 96;
+
+// consumes results so the compiler does not drop the measured loops
+static volatile uintptr g_sink;
+
+static void heap(IAllocator& allocator) {
+	void** blocks = (void**)allocator.allocate(sizeof(void*) * BLOCKS_COUNT);
+	u64 start = os::Timer::getRawTimestamp();
+	for (u32 i = 0; i < BLOCKS_COUNT; ++i) blocks[i] = allocator.allocate_aligned(BLOCK_SIZE, 16);
+	print("allocators heap", "allocate", os::Timer::getRawTimestamp() - start, BLOCKS_COUNT);
+
+	start = os::Timer::getRawTimestamp();
+	for (u32 i = 0; i < BLOCKS_COUNT; ++i) allocator.deallocate_aligned(blocks[i]);
+	print("allocators heap", "deallocate", os::Timer::getRawTimestamp() - start, BLOCKS_COUNT);
+	allocator.deallocate(blocks);
+}
+
+static void linear() {
+	LinearAllocator arena(64 * 1024 * 1024);
+	uintptr sum = 0;
+	// the first frame commits memory, the later ones reuse it
+	for (u32 frame = 0; frame < 2; ++frame) {
+		const u64 start = os::Timer::getRawTimestamp();
+		for (u32 i = 0; i < BLOCKS_COUNT; ++i) sum += (uintptr)arena.allocate_aligned(BLOCK_SIZE, 16);
+		print("allocators linear", frame == 0 ? "allocate cold" : "allocate warm", os::Timer::getRawTimestamp() - start, BLOCKS_COUNT);
+		arena.reset();
+	}
+
+	// a spike followed by a quiet period, memory above the quiet period's peak is decommitted
+	for (u32 i = 0; i < 4 * BLOCKS_COUNT; ++i) sum += (uintptr)arena.allocate_aligned(BLOCK_SIZE, 16);
+	arena.reset();
+	const u32 spike_commit = arena.getCommitted();
+	u64 reset_ticks = 0;
+	for (u32 frame = 0; frame < LinearAllocator::TRIM_PERIOD * 2; ++frame) {
+		sum += (uintptr)arena.allocate_aligned(BLOCK_SIZE, 16);
+		const u64 start = os::Timer::getRawTimestamp();
+		arena.reset();
+		reset_ticks += os::Timer::getRawTimestamp() - start;
+	}
+	print("allocators linear", "reset", reset_ticks, LinearAllocator::TRIM_PERIOD * 2);
+	printf("%-40s %-16s %7u KB -> %u KB\n", "allocators linear", "trim", spike_commit / 1024, arena.getCommitted() / 1024);
+	g_sink = sum;
+}
+
+static u64 allocFreePairs(IAllocator& allocator) {
+	const u64 start = os::Timer::getRawTimestamp();
+	for (u32 i = 0; i < BLOCKS_COUNT; ++i) allocator.deallocate(allocator.allocate(BLOCK_SIZE));
+	return os::Timer::getRawTimestamp() - start;
+}
+
+// with LUMIX_TRACK_ALLOCATIONS, the tag keeps statistics, otherwise it only forwards
+static void tagged(IAllocator& allocator) {
+	const char* group = "allocators tag";
+	print(group, "direct", allocFreePairs(allocator), BLOCKS_COUNT);
+
+	TagAllocator tag(allocator, "benchmark");
+	print(group, "tagged", allocFreePairs(tag), BLOCKS_COUNT);
+	#ifdef LUMIX_TRACK_ALLOCATIONS
+		tag.setStackSampling(64);
+		print(group, "tagged, sampling", allocFreePairs(tag), BLOCKS_COUNT);
+		tag.setStackSampling(0);
+
+		const TagAllocator::Stats stats = tag.getStats();
+		if (stats.live_bytes != 0 || stats.live_count != 0 || stats.alloc_count != 2 * BLOCKS_COUNT || stats.free_count != 2 * BLOCKS_COUNT) {
+			printf("%-40s wrong stats, %u live, %u allocs, %u frees\n", group, (u32)stats.live_count, (u32)stats.alloc_count, (u32)stats.free_count);
+		}
+	#endif
+}
+
+void allocators(IAllocator& allocator) {
+	heap(allocator);
+	linear();
+	tagged(allocator);
+}
+
+} // namespace Lumix::benchmark
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "engine/lumix.h"
+
+namespace Lumix {
+
+struct FileSystem;
+struct IAllocator;
+struct Path;
+
+namespace benchmark {
+
+// prints average duration of one operation, `ticks` (os::Timer::getRawTimestamp) were spent on `count` operations
+void print(const char* group, const char* name, u64 ticks, u32 count);
+// writes `content` where resource managers load `path` from, as if the asset compiler copied the file
+bool writeCompiledResource(FileSystem& fs, const Path& path, const char* content);
+void deleteCompiledResource(FileSystem& fs, const Path& path);
+
+void allocators(IAllocator& allocator);
+void hashMap(IAllocator& allocator);
+void log(IAllocator& allocator);
+void luaGC(IAllocator& allocator);
+void luaValueTypes(IAllocator& allocator);
+void pack(IAllocator& allocator);
+void path(IAllocator& allocator);
+void profilerWrite(IAllocator& allocator);
+void universe(IAllocator& allocator);
+void universeStreamer(IAllocator& allocator);
+// editor/, only if the studio is built
+void save(IAllocator& allocator);
+void undo(IAllocator& allocator);
+// lua_script/, only if the lua_script plugin is built
+void jobScript(IAllocator& allocator);
+void luaScript(IAllocator& allocator);
+// renderer/, only if the renderer plugin is linked statically
+void gpuProfiler(IAllocator& allocator);
+void meshCodec(IAllocator& allocator);
+void terrain(IAllocator& allocator);
+
+} // namespace benchmark
+
+} // namespace Lumix
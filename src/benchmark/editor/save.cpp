@@ -0,0 +1,134 @@
+#include "benchmark/benchmark.h"
+#include "editor/world_editor.h"
+#include "engine/allocators.h"
+#include "engine/array.h"
+#include "engine/engine.h"
+#include "engine/file_system.h"
+#include "engine/geometry.h"
+#include "engine/os.h"
+#include "engine/string.h"
+#include "engine/universe.h"
+
+#include <stdio.h>
+
+// saves a universe repeatedly, unchanged parts are reused from the previous save, the file is written in a job;
+// then checks a save which can not be written keeps the universe changed
+
+namespace Lumix::benchmark {
+
+static constexpr u32 ENTITIES_COUNT = 16 * 1024;
+static constexpr u32 SAVES_COUNT = 16;
+
+// the editor saves the camera, nothing else is used
+struct NullView : UniverseView {
+	NullView(WorldEditor& editor) : editor(editor) {}
+
+	const Viewport& getViewport() const override { return viewport; }
+	void setViewport(const Viewport& vp) override { viewport = vp; }
+	void lookAtSelected() override {}
+	void setTopView() override {}
+	void setFrontView() override {}
+	void setSideView() override {}
+	void moveCamera(float forward, float right, float up, float speed) override {}
+	void copyTransform() override {}
+	void refreshIcons() override {}
+	bool isMouseDown(os::MouseButton button) const override { return false; }
+	bool isMouseClick(os::MouseButton button) const override { return false; }
+	Vec2 getMousePos() const override { return Vec2(0, 0); }
+	void setMouseSensitivity(float x, float y) override {}
+	Vec2 getMouseSensitivity() override { return Vec2(1, 1); }
+	void setCustomPivot() override {}
+	void resetPivot() override {}
+	void setSnapMode(bool enable, bool vertex_snap) override {}
+	RayHit getCameraRaycastHit(int cam_x, int cam_y) override { return { false, -1, INVALID_ENTITY, {} }; }
+	Vertex* render(bool lines, u32 vertex_count) override { return nullptr; }
+	void addText2D(float x, float y, Color color, const char* text) override {}
+	WorldEditor& getEditor() override { return editor; }
+
+	WorldEditor& editor;
+	Viewport viewport = {};
+};
+
+// the save job's result is published in WorldEditor::update
+static bool waitForSave(WorldEditor& editor, float timeout) {
+	os::Timer timer;
+	for (;;) {
+		editor.update();
+		if (!editor.isUniverseChanged()) return true;
+		if (timer.getTimeSinceStart() > timeout) return false;
+		os::sleep(1);
+	}
+}
+
+void save(IAllocator& allocator) {
+	Engine::InitArgs init_args;
+	init_args.window_title = "Lumix benchmark";
+	UniquePtr<Engine> engine = Engine::create(static_cast<Engine::InitArgs&&>(init_args), allocator);
+	UniquePtr<WorldEditor> editor = WorldEditor::create(*engine, allocator);
+	NullView view(*editor);
+	editor->setView(&view);
+	Universe& universe = *editor->getUniverse();
+
+	Array<EntityRef> entities(allocator);
+	entities.reserve(ENTITIES_COUNT);
+	for (u32 i = 0; i < ENTITIES_COUNT; ++i) {
+		const EntityRef e = universe.createEntity(DVec3((double)i, 0, 0), Quat::IDENTITY);
+		universe.setEntityName(e, StaticString<32>("e", i));
+		entities.push(e);
+	}
+	// changes are counted by commands
+	editor->destroyEntities(&entities.back(), 1);
+	entities.pop();
+
+	u32 errors = 0;
+	const char* group = "save 16k entities";
+	// only the part on the main thread is measured, since editing continues while the file is written
+	u64 start = os::Timer::getRawTimestamp();
+	editor->saveUniverse("_benchmark_save", false);
+	print(group, "full", os::Timer::getRawTimestamp() - start, 1);
+	if (!waitForSave(*editor, 10)) ++errors;
+
+	// the previous save's job is finished before each measured save, it would be waited for otherwise
+	u64 ticks = 0;
+	for (u32 i = 0; i < SAVES_COUNT; ++i) {
+		editor->destroyEntities(&entities.back(), 1);
+		entities.pop();
+		start = os::Timer::getRawTimestamp();
+		editor->saveUniverse("_benchmark_save", false);
+		ticks += os::Timer::getRawTimestamp() - start;
+		if (!waitForSave(*editor, 10)) ++errors;
+	}
+	print(group, "changed entities", ticks, SAVES_COUNT);
+
+	// all parts are reused, the job is waited for by the next changed save
+	ticks = 0;
+	for (u32 i = 0; i < SAVES_COUNT; ++i) {
+		editor->destroyEntities(&entities.back(), 1);
+		entities.pop();
+		editor->saveUniverse("_benchmark_save", false);
+		if (!waitForSave(*editor, 10)) ++errors;
+		start = os::Timer::getRawTimestamp();
+		editor->saveUniverse("_benchmark_save", false);
+		ticks += os::Timer::getRawTimestamp() - start;
+	}
+	print(group, "unchanged", ticks, SAVES_COUNT);
+
+	// universes/_benchmark_missing/ does not exist, so the file can not be opened
+	editor->destroyEntities(&entities.back(), 1);
+	entities.pop();
+	editor->saveUniverse("_benchmark_missing/save", false);
+	if (waitForSave(*editor, 0.5f)) ++errors;
+	editor->saveUniverse("_benchmark_save", false);
+	if (!waitForSave(*editor, 10)) ++errors;
+
+	if (errors > 0) printf("%-40s %u failed saves\n", group, errors);
+	editor.reset();
+
+	const char* base_path = engine->getFileSystem().getBasePath();
+	const StaticString<LUMIX_MAX_PATH> path(base_path, "universes/_benchmark_save.unv");
+	const StaticString<LUMIX_MAX_PATH> bkp_path(path, ".bak");
+	os::deleteFile(path);
+	os::deleteFile(bkp_path);
+}
+
+} // namespace Lumix::benchmark
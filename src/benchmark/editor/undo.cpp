@@ -0,0 +1,110 @@
+#include "benchmark/benchmark.h"
+#include "editor/world_editor.h"
+#include "engine/allocators.h"
+#include "engine/array.h"
+#include "engine/engine.h"
+#include "engine/file_system.h"
+#include "engine/os.h"
+#include "engine/string.h"
+#include "engine/universe.h"
+
+#include <stdio.h>
+
+// destroys entities in many commands with zero undo memory budget, so cold payloads are spilled to the journal,
+// then undoes and redoes everything and checks the restored entities
+
+namespace Lumix::benchmark {
+
+static constexpr u32 COMMANDS_COUNT = 64;
+static constexpr u32 COMMAND_ENTITIES_COUNT = 256;
+static constexpr u32 ENTITIES_COUNT = COMMANDS_COUNT * COMMAND_ENTITIES_COUNT;
+
+// returns the number of entities in [from, to) which are not as they were created
+static u32 checkRestored(Universe& universe, const Array<EntityRef>& entities, u32 from, u32 to) {
+	u32 errors = 0;
+	for (u32 i = from; i < to; ++i) {
+		const EntityRef e = entities[i];
+		if (!universe.hasEntity(e)) {
+			++errors;
+			continue;
+		}
+		const StaticString<32> name("e", i);
+		if (!equalStrings(universe.getEntityName(e), name) || universe.getPosition(e).x != (double)i) ++errors;
+	}
+	return errors;
+}
+
+// returns the number of entities in [from, to) which still exist
+static u32 checkDestroyed(Universe& universe, const Array<EntityRef>& entities, u32 from, u32 to) {
+	u32 errors = 0;
+	for (u32 i = from; i < to; ++i) {
+		if (universe.hasEntity(entities[i])) ++errors;
+	}
+	return errors;
+}
+
+void undo(IAllocator& allocator) {
+	Engine::InitArgs init_args;
+	init_args.window_title = "Lumix benchmark";
+	UniquePtr<Engine> engine = Engine::create(static_cast<Engine::InitArgs&&>(init_args), allocator);
+	// the journal is in .lumix
+	const StaticString<LUMIX_MAX_PATH> lumix_dir(engine->getFileSystem().getBasePath(), ".lumix");
+	if (!os::dirExists(lumix_dir) && !os::makePath(lumix_dir)) {
+		printf("%-40s could not create %s\n", "undo", lumix_dir.data);
+		return;
+	}
+
+	UniquePtr<WorldEditor> editor = WorldEditor::create(*engine, allocator);
+	editor->setUndoMemoryBudget(0);
+	Universe& universe = *editor->getUniverse();
+
+	Array<EntityRef> entities(allocator);
+	entities.reserve(ENTITIES_COUNT);
+	for (u32 i = 0; i < ENTITIES_COUNT; ++i) {
+		const EntityRef e = universe.createEntity(DVec3((double)i, 0, 0), Quat::IDENTITY);
+		universe.setEntityName(e, StaticString<32>("e", i));
+		entities.push(e);
+	}
+
+	u32 errors = 0;
+	const char* group = "undo 64 x 256 entities, no memory budget";
+	u64 start = os::Timer::getRawTimestamp();
+	for (u32 i = 0; i < COMMANDS_COUNT; ++i) {
+		editor->destroyEntities(&entities[i * COMMAND_ENTITIES_COUNT], COMMAND_ENTITIES_COUNT);
+	}
+	print(group, "destroy", os::Timer::getRawTimestamp() - start, COMMANDS_COUNT);
+	errors += checkDestroyed(universe, entities, 0, ENTITIES_COUNT);
+	const WorldEditor::UndoStats stats = editor->getUndoStats();
+	if (stats.journal_size == 0) ++errors;
+
+	// every pass reads payloads back from the journal and spills them again
+	for (u32 pass = 0; pass < 2; ++pass) {
+		start = os::Timer::getRawTimestamp();
+		while (editor->canUndo()) editor->undo();
+		print(group, "undo", os::Timer::getRawTimestamp() - start, COMMANDS_COUNT);
+		errors += checkRestored(universe, entities, 0, ENTITIES_COUNT);
+
+		start = os::Timer::getRawTimestamp();
+		while (editor->canRedo()) editor->redo();
+		print(group, "redo", os::Timer::getRawTimestamp() - start, COMMANDS_COUNT);
+		errors += checkDestroyed(universe, entities, 0, ENTITIES_COUNT);
+	}
+
+	// a command of the same type as the one at the undo index gets the index's payload restored to try to merge,
+	// commands after the index are dropped together with their journal payloads
+	const u32 half = ENTITIES_COUNT / 2;
+	for (u32 i = 0; i < COMMANDS_COUNT / 2; ++i) editor->undo();
+	errors += checkDestroyed(universe, entities, 0, half);
+	errors += checkRestored(universe, entities, half, ENTITIES_COUNT);
+	editor->destroyEntities(&entities[half], COMMAND_ENTITIES_COUNT);
+	while (editor->canUndo()) editor->undo();
+	errors += checkRestored(universe, entities, 0, ENTITIES_COUNT);
+	while (editor->canRedo()) editor->redo();
+	errors += checkDestroyed(universe, entities, 0, half + COMMAND_ENTITIES_COUNT);
+	errors += checkRestored(universe, entities, half + COMMAND_ENTITIES_COUNT, ENTITIES_COUNT);
+
+	if (errors > 0) printf("%-40s %u wrong entities\n", group, errors);
+	editor.reset();
+}
+
+} // namespace Lumix::benchmark
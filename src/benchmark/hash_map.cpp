@@ -0,0 +1,83 @@
+#include "benchmark/benchmark.h"
+#include "engine/array.h"
+#include "engine/group_hash_map.h"
+#include "engine/os.h"
+#include "engine/string.h"
+
+// compares linear probing HashMap with GroupProbing (engine/group_hash_map.h) on u32 keys
+
+namespace Lumix::benchmark {
+
+// consumes results so the compiler does not drop the measured loops
+static volatile u32 g_sink;
+
+template <typename Map>
+static void run(const char* group, const char* map_name, IAllocator& allocator, const Array<u32>& keys, const Array<u32>& missing) {
+	const u32 count = keys.size();
+	StaticString<64> name(group, " ", map_name);
+	Map map(allocator);
+
+	u64 start = os::Timer::getRawTimestamp();
+	for (u32 i = 0; i < count; ++i) map.insert(keys[i], i);
+	print(name, "insert", os::Timer::getRawTimestamp() - start, count);
+
+	u32 sum = 0;
+	start = os::Timer::getRawTimestamp();
+	for (u32 i = 0; i < count; ++i) {
+		auto iter = map.find(keys[i]);
+		if (iter.isValid()) sum += iter.value();
+	}
+	print(name, "find hit", os::Timer::getRawTimestamp() - start, count);
+
+	start = os::Timer::getRawTimestamp();
+	for (u32 i = 0; i < count; ++i) {
+		if (map.find(missing[i]).isValid()) ++sum;
+	}
+	print(name, "find miss", os::Timer::getRawTimestamp() - start, count);
+
+	start = os::Timer::getRawTimestamp();
+	for (auto iter = map.begin(); iter.isValid(); ++iter) sum += iter.value();
+	print(name, "iterate", os::Timer::getRawTimestamp() - start, count);
+
+	start = os::Timer::getRawTimestamp();
+	for (u32 i = 0; i < count; ++i) map.erase(keys[i]);
+	print(name, "erase", os::Timer::getRawTimestamp() - start, count);
+
+	g_sink = sum + map.size();
+}
+
+static void run(const char* group, IAllocator& allocator, const Array<u32>& keys, const Array<u32>& missing) {
+	run<HashMap<u32, u32>>(group, "linear", allocator, keys, missing);
+	run<HashMap<u32, u32, HashFunc<u32>, GroupProbing>>(group, "group", allocator, keys, missing);
+}
+
+// unique scattered keys, multiplying by an odd number is a bijection, so odd keys are inserted and even keys miss
+static void randomKeys(u32 count, Array<u32>& keys, Array<u32>& missing) {
+	keys.clear();
+	missing.clear();
+	for (u32 i = 0; i < count; ++i) {
+		keys.push((i * 2 + 1) * 0x9E3779B1);
+		missing.push(i * 2 * 0x9E3779B1);
+	}
+}
+
+void hashMap(IAllocator& allocator) {
+	Array<u32> keys(allocator);
+	Array<u32> missing(allocator);
+
+	randomKeys(100'000, keys, missing);
+	run("hash_map 100k random", allocator, keys, missing);
+
+	randomKeys(1'000'000, keys, missing);
+	run("hash_map 1M random", allocator, keys, missing);
+
+	keys.clear();
+	missing.clear();
+	for (u32 i = 0; i < 100'000; ++i) {
+		keys.push(i);
+		missing.push(i + 100'000);
+	}
+	run("hash_map 100k sequential", allocator, keys, missing);
+}
+
+} // namespace Lumix::benchmark
@@ -0,0 +1,81 @@
+#include "benchmark/benchmark.h"
+#include "engine/allocators.h"
+#include "engine/atomic.h"
+#include "engine/log.h"
+#include "engine/os.h"
+#include "engine/string.h"
+#include "engine/thread.h"
+
+#include <stdio.h>
+
+// caller side cost of logging from several threads to a callback and a log file,
+// synchronously and through the log thread; messages are unique, so none are collapsed as repeats
+
+namespace Lumix::benchmark {
+
+static constexpr u32 MESSAGES_COUNT = 20'000;
+static const char* LOG_PATH = "_benchmark.log";
+
+static volatile i32 g_received;
+
+static void onLog(LogLevel, const char*) { atomicIncrement(&g_received); }
+
+struct Producer : Thread {
+	Producer(u32 index, IAllocator& allocator) : Thread(allocator), index(index) {}
+
+	int task() override {
+		const u64 start = os::Timer::getRawTimestamp();
+		for (u32 i = 0; i < MESSAGES_COUNT; ++i) logInfo("benchmark thread ", index, " message ", i);
+		ticks = os::Timer::getRawTimestamp() - start;
+		return 0;
+	}
+
+	u32 index;
+	u64 ticks = 0;
+};
+
+static void run(IAllocator& allocator, const char* name, u32 threads_count, bool async, bool binary) {
+	const StaticString<64> group("log ", threads_count, threads_count == 1 ? " thread" : " threads");
+	if (!openLogFile(LOG_PATH, binary)) {
+		printf("%-40s could not open %s\n", group.data, LOG_PATH);
+		return;
+	}
+	g_received = 0;
+	if (async) startLogThread();
+
+	Producer* producers[16];
+	ASSERT(threads_count <= lengthOf(producers));
+	for (u32 i = 0; i < threads_count; ++i) {
+		producers[i] = LUMIX_NEW(allocator, Producer)(i, allocator);
+		producers[i]->create("benchmark producer", false);
+	}
+	u64 ticks = 0;
+	for (u32 i = 0; i < threads_count; ++i) {
+		while (!producers[i]->isFinished()) os::sleep(1);
+		producers[i]->destroy();
+		ticks += producers[i]->ticks;
+		LUMIX_DELETE(allocator, producers[i]);
+	}
+	print(group, name, ticks, threads_count * MESSAGES_COUNT);
+
+	flushLog();
+	if (async) stopLogThread();
+	closeLogFile();
+	if (g_received != i32(threads_count * MESSAGES_COUNT)) {
+		printf("%-40s %-16s %u of %u messages received\n", group.data, name, (u32)g_received, threads_count * MESSAGES_COUNT);
+	}
+}
+
+void log(IAllocator& allocator) {
+	registerLogCallback<&onLog>();
+	const u32 threads_counts[] = { 1, 4, 16 };
+	for (u32 threads_count : threads_counts) {
+		run(allocator, "sync", threads_count, false, false);
+		run(allocator, "async", threads_count, true, false);
+		run(allocator, "async binary", threads_count, true, true);
+	}
+	unregisterLogCallback<&onLog>();
+	os::deleteFile(LOG_PATH);
+}
+
+} // namespace Lumix::benchmark
@@ -0,0 +1,84 @@
+#include "benchmark/benchmark.h"
+#include "engine/allocators.h"
+#include "engine/engine.h"
+#include "engine/file_system.h"
+#include "engine/math.h"
+#include "engine/os.h"
+#include "engine/string.h"
+#include "engine/universe.h"
+
+#include <lua.hpp>
+#include <stdio.h>
+
+// a script generates garbage every frame and keeps some of it alive, frames are timed with the collector
+// stepped within a per-frame budget and with Lua's own collector, which can run in the middle of the script
+
+namespace Lumix::benchmark {
+
+static constexpr u32 FRAMES_COUNT = 600;
+// live data is a ring of 5000 small tables, a heap above this is a leak or a collector which can not keep up
+static constexpr int MAX_HEAP_KB = 64 * 1024;
+
+static const char* SCRIPT = R"#(
+	local live = {}
+	local n = 0
+	function benchmarkGarbageFrame()
+		for i = 1, 2000 do
+			local t = { x = i, y = i * 2, name = "n" .. i }
+			if i % 50 == 0 then
+				live[n % 5000 + 1] = t
+				n = n + 1
+			end
+		end
+	end
+)#";
+
+static void runFrames(Engine& engine, Universe& universe, const char* name) {
+	const char* group = "lua gc 2000 tables per frame";
+	lua_State* L = engine.getState();
+	u64 ticks = 0;
+	u64 max_ticks = 0;
+	u32 errors = 0;
+	for (u32 i = 0; i < FRAMES_COUNT; ++i) {
+		const u64 start = os::Timer::getRawTimestamp();
+		lua_getglobal(L, "benchmarkGarbageFrame");
+		if (lua_pcall(L, 0, 0, 0) != 0) {
+			++errors;
+			lua_pop(L, 1);
+		}
+		engine.update(universe);
+		const u64 frame_ticks = os::Timer::getRawTimestamp() - start;
+		ticks += frame_ticks;
+		max_ticks = maximum(max_ticks, frame_ticks);
+	}
+	print(group, name, ticks, FRAMES_COUNT);
+	const float max_ms = float(double(max_ticks) * 1000 / double(os::Timer::getFrequency()));
+	printf("%-40s %-16s %10.2f ms worst frame\n", group, name, max_ms);
+	const int heap_kb = lua_gc(L, LUA_GCCOUNT, 0);
+	if (errors > 0 || heap_kb > MAX_HEAP_KB) printf("%-40s %-16s %u script errors, %d KB heap\n", group, name, errors, heap_kb);
+}
+
+void luaGC(IAllocator& allocator) {
+	Engine::InitArgs init_args;
+	init_args.window_title = "Lumix benchmark";
+	UniquePtr<Engine> engine = Engine::create(static_cast<Engine::InitArgs&&>(init_args), allocator);
+	Universe& universe = engine->createUniverse(true);
+
+	lua_State* L = engine->getState();
+	if (luaL_loadbuffer(L, SCRIPT, stringLength(SCRIPT), "benchmark") != 0 || lua_pcall(L, 0, 0, 0) != 0) {
+		printf("%-40s %s\n", "lua gc", lua_tostring(L, -1));
+		lua_pop(L, 1);
+		engine->destroyUniverse(universe);
+		return;
+	}
+
+	engine->setLuaGCBudget(1);
+	runFrames(*engine, universe, "budget 1 ms");
+	engine->setLuaGCBudget(0);
+	runFrames(*engine, universe, "lua collector");
+	engine->setLuaGCBudget(1);
+
+	engine->destroyUniverse(universe);
+}
+
+} // namespace Lumix::benchmark
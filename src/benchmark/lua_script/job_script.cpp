@@ -0,0 +1,89 @@
+#include "benchmark/benchmark.h"
+#include "engine/allocators.h"
+#include "engine/array.h"
+#include "engine/engine.h"
+#include "engine/file_system.h"
+#include "engine/os.h"
+#include "engine/reflection.h"
+#include "engine/resource_manager.h"
+#include "engine/string.h"
+#include "engine/universe.h"
+#include "lua_script/lua_script_system.h"
+
+#include <lua.hpp>
+#include <stdio.h>
+
+// many job script components share one script, its `inputs` must be parsed once per load, not once per component;
+// the script counts how many times its top level runs in the engine's lua state
+
+namespace Lumix::benchmark {
+
+static constexpr u32 ENTITIES_COUNT = 4096;
+static const char* SCRIPT_PATH = "_benchmark_job_script.lua";
+static const char* SCRIPT_SOURCE =
+	"inputs = {}\n"
+	"_G.benchmark_job_script_parses = (_G.benchmark_job_script_parses or 0) + 1\n";
+
+static void waitForLoads(Engine& engine) {
+	FileSystem& fs = engine.getFileSystem();
+	while (fs.hasWork()) fs.processCallbacks();
+}
+
+static i32 getParsesCount(Engine& engine) {
+	lua_State* L = engine.getState();
+	lua_getglobal(L, "benchmark_job_script_parses");
+	const i32 res = lua_isnumber(L, -1) ? (i32)lua_tointeger(L, -1) : 0;
+	lua_pop(L, 1);
+	return res;
+}
+
+void jobScript(IAllocator& allocator) {
+	Engine::InitArgs init_args;
+	init_args.window_title = "Lumix benchmark";
+	UniquePtr<Engine> engine = Engine::create(static_cast<Engine::InitArgs&&>(init_args), allocator);
+
+	const Path path(SCRIPT_PATH);
+	if (!writeCompiledResource(engine->getFileSystem(), path, SCRIPT_SOURCE)) {
+		printf("%-40s could not write %s\n", "job script", SCRIPT_PATH);
+		return;
+	}
+
+	Universe& universe = engine->createUniverse(true);
+	const ComponentType type = reflection::getComponentType("lua_job_script");
+	LuaScriptScene* scene = static_cast<LuaScriptScene*>(universe.getScene(type));
+	Array<EntityRef> entities(allocator);
+	entities.reserve(ENTITIES_COUNT);
+	for (u32 i = 0; i < ENTITIES_COUNT; ++i) {
+		const EntityRef e = universe.createEntity(DVec3((double)i, 0, 0), Quat::IDENTITY);
+		universe.createComponent(type, e);
+		entities.push(e);
+	}
+
+	u32 errors = 0;
+	const char* group = "job script 4096 components, one script";
+	u64 start = os::Timer::getRawTimestamp();
+	for (EntityRef e : entities) scene->setJobScriptPath(e, path);
+	waitForLoads(*engine);
+	print(group, "set path", os::Timer::getRawTimestamp() - start, ENTITIES_COUNT);
+	if (getParsesCount(*engine) != 1) ++errors;
+	for (EntityRef e : entities) {
+		if (scene->getJobScriptPath(e) != path) ++errors;
+	}
+
+	start = os::Timer::getRawTimestamp();
+	engine->getResourceManager().reload(path);
+	waitForLoads(*engine);
+	print(group, "hot reload", os::Timer::getRawTimestamp() - start, 1);
+	if (getParsesCount(*engine) != 2) ++errors;
+
+	// the last user unbinds the observer
+	start = os::Timer::getRawTimestamp();
+	for (EntityRef e : entities) universe.destroyComponent(e, type);
+	print(group, "destroy", os::Timer::getRawTimestamp() - start, ENTITIES_COUNT);
+
+	if (errors > 0) printf("%-40s %u wrong parses or paths\n", group, errors);
+	engine->destroyUniverse(universe);
+	deleteCompiledResource(engine->getFileSystem(), path);
+}
+
+} // namespace Lumix::benchmark
@@ -0,0 +1,143 @@
+#include "benchmark/benchmark.h"
+#include "engine/allocators.h"
+#include "engine/array.h"
+#include "engine/engine.h"
+#include "engine/file_system.h"
+#include "engine/lua_wrapper.h"
+#include "engine/os.h"
+#include "engine/reflection.h"
+#include "engine/string.h"
+#include "engine/universe.h"
+#include "lua_script/lua_script_system.h"
+
+#include <lua.hpp>
+#include <stdio.h>
+
+// every scripted entity has `update` and a repeating timer; the scene calls `update` through function refs resolved
+// when the script starts, the same calls with the environment lookup done every frame are timed for comparison;
+// timers are in a timer wheel, so the cost per script should not grow with the number of scripts
+
+namespace Lumix::benchmark {
+
+static constexpr u32 FRAMES_COUNT = 120;
+static constexpr float TIME_DELTA = 1 / 60.f;
+static const char* SCRIPT_PATH = "_benchmark_update.lua";
+static const char* SCRIPT_SOURCE = R"#(
+	local scene = benchmark_lua_script_scene
+	-- timers of different entities expire in different frames
+	local delay = 0.1 + (this._entity % 32) / 64
+	local function onTimer()
+		_G.benchmark_lua_script_timers = _G.benchmark_lua_script_timers + 1
+		LuaScript.setTimer(scene, delay, onTimer)
+	end
+	function start()
+		LuaScript.setTimer(scene, delay, onTimer)
+	end
+	function update(time_delta)
+		_G.benchmark_lua_script_updates = _G.benchmark_lua_script_updates + 1
+	end
+)#";
+
+static void waitForLoads(Engine& engine) {
+	FileSystem& fs = engine.getFileSystem();
+	while (fs.hasWork()) fs.processCallbacks();
+}
+
+static i32 getCounter(lua_State* L, const char* name) {
+	lua_getglobal(L, name);
+	const i32 res = (i32)lua_tointeger(L, -1);
+	lua_pop(L, 1);
+	return res;
+}
+
+static void resetCounters(lua_State* L) {
+	lua_pushinteger(L, 0);
+	lua_setglobal(L, "benchmark_lua_script_updates");
+	lua_pushinteger(L, 0);
+	lua_setglobal(L, "benchmark_lua_script_timers");
+}
+
+static void run(Engine& engine, const Path& path, u32 scripts_count, IAllocator& allocator) {
+	const StaticString<64> group("lua script ", scripts_count, " scripts");
+	lua_State* L = engine.getState();
+	Universe& universe = engine.createUniverse(true);
+	const ComponentType type = reflection::getComponentType("lua_script");
+	LuaScriptScene* scene = static_cast<LuaScriptScene*>(universe.getScene(type));
+	lua_pushlightuserdata(L, scene);
+	lua_setglobal(L, "benchmark_lua_script_scene");
+	resetCounters(L);
+
+	Array<EntityRef> entities(allocator);
+	entities.reserve(scripts_count);
+	for (u32 i = 0; i < scripts_count; ++i) {
+		const EntityRef e = universe.createEntity(DVec3((double)i, 0, 0), Quat::IDENTITY);
+		universe.createComponent(type, e);
+		scene->addScript(e, 0);
+		scene->setScriptPath(e, 0, path);
+		entities.push(e);
+	}
+	waitForLoads(engine);
+	engine.startGame(universe);
+	// the first update starts the scripts, which sets the timers
+	scene->update(TIME_DELTA, false);
+	u32 errors = 0;
+
+	// what the scene did before function refs were cached
+	resetCounters(L);
+	lua_gc(L, LUA_GCCOLLECT, 0);
+	u64 start = os::Timer::getRawTimestamp();
+	for (u32 frame = 0; frame < FRAMES_COUNT; ++frame) {
+		for (EntityRef e : entities) {
+			lua_State* state = scene->getState(e, 0);
+			lua_rawgeti(state, LUA_REGISTRYINDEX, scene->getEnvironment(e, 0));
+			lua_getfield(state, -1, "update");
+			if (lua_type(state, -1) == LUA_TFUNCTION) {
+				lua_pushnumber(state, TIME_DELTA);
+				if (!LuaWrapper::pcall(state, 1, 0)) ++errors;
+			}
+			else {
+				lua_pop(state, 1);
+			}
+			lua_pop(state, 1);
+		}
+	}
+	print(group, "update lookup", os::Timer::getRawTimestamp() - start, scripts_count * FRAMES_COUNT);
+	if (getCounter(L, "benchmark_lua_script_updates") != i32(scripts_count * FRAMES_COUNT)) ++errors;
+
+	// cached update refs and timers, the engine stops Lua's collector, so the heap grows by what the frames allocate
+	resetCounters(L);
+	lua_gc(L, LUA_GCCOLLECT, 0);
+	const int heap_kb = lua_gc(L, LUA_GCCOUNT, 0);
+	start = os::Timer::getRawTimestamp();
+	for (u32 frame = 0; frame < FRAMES_COUNT; ++frame) scene->update(TIME_DELTA, false);
+	print(group, "scene update", os::Timer::getRawTimestamp() - start, scripts_count * FRAMES_COUNT);
+	printf("%-40s %-16s %10d KB\n", group.data, "heap growth", lua_gc(L, LUA_GCCOUNT, 0) - heap_kb);
+	if (getCounter(L, "benchmark_lua_script_updates") != i32(scripts_count * FRAMES_COUNT)) ++errors;
+
+	// 2 seconds of frames, the longest delay is below 0.6 s, so each timer fires at least 3 times
+	const i32 timers = getCounter(L, "benchmark_lua_script_timers");
+	printf("%-40s %-16s %10.2f timers per frame\n", group.data, "scene update", float(timers) / FRAMES_COUNT);
+	if (timers < i32(scripts_count * 3)) ++errors;
+
+	if (errors > 0) printf("%-40s %u wrong counts or failed calls\n", group.data, errors);
+	engine.stopGame(universe);
+	engine.destroyUniverse(universe);
+}
+
+void luaScript(IAllocator& allocator) {
+	Engine::InitArgs init_args;
+	init_args.window_title = "Lumix benchmark";
+	UniquePtr<Engine> engine = Engine::create(static_cast<Engine::InitArgs&&>(init_args), allocator);
+
+	const Path path(SCRIPT_PATH);
+	if (!writeCompiledResource(engine->getFileSystem(), path, SCRIPT_SOURCE)) {
+		printf("%-40s could not write %s\n", "lua script", SCRIPT_PATH);
+		return;
+	}
+
+	const u32 scripts_counts[] = { 100, 1000, 10000 };
+	for (u32 scripts_count : scripts_counts) run(*engine, path, scripts_count, allocator);
+	deleteCompiledResource(engine->getFileSystem(), path);
+}
+
+} // namespace Lumix::benchmark
@@ -0,0 +1,111 @@
+#include "benchmark/benchmark.h"
+#include "engine/allocators.h"
+#include "engine/engine.h"
+#include "engine/file_system.h"
+#include "engine/lua_wrapper.h"
+#include "engine/math.h"
+#include "engine/os.h"
+#include "engine/string.h"
+
+#include <lua.hpp>
+#include <stdio.h>
+
+// vectors pushed from C++ as FFI cdata (the engine's state) compared with tables (a state without registerValueTypes);
+// the collector is stopped, so heap growth is the garbage made by the pushes
+
+namespace Lumix::benchmark {
+
+static constexpr u32 PUSHES_COUNT = 100'000;
+
+static const char* SCRIPT = R"#(
+	local get = benchmarkGetVec3
+	function benchmarkSumVec3(n)
+		local s = 0
+		for i = 1, n do
+			local v = get()
+			s = s + v[1] + v[2] + v[3]
+		end
+		return s
+	end
+)#";
+
+static int getVec3(lua_State* L) {
+	LuaWrapper::push(L, Vec3(1, 2, 3));
+	return 1;
+}
+
+static u32 run(lua_State* L, const char* name) {
+	const StaticString<64> group("lua ", name);
+	u32 errors = 0;
+	lua_gc(L, LUA_GCCOLLECT, 0);
+	lua_gc(L, LUA_GCSTOP, 0);
+
+	int heap_kb = lua_gc(L, LUA_GCCOUNT, 0);
+	u64 start = os::Timer::getRawTimestamp();
+	for (u32 i = 0; i < PUSHES_COUNT; ++i) {
+		LuaWrapper::push(L, Vec3((float)i, 0, 0));
+		lua_pop(L, 1);
+	}
+	print(group, "push", os::Timer::getRawTimestamp() - start, PUSHES_COUNT);
+	printf("%-40s %-16s %10d KB\n", group.data, "push garbage", lua_gc(L, LUA_GCCOUNT, 0) - heap_kb);
+
+	LuaWrapper::push(L, Vec3(1, 2, 3));
+	start = os::Timer::getRawTimestamp();
+	Vec3 sum(0);
+	for (u32 i = 0; i < PUSHES_COUNT; ++i) {
+		if (!LuaWrapper::isType<Vec3>(L, -1)) ++errors;
+		sum += LuaWrapper::toType<Vec3>(L, -1);
+	}
+	print(group, "read", os::Timer::getRawTimestamp() - start, PUSHES_COUNT);
+	lua_pop(L, 1);
+	if (sum.x != PUSHES_COUNT || sum.y != 2 * PUSHES_COUNT || sum.z != 3 * PUSHES_COUNT) ++errors;
+
+	// a script calling an API function which returns a vector, e.g. entity.position
+	lua_pushcfunction(L, &getVec3);
+	lua_setglobal(L, "benchmarkGetVec3");
+	if (!LuaWrapper::execute(L, Span(SCRIPT, stringLength(SCRIPT)), "benchmark", 0)) return errors + 1;
+	heap_kb = lua_gc(L, LUA_GCCOUNT, 0);
+	lua_getglobal(L, "benchmarkSumVec3");
+	lua_pushinteger(L, PUSHES_COUNT);
+	start = os::Timer::getRawTimestamp();
+	const bool called = LuaWrapper::pcall(L, 1, 1);
+	print(group, "script", os::Timer::getRawTimestamp() - start, PUSHES_COUNT);
+	printf("%-40s %-16s %10d KB\n", group.data, "script garbage", lua_gc(L, LUA_GCCOUNT, 0) - heap_kb);
+	if (!called) return errors + 1;
+	if (lua_tonumber(L, -1) != 6.0 * PUSHES_COUNT) ++errors;
+	lua_pop(L, 1);
+
+	lua_gc(L, LUA_GCRESTART, 0);
+	lua_gc(L, LUA_GCCOLLECT, 0);
+	return errors;
+}
+
+void luaValueTypes(IAllocator& allocator) {
+	Engine::InitArgs init_args;
+	init_args.window_title = "Lumix benchmark";
+	UniquePtr<Engine> engine = Engine::create(static_cast<Engine::InitArgs&&>(init_args), allocator);
+	// the engine steps the collector itself
+	engine->setLuaGCBudget(0);
+
+	lua_State* L = engine->getState();
+	u32 errors = run(L, "vec3 cdata");
+	// cdata of other FFI types is not a vector
+	const char* other_cdata = "return require('ffi').new('int[3]')";
+	if (luaL_loadbuffer(L, other_cdata, stringLength(other_cdata), "benchmark") != 0 || lua_pcall(L, 0, 1, 0) != 0) {
+		++errors;
+	}
+	else if (LuaWrapper::isType<Vec3>(L, -1)) {
+		++errors;
+	}
+	lua_pop(L, 1);
+	engine->setLuaGCBudget(1);
+
+	lua_State* tables_state = luaL_newstate();
+	luaL_openlibs(tables_state);
+	errors += run(tables_state, "vec3 table");
+	lua_close(tables_state);
+
+	if (errors > 0) printf("%-40s %u wrong values\n", "lua vec3", errors);
+}
+
+} // namespace Lumix::benchmark
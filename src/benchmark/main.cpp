@@ -0,0 +1,89 @@
+#include "benchmark/benchmark.h"
+#include "engine/allocators.h"
+#include "engine/atomic.h"
+#include "engine/file_system.h"
+#include "engine/job_system.h"
+#include "engine/os.h"
+#include "engine/path.h"
+#include "engine/string.h"
+
+#include <stdio.h>
+
+using namespace Lumix;
+
+// standalone benchmarks of engine primitives, run `benchmark` to run all of them or `benchmark <name>` to run one
+
+void benchmark::print(const char* group, const char* name, u64 ticks, u32 count) {
+	const double ns = double(ticks) * 1e9 / double(os::Timer::getFrequency()) / double(count);
+	printf("%-40s %-16s %10.2f ns/op\n", group, name, ns);
+}
+
+bool benchmark::writeCompiledResource(FileSystem& fs, const Path& path, const char* content) {
+	const StaticString<LUMIX_MAX_PATH> dir(fs.getBasePath(), ".lumix/assets");
+	if (!os::dirExists(dir) && !os::makePath(dir)) return false;
+	const StaticString<LUMIX_MAX_PATH> res_path(dir, "/", path.getHash(), ".res");
+	os::OutputFile file;
+	if (!file.open(res_path)) return false;
+	const bool written = file.write(content, stringLength(content));
+	file.close();
+	return written;
+}
+
+void benchmark::deleteCompiledResource(FileSystem& fs, const Path& path) {
+	const StaticString<LUMIX_MAX_PATH> res_path(fs.getBasePath(), ".lumix/assets/", path.getHash(), ".res");
+	os::deleteFile(res_path);
+}
+
+int main(int argc, char** argv) {
+	struct Benchmark {
+		const char* name;
+		void (*run)(IAllocator&);
+	};
+
+	const Benchmark benchmarks[] = {
+		{ "allocators", &benchmark::allocators },
+		{ "hash_map", &benchmark::hashMap },
+		{ "log", &benchmark::log },
+		{ "lua_gc", &benchmark::luaGC },
+		{ "lua_value_types", &benchmark::luaValueTypes },
+		{ "pack", &benchmark::pack },
+		{ "path", &benchmark::path },
+		{ "profiler", &benchmark::profilerWrite },
+		{ "universe", &benchmark::universe },
+		{ "universe_streamer", &benchmark::universeStreamer },
+		#ifdef LUMIX_BENCHMARK_EDITOR
+			{ "save", &benchmark::save },
+			{ "undo", &benchmark::undo },
+		#endif
+		#ifdef LUMIX_BENCHMARK_LUA_SCRIPT
+			{ "job_script", &benchmark::jobScript },
+			{ "lua_script", &benchmark::luaScript },
+		#endif
+		#ifdef LUMIX_BENCHMARK_RENDERER
+			{ "gpu_profiler", &benchmark::gpuProfiler },
+			{ "mesh_codec", &benchmark::meshCodec },
+			{ "terrain", &benchmark::terrain },
+		#endif
+	};
+
+	DefaultAllocator allocator;
+	// the engine and the editor use jobs, benchmarks run on the main thread, which is not a worker
+	if (!jobs::init(os::getCPUsCount(), allocator)) {
+		printf("Failed to initialize job system\n");
+		return 1;
+	}
+	bool found = false;
+	for (const Benchmark& b : benchmarks) {
+		if (argc > 1 && !equalStrings(argv[1], b.name)) continue;
+		found = true;
+		b.run(allocator);
+	}
+	jobs::shutdown();
+
+	if (!found) {
+		printf("Unknown benchmark %s, available:\n", argv[1]);
+		for (const Benchmark& b : benchmarks) printf("  %s\n", b.name);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,162 @@
+#include "benchmark/benchmark.h"
+#include "engine/allocators.h"
+#include "engine/array.h"
+#include "engine/crt.h"
+#include "engine/file_system.h"
+#include "engine/os.h"
+#include "engine/path.h"
+#include "engine/stream.h"
+#include "engine/string.h"
+
+#include <stdio.h>
+
+// replays a load trace of random files from two packs with the same content, one laid out in hash order,
+// the other in the trace's order; PackFileSystem reads ahead when entries are requested sequentially
+
+namespace Lumix::benchmark {
+
+static constexpr u32 FILES_COUNT = 2000;
+static constexpr u32 TRACE_COUNT = 466;
+static constexpr u32 MAX_FILE_SIZE = 32 * 1024;
+
+struct PackedFile {
+	Path path;
+	u32 hash;
+	u32 size;
+};
+
+static u8 getByte(u32 file_idx, u32 offset) { return u8(file_idx * 31 + offset * 7); }
+
+static bool writePack(const char* path, const Array<PackedFile>& files, const Array<u32>& order, IAllocator& allocator) {
+	os::OutputFile file;
+	if (!file.open(path)) return false;
+
+	bool success = file.write(PackHeader());
+	Array<PackEntry> toc(allocator);
+	OutputMemoryStream data(allocator);
+	u64 offset = sizeof(PackHeader);
+	for (u32 idx : order) {
+		const PackedFile& f = files[idx];
+		data.resize(f.size);
+		for (u32 i = 0; i < f.size; ++i) data.getMutableData()[i] = getByte(idx, i);
+		success = file.write(data.data(), data.size()) && success;
+
+		PackEntry& entry = toc.emplace();
+		entry.hash = f.hash;
+		entry.flags = PackEntry::NONE;
+		entry.offset = offset;
+		entry.size = f.size;
+		entry.compressed_size = f.size;
+		offset += f.size;
+	}
+	success = file.write(toc.begin(), toc.byte_size()) && success;
+	PackFooter footer;
+	footer.toc_offset = offset;
+	footer.count = toc.size();
+	success = file.write(footer) && success;
+	file.close();
+	return success;
+}
+
+// number of files in the trace which do not start where the previous one ended
+static u32 countJumps(const Array<PackedFile>& files, const Array<u32>& order, const Array<u32>& trace, IAllocator& allocator) {
+	Array<u64> offsets(allocator);
+	offsets.resize(files.size());
+	u64 offset = 0;
+	for (u32 idx : order) {
+		offsets[idx] = offset;
+		offset += files[idx].size;
+	}
+	u32 jumps = 0;
+	u64 prev_end = ~(u64)0;
+	for (u32 idx : trace) {
+		if (offsets[idx] != prev_end) ++jumps;
+		prev_end = offsets[idx] + files[idx].size;
+	}
+	return jumps;
+}
+
+static void replay(const char* name, const char* pak_path, const Array<PackedFile>& files, const Array<u32>& trace, u32 jumps, IAllocator& allocator) {
+	const char* group = "pack 466 of 2000 files";
+	UniquePtr<FileSystem> fs = FileSystem::createPacked(pak_path, allocator);
+	OutputMemoryStream content(allocator);
+	u32 errors = 0;
+	u64 ticks = 0;
+	for (u32 idx : trace) {
+		content.clear();
+		const u64 start = os::Timer::getRawTimestamp();
+		const bool read = fs->getContentSync(files[idx].path, content);
+		ticks += os::Timer::getRawTimestamp() - start;
+		if (!read || content.size() != files[idx].size) {
+			++errors;
+			continue;
+		}
+		for (u32 i = 0; i < files[idx].size; ++i) {
+			if (content.data()[i] != getByte(idx, i)) {
+				++errors;
+				break;
+			}
+		}
+	}
+	print(group, name, ticks, trace.size());
+	printf("%-40s %-16s %10u jumps\n", group, name, jumps);
+	if (errors > 0) printf("%-40s %-16s %u wrong files\n", group, name, errors);
+}
+
+void pack(IAllocator& allocator) {
+	Array<PackedFile> files(allocator);
+	u32 rnd = 0x12345678;
+	auto random = [&rnd](){
+		rnd = rnd * 1664525 + 1013904223;
+		return rnd >> 8;
+	};
+	for (u32 i = 0; i < FILES_COUNT; ++i) {
+		PackedFile& f = files.emplace();
+		f.path = Path(StaticString<LUMIX_MAX_PATH>("benchmark/pack/file_", i, ".dat"));
+		f.hash = getPackHash(f.path);
+		f.size = 1 + random() % MAX_FILE_SIZE;
+	}
+
+	// files requested by a load, each once
+	Array<u32> trace(allocator);
+	Array<bool> in_trace(allocator);
+	in_trace.resize(FILES_COUNT);
+	for (bool& b : in_trace) b = false;
+	while (trace.size() < TRACE_COUNT) {
+		const u32 idx = random() % FILES_COUNT;
+		if (in_trace[idx]) continue;
+		in_trace[idx] = true;
+		trace.push(idx);
+	}
+
+	Array<u32> hash_order(allocator);
+	for (u32 i = 0; i < FILES_COUNT; ++i) hash_order.push(i);
+	static const Array<PackedFile>* s_files;
+	s_files = &files;
+	qsort(hash_order.begin(), hash_order.size(), sizeof(hash_order[0]), [](const void* a, const void* b){
+		const u32 ha = (*s_files)[*(const u32*)a].hash;
+		const u32 hb = (*s_files)[*(const u32*)b].hash;
+		return ha < hb ? -1 : (ha > hb ? 1 : 0);
+	});
+
+	// what the pack builder writes with a trace, traced files in the order of requests, the rest in hash order
+	Array<u32> load_order(allocator);
+	for (u32 idx : trace) load_order.push(idx);
+	for (u32 idx : hash_order) {
+		if (!in_trace[idx]) load_order.push(idx);
+	}
+
+	const char* hash_pak = "_benchmark_hash_order.pak";
+	const char* load_pak = "_benchmark_load_order.pak";
+	if (!writePack(hash_pak, files, hash_order, allocator) || !writePack(load_pak, files, load_order, allocator)) {
+		printf("%-40s could not write packs\n", "pack");
+	}
+	else {
+		replay("hash order", hash_pak, files, trace, countJumps(files, hash_order, trace, allocator), allocator);
+		replay("load order", load_pak, files, trace, countJumps(files, load_order, trace, allocator), allocator);
+	}
+	os::deleteFile(hash_pak);
+	os::deleteFile(load_pak);
+}
+
+} // namespace Lumix::benchmark
@@ -0,0 +1,84 @@
+#include "benchmark/benchmark.h"
+#include "engine/array.h"
+#include "engine/hash_map.h"
+#include "engine/os.h"
+#include "engine/path.h"
+#include "engine/string.h"
+
+#include <stdio.h>
+
+// Path is a handle to an interned string, constructing it looks the string up in the global table,
+// copying, hashing and comparing do not touch the string
+
+namespace Lumix::benchmark {
+
+static constexpr u32 PATHS_COUNT = 100'000;
+
+// consumes results so the compiler does not drop the measured loops
+static volatile u32 g_sink;
+
+static void makeAssetPath(u32 i, StaticString<LUMIX_MAX_PATH>& out) {
+	out = "";
+	out << "models/vegetation/set_" << i % 97 << "/variant_" << i % 13 << "/asset_" << i << ".fbx";
+}
+
+void path(IAllocator& allocator) {
+	const char* group = "path 100k assets";
+	const u32 interned_count = Path::getInternedCount();
+	const size_t interned_size = Path::getInternedSize();
+	u32 errors = 0;
+	{
+		Array<StaticString<LUMIX_MAX_PATH>> strings(allocator);
+		strings.resize(PATHS_COUNT);
+		for (u32 i = 0; i < PATHS_COUNT; ++i) makeAssetPath(i, strings[i]);
+
+		Array<Path> paths(allocator);
+		paths.reserve(PATHS_COUNT);
+		u64 start = os::Timer::getRawTimestamp();
+		for (u32 i = 0; i < PATHS_COUNT; ++i) paths.emplace(strings[i]);
+		print(group, "create new", os::Timer::getRawTimestamp() - start, PATHS_COUNT);
+		printf("%-40s %-16s %10u KB\n", group, "interned", u32((Path::getInternedSize() - interned_size) / 1024));
+
+		// the same strings are already interned, so these are table hits
+		Array<Path> same(allocator);
+		same.reserve(PATHS_COUNT);
+		start = os::Timer::getRawTimestamp();
+		for (u32 i = 0; i < PATHS_COUNT; ++i) same.emplace(strings[i]);
+		print(group, "create existing", os::Timer::getRawTimestamp() - start, PATHS_COUNT);
+		for (u32 i = 0; i < PATHS_COUNT; ++i) {
+			if (same[i] != paths[i] || !equalStrings(same[i].c_str(), strings[i])) ++errors;
+		}
+		if (Path::getInternedCount() != interned_count + PATHS_COUNT) ++errors;
+
+		Array<Path> copies(allocator);
+		copies.reserve(PATHS_COUNT);
+		start = os::Timer::getRawTimestamp();
+		for (const Path& p : paths) copies.push(p);
+		print(group, "copy", os::Timer::getRawTimestamp() - start, PATHS_COUNT);
+
+		// resource managers look resources up by path hash and compare the paths
+		HashMap<u32, u32> map(allocator);
+		map.reserve(PATHS_COUNT);
+		for (u32 i = 0; i < PATHS_COUNT; ++i) map.insert(paths[i].getHash(), i);
+		u32 found = 0;
+		start = os::Timer::getRawTimestamp();
+		for (const Path& p : copies) {
+			auto iter = map.find(p.getHash());
+			if (iter.isValid() && paths[iter.value()] == p) ++found;
+		}
+		print(group, "find", os::Timer::getRawTimestamp() - start, PATHS_COUNT);
+		if (found != PATHS_COUNT) errors += PATHS_COUNT - found;
+		g_sink = found;
+
+		start = os::Timer::getRawTimestamp();
+		copies.clear();
+		same.clear();
+		paths.clear();
+		print(group, "release", os::Timer::getRawTimestamp() - start, PATHS_COUNT * 3);
+	}
+	// the last release frees the entry
+	if (Path::getInternedCount() != interned_count || Path::getInternedSize() != interned_size) ++errors;
+	if (errors > 0) printf("%-40s %u wrong paths\n", group, errors);
+}
+
+} // namespace Lumix::benchmark
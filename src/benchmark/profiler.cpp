@@ -0,0 +1,112 @@
+#include "benchmark/benchmark.h"
+#include "engine/allocators.h"
+#include "engine/crt.h"
+#include "engine/os.h"
+#include "engine/profiler.h"
+#include "engine/stream.h"
+#include "engine/string.h"
+#include "engine/thread.h"
+
+#include <stdio.h>
+
+// profiler writes without a lock, each thread owns a ring of chunks,
+// serialize() copies whole chunks and drops those recycled during the copy
+
+namespace Lumix::benchmark {
+
+static constexpr u32 PAIRS_COUNT = 1'000'000;
+static constexpr u32 WRITERS_COUNT = 4;
+static constexpr u32 WRITER_PAIRS_COUNT = 2'000'000;
+
+struct Writer : Thread {
+	Writer(IAllocator& allocator) : Thread(allocator) {}
+
+	int task() override {
+		for (u32 i = 0; i < WRITER_PAIRS_COUNT; ++i) {
+			profiler::beginBlock("benchmark writer");
+			profiler::endBlock();
+		}
+		return 0;
+	}
+};
+
+// returns the number of thread contexts in `blob` whose events do not add up to the context's size
+static u32 checkSerialized(InputMemoryStream& blob) {
+	u32 errors = 0;
+	const profiler::SerializedVersion version = blob.read<profiler::SerializedVersion>();
+	if (version > profiler::SerializedVersion::LATEST) return 1;
+	const u32 contexts_count = blob.read<u32>();
+	// the global context is not counted
+	for (u32 i = 0; i < contexts_count + 1; ++i) {
+		blob.readString();
+		blob.read<u32>(); // thread id
+		blob.read<u32>(); // begin
+		blob.read<u32>(); // end
+		blob.read<u8>(); // show in profiler
+		if (version > profiler::SerializedVersion::OVERFLOW_COUNT) blob.read<u32>();
+		const u32 size = blob.read<u32>();
+		if (blob.getPosition() + size > blob.size()) return errors + 1;
+
+		const u8* p = (const u8*)blob.getBuffer() + blob.getPosition();
+		const u8* end = p + size;
+		while (p < end) {
+			profiler::EventHeader header;
+			memcpy(&header, p, sizeof(header));
+			if (header.size < sizeof(header) || header.type > profiler::EventType::LINK) break;
+			p += header.size;
+		}
+		if (p != end) ++errors;
+		blob.skip(size);
+	}
+	return errors;
+}
+
+static void writeSingleThread() {
+	u64 start = os::Timer::getRawTimestamp();
+	for (u32 i = 0; i < PAIRS_COUNT; ++i) {
+		profiler::beginBlock("benchmark");
+		profiler::endBlock();
+	}
+	print("profiler", "begin/end block", os::Timer::getRawTimestamp() - start, PAIRS_COUNT);
+}
+
+// writers fill and recycle their chunks while the main thread serializes
+static void writeConcurrently(IAllocator& allocator) {
+	Writer* writers[WRITERS_COUNT];
+	for (Writer*& writer : writers) {
+		writer = LUMIX_NEW(allocator, Writer)(allocator);
+		writer->create("benchmark writer", false);
+	}
+
+	OutputMemoryStream blob(allocator);
+	u32 serializations = 0;
+	u32 errors = 0;
+	u64 ticks = 0;
+	for (;;) {
+		bool finished = true;
+		for (Writer* writer : writers) finished = finished && writer->isFinished();
+		if (finished) break;
+
+		blob.clear();
+		const u64 start = os::Timer::getRawTimestamp();
+		profiler::serialize(blob);
+		ticks += os::Timer::getRawTimestamp() - start;
+		InputMemoryStream input(blob);
+		errors += checkSerialized(input);
+		++serializations;
+	}
+	if (serializations > 0) print("profiler 4 writers", "serialize", ticks, serializations);
+	if (errors > 0) printf("%-40s %u malformed thread contexts\n", "profiler 4 writers", errors);
+
+	for (Writer* writer : writers) {
+		writer->destroy();
+		LUMIX_DELETE(allocator, writer);
+	}
+}
+
+void profilerWrite(IAllocator& allocator) {
+	writeSingleThread();
+	writeConcurrently(allocator);
+}
+
+} // namespace Lumix::benchmark
@@ -0,0 +1,208 @@
+#include "benchmark/benchmark.h"
+#include "engine/allocators.h"
+#include "engine/array.h"
+#include "engine/os.h"
+#include "engine/profiler.h"
+#include "engine/string.h"
+#include "engine/sync.h"
+#include "renderer/gpu_profiler.h"
+
+#include <stdio.h>
+
+// GPUProfiler runs against a stub query backend, timestamps are ready a few frames after they are recorded;
+// one pass over finished frames is compared with popping queries one by one, as the profiler did before
+
+namespace Lumix::benchmark {
+
+static constexpr u32 FRAMES_COUNT = 1000;
+static constexpr u32 PAIRS_PER_FRAME = 100;
+static constexpr u32 LATENCY = 3;
+// longer than GPUProfiler::MAX_FRAMES_IN_FLIGHT
+static constexpr u32 STALL_FRAMES_COUNT = 20;
+
+struct StubQuery {
+	u64 timestamp;
+	u32 frame;
+	bool alive;
+};
+
+struct StubGPU {
+	StubGPU(IAllocator& allocator) : queries(allocator) {}
+
+	Array<StubQuery> queries;
+	u64 timestamp = 0;
+	u64 last_read = 0;
+	u32 frame = 0;
+	u32 live = 0;
+	u32 reads = 0;
+	u32 out_of_order_reads = 0;
+	// calls with a destroyed query
+	u32 invalid_calls = 0;
+	bool stalled = false;
+};
+
+static StubGPU* g_gpu = nullptr;
+
+static StubQuery& getQuery(gpu::QueryHandle q) {
+	return g_gpu->queries[u32(uintptr(q) - 1)];
+}
+
+static GPUQueryBackend stubBackend() {
+	GPUQueryBackend backend;
+	backend.createQuery = []() {
+		StubQuery& q = g_gpu->queries.emplace();
+		q.alive = true;
+		++g_gpu->live;
+		return gpu::QueryHandle(uintptr(g_gpu->queries.size()));
+	};
+	backend.destroyQuery = [](gpu::QueryHandle q) {
+		if (!getQuery(q).alive) ++g_gpu->invalid_calls;
+		getQuery(q).alive = false;
+		--g_gpu->live;
+	};
+	backend.queryTimestamp = [](gpu::QueryHandle q) {
+		if (!getQuery(q).alive) ++g_gpu->invalid_calls;
+		getQuery(q).timestamp = ++g_gpu->timestamp;
+		getQuery(q).frame = g_gpu->frame;
+	};
+	backend.isQueryReady = [](gpu::QueryHandle q) {
+		return !g_gpu->stalled && getQuery(q).frame + LATENCY <= g_gpu->frame;
+	};
+	backend.getQueryResult = [](gpu::QueryHandle q) {
+		const u64 timestamp = getQuery(q).timestamp;
+		// the profiler expects blocks in the order they were recorded
+		if (timestamp <= g_gpu->last_read) ++g_gpu->out_of_order_reads;
+		g_gpu->last_read = timestamp;
+		++g_gpu->reads;
+		return timestamp;
+	};
+	backend.getQueryFrequency = []() { return os::Timer::getFrequency(); };
+	return backend;
+}
+
+static void recordFrame(GPUProfiler& profiler) {
+	for (u32 i = 0; i < PAIRS_PER_FRAME; ++i) {
+		profiler.beginQuery("benchmark", 0);
+		profiler.endQuery();
+	}
+}
+
+// what GPUProfiler::frame did before the per-frame ring
+struct EraseProfiler {
+	struct Query {
+		StaticString<32> name;
+		gpu::QueryHandle handle;
+		bool is_end;
+		bool is_frame;
+	};
+
+	EraseProfiler(IAllocator& allocator, const GPUQueryBackend& backend)
+		: queries(allocator)
+		, pool(allocator)
+		, backend(backend)
+	{}
+
+	void record(const char* name, bool is_end) {
+		MutexGuard lock(mutex);
+		Query& q = queries.emplace();
+		q.name = name;
+		q.is_end = is_end;
+		q.is_frame = false;
+		if (pool.empty()) {
+			q.handle = backend.createQuery();
+		}
+		else {
+			q.handle = pool.back();
+			pool.pop();
+		}
+		backend.queryTimestamp(q.handle);
+	}
+
+	void frame() {
+		MutexGuard lock(mutex);
+		Query& frame_query = queries.emplace();
+		frame_query.is_frame = true;
+		while (!queries.empty()) {
+			const Query q = queries[0];
+			if (q.is_frame) {
+				profiler::gpuFrame();
+				queries.erase(0);
+				continue;
+			}
+			if (!backend.isQueryReady(q.handle)) break;
+			const u64 timestamp = backend.getQueryResult(q.handle);
+			if (q.is_end) profiler::endGPUBlock(timestamp);
+			else profiler::beginGPUBlock(q.name, timestamp, 0);
+			pool.push(q.handle);
+			queries.erase(0);
+		}
+	}
+
+	Array<Query> queries;
+	Array<gpu::QueryHandle> pool;
+	GPUQueryBackend backend;
+	Mutex mutex;
+};
+
+void gpuProfiler(IAllocator& allocator) {
+	const StaticString<64> group("gpu profiler ", PAIRS_PER_FRAME * 2, " queries");
+	StubGPU stub(allocator);
+	g_gpu = &stub;
+	const GPUQueryBackend backend = stubBackend();
+	u32 errors = 0;
+	const u32 queries_count = FRAMES_COUNT * PAIRS_PER_FRAME * 2;
+
+	{
+		EraseProfiler profiler(allocator, backend);
+		u64 start = os::Timer::getRawTimestamp();
+		for (u32 frame = 0; frame < FRAMES_COUNT; ++frame) {
+			for (u32 i = 0; i < PAIRS_PER_FRAME; ++i) {
+				profiler.record("benchmark", false);
+				profiler.record("benchmark", true);
+			}
+			profiler.frame();
+			++stub.frame;
+		}
+		print(group, "erase", os::Timer::getRawTimestamp() - start, queries_count);
+		for (const EraseProfiler::Query& q : profiler.queries) if (!q.is_frame) backend.destroyQuery(q.handle);
+		for (gpu::QueryHandle h : profiler.pool) backend.destroyQuery(h);
+	}
+
+	stub.reads = 0;
+	stub.out_of_order_reads = 0;
+	GPUProfiler profiler(allocator, backend);
+	u64 start = os::Timer::getRawTimestamp();
+	for (u32 frame = 0; frame < FRAMES_COUNT; ++frame) {
+		recordFrame(profiler);
+		profiler.frame();
+		++stub.frame;
+	}
+	print(group, "ring", os::Timer::getRawTimestamp() - start, queries_count);
+	// handles are reused once the GPU is done with them
+	printf("%-40s %-16s %10u queries\n", group.data, "live", stub.live);
+	if (stub.live > PAIRS_PER_FRAME * 2 * (LATENCY + 2)) ++errors;
+
+	// the GPU falls behind more than the ring holds, frames are merged into the last slot and resolved later
+	stub.stalled = true;
+	for (u32 frame = 0; frame < STALL_FRAMES_COUNT; ++frame) {
+		recordFrame(profiler);
+		profiler.frame();
+		++stub.frame;
+	}
+	stub.stalled = false;
+	for (u32 frame = 0; frame < LATENCY + 2; ++frame) {
+		profiler.frame();
+		++stub.frame;
+	}
+	// everything recorded was read, in order
+	if (stub.reads != (FRAMES_COUNT + STALL_FRAMES_COUNT) * PAIRS_PER_FRAME * 2) ++errors;
+	if (stub.out_of_order_reads != 0) ++errors;
+
+	profiler.clear();
+	if (stub.live != 0 || stub.invalid_calls != 0) ++errors;
+
+	if (errors > 0) printf("%-40s %u wrong reads or leaked queries\n", group.data, errors);
+	g_gpu = nullptr;
+}
+
+} // namespace Lumix::benchmark
@@ -0,0 +1,202 @@
+#include "benchmark/benchmark.h"
+#include "engine/allocators.h"
+#include "engine/array.h"
+#include "engine/atomic.h"
+#include "engine/crt.h"
+#include "engine/job_system.h"
+#include "engine/math.h"
+#include "engine/os.h"
+#include "engine/string.h"
+#include "meshoptimizer/meshoptimizer.h"
+
+#include <math.h>
+#include <stdio.h>
+
+// vertex and index streams of compiled models are encoded with meshoptimizer's codecs, as FBXImporter writes them,
+// and decoded per mesh on workers, as Model::parseCompressedGeometry does; sizes are compared with raw streams
+// and decoding with the copy of raw data done by the old load path
+
+namespace Lumix::benchmark {
+
+static constexpr u32 MESHES_COUNT = 32;
+static constexpr u32 GRID_SIZE = 128;
+// position, packed normal, packed tangent, uv, as FBXImporter writes a static mesh
+static constexpr u32 VERTEX_SIZE = sizeof(Vec3) + sizeof(u32) + sizeof(u32) + sizeof(Vec2);
+// position replaced by 4 halfs
+static constexpr u32 QUANTIZED_VERTEX_SIZE = VERTEX_SIZE - sizeof(Vec3) + sizeof(u16) * 4;
+
+struct MeshStreams {
+	MeshStreams(IAllocator& allocator)
+		: indices(allocator)
+		, indices16(allocator)
+		, vertices(allocator)
+		, quantized(allocator)
+		, encoded_indices(allocator)
+		, encoded_vertices(allocator)
+		, encoded_quantized(allocator)
+		, decoded_indices(allocator)
+		, decoded_vertices(allocator)
+	{}
+
+	Array<u32> indices;
+	// what the old file version stored for meshes with less than 64k vertices
+	Array<u16> indices16;
+	Array<u8> vertices;
+	Array<u8> quantized;
+	Array<u8> encoded_indices;
+	Array<u8> encoded_vertices;
+	Array<u8> encoded_quantized;
+	Array<u16> decoded_indices;
+	Array<u8> decoded_vertices;
+	u32 vertex_count;
+	bool decoded;
+};
+
+static u32 packF4u(const Vec3& vec) {
+	const u8 x = u8(clamp((vec.x * 0.5f + 0.5f) * 255, 0.f, 255.f));
+	const u8 y = u8(clamp((vec.y * 0.5f + 0.5f) * 255, 0.f, 255.f));
+	const u8 z = u8(clamp((vec.z * 0.5f + 0.5f) * 255, 0.f, 255.f));
+	return x | (y << 8) | (z << 16);
+}
+
+// displaced grid, each mesh has a different displacement
+static void generate(u32 mesh_idx, MeshStreams& mesh) {
+	const float phase = mesh_idx * 0.37f;
+	auto getHeight = [phase](float x, float z) { return sinf(x * 0.11f + phase) * cosf(z * 0.07f) * 3 + sinf(x * 0.5f + z * 0.3f) * 0.2f; };
+
+	mesh.vertex_count = GRID_SIZE * GRID_SIZE;
+	mesh.vertices.resize(mesh.vertex_count * VERTEX_SIZE);
+	u8* out = mesh.vertices.begin();
+	for (u32 j = 0; j < GRID_SIZE; ++j) {
+		for (u32 i = 0; i < GRID_SIZE; ++i) {
+			const float x = (float)i;
+			const float z = (float)j;
+			const Vec3 pos(x, getHeight(x, z), z);
+			const Vec3 normal = normalize(Vec3(getHeight(x - 1, z) - getHeight(x + 1, z), 2, getHeight(x, z - 1) - getHeight(x, z + 1)));
+			const Vec3 tangent = normalize(Vec3(2, getHeight(x + 1, z) - getHeight(x - 1, z), 0));
+			const u32 packed_normal = packF4u(normal);
+			const u32 packed_tangent = packF4u(tangent);
+			const Vec2 uv(x / (GRID_SIZE - 1), z / (GRID_SIZE - 1));
+			memcpy(out, &pos, sizeof(pos));
+			memcpy(out + 12, &packed_normal, sizeof(packed_normal));
+			memcpy(out + 16, &packed_tangent, sizeof(packed_tangent));
+			memcpy(out + 20, &uv, sizeof(uv));
+			out += VERTEX_SIZE;
+		}
+	}
+
+	for (u32 j = 0; j < GRID_SIZE - 1; ++j) {
+		for (u32 i = 0; i < GRID_SIZE - 1; ++i) {
+			const u32 idx = i + j * GRID_SIZE;
+			const u32 quad[] = { idx, idx + GRID_SIZE, idx + 1, idx + 1, idx + GRID_SIZE, idx + GRID_SIZE + 1 };
+			for (u32 k : quad) mesh.indices.push(k);
+		}
+	}
+
+	// what the importer does before writing
+	meshopt_optimizeVertexCache(mesh.indices.begin(), mesh.indices.begin(), mesh.indices.size(), mesh.vertex_count);
+	meshopt_optimizeVertexFetch(mesh.vertices.begin(), mesh.indices.begin(), mesh.indices.size(), mesh.vertices.begin(), mesh.vertex_count, VERTEX_SIZE);
+	for (u32 idx : mesh.indices) mesh.indices16.push((u16)idx);
+
+	mesh.quantized.resize(mesh.vertex_count * QUANTIZED_VERTEX_SIZE);
+	for (u32 i = 0; i < mesh.vertex_count; ++i) {
+		const u8* src = &mesh.vertices[i * VERTEX_SIZE];
+		u8* dst = &mesh.quantized[i * QUANTIZED_VERTEX_SIZE];
+		Vec3 pos;
+		memcpy(&pos, src, sizeof(pos));
+		const u16 halfs[4] = { meshopt_quantizeHalf(pos.x), meshopt_quantizeHalf(pos.y), meshopt_quantizeHalf(pos.z), 0 };
+		memcpy(dst, halfs, sizeof(halfs));
+		memcpy(dst + sizeof(halfs), src + sizeof(pos), VERTEX_SIZE - sizeof(pos));
+	}
+}
+
+static void encode(MeshStreams& mesh) {
+	mesh.encoded_indices.resize((u32)meshopt_encodeIndexBufferBound(mesh.indices.size(), mesh.vertex_count));
+	mesh.encoded_indices.resize((u32)meshopt_encodeIndexBuffer(mesh.encoded_indices.begin(), mesh.encoded_indices.size(), mesh.indices.begin(), mesh.indices.size()));
+
+	mesh.encoded_vertices.resize((u32)meshopt_encodeVertexBufferBound(mesh.vertex_count, VERTEX_SIZE));
+	mesh.encoded_vertices.resize((u32)meshopt_encodeVertexBuffer(mesh.encoded_vertices.begin(), mesh.encoded_vertices.size(), mesh.vertices.begin(), mesh.vertex_count, VERTEX_SIZE));
+
+	mesh.encoded_quantized.resize((u32)meshopt_encodeVertexBufferBound(mesh.vertex_count, QUANTIZED_VERTEX_SIZE));
+	mesh.encoded_quantized.resize((u32)meshopt_encodeVertexBuffer(mesh.encoded_quantized.begin(), mesh.encoded_quantized.size(), mesh.quantized.begin(), mesh.vertex_count, QUANTIZED_VERTEX_SIZE));
+}
+
+static void decode(MeshStreams& mesh) {
+	mesh.decoded = meshopt_decodeIndexBuffer(mesh.decoded_indices.begin(), mesh.indices.size(), sizeof(u16), mesh.encoded_indices.begin(), mesh.encoded_indices.size()) == 0
+		&& meshopt_decodeVertexBuffer(mesh.decoded_vertices.begin(), mesh.vertex_count, VERTEX_SIZE, mesh.encoded_vertices.begin(), mesh.encoded_vertices.size()) == 0;
+}
+
+void meshCodec(IAllocator& allocator) {
+	const StaticString<64> group("mesh codec ", MESHES_COUNT, " meshes");
+	Array<MeshStreams> meshes(allocator);
+	meshes.reserve(MESHES_COUNT);
+	for (u32 i = 0; i < MESHES_COUNT; ++i) {
+		MeshStreams& mesh = meshes.emplace(allocator);
+		generate(i, mesh);
+		mesh.decoded_indices.resize(mesh.indices.size());
+		mesh.decoded_vertices.resize(mesh.vertices.size());
+	}
+	const u32 vertex_count = MESHES_COUNT * meshes[0].vertex_count;
+
+	u64 start = os::Timer::getRawTimestamp();
+	for (MeshStreams& mesh : meshes) encode(mesh);
+	print(group, "encode", os::Timer::getRawTimestamp() - start, vertex_count);
+
+	u64 raw_size = 0;
+	u64 encoded_size = 0;
+	u64 quantized_size = 0;
+	for (const MeshStreams& mesh : meshes) {
+		raw_size += mesh.indices16.byte_size() + mesh.vertices.size();
+		encoded_size += mesh.encoded_indices.size() + mesh.encoded_vertices.size();
+		quantized_size += mesh.encoded_indices.size() + mesh.encoded_quantized.size();
+	}
+	printf("%-40s %-16s %10u KB\n", group.data, "raw", u32(raw_size / 1024));
+	printf("%-40s %-16s %10u KB\n", group.data, "encoded", u32(encoded_size / 1024));
+	printf("%-40s %-16s %10u KB\n", group.data, "quantized", u32(quantized_size / 1024));
+
+	// old load path copied raw streams to mesh buffers
+	start = os::Timer::getRawTimestamp();
+	for (MeshStreams& mesh : meshes) {
+		memcpy(mesh.decoded_indices.begin(), mesh.indices16.begin(), mesh.indices16.byte_size());
+		memcpy(mesh.decoded_vertices.begin(), mesh.vertices.begin(), mesh.vertices.size());
+	}
+	print(group, "copy raw", os::Timer::getRawTimestamp() - start, vertex_count);
+
+	start = os::Timer::getRawTimestamp();
+	for (MeshStreams& mesh : meshes) decode(mesh);
+	print(group, "decode", os::Timer::getRawTimestamp() - start, vertex_count);
+
+	for (MeshStreams& mesh : meshes) {
+		memset(mesh.decoded_indices.begin(), 0, mesh.decoded_indices.byte_size());
+		memset(mesh.decoded_vertices.begin(), 0, mesh.decoded_vertices.byte_size());
+	}
+	start = os::Timer::getRawTimestamp();
+	jobs::forEach(meshes.size(), 1, [&](i32 i, i32){
+		decode(meshes[i]);
+	});
+	print(group, "decode jobs", os::Timer::getRawTimestamp() - start, vertex_count);
+
+	u32 errors = 0;
+	for (const MeshStreams& mesh : meshes) {
+		if (!mesh.decoded || memcmp(mesh.decoded_vertices.begin(), mesh.vertices.begin(), mesh.vertices.size()) != 0) {
+			++errors;
+			continue;
+		}
+		// the codec keeps triangles in order, but can rotate vertices of a triangle, winding stays the same
+		for (u32 i = 0, c = mesh.indices.size(); i < c; i += 3) {
+			const u16* tri = &mesh.decoded_indices[i];
+			const u32* src = &mesh.indices[i];
+			bool same = false;
+			for (u32 r = 0; r < 3; ++r) {
+				same = same || (tri[0] == src[r] && tri[1] == src[(r + 1) % 3] && tri[2] == src[(r + 2) % 3]);
+			}
+			if (!same) {
+				++errors;
+				break;
+			}
+		}
+	}
+	if (errors > 0) printf("%-40s %u wrong meshes\n", group.data, errors);
+}
+
+} // namespace Lumix::benchmark
@@ -0,0 +1,195 @@
+#include "benchmark/benchmark.h"
+#include "engine/allocators.h"
+#include "engine/array.h"
+#include "engine/engine.h"
+#include "engine/geometry.h"
+#include "engine/math.h"
+#include "engine/os.h"
+#include "engine/plugin.h"
+#include "engine/reflection.h"
+#include "engine/resource_manager.h"
+#include "engine/string.h"
+#include "engine/universe.h"
+#include "renderer/model.h"
+#include "renderer/render_scene.h"
+#include "renderer/renderer.h"
+#include "renderer/terrain.h"
+#include "renderer/texture.h"
+
+#include <math.h>
+#include <stdio.h>
+
+// rays cast against a heightmap terrain, the min/max height tree skips blocks the ray passes above or below;
+// results are compared with testing every triangle of the terrain, which is also timed as the baseline
+
+namespace Lumix::benchmark {
+
+static constexpr u32 SIZE = 1025;
+static constexpr u32 RAYS_COUNT = 10'000;
+static constexpr u32 REFERENCE_RAYS_COUNT = 16;
+static constexpr u32 HEIGHTS_COUNT = 100'000;
+static constexpr u32 BRUSH_SIZE = 64;
+static constexpr u32 BRUSHES_COUNT = 1000;
+
+struct Ray {
+	DVec3 origin;
+	Vec3 dir;
+};
+
+// the same triangles as Terrain::castRay, terrain is at the origin and not rotated
+static float castRayAllTriangles(const Terrain& terrain, const Ray& ray) {
+	const Vec3 origin = Vec3(ray.origin);
+	const float s = terrain.getXZScale();
+	float best_t = FLT_MAX;
+	for (i32 j = 0; j < terrain.getHeight() - 1; ++j) {
+		for (i32 i = 0; i < terrain.getWidth() - 1; ++i) {
+			const float x0 = i * s;
+			const float z0 = j * s;
+			const Vec3 p0(x0, terrain.getHeight(i, j), z0);
+			const Vec3 p1(x0 + s, terrain.getHeight(i + 1, j), z0);
+			const Vec3 p2(x0 + s, terrain.getHeight(i + 1, j + 1), z0 + s);
+			const Vec3 p3(x0, terrain.getHeight(i, j + 1), z0 + s);
+			float t;
+			if (getRayTriangleIntersection(origin, ray.dir, p0, p1, p2, &t) && t < best_t) best_t = t;
+			if (getRayTriangleIntersection(origin, ray.dir, p0, p2, p3, &t) && t < best_t) best_t = t;
+		}
+	}
+	return best_t;
+}
+
+static bool isSameHit(const RayCastModelHit& hit, float reference_t) {
+	if (reference_t == FLT_MAX) return !hit.is_hit;
+	return hit.is_hit && fabsf(hit.t - reference_t) <= 1e-3f * maximum(1.f, reference_t);
+}
+
+static void castRays(RenderScene& scene, const Terrain& terrain, EntityRef entity, const char* name, const Array<Ray>& rays) {
+	const char* group = "terrain 1025x1025";
+	u32 hits = 0;
+	u64 start = os::Timer::getRawTimestamp();
+	for (const Ray& ray : rays) {
+		if (scene.castRayTerrain(entity, ray.origin, ray.dir).is_hit) ++hits;
+	}
+	print(group, name, os::Timer::getRawTimestamp() - start, rays.size());
+	printf("%-40s %-16s %10u hits\n", group, name, hits);
+
+	u32 errors = 0;
+	u64 reference_ticks = 0;
+	for (u32 i = 0; i < REFERENCE_RAYS_COUNT; ++i) {
+		const Ray& ray = rays[i * (rays.size() / REFERENCE_RAYS_COUNT)];
+		start = os::Timer::getRawTimestamp();
+		const float reference_t = castRayAllTriangles(terrain, ray);
+		reference_ticks += os::Timer::getRawTimestamp() - start;
+		if (!isSameHit(scene.castRayTerrain(entity, ray.origin, ray.dir), reference_t)) ++errors;
+	}
+	const StaticString<64> reference_name(name, " all tris");
+	print(group, reference_name, reference_ticks, REFERENCE_RAYS_COUNT);
+	if (errors > 0) printf("%-40s %-16s %u wrong hits\n", group, name, errors);
+}
+
+void terrain(IAllocator& allocator) {
+	Engine::InitArgs init_args;
+	init_args.window_title = "Lumix benchmark";
+	UniquePtr<Engine> engine = Engine::create(static_cast<Engine::InitArgs&&>(init_args), allocator);
+	Renderer* renderer = static_cast<Renderer*>(engine->getPluginManager().getPlugin("renderer"));
+	if (!renderer) {
+		printf("%-40s renderer plugin not found\n", "terrain");
+		return;
+	}
+
+	Universe& universe = engine->createUniverse(true);
+	const ComponentType type = reflection::getComponentType("terrain");
+	RenderScene* scene = static_cast<RenderScene*>(universe.getScene(type));
+	const EntityRef entity = universe.createEntity(DVec3(0), Quat::IDENTITY);
+	universe.createComponent(type, entity);
+	Terrain* terrain = scene->getTerrain(entity);
+
+	// rolling hills
+	Array<u16> pixels(allocator);
+	pixels.resize(SIZE * SIZE);
+	for (u32 j = 0; j < SIZE; ++j) {
+		for (u32 i = 0; i < SIZE; ++i) {
+			const float h = 0.5f + 0.25f * sinf(i * 0.013f) * cosf(j * 0.011f) + 0.1f * sinf(i * 0.07f + j * 0.05f);
+			pixels[i + j * SIZE] = u16(h * 65535);
+		}
+	}
+	ResourceManager& texture_manager = *engine->getResourceManager().get(Texture::TYPE);
+	Texture* heightmap = LUMIX_NEW(allocator, Texture)(Path("benchmark_heightmap"), texture_manager, *renderer, allocator);
+	heightmap->create(SIZE, SIZE, gpu::TextureFormat::R16, pixels.begin(), pixels.byte_size());
+	// terrain reads heights on CPU
+	heightmap->format = gpu::TextureFormat::R16;
+	heightmap->data.write(pixels.begin(), pixels.byte_size());
+	terrain->m_heightmap = heightmap;
+	terrain->m_width = SIZE;
+	terrain->m_height = SIZE;
+
+	u32 rnd = 0x12345678;
+	auto random = [&rnd](){
+		rnd = rnd * 1664525 + 1013904223;
+		return float(rnd >> 8) / float(1 << 24);
+	};
+	const float size = float(SIZE - 1);
+
+	// the tree is built by the first ray
+	scene->castRayTerrain(entity, DVec3(size * 0.5f, 200, size * 0.5f), Vec3(0, -1, 0));
+
+	// mouse picking, steep rays from above
+	Array<Ray> rays(allocator);
+	for (u32 i = 0; i < RAYS_COUNT; ++i) {
+		Ray& ray = rays.emplace();
+		ray.origin = DVec3(random() * size, 200, random() * size);
+		ray.dir = normalize(Vec3(random() - 0.5f, -1, random() - 0.5f));
+	}
+	castRays(*scene, *terrain, entity, "pick", rays);
+
+	// rays along the terrain, e.g. line of sight, these pass over many blocks
+	rays.clear();
+	for (u32 i = 0; i < RAYS_COUNT; ++i) {
+		Ray& ray = rays.emplace();
+		ray.origin = DVec3(0, 60 + random() * 30, random() * size);
+		ray.dir = normalize(Vec3(1, -0.02f * random(), random() - 0.5f));
+	}
+	castRays(*scene, *terrain, entity, "grazing", rays);
+
+	const char* group = "terrain 1025x1025";
+	u32 errors = 0;
+	Array<Vec2> xz(allocator);
+	Array<float> heights(allocator);
+	xz.resize(HEIGHTS_COUNT);
+	heights.resize(HEIGHTS_COUNT);
+	for (Vec2& p : xz) p = Vec2(random() * size, random() * size);
+	u64 start = os::Timer::getRawTimestamp();
+	for (u32 i = 0; i < HEIGHTS_COUNT; ++i) heights[i] = scene->getTerrainHeightAt(entity, xz[i].x, xz[i].y);
+	print(group, "height", os::Timer::getRawTimestamp() - start, HEIGHTS_COUNT);
+	start = os::Timer::getRawTimestamp();
+	scene->getTerrainHeightsAt(entity, xz, heights);
+	print(group, "heights batch", os::Timer::getRawTimestamp() - start, HEIGHTS_COUNT);
+	for (u32 i = 0; i < HEIGHTS_COUNT; ++i) {
+		if (fabsf(heights[i] - terrain->getHeight(xz[i].x, xz[i].y)) > 1e-3f) ++errors;
+	}
+
+	// terrain editor's brush changes a block of heightmap and updates the tree
+	u16* data = (u16*)heightmap->getData();
+	start = os::Timer::getRawTimestamp();
+	for (u32 i = 0; i < BRUSHES_COUNT; ++i) {
+		const i32 x = i32(random() * (SIZE - BRUSH_SIZE));
+		const i32 z = i32(random() * (SIZE - BRUSH_SIZE));
+		terrain->updateHeightTree(x, z, BRUSH_SIZE, BRUSH_SIZE);
+	}
+	print(group, "brush update", os::Timer::getRawTimestamp() - start, BRUSHES_COUNT);
+
+	// a raised block must be hit at its new height
+	for (u32 j = 500; j < 500 + BRUSH_SIZE; ++j) {
+		for (u32 i = 500; i < 500 + BRUSH_SIZE; ++i) data[i + j * SIZE] = 0xffFF;
+	}
+	terrain->updateHeightTree(500, 500, BRUSH_SIZE, BRUSH_SIZE);
+	const RayCastModelHit raised = scene->castRayTerrain(entity, DVec3(532, 200, 532), Vec3(0, -1, 0));
+	if (!raised.is_hit || fabsf(raised.t - (200 - terrain->getYScale())) > 1e-2f) ++errors;
+
+	if (errors > 0) printf("%-40s %u wrong heights or hits\n", group, errors);
+	terrain->m_heightmap = nullptr;
+	engine->destroyUniverse(universe);
+	heightmap->destroy();
+	LUMIX_DELETE(allocator, heightmap);
+}
+
+} // namespace Lumix::benchmark
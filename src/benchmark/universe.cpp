@@ -0,0 +1,66 @@
+#include "benchmark/benchmark.h"
+#include "engine/allocators.h"
+#include "engine/array.h"
+#include "engine/engine.h"
+#include "engine/file_system.h"
+#include "engine/os.h"
+#include "engine/stream.h"
+#include "engine/universe.h"
+
+// creates, serializes and deserializes a universe of 1M entities, only the engine is loaded, there are no plugins' scenes
+
+namespace Lumix::benchmark {
+
+static constexpr u32 ENTITIES_COUNT = 1'000'000;
+
+void universe(IAllocator& allocator) {
+	Engine::InitArgs init_args;
+	init_args.window_title = "Lumix benchmark";
+	UniquePtr<Engine> engine = Engine::create(static_cast<Engine::InitArgs&&>(init_args), allocator);
+	OutputMemoryStream blob(allocator);
+
+	{
+		Universe& universe = engine->createUniverse(false);
+		u64 start = os::Timer::getRawTimestamp();
+		for (u32 i = 0; i < ENTITIES_COUNT; ++i) {
+			universe.createEntity(DVec3((double)i, 0, 0), Quat::IDENTITY);
+		}
+		print("universe 1M entities", "createEntity", os::Timer::getRawTimestamp() - start, ENTITIES_COUNT);
+
+		// every 16th entity is a named parent of the next 15
+		for (u32 i = 0; i < ENTITIES_COUNT; ++i) {
+			const EntityRef e = { (i32)i };
+			if (i % 16 == 0) universe.setEntityName(e, "parent");
+			else universe.setParent(EntityRef{ (i32)(i - i % 16) }, e);
+		}
+
+		start = os::Timer::getRawTimestamp();
+		engine->serialize(universe, blob);
+		print("universe 1M entities", "serialize", os::Timer::getRawTimestamp() - start, ENTITIES_COUNT);
+		engine->destroyUniverse(universe);
+	}
+
+	{
+		Universe& universe = engine->createUniverse(false);
+		Array<EntityRef> entities(allocator);
+		entities.resize(ENTITIES_COUNT);
+		const u64 start = os::Timer::getRawTimestamp();
+		universe.createEntities(entities);
+		print("universe 1M entities", "createEntities", os::Timer::getRawTimestamp() - start, ENTITIES_COUNT);
+		engine->destroyUniverse(universe);
+	}
+
+	{
+		Universe& universe = engine->createUniverse(false);
+		EntityMap entity_map(allocator);
+		InputMemoryStream input(blob);
+		const u64 start = os::Timer::getRawTimestamp();
+		if (!engine->deserialize(universe, input, entity_map)) {
+			print("universe 1M entities", "deserialize failed", 0, 1);
+		}
+		print("universe 1M entities", "deserialize", os::Timer::getRawTimestamp() - start, ENTITIES_COUNT);
+		engine->destroyUniverse(universe);
+	}
+}
+
+} // namespace Lumix::benchmark
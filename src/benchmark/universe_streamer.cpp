@@ -0,0 +1,282 @@
+#include "benchmark/benchmark.h"
+#include "engine/allocators.h"
+#include "engine/array.h"
+#include "engine/crc32.h"
+#include "engine/engine.h"
+#include "engine/file_system.h"
+#include "engine/hash_map.h"
+#include "engine/os.h"
+#include "engine/plugin.h"
+#include "engine/reflection.h"
+#include "engine/stream.h"
+#include "engine/string.h"
+#include "engine/universe.h"
+#include "engine/universe_streamer.h"
+
+#include <stdio.h>
+
+// exports a row of sectors, each entity references entities in the neighbouring sectors,
+// then a focus point sweeps along the row and references are checked after every step
+
+namespace Lumix::benchmark {
+
+static constexpr u32 SECTORS_COUNT = 16;
+static constexpr u32 SECTOR_ENTITIES_COUNT = 2'000;
+static constexpr float SECTOR_SIZE = 100;
+static constexpr const char* BASENAME = "_benchmark_streamer";
+
+static const ComponentType LINK_TYPE = reflection::getComponentType("benchmark_link");
+
+namespace {
+
+struct LinkPlugin;
+
+struct Link {
+	EntityPtr next; // same entity in the next sector
+	EntityPtr prev; // same entity in the previous sector, the global entity in the first sector
+};
+
+struct LinkScene : IScene {
+	LinkScene(IPlugin& plugin, Universe& universe, IAllocator& allocator)
+		: m_plugin(plugin)
+		, m_universe(universe)
+		, m_links(allocator)
+	{}
+
+	void serialize(OutputMemoryStream& blob) override {
+		blob.write((u32)m_links.size());
+		for (auto iter = m_links.begin(), end = m_links.end(); iter != end; ++iter) {
+			blob.write(iter.key());
+			blob.write(iter.value());
+		}
+	}
+
+	void deserialize(InputMemoryStream& blob, const EntityMap& entity_map, i32 version) override {
+		const u32 count = blob.read<u32>();
+		for (u32 i = 0; i < count; ++i) {
+			const EntityRef e = entity_map.get(blob.read<EntityRef>());
+			Link link = blob.read<Link>();
+			link.next = entity_map.get(link.next);
+			link.prev = entity_map.get(link.prev);
+			m_links.insert(e, link);
+			m_universe.onComponentCreated(e, LINK_TYPE, this);
+		}
+	}
+
+	void createLink(EntityRef e) {
+		m_links.insert(e, {INVALID_ENTITY, INVALID_ENTITY});
+		m_universe.onComponentCreated(e, LINK_TYPE, this);
+	}
+
+	void destroyLink(EntityRef e) {
+		m_links.erase(e);
+		m_universe.onComponentDestroyed(e, LINK_TYPE, this);
+	}
+
+	EntityPtr getNext(EntityRef e) { return m_links[e].next; }
+	void setNext(EntityRef e, EntityPtr value) { m_links[e].next = value; }
+	EntityPtr getPrev(EntityRef e) { return m_links[e].prev; }
+	void setPrev(EntityRef e, EntityPtr value) { m_links[e].prev = value; }
+
+	IPlugin& getPlugin() const override { return m_plugin; }
+	Universe& getUniverse() override { return m_universe; }
+	void update(float time_delta, bool paused) override {}
+	void clear() override { m_links.clear(); }
+
+	IPlugin& m_plugin;
+	Universe& m_universe;
+	HashMap<EntityRef, Link> m_links;
+};
+
+struct LinkPlugin : IPlugin {
+	explicit LinkPlugin(IAllocator& allocator) : m_allocator(allocator) {}
+
+	const char* getName() const override { return "benchmark_link"; }
+	u32 getVersion() const override { return 0; }
+	void serialize(OutputMemoryStream& serializer) const override {}
+	bool deserialize(u32 version, InputMemoryStream& serializer) override { return version == 0; }
+	void createScenes(Universe& universe) override {
+		universe.addScene(UniquePtr<LinkScene>::create(m_allocator, *this, universe, m_allocator));
+	}
+
+	IAllocator& m_allocator;
+};
+
+} // anonymous namespace
+
+// persistent ID of the i-th entity of a sector, 0 is the global entity
+static u32 persistentID(u32 sector, u32 i) { return 1 + sector * SECTOR_ENTITIES_COUNT + i; }
+
+// same layout as WorldEditor::saveSectors writes
+static bool exportSectors(Engine& engine, IAllocator& allocator) {
+	FileSystem& fs = engine.getFileSystem();
+	char dir[LUMIX_MAX_PATH];
+	fs.makeAbsolute(Span(dir), StaticString<LUMIX_MAX_PATH>("universes/", BASENAME));
+	if (!os::dirExists(dir) && !os::makePath(dir)) return false;
+
+	auto save = [&](const char* path, const OutputMemoryStream& blob){
+		os::OutputFile file;
+		if (!fs.open(path, file)) return false;
+		const bool res = file.write(blob.data(), blob.size());
+		file.close();
+		return res;
+	};
+
+	OutputMemoryStream manifest(allocator);
+	SectorManifestHeader header;
+	header.sector_size = SECTOR_SIZE;
+	header.sectors_count = SECTORS_COUNT + 1;
+	manifest.write(header);
+
+	OutputMemoryStream blob(allocator);
+	{
+		Universe& universe = engine.createUniverse(false);
+		universe.emplaceEntity(EntityRef{0});
+		universe.setTransform(EntityRef{0}, DVec3(0, 0, -1000), Quat::IDENTITY, 1);
+		engine.serialize(universe, blob);
+		engine.destroyUniverse(universe);
+		if (!save(StaticString<LUMIX_MAX_PATH>("universes/", BASENAME, "/global.sec"), blob)) return false;
+
+		SectorManifestEntry entry;
+		entry.coord = IVec2(0);
+		entry.flags = SectorManifestEntry::GLOBAL;
+		entry.entities_count = 1;
+		manifest.write(entry);
+		manifest.write((u32)0);
+		manifest.write((u32)0);
+	}
+
+	for (u32 sector = 0; sector < SECTORS_COUNT; ++sector) {
+		Universe& universe = engine.createUniverse(false);
+		LinkScene* scene = (LinkScene*)universe.getScene(LINK_TYPE);
+		SectorManifestEntry entry;
+		entry.coord = IVec2(sector, 0);
+		entry.flags = SectorManifestEntry::NONE;
+		entry.entities_count = SECTOR_ENTITIES_COUNT;
+		manifest.write(entry);
+		for (u32 i = 0; i < SECTOR_ENTITIES_COUNT; ++i) {
+			const EntityRef e = {(i32)persistentID(sector, i)};
+			universe.emplaceEntity(e);
+			const DVec3 pos(sector * SECTOR_SIZE + (i % 100) * 0.5f, 0, (i / 100) * 0.5f);
+			universe.setTransform(e, pos, Quat::IDENTITY, 1);
+			universe.createComponent(LINK_TYPE, e);
+			// raw persistent IDs, other sectors' entities are resolved by the streamer
+			if (sector + 1 < SECTORS_COUNT) scene->setNext(e, EntityPtr{(i32)persistentID(sector + 1, i)});
+			scene->setPrev(e, sector > 0 ? EntityPtr{(i32)persistentID(sector - 1, i)} : EntityPtr{0});
+			manifest.write(e.index);
+		}
+
+		const u32 refs_count = SECTOR_ENTITIES_COUNT * (sector + 1 < SECTORS_COUNT ? 2 : 1);
+		manifest.write(refs_count);
+		for (u32 i = 0; i < SECTOR_ENTITIES_COUNT; ++i) {
+			const u32 id = persistentID(sector, i);
+			const SectorEntityRef prev = {id, crc32("benchmark_link"), 0, crc32("Previous"), -1, sector > 0 ? persistentID(sector - 1, i) : 0};
+			manifest.write(prev);
+			if (sector + 1 == SECTORS_COUNT) continue;
+			const SectorEntityRef next = {id, crc32("benchmark_link"), 0, crc32("Next"), -1, persistentID(sector + 1, i)};
+			manifest.write(next);
+		}
+
+		blob.clear();
+		engine.serialize(universe, blob);
+		engine.destroyUniverse(universe);
+		const StaticString<LUMIX_MAX_PATH> path("universes/", BASENAME, "/", sector, "_0.sec");
+		if (!save(path, blob)) return false;
+	}
+	return save(StaticString<LUMIX_MAX_PATH>("universes/", BASENAME, "/sectors.lsm"), manifest);
+}
+
+static void deleteSectors(Engine& engine) {
+	FileSystem& fs = engine.getFileSystem();
+	fs.deleteFile(StaticString<LUMIX_MAX_PATH>("universes/", BASENAME, "/sectors.lsm"));
+	fs.deleteFile(StaticString<LUMIX_MAX_PATH>("universes/", BASENAME, "/global.sec"));
+	for (u32 sector = 0; sector < SECTORS_COUNT; ++sector) {
+		fs.deleteFile(StaticString<LUMIX_MAX_PATH>("universes/", BASENAME, "/", sector, "_0.sec"));
+	}
+}
+
+// returns the number of wrong references and entities
+static u32 check(UniverseStreamer& streamer, LinkScene& scene, u32 focus_sector) {
+	const EntityMap& map = streamer.getEntityMap();
+	auto runtime = [&](u32 sector, u32 i) { return map.get(EntityPtr{(i32)persistentID(sector, i)}); };
+	auto isLoaded = [&](i32 sector) { return sector >= 0 && sector < (i32)SECTORS_COUNT && sector + 1 >= (i32)focus_sector && sector <= (i32)focus_sector + 1; };
+
+	u32 errors = map.get(EntityPtr{0}).isValid() ? 0 : 1;
+	for (u32 sector = 0; sector < SECTORS_COUNT; ++sector) {
+		const bool loaded = isLoaded(sector);
+		for (u32 i = 0; i < SECTOR_ENTITIES_COUNT; ++i) {
+			const EntityPtr e = runtime(sector, i);
+			if (e.isValid() != loaded) {
+				++errors;
+				continue;
+			}
+			if (!loaded) continue;
+
+			const Link& link = scene.m_links[(EntityRef)e];
+			const EntityPtr next = isLoaded(sector + 1) ? runtime(sector + 1, i) : INVALID_ENTITY;
+			const EntityPtr prev = sector == 0 ? map.get(EntityPtr{0}) : (isLoaded(sector - 1) ? runtime(sector - 1, i) : INVALID_ENTITY);
+			if (link.next != next) ++errors;
+			if (link.prev != prev) ++errors;
+		}
+	}
+	return errors;
+}
+
+void universeStreamer(IAllocator& allocator) {
+	reflection::build_scene("benchmark_link")
+		.cmp<&LinkScene::createLink, &LinkScene::destroyLink>("benchmark_link", "Benchmark link")
+			.prop<&LinkScene::getNext, &LinkScene::setNext>("Next")
+			.prop<&LinkScene::getPrev, &LinkScene::setPrev>("Previous");
+
+	Engine::InitArgs init_args;
+	init_args.window_title = "Lumix benchmark";
+	UniquePtr<Engine> engine = Engine::create(static_cast<Engine::InitArgs&&>(init_args), allocator);
+	engine->getPluginManager().addPlugin(LUMIX_NEW(engine->getAllocator(), LinkPlugin)(engine->getAllocator()));
+
+	if (!exportSectors(*engine, allocator)) {
+		printf("%-40s could not write sectors\n", "universe streamer");
+		deleteSectors(*engine);
+		return;
+	}
+
+	Universe& universe = engine->createUniverse(true);
+	LinkScene* scene = (LinkScene*)universe.getScene(LINK_TYPE);
+	UniquePtr<UniverseStreamer> streamer = UniverseStreamer::create(*engine, universe, allocator);
+	// the focused sector and its neighbours are loaded
+	streamer->setDistances(SECTOR_SIZE * 0.6f, SECTOR_SIZE * 0.7f);
+	streamer->setBudget(FLT_MAX);
+	if (!streamer->load(BASENAME)) {
+		printf("%-40s could not load sectors\n", "universe streamer");
+		streamer.reset();
+		engine->destroyUniverse(universe);
+		deleteSectors(*engine);
+		return;
+	}
+
+	FileSystem& fs = engine->getFileSystem();
+	u32 errors = 0;
+	u64 ticks = 0;
+	for (u32 pass = 0; pass < 2; ++pass) {
+		for (u32 step = 0; step < SECTORS_COUNT; ++step) {
+			// forward, then backward, so sectors are reloaded and their references set again
+			const u32 sector = pass == 0 ? step : SECTORS_COUNT - 1 - step;
+			const DVec3 focus(sector * SECTOR_SIZE + SECTOR_SIZE * 0.5f, 0, SECTOR_SIZE * 0.5f);
+			streamer->setFocusPoints(Span(&focus, 1));
+			const u64 start = os::Timer::getRawTimestamp();
+			do {
+				fs.processCallbacks();
+				streamer->update();
+			} while (streamer->isLoading());
+			ticks += os::Timer::getRawTimestamp() - start;
+			errors += check(*streamer, *scene, sector);
+		}
+	}
+	print("universe streamer 16 sectors", "sweep", ticks, 2 * SECTORS_COUNT * SECTOR_ENTITIES_COUNT);
+	if (errors > 0) printf("%-40s %u wrong entities or references\n", "universe streamer 16 sectors", errors);
+
+	streamer.reset();
+	engine->destroyUniverse(universe);
+	deleteSectors(*engine);
+}
+
+} // namespace Lumix::benchmark
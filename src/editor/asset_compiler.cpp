@@ -11,6 +11,7 @@
 #include "engine/log.h"
 #include "engine/lua_wrapper.h"
 #include "engine/atomic.h"
+#include "engine/job_system.h"
 #include "engine/sync.h"
 #include "engine/thread.h"
 #include "engine/os.h"
@@ -40,6 +41,37 @@ struct HashFunc<Path>
 };
 
 
+// .lumix/assets/_list.bin - header, resources, dependencies and string data
+// records have fixed size and refer to strings by offset, so the file can be used in place
+struct AssetDBHeader {
+	static constexpr u32 MAGIC = '_LAD';
+	enum class Version : u32 {
+		FIRST,
+
+		LATEST // keep this last
+	};
+
+	u32 magic = MAGIC;
+	Version version = Version::LATEST;
+	u32 resources_count;
+	u32 dependencies_count;
+	u64 strings_size;
+};
+
+struct AssetDBResource {
+	u32 path; // offset in strings
+	u32 type;
+	// of the source file, used to find files changed since the last session
+	u64 last_modified;
+	u64 size;
+};
+
+struct AssetDBDependency {
+	u32 dependency;
+	u32 included_from;
+};
+
+
 struct AssetCompilerTask : Thread
 {
 	AssetCompilerTask(AssetCompilerImpl& compiler, IAllocator& allocator) 
@@ -76,6 +108,16 @@ struct AssetCompilerImpl : AssetCompiler
 		Path path;
 	};
 
+	struct FileStamp {
+		u64 last_modified;
+		u64 size;
+	};
+
+	struct ScannedFile {
+		Path path;
+		FileStamp stamp;
+	};
+
 	struct LoadHook : ResourceManagerHub::LoadHook
 	{
 		LoadHook(AssetCompilerImpl& compiler) : compiler(compiler) {}
@@ -104,6 +146,7 @@ struct AssetCompilerImpl : AssetCompiler
 		, m_changed_files(app.getAllocator())
 		, m_on_list_changed(app.getAllocator())
 		, m_on_init_load(app.getAllocator())
+		, m_file_stamps(app.getAllocator())
 	{
 		Engine& engine = app.getEngine();
 		FileSystem& fs = engine.getFileSystem();
@@ -119,31 +162,7 @@ struct AssetCompilerImpl : AssetCompiler
 
 	~AssetCompilerImpl()
 	{
-		os::OutputFile file;
-		FileSystem& fs = m_app.getEngine().getFileSystem();
-		if (fs.open(".lumix/assets/_list.txt_tmp", file)) {
-			file << "resources = {\n";
-			for (const ResourceItem& ri : m_resources) {
-				file << "\"" << ri.path.c_str() << "\",\n";
-			}
-			file << "}\n\n";
-			file << "dependencies = {\n";
-			for (auto iter = m_dependencies.begin(), end = m_dependencies.end(); iter != end; ++iter) {
-				file << "\t[\"" << iter.key().c_str() << "\"] = {\n";
-				for (const Path& p : iter.value()) {
-					file << "\t\t\"" << p.c_str() << "\",\n";
-				}
-				file << "\t},\n";
-			}
-			file << "}\n";
-
-			file.close();
-			fs.deleteFile(".lumix/assets/_list.txt");
-			fs.moveFile(".lumix/assets/_list.txt_tmp", ".lumix/assets/_list.txt");
-		}
-		else {
-			logError("Could not save .lumix/assets/_list.txt");
-		}
+		saveDB();
 
 		ASSERT(m_plugins.empty());
 		m_task.m_finished = true;
@@ -162,6 +181,7 @@ struct AssetCompilerImpl : AssetCompiler
 		m_watcher->getCallback().bind<&AssetCompilerImpl::onFileChanged>(this);
 		m_dependencies.clear();
 		m_resources.clear();
+		m_file_stamps.clear();
 		fillDB();
 	}
 
@@ -255,44 +275,49 @@ struct AssetCompilerImpl : AssetCompiler
 	}
 
 	
-	void processDir(const char* dir, u64 list_last_modified)
-	{
+	// stats the whole project tree, directories of each level are processed in parallel
+	void scanFiles(Array<ScannedFile>& files) {
+		PROFILE_FUNCTION();
 		FileSystem& fs = m_app.getEngine().getFileSystem();
-		auto* iter = fs.createFileIterator(dir);
-		os::FileInfo info;
-		while (getNextFile(iter, &info))
-		{
-			if (info.filename[0] == '.') continue;
-
-			if (info.is_directory)
-			{
-				char child_path[LUMIX_MAX_PATH];
-				copyString(child_path, dir);
-				if(dir[0]) catString(child_path, "/");
-				catString(child_path, info.filename);
-				processDir(child_path, list_last_modified);
-			}
-			else
-			{
-				char fullpath[LUMIX_MAX_PATH];
-				copyString(fullpath, dir);
-				if(dir[0]) catString(fullpath, "/");
-				catString(fullpath, info.filename);
-				makeLowercase(Span(fullpath), fullpath);
-
-				if (fs.getLastModified(fullpath[0] == '/' ? fullpath + 1 : fullpath) > list_last_modified) {
-					addResource(fullpath);
-				}
-				else {
-					Path path(fullpath[0] == '/' ? fullpath + 1 : fullpath);
-					if (!m_resources.find(path.getHash()).isValid()) {
-						addResource(fullpath);
+		const char* base_path = fs.getBasePath();
+		IAllocator& allocator = m_app.getAllocator();
+		Array<StaticString<LUMIX_MAX_PATH>> dirs(allocator);
+		Array<StaticString<LUMIX_MAX_PATH>> subdirs(allocator);
+		Mutex mutex;
+		dirs.emplace();
+		while (!dirs.empty()) {
+			jobs::forEach(dirs.size(), 1, [&](i32 idx, i32){
+				PROFILE_BLOCK("scan dir");
+				const char* dir = dirs[idx];
+				Array<ScannedFile> dir_files(allocator);
+				Array<StaticString<LUMIX_MAX_PATH>> dir_subdirs(allocator);
+				os::FileIterator* iter = fs.createFileIterator(dir);
+				os::FileInfo info;
+				while (os::getNextFile(iter, &info)) {
+					if (info.filename[0] == '.') continue;
+
+					StaticString<LUMIX_MAX_PATH> path(dir, dir[0] ? "/" : "", info.filename);
+					if (info.is_directory) {
+						dir_subdirs.push(path);
+						continue;
 					}
+
+					const StaticString<LUMIX_MAX_PATH> fullpath(base_path, path);
+					ScannedFile& file = dir_files.emplace();
+					file.stamp.last_modified = os::getLastModified(fullpath);
+					file.stamp.size = os::getFileSize(fullpath);
+					makeLowercase(Span(path.data), path);
+					file.path = path;
 				}
-			}
+				os::destroyFileIterator(iter);
+
+				MutexGuard lock(mutex);
+				for (ScannedFile& file : dir_files) files.push(static_cast<ScannedFile&&>(file));
+				for (const auto& subdir : dir_subdirs) subdirs.push(subdir);
+			});
+			dirs.clear();
+			dirs.swap(subdirs);
 		}
-
-		destroyFileIterator(iter);
 	}
 
 
@@ -307,7 +332,131 @@ struct AssetCompilerImpl : AssetCompiler
 		iter.value().push(included_from);
 	}
 
-	void fillDB() {
+	bool loadDB(HashMap<u32, FileStamp, HashFuncDirect<u32>>& stamps) {
+		PROFILE_FUNCTION();
+		FileSystem& fs = m_app.getEngine().getFileSystem();
+		OutputMemoryStream content(m_app.getAllocator());
+		if (!fs.getContentSync(Path(".lumix/assets/_list.bin"), content)) return false;
+
+		AssetDBHeader header;
+		if (content.size() < sizeof(header)) return false;
+		memcpy(&header, content.data(), sizeof(header));
+		if (header.magic != AssetDBHeader::MAGIC || header.version != AssetDBHeader::Version::LATEST) return false;
+
+		const u64 resources_offset = sizeof(header);
+		const u64 dependencies_offset = resources_offset + header.resources_count * sizeof(AssetDBResource);
+		const u64 strings_offset = dependencies_offset + header.dependencies_count * sizeof(AssetDBDependency);
+		if (content.size() != strings_offset + header.strings_size || header.strings_size == 0) {
+			logError(".lumix/assets/_list.bin is corrupted");
+			return false;
+		}
+
+		const AssetDBResource* resources = (const AssetDBResource*)(content.data() + resources_offset);
+		const AssetDBDependency* dependencies = (const AssetDBDependency*)(content.data() + dependencies_offset);
+		const char* strings = (const char*)content.data() + strings_offset;
+		if (strings[header.strings_size - 1] != '\0') {
+			logError(".lumix/assets/_list.bin is corrupted");
+			return false;
+		}
+		auto getString = [&](u32 offset) { return offset < header.strings_size ? strings + offset : ""; };
+
+		{
+			MutexGuard lock(m_resources_mutex);
+			m_resources.reserve(header.resources_count);
+			for (u32 i = 0; i < header.resources_count; ++i) {
+				const AssetDBResource& r = resources[i];
+				const Path path(getString(r.path));
+				const ResourceType type = getResourceType(path.c_str());
+				// plugin for the type might not be loaded anymore
+				if (!type.isValid() || type.type != r.type) continue;
+
+				#ifdef CACHE_MASTER 
+					StaticString<LUMIX_MAX_PATH> res_path(".lumix/assets/", path.getHash(), ".res");
+					if (!fs.fileExists(res_path)) continue;
+				#endif
+				m_resources.insert(path.getHash(), {path, type, dirHash(path.c_str())});
+
+				const u32 file_hash = crc32(getResourceFilePath(path.c_str()));
+				if (!stamps.find(file_hash).isValid()) stamps.insert(file_hash, {r.last_modified, r.size});
+			}
+		}
+
+		IAllocator& allocator = m_app.getAllocator();
+		for (u32 i = 0; i < header.dependencies_count; ++i) {
+			const Path dependency(getString(dependencies[i].dependency));
+			auto iter = m_dependencies.find(dependency);
+			if (!iter.isValid()) {
+				m_dependencies.insert(dependency, Array<Path>(allocator));
+				iter = m_dependencies.find(dependency);
+			}
+			iter.value().push(Path(getString(dependencies[i].included_from)));
+		}
+		return true;
+	}
+
+	void saveDB() {
+		PROFILE_FUNCTION();
+		IAllocator& allocator = m_app.getAllocator();
+		OutputMemoryStream strings(allocator);
+		HashMap<u32, u32, HashFuncDirect<u32>> string_offsets(allocator);
+		auto addString = [&](const Path& path) -> u32 {
+			auto iter = string_offsets.find(path.getHash());
+			if (iter.isValid()) return iter.value();
+			const u32 offset = (u32)strings.size();
+			strings.write(path.c_str(), path.length() + 1);
+			string_offsets.insert(path.getHash(), offset);
+			return offset;
+		};
+
+		Array<AssetDBResource> resources(allocator);
+		resources.reserve(m_resources.size());
+		for (const ResourceItem& ri : m_resources) {
+			AssetDBResource& r = resources.emplace();
+			r.path = addString(ri.path);
+			r.type = ri.type.type;
+			// files added during this session have no stamp and are checked again next time
+			auto iter = m_file_stamps.find(crc32(getResourceFilePath(ri.path.c_str())));
+			r.last_modified = iter.isValid() ? iter.value().last_modified : 0;
+			r.size = iter.isValid() ? iter.value().size : 0;
+		}
+
+		Array<AssetDBDependency> dependencies(allocator);
+		for (auto iter = m_dependencies.begin(), end = m_dependencies.end(); iter != end; ++iter) {
+			for (const Path& p : iter.value()) {
+				AssetDBDependency& d = dependencies.emplace();
+				d.dependency = addString(iter.key());
+				d.included_from = addString(p);
+			}
+		}
+		if (strings.empty()) strings.write('\0');
+
+		AssetDBHeader header;
+		header.resources_count = resources.size();
+		header.dependencies_count = dependencies.size();
+		header.strings_size = strings.size();
+
+		os::OutputFile file;
+		FileSystem& fs = m_app.getEngine().getFileSystem();
+		if (!fs.open(".lumix/assets/_list.bin_tmp", file)) {
+			logError("Could not save .lumix/assets/_list.bin");
+			return;
+		}
+		bool success = file.write(&header, sizeof(header));
+		success = file.write(resources.begin(), resources.byte_size()) && success;
+		success = file.write(dependencies.begin(), dependencies.byte_size()) && success;
+		success = file.write(strings.data(), strings.size()) && success;
+		file.close();
+		if (!success) {
+			logError("Could not save .lumix/assets/_list.bin");
+			return;
+		}
+		fs.deleteFile(".lumix/assets/_list.bin");
+		fs.moveFile(".lumix/assets/_list.bin_tmp", ".lumix/assets/_list.bin");
+		fs.deleteFile(".lumix/assets/_list.txt");
+	}
+
+	// _list.txt from older versions, does not have file stamps so all files are added again
+	void loadLegacyList() {
 		FileSystem& fs = m_app.getEngine().getFileSystem();
 		const StaticString<LUMIX_MAX_PATH> list_path(fs.getBasePath(), ".lumix/assets/_list.txt");
 		OutputMemoryStream content(m_app.getAllocator());
@@ -384,20 +533,59 @@ struct AssetCompilerImpl : AssetCompiler
 			lua_close(L);
 		}
 
-		const u64 list_last_modified = os::getLastModified(list_path);
-		processDir("", list_last_modified);
+	}
+
+	void fillDB() {
+		PROFILE_FUNCTION();
+		HashMap<u32, FileStamp, HashFuncDirect<u32>> stamps(m_app.getAllocator());
+		if (!loadDB(stamps)) loadLegacyList();
+
+		Array<ScannedFile> files(m_app.getAllocator());
+		scanFiles(files);
+
+		// only files changed since the last session go through plugins
+		m_file_stamps.clear();
+		m_file_stamps.reserve(files.size());
+		for (const ScannedFile& file : files) {
+			const u32 hash = file.path.getHash();
+			auto iter = stamps.find(hash);
+			if (!iter.isValid() || iter.value().last_modified != file.stamp.last_modified || iter.value().size != file.stamp.size) {
+				addResource(file.path.c_str());
+			}
+			m_file_stamps.insert(hash, file.stamp);
+		}
+
+		#ifndef CACHE_MASTER
+			FileSystem& fs = m_app.getEngine().getFileSystem();
+			MutexGuard lock(m_resources_mutex);
+			m_resources.eraseIf([&](const ResourceItem& ri){
+				const char* filepath = getResourceFilePath(ri.path.c_str());
+				if (m_file_stamps.find(crc32(filepath)).isValid()) return false;
+				// scan skips hidden files and directories
+				if (fs.fileExists(filepath)) return false;
+				
+				const StaticString<LUMIX_MAX_PATH> res_path(".lumix/assets/", ri.path.getHash(), ".res");
+				fs.deleteFile(res_path);
+				return true;
+			});
+		#endif
+
 		registerLuaAPI(m_app.getEngine().getState());
 	}
 
 	void onInitFinished() override
 	{
 		m_init_finished = true;
-		for (Resource* res : m_on_init_load) {
+		Array<Resource*> on_init_load(m_app.getAllocator());
+		{
+			MutexGuard lock(m_to_compile_mutex);
+			on_init_load.swap(m_on_init_load);
+		}
+		for (Resource* res : on_init_load) {
 			const char* filepath = getResourceFilePath(res->getPath().c_str());
 			pushToCompileQueue(*res, filepath);
 			res->decRefCount();
 		}
-		m_on_init_load.clear();
 		fillDB();
 	}
 
@@ -535,6 +723,8 @@ struct AssetCompilerImpl : AssetCompiler
 		{
 			if (!m_init_finished) {
 				res.incRefCount();
+				// resources can be loaded from jobs
+				MutexGuard lock(m_to_compile_mutex);
 				m_on_init_load.push(&res);
 				return ResourceManagerHub::LoadHook::Action::DEFERRED;
 			}
@@ -752,6 +942,8 @@ struct AssetCompilerImpl : AssetCompiler
 	DelegateList<void()> m_on_list_changed;
 	bool m_init_finished = false;
 	Array<Resource*> m_on_init_load;
+	// source files' stamps from the last scan, keyed by path hash
+	HashMap<u32, FileStamp, HashFuncDirect<u32>> m_file_stamps;
 
 	u32 m_compile_batch_count = 0;
 	u32 m_batch_remaining_count = 0;
@@ -0,0 +1,176 @@
+#include "pack_writer.h"
+#include "engine/atomic.h"
+#include "engine/crc32.h"
+#include "engine/file_system.h"
+#include "engine/hash_map.h"
+#include "engine/job_system.h"
+#include "engine/log.h"
+#include "engine/lz4.h"
+#include "engine/os.h"
+#include "engine/path.h"
+#include "engine/profiler.h"
+#include "engine/stream.h"
+#include "engine/string.h"
+
+namespace Lumix {
+
+// source bytes processed at once, bounds memory used while packing
+static constexpr u64 BATCH_SIZE = 64 * 1024 * 1024;
+static constexpr u32 MAX_BATCH_FILES = 1024;
+static constexpr i32 FAST_ACCELERATION = 8;
+
+namespace {
+
+struct PackJob {
+	PackJob(IAllocator& allocator) : src(allocator), dst(allocator) {}
+
+	OutputMemoryStream src;
+	OutputMemoryStream dst;
+	u32 hash;
+	bool compressed;
+	bool failed;
+};
+
+} // anonymous namespace
+
+PackWriter::PackWriter(FileSystem& fs, IAllocator& allocator)
+	: m_fs(fs)
+	, m_allocator(allocator)
+	, m_inputs(allocator)
+{}
+
+void PackWriter::add(u32 hash, const char* path, u64 size_hint) {
+	Input& input = m_inputs.emplace();
+	input.hash = hash;
+	input.size_hint = size_hint;
+	copyString(input.path, path);
+}
+
+bool PackWriter::write(const char* dest_path, Compression compression) {
+	PROFILE_FUNCTION();
+	m_stats = {};
+
+	os::OutputFile file;
+	if (!file.open(dest_path)) {
+		logError("Could not create ", dest_path);
+		return false;
+	}
+
+	const PackHeader header;
+	bool success = file.write(&header, sizeof(header));
+	u64 offset = sizeof(header);
+
+	Array<PackEntry> toc(m_allocator);
+	toc.reserve(m_inputs.size());
+	// content hash ^ size -> index in toc, candidates are verified byte by byte before reuse
+	HashMap<u64, u32> written(m_allocator);
+	written.reserve(m_inputs.size());
+	OutputMemoryStream verify(m_allocator);
+
+	Array<PackJob> batch(m_allocator);
+	batch.reserve(MAX_BATCH_FILES);
+	for (u32 i = 0; i < MAX_BATCH_FILES; ++i) batch.emplace(m_allocator);
+
+	for (i32 batch_start = 0; batch_start < m_inputs.size() && success;) {
+		i32 batch_end = batch_start;
+		u64 batch_size = 0;
+		while (batch_end < m_inputs.size() && batch_end - batch_start < (i32)MAX_BATCH_FILES && (batch_size < BATCH_SIZE || batch_end == batch_start)) {
+			batch_size += m_inputs[batch_end].size_hint;
+			++batch_end;
+		}
+
+		jobs::forEach(batch_end - batch_start, 1, [&](i32 idx, i32){
+			PROFILE_BLOCK("pack file");
+			PackJob& job = batch[idx];
+			const Input& input = m_inputs[batch_start + idx];
+			job.failed = false;
+			job.compressed = false;
+			job.dst.clear();
+			if (!m_fs.getContentSync(Path(input.path), job.src)) {
+				job.failed = true;
+				return;
+			}
+			job.hash = crc32(job.src.data(), (u32)job.src.size());
+			if (compression == Compression::STORE || job.src.empty()) return;
+
+			const i32 cap = LZ4_compressBound((i32)job.src.size());
+			job.dst.resize(cap);
+			const i32 acceleration = compression == Compression::FAST ? FAST_ACCELERATION : 1;
+			const i32 dst_size = LZ4_compress_fast((const char*)job.src.data(), (char*)job.dst.getMutableData(), (i32)job.src.size(), cap, acceleration);
+			// store as is if compression does not save at least 1/16, it's not worth decompressing
+			if (dst_size == 0 || (u64)dst_size >= job.src.size() - job.src.size() / 16) return;
+
+			job.dst.resize(dst_size);
+			job.compressed = true;
+		});
+
+		for (i32 i = batch_start; i < batch_end; ++i) {
+			PackJob& job = batch[i - batch_start];
+			const Input& input = m_inputs[i];
+			if (job.failed) {
+				logError("Could not open ", input.path);
+				success = false;
+				break;
+			}
+
+			PackEntry& entry = toc.emplace();
+			entry.hash = input.hash;
+			entry.size = job.src.size();
+			++m_stats.files;
+			m_stats.size += entry.size;
+
+			const u64 key = job.hash ^ (entry.size << 32);
+			auto iter = written.find(key);
+			if (iter.isValid()) {
+				const PackEntry& prev = toc[iter.value()];
+				if (prev.size == entry.size
+					&& m_fs.getContentSync(Path(m_inputs[iter.value()].path), verify)
+					&& verify.size() == job.src.size()
+					&& memcmp(verify.data(), job.src.data(), verify.size()) == 0)
+				{
+					entry.flags = prev.flags;
+					entry.offset = prev.offset;
+					entry.compressed_size = prev.compressed_size;
+					++m_stats.deduplicated;
+					continue;
+				}
+			}
+			else {
+				written.insert(key, toc.size() - 1);
+			}
+
+			const OutputMemoryStream& data = job.compressed ? job.dst : job.src;
+			entry.flags = job.compressed ? PackEntry::LZ4 : PackEntry::NONE;
+			entry.offset = offset;
+			entry.compressed_size = data.size();
+			if (!job.compressed) ++m_stats.stored;
+			success = file.write(data.data(), data.size()) && success;
+			offset += data.size();
+			m_stats.packed_size += data.size();
+		}
+
+		// capacity kept for the next batch would make peak memory depend on the biggest files, not on BATCH_SIZE
+		for (PackJob& job : batch) {
+			job.src.free();
+			job.dst.free();
+		}
+		batch_start = batch_end;
+	}
+
+	if (success) {
+		PackFooter footer;
+		footer.toc_offset = offset;
+		footer.count = toc.size();
+		success = file.write(toc.begin(), toc.byte_size());
+		success = file.write(&footer, sizeof(footer)) && success;
+	}
+	file.close();
+
+	if (!success) {
+		logError("Could not write ", dest_path);
+		return false;
+	}
+	return true;
+}
+
+} // namespace Lumix
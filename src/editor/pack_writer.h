@@ -0,0 +1,47 @@
+#pragma once
+
+#include "engine/array.h"
+#include "engine/lumix.h"
+
+namespace Lumix {
+
+struct FileSystem;
+
+// writes packed data files readable by FileSystem::createPacked
+// entries are compressed in parallel, written in batches and identical content is stored only once
+struct LUMIX_EDITOR_API PackWriter final {
+	enum class Compression : i32 {
+		STORE,	// no compression
+		FAST,	// LZ4 with higher acceleration
+		DEFAULT	// LZ4 default acceleration, there's no HC level since lz4hc is not in the tree
+	};
+
+	struct Stats {
+		u32 files = 0;
+		u32 deduplicated = 0;
+		u32 stored = 0;
+		u64 size = 0;
+		u64 packed_size = 0;
+	};
+
+	PackWriter(FileSystem& fs, IAllocator& allocator);
+
+	// entries are written in the same order as they are added
+	void add(u32 hash, const char* path, u64 size_hint);
+	bool write(const char* dest_path, Compression compression);
+	const Stats& getStats() const { return m_stats; }
+
+private:
+	struct Input {
+		u32 hash;
+		u64 size_hint;
+		char path[LUMIX_MAX_PATH];
+	};
+
+	FileSystem& m_fs;
+	IAllocator& m_allocator;
+	Array<Input> m_inputs;
+	Stats m_stats;
+};
+
+} // namespace Lumix
@@ -127,6 +127,9 @@ struct PrefabSystemImpl final : PrefabSystem
 		}
 
 
+		Changes getChanges(ComponentType& type) override { return Changes::NONE; }
+
+
 		bool merge(IEditorCommand& command) override { return false; }
 
 		PrefabResource& prefab;
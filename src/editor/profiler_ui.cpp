@@ -54,7 +54,7 @@ struct ThreadRecord
 };
 
 struct ThreadContextProxy {
-	ThreadContextProxy(u8* ptr) 
+	ThreadContextProxy(u8* ptr, u32 version) 
 	{
 		InputMemoryStream blob(ptr, 9000);
 		name = blob.readString();
@@ -62,6 +62,8 @@ struct ThreadContextProxy {
 		blob.read(begin);
 		blob.read(end);
 		default_show = blob.read<u8>();
+		overflow_count = 0;
+		if (version > (u32)profiler::SerializedVersion::OVERFLOW_COUNT) blob.read(overflow_count);
 		blob.read(buffer_size);
 		buffer = (u8*)blob.getData() + blob.getPosition();
 	}
@@ -73,12 +75,24 @@ struct ThreadContextProxy {
 	u32 begin;
 	u32 end;
 	u32 buffer_size;
+	u32 overflow_count;
 	bool default_show;
 	u8* buffer;
 };
 
 static const char* getContexSwitchReasonString(i8 reason)
 {
+	#ifdef __linux__
+		// state of the thread switched out, see TraceTask::readTracepoints
+		const char* linux_reasons[] = {
+			"Preempted",
+			"Sleeping",
+			"DiskSleep",
+			"Other",
+		};
+		if (reason < 0 || reason >= (i8)lengthOf(linux_reasons)) return "Unknown";
+		return linux_reasons[reason];
+	#endif
 	const char* reasons[] = {
 		"Executive"		   ,
 		"FreePage"		   ,
@@ -169,6 +183,7 @@ struct ProfilerUIImpl final : ProfilerUI
 {
 	ProfilerUIImpl(debug::Allocator* allocator, Engine& engine)
 		: m_main_allocator(allocator)
+		, m_tag_rates(m_allocator)
 		, m_threads(m_allocator)
 		, m_data(m_allocator)
 		, m_resource_manager(engine.getResourceManager())
@@ -219,13 +234,13 @@ struct ProfilerUIImpl final : ProfilerUI
 
 	void patchStrings() {
 		InputMemoryStream tmp(m_data);
-		tmp.read<u32>();
+		const u32 version = tmp.read<u32>();
 		const u32 count = tmp.read<u32>();
 		u8* iter = (u8*)tmp.skip(0);
-		ThreadContextProxy global(iter);
+		ThreadContextProxy global(iter, version);
 		iter = global.next();
 		for (u32 i = 0; i < count; ++i) {
-			ThreadContextProxy ctx(iter);
+			ThreadContextProxy ctx(iter, version);
 			iter = ctx.next();
 		}
 
@@ -301,11 +316,11 @@ struct ProfilerUIImpl final : ProfilerUI
 		const u32 version = blob.read<u32>();
 		const u32 count = blob.read<u32>();
 		u8* iter = (u8*)blob.skip(0);
-		ThreadContextProxy global(iter);
+		ThreadContextProxy global(iter, version);
 		f(global);
 		iter = global.next();
 		for (u32 i = 0; i < count; ++i) {
-			ThreadContextProxy ctx(iter);
+			ThreadContextProxy ctx(iter, version);
 			f(ctx);
 			iter = ctx.next();
 		}
@@ -349,7 +364,6 @@ struct ProfilerUIImpl final : ProfilerUI
 			size_t inclusive_size,
 			IAllocator& allocator)
 			: m_children(allocator)
-			, m_allocations(allocator)
 			, m_stack_node(stack_node)
 			, m_inclusive_size(inclusive_size)
 			, m_open(false)
@@ -378,7 +392,13 @@ struct ProfilerUIImpl final : ProfilerUI
 		bool m_open;
 		debug::StackNode* m_stack_node;
 		Array<AllocationStackNode*> m_children;
-		Array<debug::Allocator::AllocationInfo*> m_allocations;
+	};
+
+	struct TagRates {
+		u64 alloc_count = 0;
+		u64 free_count = 0;
+		float allocs_per_sec = 0;
+		float frees_per_sec = 0;
 	};
 
 
@@ -386,14 +406,19 @@ struct ProfilerUIImpl final : ProfilerUI
 	void onGUIMemoryProfiler();
 	void onGUIResources();
 	void onFrame();
-	void addToTree(debug::Allocator::AllocationInfo* info);
+	void onGUITagAllocators();
+	void addToTree(debug::StackNode* stack_leaf, size_t size);
+	void clearAllocationTree();
 	void refreshAllocations();
+	void refreshSampledAllocations(TagAllocator& tag);
 	void showAllocationTree(AllocationStackNode* node, int column) const;
 	AllocationStackNode* getOrCreate(AllocationStackNode* my_node,
 		debug::StackNode* external_node, size_t size);
 
 	DefaultAllocator m_allocator;
 	debug::Allocator* m_main_allocator;
+	HashMap<TagAllocator*, TagRates> m_tag_rates;
+	float m_tag_rates_time = 0;
 	ResourceManagerHub& m_resource_manager;
 	AllocationStackNode* m_allocation_root;
 	int m_allocation_size_from;
@@ -528,40 +553,136 @@ ProfilerUIImpl::AllocationStackNode* ProfilerUIImpl::getOrCreate(AllocationStack
 }
 
 
-void ProfilerUIImpl::addToTree(debug::Allocator::AllocationInfo* info)
+void ProfilerUIImpl::addToTree(debug::StackNode* stack_leaf, size_t size)
 {
 	debug::StackNode* nodes[1024];
-	int count = debug::StackTree::getPath(info->stack_leaf, Span(nodes));
+	int count = debug::StackTree::getPath(stack_leaf, Span(nodes));
 
 	auto node = m_allocation_root;
 	for (int i = count - 1; i >= 0; --i)
 	{
-		node = getOrCreate(node, nodes[i], info->size);
+		node = getOrCreate(node, nodes[i], size);
 	}
-	node->m_allocations.push(info);
 }
 
 
-void ProfilerUIImpl::refreshAllocations()
+void ProfilerUIImpl::clearAllocationTree()
 {
-	if (!m_main_allocator) return;
-
 	m_allocation_root->clear(m_allocator);
 	LUMIX_DELETE(m_allocator, m_allocation_root);
 	m_allocation_root = LUMIX_NEW(m_allocator, AllocationStackNode)(nullptr, 0, m_allocator);
+}
+
+
+void ProfilerUIImpl::refreshAllocations()
+{
+	if (!m_main_allocator) return;
+
+	clearAllocationTree();
 
 	m_main_allocator->lock();
 	auto* current_info = m_main_allocator->getFirstAllocationInfo();
 
 	while (current_info)
 	{
-		addToTree(current_info);
+		addToTree(current_info->stack_leaf, current_info->size);
 		current_info = current_info->next;
 	}
 	m_main_allocator->unlock();
 }
 
 
+void ProfilerUIImpl::refreshSampledAllocations(TagAllocator& tag)
+{
+	clearAllocationTree();
+
+	Array<TagAllocator::SampledAllocation> allocations(m_allocator);
+	u32 count = tag.getSampledAllocations(Span(allocations.begin(), allocations.end()));
+	// allocations can happen between the calls
+	while (count > (u32)allocations.size()) {
+		allocations.resize(count + 64);
+		count = tag.getSampledAllocations(Span(allocations.begin(), allocations.end()));
+	}
+
+	for (u32 i = 0; i < count; ++i) {
+		addToTree(allocations[i].stack, allocations[i].size);
+	}
+}
+
+
+void ProfilerUIImpl::onGUITagAllocators()
+{
+	TagAllocator* tags[64];
+	const u32 count = minimum(TagAllocator::getTags(Span(tags)), lengthOf(tags));
+
+	#ifdef LUMIX_TRACK_ALLOCATIONS
+		// alloc / free rates, updated once per second
+		const float now = m_timer.getTimeSinceStart();
+		const float dt = now - m_tag_rates_time;
+		const bool update_rates = dt > 1;
+		if (update_rates) m_tag_rates_time = now;
+
+		if (!ImGui::BeginTable("tags", 6, ImGuiTableFlags_Resizable)) return;
+
+		ImGui::TableSetupColumn("Tag");
+		ImGui::TableSetupColumn("Live");
+		ImGui::TableSetupColumn("Peak");
+		ImGui::TableSetupColumn("Count");
+		ImGui::TableSetupColumn("Allocs/s");
+		ImGui::TableSetupColumn("Frees/s");
+		ImGui::TableHeadersRow();
+
+		for (u32 i = 0; i < count; ++i) {
+			TagAllocator& tag = *tags[i];
+			const TagAllocator::Stats stats = tag.getStats();
+			auto iter = m_tag_rates.find(&tag);
+			if (!iter.isValid()) iter = m_tag_rates.insert(&tag, {});
+			TagRates& rates = iter.value();
+			if (update_rates) {
+				rates.allocs_per_sec = (stats.alloc_count - rates.alloc_count) / dt;
+				rates.frees_per_sec = (stats.free_count - rates.free_count) / dt;
+				rates.alloc_count = stats.alloc_count;
+				rates.free_count = stats.free_count;
+			}
+
+			ImGui::TableNextColumn();
+			const bool open = ImGui::TreeNodeEx(&tag, ImGuiTreeNodeFlags_SpanFullWidth, "%s", tag.getTagName());
+			ImGui::TableNextColumn();
+			ImGui::Text("%.3fMB", stats.live_bytes / (1024.f * 1024.f));
+			ImGui::TableNextColumn();
+			ImGui::Text("%.3fMB", stats.peak_bytes / (1024.f * 1024.f));
+			ImGui::TableNextColumn();
+			ImGui::Text("%d", (int)stats.live_count);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.0f", rates.allocs_per_sec);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.0f", rates.frees_per_sec);
+
+			if (!open) continue;
+
+			ImGui::TableNextColumn();
+			float histogram[TagAllocator::HISTOGRAM_SIZE];
+			for (u32 j = 0; j < TagAllocator::HISTOGRAM_SIZE; ++j) histogram[j] = (float)stats.histogram[j];
+			ImGui::PlotHistogram("##hist", histogram, lengthOf(histogram), 0, "16B .. 256KB+", 0, FLT_MAX, ImVec2(-1, 60));
+
+			int sampling = (int)tag.getStackSampling();
+			ImGui::SetNextItemWidth(-1);
+			if (ImGui::DragInt("##sampling", &sampling, 1, 0, 1000, sampling ? "Callstack of every %d. allocation" : "Callstacks disabled")) {
+				tag.setStackSampling((u32)maximum(sampling, 0));
+			}
+			if (sampling && ImGui::Button("Show callstacks")) refreshSampledAllocations(tag);
+			ImGui::TreePop();
+		}
+		ImGui::EndTable();
+	#else
+		ImGui::TextUnformatted("Allocation tracking is disabled, build with LUMIX_TRACK_ALLOCATIONS.");
+		for (u32 i = 0; i < count; ++i) {
+			ImGui::BulletText("%s", tags[i]->getTagName());
+		}
+	#endif
+}
+
+
 void ProfilerUIImpl::showAllocationTree(AllocationStackNode* node, int column) const
 {
 	if (column == FUNCTION)
@@ -643,6 +764,11 @@ void ProfilerUIImpl::onGUIMemoryProfiler()
 	const float reserved_pages_size = (page_allocator.getReservedCount() * PageAllocator::PAGE_SIZE) / (1024.f * 1024.f);
 	ImGui::Text("Page allocator: %.3fMB", reserved_pages_size);
 
+	if (ImGui::TreeNode("Subsystems")) {
+		onGUITagAllocators();
+		ImGui::TreePop();
+	}
+
 	if (m_is_gpu_mem_stats_valid) {
 		const float current = m_gpu_mem_stats.current / (1024.f * 1024.f);
 		const float total = m_gpu_mem_stats.total / (1024.f * 1024.f);
@@ -730,6 +856,10 @@ void ProfilerUIImpl::onGUICPUProfiler()
 				auto thread = m_threads.find(ctx.thread_id);
 				if (thread.isValid()) {
 					ImGui::Checkbox(StaticString<128>(ctx.name, "##t", ctx.thread_id), &thread.value().show);
+					if (ctx.overflow_count > 0) {
+						ImGui::SameLine();
+						ImGui::TextDisabled("(%d chunks overwritten)", ctx.overflow_count);
+					}
 				}
 			});
 			ImGui::EndMenu();
@@ -737,18 +867,29 @@ void ProfilerUIImpl::onGUICPUProfiler()
 		if (profiler::contextSwitchesEnabled())
 		{
 			ImGui::Checkbox("Show context switches", &m_show_context_switches);
+			#ifdef __linux__
+				if (ImGui::IsItemHovered()) {
+					ImGui::SetTooltip("Exact switches need CAP_PERFMON or kernel.perf_event_paranoid <= 0,\notherwise threads are sampled every millisecond.");
+				}
+			#endif
 		}
 		else {
 			ImGui::Separator();
 			ImGui::Text("Context switch tracing not available.");
-			ImGui::Text("Run the app as an administrator.");
+			#ifdef __linux__
+				ImGui::Text("/proc/self/task/*/schedstat is not readable.");
+			#else
+				ImGui::Text("Run the app as an administrator.");
+			#endif
 		}
 		ImGui::EndMenu();
 	}
 
 	if (m_data.empty()) return;
 	if (!m_is_paused) return;
-	ThreadContextProxy global(m_data.getMutableData() + 2 * sizeof(u32));
+	u32 version;
+	memcpy(&version, m_data.data(), sizeof(version));
+	ThreadContextProxy global(m_data.getMutableData() + 2 * sizeof(u32), version);
 
 	const u64 view_start = m_end - m_range;
 
@@ -384,6 +384,8 @@ bool Settings::load()
 	m_mouse_sensitivity.y = getFloat(L, "mouse_sensitivity_y", 200.f);
 	m_app.setFOV(degreesToRadians(getFloat(L, "fov", 60)));
 	m_font_size = getInteger(L, "font_size", 13);
+	m_undo_budget_mb = getInteger(L, "undo_budget_mb", 256);
+	m_app.getWorldEditor().setUndoMemoryBudget((u64)maximum(m_undo_budget_mb, 1) * 1024 * 1024);
 
 	auto& actions = m_app.getActions();
 	lua_getglobal(L, "actions");
@@ -510,6 +512,7 @@ bool Settings::save()
 	file << "mouse_sensitivity_x = " << m_mouse_sensitivity.x << "\n";
 	file << "mouse_sensitivity_y = " << m_mouse_sensitivity.y << "\n";
 	file << "font_size = " << m_font_size << "\n";
+	file << "undo_budget_mb = " << m_undo_budget_mb << "\n";
 	
 	saveStyle(file);
 
@@ -1001,6 +1004,17 @@ void Settings::onGUI()
 					m_app.setFOV(fov);
 				}
 				ImGui::DragFloat("Gizmo scale", &m_app.getGizmoConfig().scale, 0.1f);
+				WorldEditor& editor = m_app.getWorldEditor();
+				if (ImGui::InputInt("Undo memory budget (MB)", &m_undo_budget_mb)) {
+					m_undo_budget_mb = maximum(m_undo_budget_mb, 1);
+					editor.setUndoMemoryBudget((u64)m_undo_budget_mb * 1024 * 1024);
+				}
+				const WorldEditor::UndoStats undo_stats = editor.getUndoStats();
+				ImGui::Text("Undo history: %d commands, %d compressed", undo_stats.commands, undo_stats.released);
+				ImGui::Text("Compressed payloads: %.2f MB raw, %.2f MB in memory, %.2f MB on disk"
+					, undo_stats.raw_size / (1024.f * 1024.f)
+					, undo_stats.memory_size / (1024.f * 1024.f)
+					, undo_stats.journal_size / (1024.f * 1024.f));
 				ImGui::EndTabItem();
 			}
 
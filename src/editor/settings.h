@@ -38,6 +38,7 @@ struct LUMIX_EDITOR_API Settings {
 	Vec2 m_mouse_sensitivity;
 	float m_mouse_sensitivity_y;
 	int m_font_size = 13;
+	int m_undo_budget_mb = 256;
 	String m_imgui_state;
 
 	explicit Settings(struct StudioApp& app);
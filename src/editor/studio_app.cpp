@@ -8,6 +8,7 @@
 #include "editor/entity_folders.h"
 #include "editor/file_system_watcher.h"
 #include "editor/gizmo.h"
+#include "editor/pack_writer.h"
 #include "editor/prefab_system.h"
 #include "editor/render_interface.h"
 #include "editor/world_editor.h"
@@ -24,7 +25,6 @@
 #include "engine/job_system.h"
 #include "engine/log.h"
 #include "engine/lua_wrapper.h"
-#include "engine/lz4.h"
 #include "engine/os.h"
 #include "engine/path.h"
 #include "engine/profiler.h"
@@ -72,6 +72,8 @@ struct TarHeader {
 
 #define NO_ICON "     "
 
+static const char* PACK_TRACE_PATH = ".lumix/pack_trace.txt";
+
 
 struct LuaPlugin : StudioApp::GUIPlugin
 {
@@ -450,6 +452,7 @@ struct StudioAppImpl final : StudioApp
 		m_watched_plugin.watcher.reset();
 
 		saveSettings();
+		setPackTraceRecording(false);
 
 		while (m_engine->getFileSystem().hasWork()) {
 			m_engine->getFileSystem().processCallbacks();
@@ -795,6 +798,7 @@ struct StudioAppImpl final : StudioApp
 				onEntityListGUI();
 				onEditCameraGUI();
 				onSaveAsDialogGUI();
+				onExportSectorsDialogGUI();
 				for (auto* plugin : m_gui_plugins)
 				{
 					plugin->onWindowGUI();
@@ -1137,6 +1141,44 @@ struct StudioAppImpl final : StudioApp
 	}
 
 
+	void onExportSectorsDialogGUI()
+	{
+		if (m_export_sectors_request) {
+			ImGui::OpenPopup("Export sectors");
+			m_export_sectors_request = false;
+		}
+		if (ImGui::BeginPopupModal("Export sectors"))
+		{
+			ImGuiEx::Label("Sector size");
+			ImGui::DragFloat("##sector_size", &m_sector_size, 1, 16, FLT_MAX);
+			if (ImGui::Button(ICON_FA_SAVE "Export")) {
+				m_editor->saveSectors(m_editor->getUniverse()->getName(), m_sector_size);
+				ImGui::CloseCurrentPopup();
+			}
+			ImGui::SameLine();
+			if (ImGui::Button(ICON_FA_TIMES "Cancel")) ImGui::CloseCurrentPopup();
+			ImGui::EndPopup();
+		}
+	}
+
+
+	void exportSectors()
+	{
+		if (m_editor->isGameMode())
+		{
+			logError("Can not export while the game is running");
+			return;
+		}
+		if (!m_editor->getUniverse()->getName()[0])
+		{
+			logError("Save the universe before exporting it to sectors");
+			return;
+		}
+
+		m_export_sectors_request = true;
+	}
+
+
 	void exit()
 	{
 		if (m_editor->isUniverseChanged())
@@ -1532,6 +1574,7 @@ struct StudioAppImpl final : StudioApp
 		}
 		menuItem("save", !m_editor->isGameMode());
 		menuItem("saveAs", !m_editor->isGameMode());
+		menuItem("exportSectors", !m_editor->isGameMode());
 		menuItem("exit", true);
 		ImGui::EndMenu();
 	}
@@ -2267,6 +2310,7 @@ struct StudioAppImpl final : StudioApp
 			ICON_FA_SAVE "Save", "Save universe", "save", ICON_FA_SAVE, os::Keycode::S, (u8)Action::Modifiers::CTRL);
 		addAction<&StudioAppImpl::saveAs>(
 			NO_ICON "Save As", "Save universe as", "saveAs", "", os::Keycode::S, (u8)Action::Modifiers::CTRL | (u8)Action::Modifiers::SHIFT);
+		addAction<&StudioAppImpl::exportSectors>(NO_ICON "Export sectors", "Export universe to streamable sectors", "exportSectors");
 		addAction<&StudioAppImpl::exit>(
 			ICON_FA_SIGN_OUT_ALT "Exit", "Exit Studio", "exit", ICON_FA_SIGN_OUT_ALT, os::Keycode::X, (u8)Action::Modifiers::CTRL);
 		addAction<&StudioAppImpl::redo>(
@@ -3022,9 +3066,7 @@ struct StudioAppImpl final : StudioApp
 	struct PackFileInfo
 	{
 		u32 hash;
-		u64 offset;
 		u64 size;
-		u64 size_compressed;
 
 		char path[LUMIX_MAX_PATH];
 	};
@@ -3039,7 +3081,6 @@ struct StudioAppImpl final : StudioApp
 			Span<const char> basename = Path::getBasename(info.filename);
 			PackFileInfo rec;
 			fromCString(Span(basename), rec.hash);
-			rec.offset = 0;
 			rec.size = os::getFileSize(StaticString<LUMIX_MAX_PATH>(base_path, ".lumix/assets/", info.filename));
 			copyString(rec.path, ".lumix/assets/");
 			catString(rec.path, info.filename);
@@ -3092,7 +3133,6 @@ struct StudioAppImpl final : StudioApp
 			copyString(out_info.path, out_path);
 			out_info.hash = hash;
 			out_info.size = os::getFileSize(StaticString<LUMIX_MAX_PATH>(base_path, out_path.data));
-			out_info.offset = ~0UL;
 		}
 		os::destroyFileIterator(iter);
 	}
@@ -3112,7 +3152,6 @@ struct StudioAppImpl final : StudioApp
 				copyString(Span(out_info.path), baked_path);
 				out_info.hash = hash;
 				out_info.size = os::getFileSize(baked_path);
-				out_info.offset = ~0UL;
 			}
 		}
 		packDataScan("pipelines/", infos);
@@ -3123,7 +3162,133 @@ struct StudioAppImpl final : StudioApp
 		copyString(Span(out_info.path), unv_path);
 		out_info.hash = hash;
 		out_info.size = os::getFileSize(unv_path);
-		out_info.offset = ~0UL;
+	}
+
+
+	void setPackTraceRecording(bool enable) {
+		if (m_pack.is_recording_trace == enable) return;
+
+		m_pack.is_recording_trace = enable;
+		if (enable) {
+			m_editor->universeCreated().bind<&StudioAppImpl::startPackTrace>(this);
+			m_editor->universeDestroyed().bind<&StudioAppImpl::savePackTrace>(this);
+			startPackTrace();
+		}
+		else {
+			m_editor->universeCreated().unbind<&StudioAppImpl::startPackTrace>(this);
+			m_editor->universeDestroyed().unbind<&StudioAppImpl::savePackTrace>(this);
+			savePackTrace();
+		}
+	}
+
+
+	void startPackTrace() { m_engine->getFileSystem().startAccessTrace(); }
+
+
+	// appends files requested since the universe was created to the trace, under the universe's name
+	void savePackTrace() {
+		FileSystem& fs = m_engine->getFileSystem();
+		Array<Path> paths(m_allocator);
+		fs.stopAccessTrace(paths);
+		const char* universe_name = m_editor->getUniverse()->getName();
+		if (paths.empty() || !universe_name[0]) return;
+
+		OutputMemoryStream content(m_allocator);
+		if (fs.fileExists(PACK_TRACE_PATH) && !fs.getContentSync(Path(PACK_TRACE_PATH), content)) {
+			logError("Could not read ", PACK_TRACE_PATH);
+			return;
+		}
+		content << "universe:" << universe_name << "\n";
+		for (const Path& path : paths) {
+			content << path.c_str() << "\n";
+		}
+
+		os::OutputFile file;
+		if (!fs.open(PACK_TRACE_PATH, file)) {
+			logError("Could not create ", PACK_TRACE_PATH);
+			return;
+		}
+		if (!file.write(content.data(), content.size())) {
+			logError("Could not write ", PACK_TRACE_PATH);
+		}
+		file.close();
+	}
+
+
+	// universes from the trace one after another, each universe's file first followed by files in order of their
+	// first request, so a cold load reads the pack sequentially; files not in the trace follow in hash order
+	void addPackEntriesInLoadOrder(const AssociativeArray<u32, PackFileInfo>& infos, PackWriter& writer) {
+		Array<bool> added(m_allocator);
+		added.resize(infos.size());
+		for (bool& b : added) b = false;
+
+		auto add = [&](u32 hash){
+			const i32 idx = infos.find(hash);
+			if (idx < 0 || added[idx]) return;
+			added[idx] = true;
+			const PackFileInfo& info = infos.at(idx);
+			writer.add(info.hash, info.path, info.size);
+		};
+
+		OutputMemoryStream trace(m_allocator);
+		if (m_engine->getFileSystem().getContentSync(Path(PACK_TRACE_PATH), trace)) {
+			Array<Span<const char>> lines(m_allocator);
+			const char* line_start = (const char*)trace.data();
+			const char* end = line_start + trace.size();
+			for (const char* c = line_start; c <= end; ++c) {
+				if (c != end && *c != '\n' && *c != '\r') continue;
+				if (c != line_start) lines.push(Span(line_start, c));
+				line_start = c + 1;
+			}
+
+			static const char UNIVERSE_PREFIX[] = "universe:";
+			auto getUniverseName = [](Span<const char> line) -> Span<const char> {
+				const u32 prefix_len = lengthOf(UNIVERSE_PREFIX) - 1;
+				if (line.length() <= prefix_len || memcmp(line.begin(), UNIVERSE_PREFIX, prefix_len) != 0) return {};
+				return Span(line.begin() + prefix_len, line.end());
+			};
+			auto equal = [](Span<const char> a, Span<const char> b){
+				return a.length() == b.length() && memcmp(a.begin(), b.begin(), a.length()) == 0;
+			};
+
+			// the same universe can be recorded several times, process all its parts together
+			for (u32 i = 0; i < lines.size(); ++i) {
+				const Span<const char> universe = getUniverseName(lines[i]);
+				if (universe.length() == 0) continue;
+
+				bool is_processed = false;
+				for (u32 j = 0; j < i && !is_processed; ++j) {
+					is_processed = equal(getUniverseName(lines[j]), universe);
+				}
+				if (is_processed) continue;
+
+				StaticString<LUMIX_MAX_PATH> unv_path("universes/");
+				catString(Span(unv_path.data), universe);
+				unv_path << ".unv";
+				add(crc32(unv_path));
+
+				bool is_in_universe = false;
+				for (u32 j = i; j < lines.size(); ++j) {
+					const Span<const char> line_universe = getUniverseName(lines[j]);
+					if (line_universe.length() > 0) {
+						is_in_universe = equal(line_universe, universe);
+						continue;
+					}
+					if (!is_in_universe) continue;
+
+					char path[LUMIX_MAX_PATH];
+					copyString(Span(path), lines[j]);
+					add(getPackHash(Path(path)));
+				}
+			}
+		}
+		else {
+			logWarning("Could not read ", PACK_TRACE_PATH, ", files are packed in hash order");
+		}
+
+		for (i32 i = 0; i < infos.size(); ++i) {
+			if (!added[i]) add(infos.getKey(i));
+		}
 	}
 
 
@@ -3143,6 +3308,17 @@ struct StudioAppImpl final : StudioApp
 			ImGuiEx::Label("Mode");
 			ImGui::Combo("##mode", (int*)&m_pack.mode, "All files\0Loaded universe\0");
 
+			ImGuiEx::Label("Compression");
+			ImGui::Combo("##compression", (int*)&m_pack.compression, "None\0Fast\0Default\0");
+
+			ImGuiEx::Label("Load order from trace");
+			ImGui::Checkbox("##use_trace", &m_pack.use_trace);
+
+			ImGuiEx::Label("Record trace");
+			bool is_recording = m_pack.is_recording_trace;
+			if (ImGui::Checkbox("##record_trace", &is_recording)) setPackTraceRecording(is_recording);
+			if (ImGui::IsItemHovered()) ImGui::SetTooltip("Files loaded by universes opened while recording are appended to %s", PACK_TRACE_PATH);
+
 			if (ImGui::Button("Pack")) packData();
 		}
 		ImGui::End();
@@ -3171,57 +3347,20 @@ struct StudioAppImpl final : StudioApp
 			return;
 		}
 
-		FileSystem& fs = m_engine->getFileSystem();
-		OutputMemoryStream compressed(m_allocator);
-		OutputMemoryStream src(m_allocator);
-		u64 total_size = 0;
-		for (auto& info : infos) {
-			if (!fs.getContentSync(Path(info.path), src)) {
-				logError("Could not open ", info.path);
-				return;
-			}
-
-			total_size += (u32)src.size();
-
-			info.size = src.size();
-			info.offset = compressed.size();
-			const i32 cap = LZ4_compressBound((i32)src.size());
-			compressed.reserve(compressed.size() + cap);
-			const i32 dst_size = LZ4_compress_default((const char*)src.data(), (char*)compressed.skip(0), (i32)src.size(), cap); 
-			if (dst_size == 0) {
-				logError("Could not compress ", info.path);
-				return;
-			}
-			
-			info.size_compressed = dst_size;
-			compressed.resize(compressed.size() + dst_size);
+		PackWriter writer(m_engine->getFileSystem(), m_allocator);
+		if (m_pack.use_trace) {
+			addPackEntriesInLoadOrder(infos, writer);
 		}
-		logInfo("Packed ", infos.size(), " files (", total_size / 1024, "KiB) in ", compressed.size() / 1024, " KiB");
-
-		bool success;
-		os::OutputFile file;
-		if (!file.open(dest)) {
-			logError("Could not create ", dest);
-			return;
-		}
-
-		const u32 count = (u32)infos.size();
-		success = file.write(&count, sizeof(count));
-
-		for (auto& info : infos) {
-			success = file.write(&info.hash, sizeof(info.hash)) && success;
-			success = file.write(&info.offset, sizeof(info.offset)) && success;
-			success = file.write(&info.size, sizeof(info.size)) && success;
-			success = file.write(&info.size_compressed, sizeof(info.size_compressed)) && success;
+		else {
+			for (const PackFileInfo& info : infos) {
+				writer.add(info.hash, info.path, info.size);
+			}
 		}
+		if (!writer.write(dest, m_pack.compression)) return;
 
-		success = file.write(compressed.data(), compressed.size()) && success;
-		file.close();
-
-		if (!success) {
-			logError("Could not write ", dest);
-			return;
-		}
+		const PackWriter::Stats& stats = writer.getStats();
+		logInfo("Packed ", stats.files, " files (", stats.size / 1024, " KiB) in ", stats.packed_size / 1024, " KiB, "
+			, stats.deduplicated, " duplicates, ", stats.stored, " stored uncompressed");
 
 		const char* bin_files[] = {"app.exe", "dbghelp.dll", "dbgcore.dll"};
 		StaticString<LUMIX_MAX_PATH> src_dir("bin/");
@@ -3406,6 +3545,8 @@ struct StudioAppImpl final : StudioApp
 	Action m_reset_pivot_action;
 	Gizmo::Config m_gizmo_config;
 	bool m_save_as_request = false;
+	bool m_export_sectors_request = false;
+	float m_sector_size = 256;
 	bool m_cursor_captured = false;
 	bool m_confirm_exit;
 	bool m_confirm_load;
@@ -3437,6 +3578,9 @@ struct StudioAppImpl final : StudioApp
 		};
 
 		Mode mode;
+		PackWriter::Compression compression = PackWriter::Compression::DEFAULT;
+		bool use_trace = false;
+		bool is_recording_trace = false;
 		StaticString<LUMIX_MAX_PATH> dest_dir;
 	};
 
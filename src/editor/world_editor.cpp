@@ -5,6 +5,7 @@
 #include "editor/prefab_system.h"
 #include "engine/array.h"
 #include "engine/associative_array.h"
+#include "engine/atomic.h"
 #include "engine/command_line_parser.h"
 #include "engine/crc32.h"
 #include "engine/crt.h"
@@ -12,8 +13,10 @@
 #include "engine/engine.h"
 #include "engine/file_system.h"
 #include "engine/geometry.h"
+#include "engine/job_system.h"
 #include "engine/plugin.h"
 #include "engine/log.h"
+#include "engine/lz4.h"
 #include "engine/math.h"
 #include "engine/metaprogramming.h"
 #include "engine/os.h"
@@ -25,6 +28,7 @@
 #include "engine/stream.h"
 #include "engine/string.h"
 #include "engine/universe.h"
+#include "engine/universe_streamer.h"
 #include "render_interface.h"
 
 
@@ -471,7 +475,7 @@ struct PropertyDeserializeVisitor : reflection::IPropertyVisitor {
 	ComponentUID cmp;
 	const HashMap<EntityPtr, u32>& map;
 	Span<const EntityRef> entities;
-	int idx;
+	int idx = -1;
 };
 
 struct PropertySerializeVisitor : reflection::IPropertyVisitor {
@@ -568,6 +572,7 @@ struct BeginGroupCommand final : IEditorCommand
 	void undo() override { ASSERT(false); }
 	bool merge(IEditorCommand& command) override { ASSERT(false); return false; }
 	const char* getType() override { return "begin_group"; }
+	Changes getChanges(ComponentType& type) override { return Changes::NONE; }
 };
 
 
@@ -580,6 +585,7 @@ struct EndGroupCommand final : IEditorCommand
 	void undo() override { ASSERT(false); }
 	bool merge(IEditorCommand& command) override { ASSERT(false); return false; }
 	const char* getType() override { return "end_group"; }
+	Changes getChanges(ComponentType& type) override { return Changes::NONE; }
 
 	u32 group_type;
 };
@@ -612,6 +618,7 @@ public:
 
 
 	const char* getType() override { return "set_entity_name"; }
+	Changes getChanges(ComponentType& type) override { return Changes::ENTITIES; }
 
 
 	bool merge(IEditorCommand& command) override
@@ -711,6 +718,7 @@ public:
 
 
 	const char* getType() override { return "move_entity"; }
+	Changes getChanges(ComponentType& type) override { return Changes::NONE; }
 
 
 	bool merge(IEditorCommand& command) override
@@ -813,6 +821,7 @@ public:
 
 
 	const char* getType() override { return "local_move_entity"; }
+	Changes getChanges(ComponentType& type) override { return Changes::NONE; }
 
 
 	bool merge(IEditorCommand& command) override
@@ -926,6 +935,7 @@ public:
 
 
 	const char* getType() override { return "scale_entity"; }
+	Changes getChanges(ComponentType& type) override { return Changes::NONE; }
 
 
 	bool merge(IEditorCommand& command) override
@@ -1036,6 +1046,9 @@ public:
 
 
 	const char* getType() override { return "remove_array_property_item"; }
+	Changes getChanges(ComponentType& type) override { type = m_component.type; return Changes::COMPONENT; }
+	void releasePayload(OutputMemoryStream& blob) override { blob.write(m_old_values.data(), m_old_values.size()); m_old_values.free(); }
+	void restorePayload(InputMemoryStream& blob) override { m_old_values.clear(); m_old_values.write(blob.getData(), blob.size()); }
 
 
 	bool merge(IEditorCommand&) override { return false; }
@@ -1094,6 +1107,7 @@ public:
 
 
 	const char* getType() override { return "add_array_property_item"; }
+	Changes getChanges(ComponentType& type) override { type = m_component.type; return Changes::COMPONENT; }
 
 
 	bool merge(IEditorCommand&) override { return false; }
@@ -1245,6 +1259,9 @@ public:
 
 
 	const char* getType() override { return getSetPropertyCmdName<T>(); }
+	Changes getChanges(ComponentType& type) override { type = m_component_type; return Changes::COMPONENT; }
+	void releasePayload(OutputMemoryStream& blob) override { blob.write(m_old_values.data(), m_old_values.size()); m_old_values.free(); }
+	void restorePayload(InputMemoryStream& blob) override { m_old_values.clear(); m_old_values.write(blob.getData(), blob.size()); }
 
 	bool merge(IEditorCommand& command) override
 	{
@@ -1285,6 +1302,24 @@ struct WorldEditorImpl final : WorldEditor
 {
 	friend struct PasteEntityCommand;
 private:
+	// commands this close to m_undo_index keep their payload, so repeated undo and redo does not pay for compression
+	static constexpr i32 HOT_UNDO_COMMANDS = 8;
+	// the journal continues in a new segment after this many bytes, so old segments can be deleted
+	static constexpr u64 UNDO_JOURNAL_SEGMENT_SIZE = 64 * 1024 * 1024;
+
+	// payload released by a cold command, see IEditorCommand::releasePayload
+	struct UndoPayload {
+		UndoPayload(IAllocator& allocator) : data(allocator) {}
+
+		i32 index;				// in m_undo_stack
+		u64 raw_size = 0;
+		u64 size = 0;			// size of stored data
+		bool compressed = false;
+		i32 segment = -1;		// journal segment the data are in, -1 if they are in `data`
+		u64 offset = 0;			// in the journal segment
+		OutputMemoryStream data;
+	};
+
 	struct DestroyEntityFolderCommand final : IEditorCommand {
 		DestroyEntityFolderCommand(WorldEditorImpl& editor, u16 folder)
 			: m_editor(editor)
@@ -1308,6 +1343,7 @@ private:
 		}
 
 		const char* getType() override { return "destroy_entity_folder"; }
+		Changes getChanges(ComponentType& type) override { return Changes::NONE; }
 		bool merge(IEditorCommand& command) override { return false; }
 
 		WorldEditorImpl& m_editor;
@@ -1336,6 +1372,7 @@ private:
 		}
 
 		const char* getType() override { return "create_entity_folder"; }
+		Changes getChanges(ComponentType& type) override { return Changes::NONE; }
 		bool merge(IEditorCommand& command) override { return false; }
 	
 		WorldEditorImpl& m_editor;
@@ -1366,6 +1403,7 @@ private:
 		}
 
 		const char* getType() override { return "rename_entity_folder"; }
+		Changes getChanges(ComponentType& type) override { return Changes::NONE; }
 		bool merge(IEditorCommand& command) override { 
 			RenameEntityFolderCommand& cmd = (RenameEntityFolderCommand&)command;
 			if (cmd.m_folder != m_folder) return false;
@@ -1398,6 +1436,7 @@ private:
 		}
 
 		const char* getType() override { return "move_entity_to_folder"; }
+		Changes getChanges(ComponentType& type) override { return Changes::NONE; }
 
 		bool merge(IEditorCommand& command) override { return false; }
 	
@@ -1431,6 +1470,7 @@ private:
 
 
 		const char* getType() override { return "add_component"; }
+		Changes getChanges(ComponentType& type) override { return Changes::NONE; }
 
 
 		bool execute() override
@@ -1500,6 +1540,7 @@ private:
 
 
 		const char* getType() override { return "make_parent"; }
+		Changes getChanges(ComponentType& type) override { return Changes::ENTITIES; }
 
 
 		bool execute() override
@@ -1705,6 +1746,9 @@ private:
 
 
 		const char* getType() override { return "destroy_entities"; }
+		Changes getChanges(ComponentType& type) override { return Changes::NONE; }
+		void releasePayload(OutputMemoryStream& blob) override { blob.write(m_old_values.data(), m_old_values.size()); m_old_values.free(); }
+		void restorePayload(InputMemoryStream& blob) override { m_old_values.clear(); m_old_values.write(blob.getData(), blob.size()); }
 
 
 	private:
@@ -1774,6 +1818,9 @@ private:
 
 
 		const char* getType() override { return "destroy_components"; }
+		Changes getChanges(ComponentType& type) override { return Changes::NONE; }
+		void releasePayload(OutputMemoryStream& blob) override { blob.write(m_old_values.data(), m_old_values.size()); m_old_values.free(); }
+		void restorePayload(InputMemoryStream& blob) override { m_old_values.clear(); m_old_values.write(blob.getData(), blob.size()); }
 
 
 		bool execute() override
@@ -1852,6 +1899,7 @@ private:
 
 		bool merge(IEditorCommand&) override { return false; }
 		const char* getType() override { return "add_entity"; }
+		Changes getChanges(ComponentType& type) override { return Changes::NONE; }
 
 
 	private:
@@ -1882,11 +1930,14 @@ public:
 
 		Gizmo::frame();
 		m_prefab_system->update();
+		// the save job is finished, publish its result
+		if (compareAndExchange(&m_save_finished, 0, 1)) waitForSave();
 	}
 
 
 	~WorldEditorImpl()
 	{
+		waitForSave();
 		destroyUniverse();
 
 		m_prefab_system.reset();
@@ -1937,7 +1988,7 @@ public:
 	}
 
 
-	bool isUniverseChanged() const override { return m_is_universe_changed; }
+	bool isUniverseChanged() const override { return m_universe_changes != m_saved_universe_changes; }
 
 	void saveUniverse(const char* basename, bool save_path) override
 	{
@@ -1948,24 +1999,138 @@ public:
 		StaticString<LUMIX_MAX_PATH> path(m_engine.getFileSystem().getBasePath(), "universes");
 		if (!os::makePath(path)) logError("Could not create directory universes/");
 		path << "/" << basename << ".unv";
-		StaticString<LUMIX_MAX_PATH> bkp_path(path, ".bak");
-		if (os::fileExists(path)) {
-			if (!os::copyFile(path, bkp_path)) {
-				logError("Could not copy ", path, " to ", bkp_path);
+
+		while (m_engine.getFileSystem().hasWork()) m_engine.getFileSystem().processCallbacks();
+		ASSERT(m_universe);
+		serializeChangedParts();
+
+		// the file is written from already serialized parts, so editing can continue meanwhile
+		m_save_cache.path = path;
+		m_save_cache.universe_changes = m_universe_changes;
+		m_save_cache.is_saved = false;
+		jobs::run(this, [](void* data){
+			WorldEditorImpl* editor = (WorldEditorImpl*)data;
+			editor->writeSaveCache();
+			memoryBarrier();
+			atomicIncrement(&editor->m_save_finished);
+		}, &m_save_signal);
+
+		if (save_path) m_universe->setName(basename);
+	}
+
+
+	void writeSaveCache()
+	{
+		PROFILE_FUNCTION();
+		const char* path = m_save_cache.path;
+		// the previous file stays untouched until the new one is completely written
+		const StaticString<LUMIX_MAX_PATH> tmp_path(path, ".tmp");
+		os::OutputFile file;
+		if (!file.open(tmp_path)) {
+			logError("Failed to save universe ", tmp_path);
+			return;
+		}
+		const bool success = writeSaveCache(file);
+		file.close();
+		if (!success) {
+			logError("Failed to write ", tmp_path);
+			if (!os::deleteFile(tmp_path)) logError("Could not delete ", tmp_path);
+			return;
+		}
+
+		const StaticString<LUMIX_MAX_PATH> bkp_path(path, ".bak");
+		if (os::fileExists(path) && !os::copyFile(path, bkp_path)) {
+			logError("Could not copy ", path, " to ", bkp_path);
+		}
+		if (!os::moveFile(tmp_path, path)) {
+			logError("Could not move ", tmp_path, " to ", path);
+			return;
+		}
+		// universe is not marked as saved until it's really on disk
+		m_save_cache.is_saved = true;
+		logInfo("Universe saved");
+	}
+
+
+	bool writeSaveCache(IOutputStream& file) const
+	{
+		const SaveCache& cache = m_save_cache;
+		u32 engine_hash = crc32(cache.universe.data(), (u32)cache.universe.size());
+		for (const OutputMemoryStream& scene : cache.scenes) {
+			engine_hash = continueCrc32(engine_hash, scene.data(), (u32)scene.size());
+		}
+
+		Header header = {0xffffFFFF, (int)SerializedVersion::LATEST, 0, engine_hash};
+		header.hash = crc32(cache.header.data(), (u32)cache.header.size());
+		header.hash = continueCrc32(header.hash, cache.universe.data(), (u32)cache.universe.size());
+		for (const OutputMemoryStream& scene : cache.scenes) {
+			header.hash = continueCrc32(header.hash, scene.data(), (u32)scene.size());
+		}
+		header.hash = continueCrc32(header.hash, cache.editor.data(), (u32)cache.editor.size());
+
+		bool success = file.write(header);
+		success = file.write(cache.header.data(), cache.header.size()) && success;
+		success = file.write(cache.universe.data(), cache.universe.size()) && success;
+		for (const OutputMemoryStream& scene : cache.scenes) {
+			success = file.write(scene.data(), scene.size()) && success;
+		}
+		success = file.write(cache.editor.data(), cache.editor.size()) && success;
+		return success;
+	}
+
+
+	// m_saved_universe_changes is published here, on the main thread, since the save job must not touch it
+	void waitForSave()
+	{
+		if (m_save_signal == jobs::INVALID_HANDLE) return;
+		jobs::wait(m_save_signal);
+		m_save_signal = jobs::INVALID_HANDLE;
+		m_save_finished = 0;
+		if (m_save_cache.is_saved) m_saved_universe_changes = m_save_cache.universe_changes;
+	}
+
+
+	// serializes only parts changed since the last save, unchanged parts are kept from previous saves
+	void serializeChangedParts()
+	{
+		PROFILE_FUNCTION();
+		waitForSave();
+
+		SaveCache& cache = m_save_cache;
+		Array<UniquePtr<IScene>>& scenes = m_universe->getScenes();
+		if (!cache.is_valid) {
+			cache.header.clear();
+			m_engine.serializeHeader(cache.header);
+			cache.scenes.clear();
+			cache.dirty_scenes.clear();
+			for (i32 i = 0; i < scenes.size(); ++i) {
+				cache.scenes.emplace(m_allocator);
+				cache.dirty_scenes.push(true);
 			}
+			cache.is_universe_dirty = true;
+			cache.is_valid = true;
 		}
-		os::OutputFile file;
-		if (file.open(path)) {
-			save(file);
-			file.close();
+
+		if (cache.is_universe_dirty) {
+			cache.universe.clear();
+			m_engine.serializeUniverse(*m_universe, cache.universe);
+			cache.is_universe_dirty = false;
 		}
-		else {
-			logError("Failed to save universe ", basename);
+
+		for (i32 i = 0; i < scenes.size(); ++i) {
+			if (!cache.dirty_scenes[i]) continue;
+			cache.scenes[i].clear();
+			m_engine.serializeScene(*scenes[i], cache.scenes[i]);
+			cache.dirty_scenes[i] = false;
 		}
-		
-		m_is_universe_changed = false;
 
-		if (save_path) m_universe->setName(basename);
+		// editor data are small, no need to track their changes
+		cache.editor.clear();
+		m_prefab_system->serialize(cache.editor);
+		m_entity_folders->serialize(cache.editor);
+		const Viewport& vp = getView().getViewport();
+		cache.editor.write(vp.pos);
+		cache.editor.write(vp.rot);
 	}
 
 
@@ -1975,24 +2140,246 @@ public:
 
 		ASSERT(m_universe);
 
+		serializeChangedParts();
+		writeSaveCache(file);
+
+		logInfo("Universe saved");
+	}
+
+
+	void markSceneDirty(IScene* scene)
+	{
+		Array<UniquePtr<IScene>>& scenes = m_universe->getScenes();
+		for (i32 i = 0; i < m_save_cache.dirty_scenes.size(); ++i) {
+			if (scenes[i].get() == scene) {
+				m_save_cache.dirty_scenes[i] = true;
+				return;
+			}
+		}
+	}
+
+
+	void markChanged(IEditorCommand& command)
+	{
+		ComponentType type;
+		switch (command.getChanges(type)) {
+			case IEditorCommand::Changes::UNKNOWN: m_save_cache.is_valid = false; break;
+			case IEditorCommand::Changes::NONE: break;
+			case IEditorCommand::Changes::ENTITIES: m_save_cache.is_universe_dirty = true; break;
+			case IEditorCommand::Changes::COMPONENT: markSceneDirty(m_universe->getScene(type)); break;
+		}
+	}
+
+
+	void onEntityChanged(EntityRef) { m_save_cache.is_universe_dirty = true; }
+	void onComponentChanged(const ComponentUID& cmp) { markSceneDirty(cmp.scene); }
+
+
+	void bindUniverseEvents()
+	{
+		m_universe->entityDestroyed().bind<&WorldEditorImpl::onEntityDestroyed>(this);
+		m_universe->entityCreated().bind<&WorldEditorImpl::onEntityChanged>(this);
+		m_universe->entityDestroyed().bind<&WorldEditorImpl::onEntityChanged>(this);
+		m_universe->entityTransformed().bind<&WorldEditorImpl::onEntityChanged>(this);
+		m_universe->componentAdded().bind<&WorldEditorImpl::onComponentChanged>(this);
+		m_universe->componentDestroyed().bind<&WorldEditorImpl::onComponentChanged>(this);
+		// entity indices can differ after load, so nothing from the previous universe can be reused
+		m_save_cache.is_valid = false;
+	}
+
+
+	bool isInGlobalFolder(EntityRef e) const {
+		EntityFolders::FolderID folder = m_entity_folders->getFolder(e);
+		while (folder != EntityFolders::INVALID_FOLDER) {
+			const EntityFolders::Folder& f = m_entity_folders->getFolder(folder);
+			if (equalIStrings(f.name, "global")) return true;
+			folder = f.parent_folder;
+		}
+		return false;
+	}
+
+
+	void saveSectors(const char* basename, float sector_size) override
+	{
+		PROFILE_FUNCTION();
+		ASSERT(m_universe);
+		ASSERT(sector_size > 0);
+		while (m_engine.getFileSystem().hasWork()) m_engine.getFileSystem().processCallbacks();
+
+		struct Sector {
+			Sector(IAllocator& allocator) : entities(allocator) {}
+			IVec2 coord;
+			u32 flags;
+			Array<EntityRef> entities;
+		};
+
+		Array<Sector> sectors(m_allocator);
+		Array<u32> entity_sectors(m_allocator);
+		HashMap<u64, u32> coord_to_sector(m_allocator);
+		Sector& global = sectors.emplace(m_allocator);
+		global.coord = IVec2(0);
+		global.flags = SectorManifestEntry::GLOBAL;
+		for (EntityPtr e = m_universe->getFirstEntity(); e.isValid(); e = m_universe->getNextEntity((EntityRef)e)) {
+			EntityRef root = (EntityRef)e;
+			for (EntityPtr parent = m_universe->getParent(root); parent.isValid(); parent = m_universe->getParent(root)) {
+				root = (EntityRef)parent;
+			}
+
+			u32 sector_idx = 0;
+			if (!isInGlobalFolder(root)) {
+				const DVec3 pos = m_universe->getPosition(root);
+				const IVec2 coord((i32)floor(pos.x / sector_size), (i32)floor(pos.z / sector_size));
+				const u64 key = u64(u32(coord.x)) | (u64(u32(coord.y)) << 32);
+				auto iter = coord_to_sector.find(key);
+				if (iter.isValid()) {
+					sector_idx = iter.value();
+				}
+				else {
+					sector_idx = sectors.size();
+					Sector& sector = sectors.emplace(m_allocator);
+					sector.coord = coord;
+					sector.flags = SectorManifestEntry::NONE;
+					coord_to_sector.insert(key, sector_idx);
+				}
+			}
+			sectors[sector_idx].entities.push((EntityRef)e);
+			while ((u32)entity_sectors.size() <= (u32)e.index) entity_sectors.push(0xffFFffFF);
+			entity_sectors[e.index] = sector_idx;
+		}
+
+		StaticString<LUMIX_MAX_PATH> dir(m_engine.getFileSystem().getBasePath(), "universes/", basename);
+		if (!os::makePath(dir)) {
+			logError("Could not create directory ", dir);
+			return;
+		}
+
+		SectorManifestHeader header;
+		header.sector_size = sector_size;
+		header.sectors_count = 0;
+		OutputMemoryStream manifest(m_allocator);
+		manifest.write(header);
+
+		// scenes have state which is not reflected, so each sector is a full copy of the universe
+		// with other sectors' entities destroyed, this deserializes the whole universe once per sector
+		OutputMemoryStream src_blob(m_allocator);
+		m_engine.serialize(*m_universe, src_blob);
+
+		// entity properties pointing to other sectors, the streamer sets them when both sectors are instantiated
+		struct RefCollector : reflection::IEmptyPropertyVisitor {
+			RefCollector(IAllocator& allocator) : refs(allocator) {}
+
+			void visit(const reflection::Property<EntityPtr>& prop) override {
+				const EntityPtr target = prop.get(cmp, array_index);
+				if (!target.isValid() || (u32)target.index >= (u32)entity_sectors->size()) return;
+				if ((*entity_sectors)[target.index] == sector) return;
+				const EntityPtr mapped_target = map->get(target);
+				if (!mapped_target.isValid()) return;
+
+				SectorEntityRef& ref = refs.emplace();
+				ref.entity = map->get((EntityRef)cmp.entity).index;
+				ref.cmp_hash = cmp_hash;
+				ref.array_hash = array_hash;
+				ref.prop_hash = crc32(prop.name);
+				ref.array_index = array_index;
+				ref.target = mapped_target.index;
+			}
+
+			void visit(const reflection::ArrayProperty& prop) override {
+				array_hash = crc32(prop.name);
+				for (u32 i = 0, c = prop.getCount(cmp); i < c; ++i) {
+					array_index = i;
+					prop.visitChildren(*this);
+				}
+				array_hash = 0;
+				array_index = -1;
+			}
+
+			Array<SectorEntityRef> refs;
+			const Array<u32>* entity_sectors;
+			const EntityMap* map;
+			ComponentUID cmp;
+			u32 sector;
+			u32 cmp_hash;
+			u32 array_hash = 0;
+			i32 array_index = -1;
+		};
+
+		RefCollector collector(m_allocator);
+		collector.entity_sectors = &entity_sectors;
 		OutputMemoryStream blob(m_allocator);
-		blob.reserve(64 * 1024);
+		Array<u32> persistent_ids(m_allocator);
+		for (u32 sector_idx = 0, c = sectors.size(); sector_idx < c; ++sector_idx) {
+			const Sector& sector = sectors[sector_idx];
+			if (sector.entities.empty()) continue;
+
+			// a new universe assigns the same indices on each deserialization, so they are the persistent IDs
+			Universe& dst = m_engine.createUniverse(false);
+			EntityMap map(m_allocator);
+			InputMemoryStream src(src_blob);
+			if (!m_engine.deserialize(dst, src, map)) {
+				logError("Could not copy universe for sector ", sector.coord.x, "_", sector.coord.y);
+				m_engine.destroyUniverse(dst);
+				return;
+			}
+			for (EntityPtr e = m_universe->getFirstEntity(); e.isValid(); e = m_universe->getNextEntity((EntityRef)e)) {
+				if (entity_sectors[e.index] != sector_idx) dst.destroyEntity(map.get((EntityRef)e));
+			}
 
-		Header header = {0xffffFFFF, (int)SerializedVersion::LATEST, 0, 0};
-		blob.write(header);
-		int hashed_offset = sizeof(header);
+			blob.clear();
+			m_engine.serialize(dst, blob);
+			m_engine.destroyUniverse(dst);
+
+			persistent_ids.clear();
+			collector.refs.clear();
+			collector.map = &map;
+			collector.sector = sector_idx;
+			for (EntityRef e : sector.entities) {
+				persistent_ids.push(map.get(e).index);
+				for (ComponentUID cmp = m_universe->getFirstComponent(e); cmp.isValid(); cmp = m_universe->getNextComponent(cmp)) {
+					const reflection::ComponentBase* cmp_desc = reflection::getComponent(cmp.type);
+					if (!cmp_desc) continue;
+					collector.cmp = cmp;
+					collector.cmp_hash = crc32(cmp_desc->name);
+					cmp_desc->visit(collector);
+				}
+			}
 
-		header.engine_hash = m_engine.serialize(*m_universe, blob);
-		m_prefab_system->serialize(blob);
-		m_entity_folders->serialize(blob);
-		const Viewport& vp = getView().getViewport();
-		blob.write(vp.pos);
-		blob.write(vp.rot);
-		header.hash = crc32((const u8*)blob.data() + hashed_offset, (int)blob.size() - hashed_offset);
-		memcpy(blob.getMutableData(), &header, sizeof(header));
-		file.write(blob.data(), blob.size());
+			const StaticString<LUMIX_MAX_PATH> path = (sector.flags & SectorManifestEntry::GLOBAL)
+				? StaticString<LUMIX_MAX_PATH>(dir, "/global.sec")
+				: StaticString<LUMIX_MAX_PATH>(dir, "/", sector.coord.x, "_", sector.coord.y, ".sec");
+			os::OutputFile file;
+			if (!file.open(path)) {
+				logError("Could not create ", path);
+				return;
+			}
+			const bool written = file.write(blob.data(), blob.size());
+			file.close();
+			if (!written) {
+				logError("Could not write ", path);
+				return;
+			}
 
-		logInfo("Universe saved");
+			SectorManifestEntry entry;
+			entry.coord = sector.coord;
+			entry.flags = sector.flags;
+			entry.entities_count = persistent_ids.size();
+			manifest.write(entry);
+			manifest.write(persistent_ids.begin(), persistent_ids.byte_size());
+			manifest.write((u32)collector.refs.size());
+			manifest.write(collector.refs.begin(), collector.refs.byte_size());
+			++header.sectors_count;
+		}
+		memcpy(manifest.getMutableData(), &header, sizeof(header));
+
+		const StaticString<LUMIX_MAX_PATH> manifest_path(dir, "/sectors.lsm");
+		os::OutputFile file;
+		if (!file.open(manifest_path)) {
+			logError("Could not create ", manifest_path);
+			return;
+		}
+		if (!file.write(manifest.data(), manifest.size())) logError("Could not write ", manifest_path);
+		file.close();
+		logInfo("Universe ", basename, " exported to ", header.sectors_count, " sectors");
 	}
 
 
@@ -2156,13 +2543,9 @@ public:
 	void beginCommandGroup(const char* type_str) override
 	{
 		const u32 type = crc32(type_str);
-		while (m_undo_index < m_undo_stack.size() - 1)
+		if (m_undo_index < m_undo_stack.size() - 1)
 		{
-			for(int i = m_undo_stack.size() - 1; i > m_undo_index; --i)
-			{
-				m_undo_stack[i].reset();
-			}
-			m_undo_stack.resize(m_undo_index + 1);
+			truncateUndoStack(m_undo_index + 1);
 		}
 
 		if(m_undo_index >= 0)
@@ -2172,9 +2555,8 @@ public:
 			{
 				if(static_cast<EndGroupCommand*>(m_undo_stack[m_undo_index].get())->group_type == type)
 				{
-					m_undo_stack[m_undo_index].reset();
+					truncateUndoStack(m_undo_index);
 					--m_undo_index;
-					m_undo_stack.pop();
 					return;
 				}
 			}
@@ -2184,6 +2566,7 @@ public:
 		UniquePtr<BeginGroupCommand> cmd = UniquePtr<BeginGroupCommand>::create(m_allocator);
 		m_undo_stack.push(cmd.move());
 		++m_undo_index;
+		releaseColdPayloads(m_undo_index - 1);
 	}
 
 
@@ -2191,17 +2574,14 @@ public:
 	{
 		if (m_undo_index < m_undo_stack.size() - 1)
 		{
-			for (int i = m_undo_stack.size() - 1; i > m_undo_index; --i)
-			{
-				m_undo_stack[i].reset();
-			}
-			m_undo_stack.resize(m_undo_index + 1);
+			truncateUndoStack(m_undo_index + 1);
 		}
 
 		UniquePtr<EndGroupCommand> cmd = UniquePtr<EndGroupCommand>::create(m_allocator);
 		cmd->group_type = m_current_group_type;
 		m_undo_stack.push(cmd.move());
 		++m_undo_index;
+		releaseColdPayloads(m_undo_index - 1);
 	}
 
 	void executeCommand(UniquePtr<IEditorCommand>&& command) override
@@ -2212,24 +2592,31 @@ public:
 
 	void doExecute(UniquePtr<IEditorCommand>&& command)
 	{
-		m_is_universe_changed = true;
+		++m_universe_changes;
 		if (m_undo_index >= 0 && command->getType() == m_undo_stack[m_undo_index]->getType())
 		{
-			if (command->merge(*m_undo_stack[m_undo_index]))
+			if (!restoreUndoPayload(m_undo_index)) {
+				logError("Undo history is lost");
+				destroyUndoStack();
+			}
+			else if (command->merge(*m_undo_stack[m_undo_index]))
 			{
 				m_undo_stack[m_undo_index]->execute();
+				markChanged(*m_undo_stack[m_undo_index]);
 				return;
 			}
 		}
 
 		if (command->execute())
 		{
+			markChanged(*command);
 			if (m_undo_index < m_undo_stack.size() - 1) {
-				m_undo_stack.resize(m_undo_index + 1);
+				truncateUndoStack(m_undo_index + 1);
 			}
 			m_undo_stack.emplace(command.move());
 			if (m_is_game_mode) ++m_game_mode_commands;
 			++m_undo_index;
+			releaseColdPayloads(m_undo_index - 1);
 			return;
 		}
 		else {
@@ -2263,11 +2650,8 @@ public:
 
 	void stopGameMode(bool reload)
 	{
-		for (int i = 0; i < m_game_mode_commands; ++i)
-		{
-			m_undo_stack.pop();
-			--m_undo_index;
-		}
+		truncateUndoStack(m_undo_stack.size() - m_game_mode_commands);
+		m_undo_index -= m_game_mode_commands;
 
 		ASSERT(m_universe);
 		m_engine.getResourceManager().enableUnload(false);
@@ -2287,7 +2671,7 @@ public:
 			m_prefab_system->setUniverse(m_universe);
 			m_universe_created.invoke();
 			m_universe->setName(name);
-			m_universe->entityDestroyed().bind<&WorldEditorImpl::onEntityDestroyed>(this);
+			bindUniverseEvents();
 			m_selected_entities.clear();
             InputMemoryStream file(m_game_mode_file);
 			load(file);
@@ -2597,6 +2981,8 @@ public:
 		, m_universe_created(m_allocator)
 		, m_selected_entities(m_allocator)
 		, m_undo_stack(m_allocator)
+		, m_undo_payloads(m_allocator)
+		, m_undo_journal_refs(m_allocator)
 		, m_copy_buffer(m_allocator)
 		, m_is_loading(false)
 		, m_universe(nullptr)
@@ -2605,6 +2991,7 @@ public:
 		, m_undo_index(-1)
 		, m_engine(engine)
 		, m_game_mode_file(m_allocator)
+		, m_save_cache(m_allocator)
 	{
 		loadProject();
 		logInfo("Initializing editor...");
@@ -2730,8 +3117,224 @@ public:
 
 	void destroyUndoStack()
 	{
+		truncateUndoStack(0);
 		m_undo_index = -1;
-		m_undo_stack.clear();
+		if (m_undo_journal_segment >= 0) closeUndoJournalSegment();
+		m_undo_journal_refs.clear();
+		m_undo_journal_failed = false;
+	}
+
+
+	StaticString<LUMIX_MAX_PATH> getUndoJournalPath(i32 segment)
+	{
+		return StaticString<LUMIX_MAX_PATH>(m_engine.getFileSystem().getBasePath(), ".lumix/undo_journal_", segment, ".bin");
+	}
+
+
+	void deleteJournalSegment(i32 segment)
+	{
+		if (!os::deleteFile(getUndoJournalPath(segment))) {
+			logError("Could not delete ", getUndoJournalPath(segment));
+		}
+	}
+
+
+	// spilling continues in a new segment, closed segment is deleted once it has no payloads
+	void closeUndoJournalSegment()
+	{
+		const i32 segment = m_undo_journal_segment;
+		m_undo_journal.close();
+		m_undo_journal_segment = -1;
+		if (m_undo_journal_refs[segment] == 0) deleteJournalSegment(segment);
+	}
+
+
+	void releaseJournalSegment(i32 segment)
+	{
+		--m_undo_journal_refs[segment];
+		if (m_undo_journal_refs[segment] > 0) return;
+		if (segment == m_undo_journal_segment) {
+			closeUndoJournalSegment();
+		}
+		else {
+			deleteJournalSegment(segment);
+		}
+	}
+
+
+	void dropUndoPayload(const UndoPayload& payload)
+	{
+		if (payload.segment >= 0) {
+			releaseJournalSegment(payload.segment);
+		}
+		else {
+			m_undo_memory_size -= payload.size;
+		}
+	}
+
+
+	// destroys commands from `size` to the top of the undo stack
+	void truncateUndoStack(i32 size)
+	{
+		if (!m_undo_payloads.empty()) {
+			m_undo_payloads.eraseIf([&](const UndoPayload& payload){
+				if (payload.index < size) return false;
+				dropUndoPayload(payload);
+				return true;
+			});
+		}
+		for (i32 i = m_undo_stack.size() - 1; i >= size; --i) {
+			m_undo_stack[i].reset();
+		}
+		m_undo_stack.resize(size);
+	}
+
+
+	// gives the payload back to the command, must be called before the command is executed or undone
+	[[nodiscard]] bool restoreUndoPayload(i32 idx)
+	{
+		auto iter = m_undo_payloads.find(idx);
+		if (!iter.isValid()) return true;
+
+		PROFILE_FUNCTION();
+		UndoPayload& payload = iter.value();
+		bool success = true;
+		if (payload.segment >= 0) {
+			// the segment can not be read while it's open for writing
+			if (payload.segment == m_undo_journal_segment) closeUndoJournalSegment();
+			os::InputFile file;
+			const StaticString<LUMIX_MAX_PATH> path = getUndoJournalPath(payload.segment);
+			payload.data.resize(payload.size);
+			success = file.open(path);
+			if (success) {
+				success = file.seek(payload.offset) && file.read(payload.data.getMutableData(), payload.size);
+				file.close();
+			}
+			if (!success) logError("Could not read ", path);
+		}
+
+		OutputMemoryStream raw(m_allocator);
+		if (success && payload.compressed) {
+			raw.resize(payload.raw_size);
+			const i32 size = LZ4_decompress_safe((const char*)payload.data.data(), (char*)raw.getMutableData(), (i32)payload.size, (i32)payload.raw_size);
+			success = size == (i32)payload.raw_size;
+			if (!success) logError("Corrupted undo payload");
+		}
+		if (success) {
+			InputMemoryStream blob(payload.compressed ? raw : payload.data);
+			m_undo_stack[idx]->restorePayload(blob);
+		}
+
+		dropUndoPayload(payload);
+		m_undo_payloads.erase(iter);
+		return success;
+	}
+
+
+	// payloads of commands farther than HOT_UNDO_COMMANDS from m_undo_index are compressed,
+	// only commands around the range the undo index moved in can change their state
+	void releaseColdPayloads(i32 prev_undo_index)
+	{
+		PROFILE_FUNCTION();
+		const i32 from = maximum(0, minimum(prev_undo_index, m_undo_index) - HOT_UNDO_COMMANDS - 1);
+		const i32 to = minimum(m_undo_stack.size(), maximum(prev_undo_index, m_undo_index) + HOT_UNDO_COMMANDS + 2);
+		OutputMemoryStream raw(m_allocator);
+		OutputMemoryStream compressed(m_allocator);
+		for (i32 i = from; i < to; ++i) {
+			if (i >= m_undo_index - HOT_UNDO_COMMANDS && i <= m_undo_index + HOT_UNDO_COMMANDS) continue;
+			if (m_undo_payloads.find(i).isValid()) continue;
+
+			raw.clear();
+			m_undo_stack[i]->releasePayload(raw);
+			if (raw.empty()) continue;
+
+			UndoPayload payload(m_allocator);
+			payload.index = i;
+			payload.raw_size = raw.size();
+			const OutputMemoryStream* stored = &raw;
+			if (raw.size() <= LZ4_MAX_INPUT_SIZE) {
+				const i32 cap = LZ4_compressBound((i32)raw.size());
+				compressed.resize(cap);
+				const i32 size = LZ4_compress_default((const char*)raw.data(), (char*)compressed.getMutableData(), (i32)raw.size(), cap);
+				if (size > 0 && (u64)size < raw.size()) {
+					compressed.resize(size);
+					stored = &compressed;
+					payload.compressed = true;
+				}
+			}
+			payload.size = stored->size();
+			payload.data.reserve(payload.size);
+			payload.data.write(stored->data(), stored->size());
+			m_undo_memory_size += payload.size;
+			m_undo_payloads.insert(i, static_cast<UndoPayload&&>(payload));
+		}
+		enforceUndoBudget();
+	}
+
+
+	// moves the oldest payloads from memory to the journal until they fit in the budget
+	void enforceUndoBudget()
+	{
+		if (m_undo_memory_size <= m_undo_memory_budget || m_undo_journal_failed) return;
+
+		PROFILE_FUNCTION();
+		for (i32 i = 0, c = m_undo_stack.size(); i < c && m_undo_memory_size > m_undo_memory_budget; ++i) {
+			auto iter = m_undo_payloads.find(i);
+			if (!iter.isValid()) continue;
+			UndoPayload& payload = iter.value();
+			if (payload.segment >= 0) continue;
+
+			if (m_undo_journal_segment < 0) {
+				// segments without payloads are deleted, their slots are reused so there are only as many as live segments
+				m_undo_journal_segment = m_undo_journal_refs.indexOf(0u);
+				if (m_undo_journal_segment < 0) {
+					m_undo_journal_segment = m_undo_journal_refs.size();
+					m_undo_journal_refs.push(0);
+				}
+				m_undo_journal_size = 0;
+				const StaticString<LUMIX_MAX_PATH> path = getUndoJournalPath(m_undo_journal_segment);
+				if (!m_undo_journal.open(path)) {
+					logError("Could not create ", path, ", undo history is kept in memory");
+					m_undo_journal_segment = -1;
+					m_undo_journal_failed = true;
+					return;
+				}
+			}
+			if (!m_undo_journal.write(payload.data.data(), payload.size)) {
+				logError("Could not write ", getUndoJournalPath(m_undo_journal_segment), ", undo history is kept in memory");
+				m_undo_journal_failed = true;
+				return;
+			}
+			payload.segment = m_undo_journal_segment;
+			payload.offset = m_undo_journal_size;
+			m_undo_journal_size += payload.size;
+			++m_undo_journal_refs[payload.segment];
+			m_undo_memory_size -= payload.size;
+			payload.data.free();
+			if (m_undo_journal_size >= UNDO_JOURNAL_SEGMENT_SIZE) closeUndoJournalSegment();
+		}
+		if (m_undo_journal_segment >= 0) m_undo_journal.flush();
+	}
+
+
+	void setUndoMemoryBudget(u64 bytes) override
+	{
+		m_undo_memory_budget = bytes;
+		enforceUndoBudget();
+	}
+
+
+	UndoStats getUndoStats() const override
+	{
+		UndoStats stats;
+		stats.commands = m_undo_stack.size();
+		stats.released = m_undo_payloads.size();
+		for (const UndoPayload& payload : m_undo_payloads) {
+			stats.raw_size += payload.raw_size;
+			if (payload.segment >= 0) stats.journal_size += payload.size;
+		}
+		stats.memory_size = m_undo_memory_size;
+		return stats;
 	}
 
 
@@ -2739,12 +3342,13 @@ public:
 	{
 		ASSERT(!m_universe);
 
-		m_is_universe_changed = false;
+		waitForSave();
+		m_saved_universe_changes = m_universe_changes;
 		destroyUndoStack();
 		m_universe = &m_engine.createUniverse(true);
 		Universe* universe = m_universe;
 
-		universe->entityDestroyed().bind<&WorldEditorImpl::onEntityDestroyed>(this);
+		bindUniverseEvents();
 		m_entity_folders.create(*m_universe, m_allocator);
 
 		m_selected_entities.clear();
@@ -2774,21 +3378,23 @@ public:
 
 		if (m_undo_index >= m_undo_stack.size() || m_undo_index < 0) return;
 
+		const i32 prev_undo_index = m_undo_index;
 		if(crc32(m_undo_stack[m_undo_index]->getType()) == end_group_hash)
 		{
 			--m_undo_index;
 			while(crc32(m_undo_stack[m_undo_index]->getType()) != begin_group_hash)
 			{
-				m_undo_stack[m_undo_index]->undo();
+				if (!undoCommand(m_undo_index)) return;
 				--m_undo_index;
 			}
 			--m_undo_index;
 		}
 		else
 		{
-			m_undo_stack[m_undo_index]->undo();
+			if (!undoCommand(m_undo_index)) return;
 			--m_undo_index;
 		}
+		releaseColdPayloads(prev_undo_index);
 	}
 
 
@@ -2801,20 +3407,49 @@ public:
 
 		if (m_undo_index + 1 >= m_undo_stack.size()) return;
 
+		const i32 prev_undo_index = m_undo_index;
 		++m_undo_index;
 		if(crc32(m_undo_stack[m_undo_index]->getType()) == begin_group_hash)
 		{
 			++m_undo_index;
 			while(crc32(m_undo_stack[m_undo_index]->getType()) != end_group_hash)
 			{
-				m_undo_stack[m_undo_index]->execute();
+				if (!redoCommand(m_undo_index)) return;
 				++m_undo_index;
 			}
 		}
 		else
 		{
-			m_undo_stack[m_undo_index]->execute();
+			if (!redoCommand(m_undo_index)) return;
+		}
+		releaseColdPayloads(prev_undo_index);
+	}
+
+
+	// if a payload can not be restored, the history can not be trusted anymore and it's dropped
+	bool undoCommand(i32 idx)
+	{
+		if (!restoreUndoPayload(idx)) {
+			logError("Undo history is lost");
+			destroyUndoStack();
+			return false;
 		}
+		m_undo_stack[idx]->undo();
+		markChanged(*m_undo_stack[idx]);
+		return true;
+	}
+
+
+	bool redoCommand(i32 idx)
+	{
+		if (!restoreUndoPayload(idx)) {
+			logError("Undo history is lost");
+			destroyUndoStack();
+			return false;
+		}
+		m_undo_stack[idx]->execute();
+		markChanged(*m_undo_stack[idx]);
+		return true;
 	}
 
 
@@ -2833,12 +3468,24 @@ private:
 	Local<EntityFolders> m_entity_folders;
 	Universe* m_universe;
 	bool m_is_loading;
-	bool m_is_universe_changed;
+	// the universe is changed if commands were executed since the last successful save
+	u32 m_universe_changes = 0;
+	u32 m_saved_universe_changes = 0;
 	
 	Array<UniquePtr<IEditorCommand>> m_undo_stack;
 	int m_undo_index;
 	u32 m_current_group_type;
 
+	HashMap<i32, UndoPayload> m_undo_payloads;
+	u64 m_undo_memory_budget = 256 * 1024 * 1024;
+	u64 m_undo_memory_size = 0;		// payloads stored in memory
+	// .lumix/undo_journal_<segment>.bin, a segment is deleted once no payload is stored in it
+	Array<u32> m_undo_journal_refs;
+	os::OutputFile m_undo_journal;
+	i32 m_undo_journal_segment = -1;	// open for writing, -1 if there is none
+	u64 m_undo_journal_size = 0;
+	bool m_undo_journal_failed = false;
+
 	Array<EntityRef> m_selected_entities;
 	EntityPtr m_selected_entity_on_game_mode;
 
@@ -2849,6 +3496,34 @@ private:
 	DelegateList<void()> m_universe_created;
 
 	OutputMemoryStream m_copy_buffer;
+
+	// serialized parts of the universe, a part is serialized again only if it changed since the last save;
+	// parts are written to file in a job, so they must not be modified until m_save_signal is done;
+	// a part is a whole scene, since IScene::serialize can not write a subset of component types
+	struct SaveCache {
+		SaveCache(IAllocator& allocator)
+			: header(allocator)
+			, universe(allocator)
+			, scenes(allocator)
+			, dirty_scenes(allocator)
+			, editor(allocator)
+		{}
+
+		OutputMemoryStream header;
+		OutputMemoryStream universe;
+		Array<OutputMemoryStream> scenes;
+		Array<bool> dirty_scenes;
+		OutputMemoryStream editor;
+		bool is_universe_dirty = true;
+		bool is_valid = false;
+		StaticString<LUMIX_MAX_PATH> path;
+		u32 universe_changes = 0;
+		bool is_saved = false;	// written by the save job
+	};
+
+	SaveCache m_save_cache;
+	jobs::SignalHandle m_save_signal = jobs::INVALID_HANDLE;
+	volatile i32 m_save_finished = 0;	// set by the save job when it's done
 };
 
 
@@ -2960,6 +3635,9 @@ public:
 
 
 	const char* getType() override { return "paste_entity"; }
+	Changes getChanges(ComponentType& type) override { return Changes::NONE; }
+	void releasePayload(OutputMemoryStream& blob) override { blob.write(m_copy_buffer.data(), m_copy_buffer.size()); m_copy_buffer.free(); }
+	void restorePayload(InputMemoryStream& blob) override { m_copy_buffer.clear(); m_copy_buffer.write(blob.getData(), blob.size()); }
 
 
 	bool merge(IEditorCommand& command) override
@@ -19,12 +19,26 @@ template <typename T> struct UniquePtr;
 
 struct IEditorCommand
 {
+	// what execute() and undo() change, lets saving skip parts of the universe which did not change;
+	// creating and destroying entities or components and moving entities is tracked through Universe's events
+	enum class Changes {
+		UNKNOWN,	// anything, the next save serializes the whole universe
+		NONE,		// nothing besides what Universe's events report, or only editor data
+		ENTITIES,	// entities' names or hierarchy
+		COMPONENT	// properties of components of type returned in `type`
+	};
+
 	virtual ~IEditorCommand() {}
 
 	virtual bool execute() = 0;
 	virtual void undo() = 0;
 	virtual const char* getType() = 0;
 	virtual bool merge(IEditorCommand& command) = 0;
+	virtual Changes getChanges(ComponentType& type) { return Changes::UNKNOWN; }
+	// commands far from the top of the undo stack give up data needed only by execute() and undo(),
+	// the editor keeps it compressed or on disk and gives it back through restorePayload() before the command is used again
+	virtual void releasePayload(struct OutputMemoryStream& blob) {}
+	virtual void restorePayload(struct InputMemoryStream& blob) {}
 };
 
 struct UniverseView {
@@ -83,6 +97,14 @@ struct LUMIX_EDITOR_API WorldEditor
 		NONE
 	};
 
+	struct UndoStats {
+		u32 commands = 0;
+		u32 released = 0;		// commands whose payload is compressed or in the journal
+		u64 raw_size = 0;		// uncompressed size of released payloads
+		u64 memory_size = 0;	// compressed payloads kept in memory
+		u64 journal_size = 0;	// payloads spilled to the journal on disk
+	};
+
 	static UniquePtr<WorldEditor> create(struct Engine& engine, struct IAllocator& allocator);
 
 	virtual bool loadProject() = 0;
@@ -101,6 +123,9 @@ struct LUMIX_EDITOR_API WorldEditor
 	virtual bool canRedo() const = 0;
 	virtual void undo() = 0;
 	virtual void redo() = 0;
+	// compressed payloads over the budget are moved to a journal on disk
+	virtual void setUndoMemoryBudget(u64 bytes) = 0;
+	virtual UndoStats getUndoStats() const = 0;
 	virtual void addComponent(Span<const EntityRef> entities, ComponentType type) = 0;
 	virtual void destroyComponent(Span<const EntityRef> entities, ComponentType cmp_type) = 0;
 	virtual EntityRef addEntity() = 0;
@@ -145,6 +170,9 @@ struct LUMIX_EDITOR_API WorldEditor
 
 	virtual void loadUniverse(const char* basename) = 0;
 	virtual void saveUniverse(const char* basename, bool save_path) = 0;
+	// splits the universe into sectors loadable by UniverseStreamer, hierarchies are assigned by their root's position,
+	// hierarchies in a folder named "global" (or in its subfolders) are always loaded
+	virtual void saveSectors(const char* basename, float sector_size) = 0;
 	virtual bool isLoading() const = 0;
 	virtual void newUniverse() = 0;
 	virtual void toggleGameMode() = 0;
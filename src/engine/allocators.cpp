@@ -1,8 +1,12 @@
 #include "engine/allocators.h"
 #include "engine/atomic.h"
 #include "engine/crt.h"
+#include "engine/debug.h"
+#include "engine/hash_map.h"
 #include "engine/math.h"
 #include "engine/os.h"
+#include "engine/profiler.h"
+#include "engine/string.h"
 #ifndef _WIN32
 	#include <string.h>
 	#include <malloc.h>
@@ -149,7 +153,7 @@ namespace Lumix
 	}
 
 	DefaultAllocator::~DefaultAllocator() {
-		os::memRelease(m_small_allocations);
+		os::memRelease(m_small_allocations, PAGE_SIZE * MAX_PAGE_COUNT);
 	}
 
 	void* DefaultAllocator::allocate(size_t n)
@@ -294,4 +298,284 @@ void* BaseProxyAllocator::reallocate(void* ptr, size_t size)
 }
 
 
+static constexpr u32 LINEAR_COMMIT_STEP = 1024 * 1024;
+
+LinearAllocator::LinearAllocator(u32 reserved)
+	: m_reserved((reserved + LINEAR_COMMIT_STEP - 1) & ~(LINEAR_COMMIT_STEP - 1))
+{
+	ASSERT(m_reserved <= 0x7fffFFFF);
+	m_mem = (u8*)os::memReserve(m_reserved);
+}
+
+LinearAllocator::~LinearAllocator() {
+	os::memRelease(m_mem, m_reserved);
+}
+
+// must not run concurrently with allocations
+void LinearAllocator::reset() {
+	m_high_water = maximum(m_high_water, (u32)m_end);
+	m_period_peak = maximum(m_period_peak, (u32)m_end);
+	m_end = 0;
+
+	++m_period_resets;
+	if (m_period_resets < TRIM_PERIOD) return;
+
+	const u32 keep = (m_period_peak + LINEAR_COMMIT_STEP - 1) & ~(LINEAR_COMMIT_STEP - 1);
+	if (keep < m_commited) {
+		os::memDecommit(m_mem + keep, m_commited - keep);
+		m_commited = keep;
+	}
+	m_period_peak = 0;
+	m_period_resets = 0;
+}
+
+void* LinearAllocator::allocate_aligned(size_t size, size_t align) {
+	ASSERT((align & (align - 1)) == 0);
+	u64 end;
+	u32 start;
+	for (;;) {
+		const i32 prev_end = m_end;
+		start = ((u32)prev_end + u32(align) - 1) & ~u32(align - 1);
+		end = start + (u64)size;
+		if (end > m_reserved) return nullptr;
+		if (compareAndExchange(&m_end, (i32)end, prev_end)) break;
+	}
+
+	if (end > m_commited) {
+		MutexGuard lock(m_mutex);
+		if (end > m_commited) {
+			const u32 commit = u32((end + LINEAR_COMMIT_STEP - 1) & ~u64(LINEAR_COMMIT_STEP - 1));
+			os::memCommit(m_mem + m_commited, commit - m_commited);
+			m_commited = commit;
+		}
+	}
+	return m_mem + start;
+}
+
+void LinearAllocator::deallocate_aligned(void* ptr) {
+	ASSERT(!ptr || owns(ptr));
+}
+
+void* LinearAllocator::reallocate_aligned(void* ptr, size_t size, size_t align) {
+	// size of the old block is not known, so it can not be moved
+	ASSERT(!ptr);
+	return size == 0 ? nullptr : allocate_aligned(size, align);
+}
+
+void* LinearAllocator::allocate(size_t size) {
+	return allocate_aligned(size, 16);
+}
+
+void LinearAllocator::deallocate(void* ptr) {
+	ASSERT(!ptr || owns(ptr));
+}
+
+void* LinearAllocator::reallocate(void* ptr, size_t size) {
+	ASSERT(!ptr);
+	return size == 0 ? nullptr : allocate(size);
+}
+
+
+static TagAllocator* s_first_tag = nullptr;
+
+static Mutex& getTagsMutex() {
+	static Mutex mutex;
+	return mutex;
+}
+
+
+struct TagAllocator::Tracking {
+	struct Allocation {
+		u64 size;
+		debug::StackNode* stack;
+	};
+
+	explicit Tracking(IAllocator& allocator) : allocations(allocator) {}
+
+	Mutex mutex;
+	HashMap<void*, Allocation> allocations;
+	Stats stats;
+	debug::StackTree* stack_tree = nullptr;
+	u32 stack_sampling = 0;
+	u32 sampling_counter = 0;
+};
+
+
+TagAllocator::TagAllocator(IAllocator& source, const char* tag_name)
+	: m_source(source)
+{
+	copyString(m_tag_name, tag_name);
+
+	#ifdef LUMIX_TRACK_ALLOCATIONS
+		m_tracking = LUMIX_NEW(m_source, Tracking)(m_source);
+	#endif
+
+	MutexGuard lock(getTagsMutex());
+	m_next = s_first_tag;
+	if (s_first_tag) s_first_tag->m_prev = this;
+	s_first_tag = this;
+}
+
+
+TagAllocator::~TagAllocator() {
+	{
+		MutexGuard lock(getTagsMutex());
+		if (m_prev) m_prev->m_next = m_next;
+		else s_first_tag = m_next;
+		if (m_next) m_next->m_prev = m_prev;
+	}
+
+	if (m_tracking) {
+		LUMIX_DELETE(m_source, m_tracking->stack_tree);
+		LUMIX_DELETE(m_source, m_tracking);
+	}
+}
+
+
+void TagAllocator::onAllocate(void* ptr, size_t size) {
+	#ifdef LUMIX_TRACK_ALLOCATIONS
+		if (!ptr) return;
+		Tracking& t = *m_tracking;
+		MutexGuard lock(t.mutex);
+		Tracking::Allocation a;
+		a.size = size;
+		a.stack = nullptr;
+		if (t.stack_sampling && ++t.sampling_counter >= t.stack_sampling) {
+			t.sampling_counter = 0;
+			a.stack = t.stack_tree->record();
+		}
+		t.allocations.insert(ptr, a);
+
+		Stats& stats = t.stats;
+		stats.live_bytes += size;
+		stats.peak_bytes = maximum(stats.peak_bytes, stats.live_bytes);
+		++stats.live_count;
+		++stats.alloc_count;
+		u32 bucket = 0;
+		while (bucket < HISTOGRAM_SIZE - 1 && size > (size_t(16) << bucket)) ++bucket;
+		++stats.histogram[bucket];
+	#endif
+}
+
+
+void TagAllocator::onDeallocate(void* ptr) {
+	#ifdef LUMIX_TRACK_ALLOCATIONS
+		if (!ptr) return;
+		Tracking& t = *m_tracking;
+		MutexGuard lock(t.mutex);
+		auto iter = t.allocations.find(ptr);
+		// allocated by other allocator
+		if (!iter.isValid()) return;
+
+		t.stats.live_bytes -= iter.value().size;
+		--t.stats.live_count;
+		++t.stats.free_count;
+		t.allocations.erase(iter);
+	#endif
+}
+
+
+void* TagAllocator::allocate_aligned(size_t size, size_t align) {
+	void* ptr = m_source.allocate_aligned(size, align);
+	onAllocate(ptr, size);
+	return ptr;
+}
+
+
+void TagAllocator::deallocate_aligned(void* ptr) {
+	onDeallocate(ptr);
+	m_source.deallocate_aligned(ptr);
+}
+
+
+void* TagAllocator::reallocate_aligned(void* ptr, size_t size, size_t align) {
+	onDeallocate(ptr);
+	void* res = m_source.reallocate_aligned(ptr, size, align);
+	if (size > 0) onAllocate(res, size);
+	return res;
+}
+
+
+void* TagAllocator::allocate(size_t size) {
+	void* ptr = m_source.allocate(size);
+	onAllocate(ptr, size);
+	return ptr;
+}
+
+
+void TagAllocator::deallocate(void* ptr) {
+	onDeallocate(ptr);
+	m_source.deallocate(ptr);
+}
+
+
+void* TagAllocator::reallocate(void* ptr, size_t size) {
+	onDeallocate(ptr);
+	void* res = m_source.reallocate(ptr, size);
+	if (size > 0) onAllocate(res, size);
+	return res;
+}
+
+
+TagAllocator::Stats TagAllocator::getStats() {
+	if (!m_tracking) return {};
+	MutexGuard lock(m_tracking->mutex);
+	return m_tracking->stats;
+}
+
+
+void TagAllocator::setStackSampling(u32 every_nth) {
+	if (!m_tracking) return;
+	MutexGuard lock(m_tracking->mutex);
+	if (every_nth && !m_tracking->stack_tree) m_tracking->stack_tree = LUMIX_NEW(m_source, debug::StackTree);
+	m_tracking->stack_sampling = every_nth;
+}
+
+
+u32 TagAllocator::getStackSampling() const {
+	return m_tracking ? m_tracking->stack_sampling : 0;
+}
+
+
+u32 TagAllocator::getSampledAllocations(Span<SampledAllocation> out) {
+	if (!m_tracking) return 0;
+	MutexGuard lock(m_tracking->mutex);
+	u32 count = 0;
+	for (const Tracking::Allocation& a : m_tracking->allocations) {
+		if (!a.stack) continue;
+		if (count < out.length()) out[count] = { a.stack, a.size };
+		++count;
+	}
+	return count;
+}
+
+
+u32 TagAllocator::getTags(Span<TagAllocator*> out) {
+	MutexGuard lock(getTagsMutex());
+	u32 count = 0;
+	for (TagAllocator* tag = s_first_tag; tag; tag = tag->m_next) {
+		if (count < out.length()) out[count] = tag;
+		++count;
+	}
+	return count;
+}
+
+
+void TagAllocator::pushProfilerCounters() {
+	#ifdef LUMIX_TRACK_ALLOCATIONS
+		MutexGuard lock(getTagsMutex());
+		for (TagAllocator* tag = s_first_tag; tag; tag = tag->m_next) {
+			const Stats stats = tag->getStats();
+			if (!tag->m_live_counter_name) {
+				tag->m_live_counter_name = profiler::internString(StaticString<48>(tag->m_tag_name, " KB"));
+				tag->m_rate_counter_name = profiler::internString(StaticString<48>(tag->m_tag_name, " allocs"));
+			}
+			profiler::pushInt(tag->m_live_counter_name, int(stats.live_bytes / 1024));
+			profiler::pushInt(tag->m_rate_counter_name, int(stats.alloc_count - tag->m_last_alloc_count));
+			tag->m_last_alloc_count = stats.alloc_count;
+		}
+	#endif
+}
+
+
 } // namespace Lumix
@@ -3,8 +3,15 @@
 #include "allocator.h"
 #include "sync.h"
 
+// TagAllocator statistics, on by default in debug builds
+#if !defined LUMIX_TRACK_ALLOCATIONS && defined LUMIX_DEBUG
+	#define LUMIX_TRACK_ALLOCATIONS
+#endif
+
 namespace Lumix {
 
+namespace debug { struct StackNode; }
+
 struct LUMIX_ENGINE_API DefaultAllocator final : IAllocator {
 	struct Page;
 
@@ -43,4 +50,101 @@ private:
 };
 
 
-} // namespace Lumix
\ No newline at end of file
+// Bump allocator in a reserved address range, memory is committed as needed.
+// Individual deallocations are no-ops, everything is released at once by reset(). Thread safe.
+// Every TRIM_PERIOD resets, memory above the peak use of those resets is decommitted.
+// Returns null when the reserved range is exhausted, callers are expected to fall back to other allocator.
+struct LUMIX_ENGINE_API LinearAllocator final : IAllocator {
+	static constexpr u32 TRIM_PERIOD = 256;
+
+	explicit LinearAllocator(u32 reserved);
+	~LinearAllocator();
+
+	void reset();
+	bool owns(const void* ptr) const { return ptr >= m_mem && ptr < m_mem + m_reserved; }
+	u32 getAllocated() const { return m_end; }
+	u32 getCommitted() const { return m_commited; }
+	u32 getHighWater() const { return m_high_water; }
+
+	void* allocate_aligned(size_t size, size_t align) override;
+	void deallocate_aligned(void* ptr) override;
+	void* reallocate_aligned(void* ptr, size_t size, size_t align) override;
+	void* allocate(size_t size) override;
+	void deallocate(void* ptr) override;
+	void* reallocate(void* ptr, size_t size) override;
+
+private:
+	u8* m_mem;
+	u32 m_reserved;
+	volatile i32 m_end = 0;
+	volatile u32 m_commited = 0;
+	u32 m_high_water = 0;
+	u32 m_period_peak = 0;
+	u32 m_period_resets = 0;
+	Mutex m_mutex;
+};
+
+
+// Proxy allocator owned by a subsystem (plugin, scene, ...). With LUMIX_TRACK_ALLOCATIONS it tracks memory
+// of the subsystem, which is shown in profiler UI and pushed as profiler counters, otherwise it only forwards calls.
+struct LUMIX_ENGINE_API TagAllocator final : IAllocator {
+	static constexpr u32 HISTOGRAM_SIZE = 16;
+
+	struct Stats {
+		u64 live_bytes = 0;
+		u64 peak_bytes = 0;
+		u64 live_count = 0;
+		// since creation
+		u64 alloc_count = 0;
+		u64 free_count = 0;
+		// allocations by size, bucket i has sizes up to 16 << i, the last one everything bigger
+		u64 histogram[HISTOGRAM_SIZE] = {};
+	};
+
+	struct SampledAllocation {
+		debug::StackNode* stack;
+		u64 size;
+	};
+
+	TagAllocator(IAllocator& source, const char* tag_name);
+	~TagAllocator();
+
+	void* allocate_aligned(size_t size, size_t align) override;
+	void deallocate_aligned(void* ptr) override;
+	void* reallocate_aligned(void* ptr, size_t size, size_t align) override;
+	void* allocate(size_t size) override;
+	void deallocate(void* ptr) override;
+	void* reallocate(void* ptr, size_t size) override;
+	IAllocator& getSourceAllocator() { return m_source; }
+	const char* getTagName() const { return m_tag_name; }
+
+	Stats getStats();
+	// records callstack of every `every_nth` allocation, 0 disables sampling
+	void setStackSampling(u32 every_nth);
+	u32 getStackSampling() const;
+	// returns number of live sampled allocations, copies at most out.length() of them
+	u32 getSampledAllocations(Span<SampledAllocation> out);
+	// returns number of existing tags, copies at most out.length() of them
+	static u32 getTags(Span<TagAllocator*> out);
+	// pushes live KB and allocations per frame of each tag as profiler counters
+	static void pushProfilerCounters();
+
+private:
+	struct Tracking;
+
+	void onAllocate(void* ptr, size_t size);
+	void onDeallocate(void* ptr);
+
+	IAllocator& m_source;
+	char m_tag_name[32];
+	// profiler counter names, interned in the profiler since recorded events outlive the tag
+	const char* m_live_counter_name = nullptr;
+	const char* m_rate_counter_name = nullptr;
+	u64 m_last_alloc_count = 0;
+	Tracking* m_tracking = nullptr;
+	TagAllocator* m_next = nullptr;
+	TagAllocator* m_prev = nullptr;
+};
+
+
+} // namespace Lumix
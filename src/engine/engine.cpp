@@ -1,4 +1,6 @@
+#include "engine/allocators.h"
 #include "engine/atomic.h"
+#include "engine/command_line_parser.h"
 #include "engine/crc32.h"
 #include "engine/debug.h"
 #include "engine/engine.h"
@@ -25,6 +27,26 @@ void registerEngineAPI(lua_State* L, Engine* engine);
 
 static const u32 SERIALIZED_ENGINE_MAGIC = 0x5f4c454e; // == '_LEN'
 static const u32 SERIALIZED_PROJECT_MAGIC = 0x5f50524c; // == '_PRL'
+// size of a single incremental step, the budget is checked between steps
+static const int LUA_GC_STEP_KB = 16;
+// new cycle starts when heap grows by this factor since the end of the last one
+static const float LUA_GC_PAUSE = 1.5f;
+// incremental collector can not keep up, heap grew by this factor -> full collection
+static const float LUA_GC_EMERGENCY = 4.f;
+static const int LUA_GC_MIN_HEAP_KB = 1024;
+
+
+// smaller universes and prefabs are not worth the jobs' overhead
+static const u32 PARALLEL_DESERIALIZE_MIN_SIZE = 64 * 1024;
+
+
+enum class SerializedEngineVersion : u32
+{
+	FIRST,
+	SCENE_SIZES,
+
+	LATEST // keep this last
+};
 
 
 #pragma pack(1)
@@ -84,21 +106,32 @@ public:
 			logError("Failed to create main window.");
 		}
 
-		m_is_log_file_open = m_log_file.open("lumix.log");
-		
+		char cmd_line[2048];
+		os::getCommandLine(Span(cmd_line));
+		CommandLineParser parser(cmd_line);
+		bool binary_log = false;
+		while (parser.next()) {
+			if (parser.currentEquals("-binary_log")) binary_log = true;
+		}
+		if (!openLogFile(binary_log ? "lumix.llog" : "lumix.log", binary_log)) {
+			logError("Failed to open log file");
+		}
+		registerLogCallback<logToDebugOutput>();
+		startLogThread();
+
 		logInfo("Creating engine...");
 		profiler::setThreadName("Worker");
 		installUnhandledExceptionHandler();
 
-		registerLogCallback<&EngineImpl::logToFile>(this);
-		registerLogCallback<logToDebugOutput>();
-
 		os::logVersion();
 
 		m_state = luaL_newstate();
 		luaL_openlibs(m_state);
 
 		registerEngineAPI(m_state, this);
+		// collector runs only in stepLuaGC, never in the middle of script callbacks
+		lua_gc(m_state, LUA_GCSTOP, 0);
+		m_lua_gc_base_kb = lua_gc(m_state, LUA_GCCOUNT, 0);
 
 		if (init_data.file_system.get()) {
 			m_file_system = static_cast<UniquePtr<FileSystem>&&>(init_data.file_system);
@@ -153,9 +186,9 @@ public:
 
 		lua_close(m_state);
 
-		unregisterLogCallback<&EngineImpl::logToFile>(this);
-		m_log_file.close();
-		m_is_log_file_open = false;
+		stopLogThread();
+		unregisterLogCallback<logToDebugOutput>();
+		closeLogFile();
 		os::destroyWindow(m_window_handle);
 	}
 
@@ -168,19 +201,6 @@ public:
 		debug::debugOutput("\n");
 	}
 
-	void logToFile(LogLevel level, const char* message)
-	{
-		if (!m_is_log_file_open) return;
-		bool success = true;
-		if (level == LogLevel::ERROR) {
-			success = m_log_file.write("Error: ", stringLength("Error :"));
-		}
-		success = m_log_file.write(message, stringLength(message)) && success ;
-		success = m_log_file.write("\n", 1) && success ;
-		ASSERT(success);
-		m_log_file.flush();
-	}
-
 	os::WindowHandle getWindowHandle() override { return m_window_handle; }
 	IAllocator& getAllocator() override { return m_allocator; }
 	PageAllocator& getPageAllocator() override { return m_page_allocator; }
@@ -326,6 +346,8 @@ public:
 		m_plugin_manager->update(dt, m_paused);
 		m_input_system->update(dt);
 		m_file_system->processCallbacks();
+		stepLuaGC();
+		TagAllocator::pushProfilerCounters();
 
 		if (m_next_frame)
 		{
@@ -335,6 +357,59 @@ public:
 	}
 
 
+	void setLuaGCBudget(float ms) override
+	{
+		if (ms > 0 && m_lua_gc_budget_ms <= 0) {
+			lua_gc(m_state, LUA_GCSTOP, 0);
+			m_lua_gc_base_kb = lua_gc(m_state, LUA_GCCOUNT, 0);
+			m_lua_gc_in_cycle = false;
+		}
+		else if (ms <= 0 && m_lua_gc_budget_ms > 0) {
+			lua_gc(m_state, LUA_GCRESTART, 0);
+		}
+		m_lua_gc_budget_ms = ms;
+	}
+
+
+	void stepLuaGC()
+	{
+		if (m_lua_gc_budget_ms <= 0) {
+			profiler::pushInt("Lua heap KB", lua_gc(m_state, LUA_GCCOUNT, 0));
+			return;
+		}
+
+		PROFILE_FUNCTION();
+		lua_State* L = m_state;
+		const int heap_kb = lua_gc(L, LUA_GCCOUNT, 0);
+		const int base_kb = maximum(m_lua_gc_base_kb, LUA_GC_MIN_HEAP_KB);
+		u32 steps = 0;
+		if (heap_kb > base_kb * LUA_GC_EMERGENCY) {
+			PROFILE_BLOCK("full collection");
+			lua_gc(L, LUA_GCCOLLECT, 0);
+			++m_lua_gc_full_collections;
+			m_lua_gc_in_cycle = false;
+			m_lua_gc_base_kb = lua_gc(L, LUA_GCCOUNT, 0);
+			profiler::pushInt("Lua GC full collections", m_lua_gc_full_collections);
+		}
+		else if (m_lua_gc_in_cycle || heap_kb > base_kb * LUA_GC_PAUSE) {
+			m_lua_gc_in_cycle = true;
+			os::Timer timer;
+			do {
+				++steps;
+				if (lua_gc(L, LUA_GCSTEP, LUA_GC_STEP_KB)) {
+					m_lua_gc_in_cycle = false;
+					m_lua_gc_base_kb = lua_gc(L, LUA_GCCOUNT, 0);
+					break;
+				}
+			} while (timer.getTimeSinceStart() * 1000 < m_lua_gc_budget_ms);
+			// stepping rearms the collector's threshold
+			lua_gc(L, LUA_GCSTOP, 0);
+		}
+		profiler::pushInt("Lua heap KB", lua_gc(L, LUA_GCCOUNT, 0));
+		profiler::pushInt("Lua GC steps", steps);
+	}
+
+
 	void serializeSceneVersions(OutputMemoryStream& serializer, Universe& ctx)
 	{
 		serializer.write(ctx.getScenes().size());
@@ -411,21 +486,43 @@ public:
 		}
 	}
 
-	u32 serialize(Universe& ctx, OutputMemoryStream& serializer) override
+	void serializeHeader(OutputMemoryStream& serializer) override
 	{
 		SerializedEngineHeader header;
 		header.magic = SERIALIZED_ENGINE_MAGIC; // == '_LEN'
-		header.version = 0;
+		header.version = (u32)SerializedEngineVersion::LATEST;
 		serializer.write(header);
 		serializePluginList(serializer);
 		//serializeSceneVersions(serializer, ctx);
-		i32 pos = (i32)serializer.size();
+	}
+
+
+	void serializeUniverse(Universe& ctx, OutputMemoryStream& serializer) override
+	{
 		ctx.serialize(serializer);
 		serializer.write((i32)ctx.getScenes().size());
+	}
+
+
+	void serializeScene(IScene& scene, OutputMemoryStream& serializer) override
+	{
+		serializer.writeString(scene.getPlugin().getName());
+		serializer.write(scene.getVersion());
+		const u64 size_pos = serializer.size();
+		serializer.write((u32)0);
+		scene.serialize(serializer);
+		const u32 size = u32(serializer.size() - size_pos - sizeof(u32));
+		memcpy(serializer.getMutableData() + size_pos, &size, sizeof(size));
+	}
+
+
+	u32 serialize(Universe& ctx, OutputMemoryStream& serializer) override
+	{
+		serializeHeader(serializer);
+		i32 pos = (i32)serializer.size();
+		serializeUniverse(ctx, serializer);
 		for (UniquePtr<IScene>& scene : ctx.getScenes()) {
-			serializer.writeString(scene->getPlugin().getName());
-			serializer.write(scene->getVersion());
-			scene->serialize(serializer);
+			serializeScene(*scene, serializer);
 		}
 		u32 crc = crc32((const u8*)serializer.data() + pos, (i32)serializer.size() - pos);
 		return crc;
@@ -443,16 +540,87 @@ public:
 		}
 		if (!hasSerializedPlugins(serializer)) return false;
 
-		ctx.deserialize(serializer, entity_map);
+		if (!ctx.deserialize(serializer, entity_map)) return false;
 		i32 scene_count;
 		serializer.read(scene_count);
-		for (int i = 0; i < scene_count; ++i)
-		{
+		if (header.version <= (u32)SerializedEngineVersion::SCENE_SIZES) {
+			for (int i = 0; i < scene_count; ++i)
+			{
+				const char* tmp = serializer.readString();
+				IScene* scene = ctx.getScene(crc32(tmp));
+				const i32 version = serializer.read<i32>();
+				scene->deserialize(serializer, entity_map, version);
+			}
+			return true;
+		}
+
+		struct SceneBlob {
+			IScene* scene;
+			i32 version;
+			InputMemoryStream blob;
+			const EntityMap* entity_map;
+			jobs::SignalHandle signal;
+		};
+
+		Array<SceneBlob> scenes(m_allocator);
+		Array<IScene*> independent(m_allocator);
+		scenes.reserve(scene_count);
+		u64 independent_size = 0;
+		for (int i = 0; i < scene_count; ++i) {
 			const char* tmp = serializer.readString();
 			IScene* scene = ctx.getScene(crc32(tmp));
 			const i32 version = serializer.read<i32>();
-			scene->deserialize(serializer, entity_map, version);
+			const u32 size = serializer.read<u32>();
+			const void* data = serializer.skip(size);
+			if (serializer.getPosition() > serializer.size()) {
+				logError("Wrong or corrupted file");
+				return false;
+			}
+			scenes.push({scene, version, InputMemoryStream(data, size), &entity_map, jobs::INVALID_HANDLE});
+			if (scene->isDeserializeIndependent()) {
+				independent.push(scene);
+				independent_size += size;
+			}
+		}
+
+		if (independent_size < PARALLEL_DESERIALIZE_MIN_SIZE) {
+			for (SceneBlob& s : scenes) {
+				s.scene->deserialize(s.blob, entity_map, s.version);
+			}
+			return true;
+		}
+
+		// independent scenes run in jobs while the rest is deserialized here in the original order;
+		// resource requests from all scenes are issued at once, so file IO overlaps parsing
+		ctx.beginDeferredComponentEvents(independent);
+		m_resource_manager.beginParallelLoads();
+		for (SceneBlob& s : scenes) {
+			if (!s.scene->isDeserializeIndependent()) continue;
+			jobs::run(&s, [](void* data){
+				SceneBlob* s = (SceneBlob*)data;
+				PROFILE_BLOCK("deserialize scene");
+				profiler::pushString(s->scene->getPlugin().getName());
+				s->scene->deserialize(s->blob, *s->entity_map, s->version);
+			}, &s.signal);
+		}
+		// a scene sees components of all scenes before it in hasComponent, as if everything was sequential
+		u32 ended = 0;
+		auto endIndependent = [&](u32 until) {
+			for (; ended < until; ++ended) {
+				SceneBlob& s = scenes[ended];
+				if (!s.scene->isDeserializeIndependent()) continue;
+				jobs::wait(s.signal);
+				ctx.endDeferredComponentEvents(*s.scene);
+			}
+		};
+		for (u32 i = 0; i < (u32)scenes.size(); ++i) {
+			SceneBlob& s = scenes[i];
+			if (s.scene->isDeserializeIndependent()) continue;
+			endIndependent(i);
+			s.scene->deserialize(s.blob, entity_map, s.version);
 		}
+		endIndependent(scenes.size());
+		m_resource_manager.endParallelLoads();
 		return true;
 	}
 
@@ -508,8 +676,10 @@ private:
 	bool m_next_frame;
 	os::WindowHandle m_window_handle;
 	lua_State* m_state;
-	os::OutputFile m_log_file;
-	bool m_is_log_file_open = false;
+	float m_lua_gc_budget_ms = 1.f;
+	int m_lua_gc_base_kb = 0;
+	bool m_lua_gc_in_cycle = false;
+	u32 m_lua_gc_full_collections = 0;
 	HashMap<int, Resource*> m_lua_resources;
 	u32 m_last_lua_resource_idx;
 };
@@ -46,6 +46,11 @@ struct LUMIX_ENGINE_API Engine {
 
 	virtual void update(Universe& context) = 0;
 	virtual u32 serialize(Universe& ctx, struct OutputMemoryStream& serializer) = 0;
+	// parts of serialize() in the order they are written, callers can keep parts which did not change,
+	// returned hash of serialize() is crc32 of universe part and all scenes
+	virtual void serializeHeader(OutputMemoryStream& serializer) = 0;
+	virtual void serializeUniverse(Universe& ctx, OutputMemoryStream& serializer) = 0;
+	virtual void serializeScene(struct IScene& scene, OutputMemoryStream& serializer) = 0;
 	virtual bool deserialize(Universe& ctx, struct InputMemoryStream& serializer, struct EntityMap& entity_map) = 0;
 	virtual bool deserializeProject(InputMemoryStream& serializer) = 0;
 	virtual void serializeProject(OutputMemoryStream& serializer) const = 0;
@@ -55,6 +60,8 @@ struct LUMIX_ENGINE_API Engine {
 	virtual bool isPaused() const = 0;
 	virtual void nextFrame() = 0;
 	virtual lua_State* getState() = 0;
+	// time per frame spent in incremental Lua GC, <= 0 gives control back to Lua's own collector
+	virtual void setLuaGCBudget(float ms) = 0;
 
 	virtual struct Resource* getLuaResource(LuaResourceHandle idx) const = 0;
 	virtual LuaResourceHandle addLuaResource(const struct Path& path, struct ResourceType type) = 0;
@@ -9,6 +9,7 @@
 #include "engine/metaprogramming.h"
 #include "engine/log.h"
 #include "engine/lz4.h"
+#include "engine/math.h"
 #include "engine/sync.h"
 #include "engine/thread.h"
 #include "engine/os.h"
@@ -64,6 +65,7 @@ struct FileSystemImpl : FileSystem {
 		: m_allocator(allocator)
 		, m_queue(allocator)	
 		, m_finished(allocator)	
+		, m_trace(allocator)
 		, m_last_id(0)
 		, m_semaphore(0, 0xffFF)
 	{
@@ -122,11 +124,28 @@ struct FileSystemImpl : FileSystem {
 		item.id = m_last_id;
 		item.path = file.c_str();
 		item.callback = callback;
+		if (m_is_tracing) m_trace.push(file);
 		m_semaphore.signal();
 		return AsyncHandle(item.id);
 	}
 
 
+	void startAccessTrace() override {
+		MutexGuard lock(m_mutex);
+		m_trace.clear();
+		m_is_tracing = true;
+	}
+
+
+	void stopAccessTrace(Array<Path>& paths) override {
+		MutexGuard lock(m_mutex);
+		m_is_tracing = false;
+		paths.reserve(paths.size() + m_trace.size());
+		for (const Path& path : m_trace) paths.push(path);
+		m_trace.clear();
+	}
+
+
 	void cancel(AsyncHandle async) override
 	{
 		MutexGuard lock(m_mutex);
@@ -262,6 +281,8 @@ struct FileSystemImpl : FileSystem {
 	Array<AsyncItem> m_finished;
 	Mutex m_mutex;
 	Semaphore m_semaphore;
+	Array<Path> m_trace;
+	bool m_is_tracing = false;
 
 	u32 m_last_id;
 };
@@ -314,49 +335,132 @@ struct PackFileSystem : FileSystemImpl {
 		: FileSystemImpl("pack://", allocator) 
 		, m_map(allocator)
 		, m_allocator(allocator)
+		, m_read_buffer(allocator)
 	{
 		if (!m_file.open(pak_path)) {
 			logError("Failed to open game.pak");
 			return;
 		}
+		PackHeader header;
+		if (!m_file.read(&header, sizeof(header))) {
+			logError("Failed to read ", pak_path);
+			return;
+		}
+		if (header.magic != PackHeader::MAGIC) {
+			loadLegacyTOC();
+			return;
+		}
+		if (header.version > PackHeader::Version::LATEST) {
+			logError("Unsupported version of ", pak_path);
+			return;
+		}
+
+		PackFooter footer;
+		if (m_file.size() < sizeof(header) + sizeof(footer)
+			|| !m_file.seek(m_file.size() - sizeof(footer))
+			|| !m_file.read(&footer, sizeof(footer))
+			|| footer.magic != PackHeader::MAGIC
+			|| !m_file.seek(footer.toc_offset))
+		{
+			logError("Corrupted ", pak_path);
+			return;
+		}
+
+		m_data_end = footer.toc_offset;
+		m_map.reserve(footer.count);
+		for (u32 i = 0; i < footer.count; ++i) {
+			PackEntry entry;
+			if (!m_file.read(&entry, sizeof(entry))) {
+				logError("Corrupted ", pak_path);
+				m_map.clear();
+				return;
+			}
+			PackFile& f = m_map.insert(entry.hash);
+			f.offset = entry.offset;
+			f.size = entry.size;
+			f.compressed_size = entry.compressed_size;
+			f.flags = entry.flags;
+		}
+	}
+
+	// packs without header - u32 count, table, all entries LZ4 with offsets relative to the end of table
+	void loadLegacyTOC() {
+		if (!m_file.seek(0)) return;
 		const u32 count = m_file.read<u32>();
+		const u64 header_size = sizeof(u32) + count * (3 * sizeof(u64) + sizeof(u32));
+		m_map.reserve(count);
 		for (u32 i = 0; i < count; ++i) {
 			const u32 hash = m_file.read<u32>();
 			PackFile& f = m_map.insert(hash);
-			f.offset = m_file.read<u64>();
+			f.offset = m_file.read<u64>() + header_size;
 			f.size = m_file.read<u64>();
 			f.compressed_size = m_file.read<u64>();
+			f.flags = PackEntry::LZ4;
 		}
+		m_data_end = m_file.size();
 	}
 
 	~PackFileSystem() {
 		m_file.close();
 	}
 
-	bool getContentSync(const Path& path, OutputMemoryStream& content) override {
-		Span<const char> basename = Path::getBasename(path.c_str());
-		u32 hash;
-		fromCString(basename, hash);
-		if (basename[0] < '0' || basename[0] > '9' || hash == 0) {
-			hash = path.getHash();
+	// called with m_mutex locked; sequential reads are extended to READ_AHEAD_SIZE, so entries
+	// laid out in load order are served from one large read instead of a seek + read per file
+	bool readData(u64 offset, u64 size, u8* dst) {
+		const u64 end = offset + size;
+		const u64 buffer_end = m_read_buffer_offset + m_read_buffer.size();
+		if (offset >= m_read_buffer_offset && end <= buffer_end) {
+			memcpy(dst, m_read_buffer.data() + (offset - m_read_buffer_offset), size);
+			m_last_read_end = end;
+			return true;
+		}
+
+		const bool is_sequential = offset == m_last_read_end || (offset >= m_read_buffer_offset && offset < buffer_end);
+		m_last_read_end = end;
+		if (!is_sequential || size >= READ_AHEAD_SIZE || end > m_data_end) {
+			return m_file.seek(offset) && m_file.read(dst, size);
+		}
+
+		m_read_buffer.resize(minimum(READ_AHEAD_SIZE, m_data_end - offset));
+		m_read_buffer_offset = offset;
+		if (!m_file.seek(offset) || !m_file.read(m_read_buffer.getMutableData(), m_read_buffer.size())) {
+			m_read_buffer.clear();
+			return false;
 		}
-		auto iter = m_map.find(hash);
+		memcpy(dst, m_read_buffer.data(), size);
+		return true;
+	}
+
+	bool getContentSync(const Path& path, OutputMemoryStream& content) override {
+		auto iter = m_map.find(getPackHash(path));
 		if (!iter.isValid()) {
 			iter = m_map.find(path.getHash());
 			if (!iter.isValid()) return false;
 		}
 
+		const PackFile& f = iter.value();
+		if (!(f.flags & PackEntry::LZ4)) {
+			content.resize(f.size);
+			MutexGuard lock(m_mutex);
+			if (!readData(f.offset, f.size, content.getMutableData())) {
+				logError("Could not read ", path);
+				return false;
+			}
+			return true;
+		}
+
 		OutputMemoryStream compressed(m_allocator);
-		compressed.resize(iter.value().compressed_size);
-		MutexGuard lock(m_mutex);
-		const u32 header_size = sizeof(u32) + m_map.size() * (3 * sizeof(u64) + sizeof(u32));
-		if (!m_file.seek(iter.value().offset + header_size) || !m_file.read(compressed.getMutableData(), compressed.size())) {
-			logError("Could not read ", path);
-			return false;
+		compressed.resize(f.compressed_size);
+		{
+			MutexGuard lock(m_mutex);
+			if (!readData(f.offset, f.compressed_size, compressed.getMutableData())) {
+				logError("Could not read ", path);
+				return false;
+			}
 		}
 
-		content.resize(iter.value().size);
-		const i32 res = LZ4_decompress_safe((const char*)compressed.data(), (char*)content.getMutableData(), (i32)iter.value().compressed_size, (i32)content.size());
+		content.resize(f.size);
+		const i32 res = LZ4_decompress_safe((const char*)compressed.data(), (char*)content.getMutableData(), (i32)f.compressed_size, (i32)content.size());
 		
 		if (res != content.size()) {
 			logError("Could not decompress ", path);
@@ -369,15 +473,33 @@ struct PackFileSystem : FileSystemImpl {
 		u64 offset;
 		u64 size;
 		u64 compressed_size;
+		u32 flags;
 	};
 
+	static constexpr u64 READ_AHEAD_SIZE = 1024 * 1024;
+
 	IAllocator& m_allocator;
 	HashMap<u32, PackFile> m_map;
 	Mutex m_mutex;
 	os::InputFile m_file;
+	u64 m_data_end = 0;
+	OutputMemoryStream m_read_buffer;
+	u64 m_read_buffer_offset = 0;
+	u64 m_last_read_end = 0;
 };
 
 
+u32 getPackHash(const Path& path) {
+	Span<const char> basename = Path::getBasename(path.c_str());
+	u32 hash;
+	fromCString(basename, hash);
+	if (basename.length() == 0 || basename[0] < '0' || basename[0] > '9' || hash == 0) {
+		return path.getHash();
+	}
+	return hash;
+}
+
+
 UniquePtr<FileSystem> FileSystem::create(const char* base_path, IAllocator& allocator)
 {
 	return UniquePtr<FileSystemImpl>::create(allocator, base_path, allocator);
@@ -4,6 +4,7 @@
 
 namespace Lumix {
 
+template <typename T> struct Array;
 template <typename T> struct Delegate;
 template <typename T> struct UniquePtr;
 
@@ -13,6 +14,43 @@ namespace os {
 	struct OutputFile;
 }
 
+// Layout of packed data files (main.pak):
+// PackHeader, entries' data, PackEntry[count], PackFooter
+// Files without PackHeader are from older versions - u32 count, PackEntry-like table, LZ4 data
+struct PackHeader {
+	static constexpr u32 MAGIC = '_LPK';
+	enum class Version : u32 {
+		FIRST,
+
+		LATEST // keep this last
+	};
+
+	u32 magic = MAGIC;
+	Version version = Version::LATEST;
+};
+
+struct PackEntry {
+	enum Flags : u32 {
+		NONE = 0,
+		LZ4 = 1 << 0
+	};
+
+	u32 hash;
+	u32 flags;
+	u64 offset; // absolute, several entries can share the same data
+	u64 size;
+	u64 compressed_size; // == size if not compressed
+};
+
+struct PackFooter {
+	u64 toc_offset;
+	u32 count;
+	u32 magic = PackHeader::MAGIC;
+};
+
+// key of a file in packs, compiled assets (.lumix/assets/<hash>.res) use their hash
+LUMIX_ENGINE_API u32 getPackHash(const struct Path& path);
+
 struct LUMIX_ENGINE_API FileSystem {
 	using ContentCallback = Delegate<void(u64, const u8*, bool)>;
 
@@ -47,6 +85,10 @@ struct LUMIX_ENGINE_API FileSystem {
 	[[nodiscard]] virtual bool getContentSync(const struct Path& file, struct OutputMemoryStream& content) =  0;
 	virtual AsyncHandle getContent(const Path& file, const ContentCallback& callback) = 0;
 	virtual void cancel(AsyncHandle handle) = 0;
+
+	// records paths requested by getContent, used to lay out packs in load order
+	virtual void startAccessTrace() = 0;
+	virtual void stopAccessTrace(Array<Path>& paths) = 0;
 };
 
 } // namespace Lumix
@@ -0,0 +1,399 @@
+#pragma once
+
+
+#include "engine/crt.h"
+#include "engine/hash_map.h"
+
+#if defined _WIN32 || defined __SSE2__
+	#include <emmintrin.h>
+	#ifdef _WIN32
+		#include <intrin.h>
+	#endif
+#elif defined __ARM_NEON
+	#include <arm_neon.h>
+#endif
+
+
+namespace Lumix
+{
+
+
+// 16 control bytes probed at once, each byte is either EMPTY or 7 bits of slot's key hash
+struct HashMapGroup {
+	static constexpr u32 SIZE = 16;
+	static constexpr u8 EMPTY = 0x80;
+
+	// returns mask with bit `i` set if ctrl[i] == h2
+	static LUMIX_FORCE_INLINE u32 match(const u8* ctrl, u8 h2) {
+		#if defined _WIN32 || defined __SSE2__
+			const __m128i c = _mm_loadu_si128((const __m128i*)ctrl);
+			return (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8((char)h2)));
+		#elif defined __ARM_NEON
+			return toMask(vceqq_u8(vld1q_u8(ctrl), vdupq_n_u8(h2)));
+		#else
+			u32 res = 0;
+			for (u32 i = 0; i < SIZE; ++i) res |= u32(ctrl[i] == h2) << i;
+			return res;
+		#endif
+	}
+
+	static LUMIX_FORCE_INLINE u32 matchEmpty(const u8* ctrl) {
+		#if defined _WIN32 || defined __SSE2__
+			return (u32)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)ctrl));
+		#elif defined __ARM_NEON
+			return toMask(vtstq_u8(vld1q_u8(ctrl), vdupq_n_u8(EMPTY)));
+		#else
+			u32 res = 0;
+			for (u32 i = 0; i < SIZE; ++i) res |= u32(ctrl[i] >> 7) << i;
+			return res;
+		#endif
+	}
+
+	static LUMIX_FORCE_INLINE u32 matchFull(const u8* ctrl) { return ~matchEmpty(ctrl) & 0xffFF; }
+
+	static LUMIX_FORCE_INLINE u32 firstBit(u32 mask) {
+		ASSERT(mask);
+		#ifdef _WIN32
+			unsigned long res;
+			_BitScanForward(&res, mask);
+			return res;
+		#else
+			return __builtin_ctz(mask);
+		#endif
+	}
+
+	#if !defined _WIN32 && !defined __SSE2__ && defined __ARM_NEON
+		static LUMIX_FORCE_INLINE u32 toMask(uint8x16_t v) {
+			static const u8 bits[] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+			const uint8x16_t masked = vandq_u8(v, vld1q_u8(bits));
+			return vaddv_u8(vget_low_u8(masked)) | (vaddv_u8(vget_high_u8(masked)) << 8);
+		}
+	#endif
+};
+
+
+// Swiss table, slots are split into groups of HashMapGroup::SIZE, key's hash selects the first group to probe
+// and 7 bits of the hash are stored in control bytes, so a whole group is checked with a few SIMD instructions.
+// Each group counts keys which overflowed it while probing, lookups stop at the first group without overflow,
+// so erase just marks the slot empty and decrements the counters, there are no tombstones.
+// Same interface as linear probing HashMap, but erase and insert never move other elements.
+template<typename Key, typename Value, typename Hasher>
+struct HashMap<Key, Value, Hasher, GroupProbing>
+{
+private:
+	using Group = HashMapGroup;
+
+	template <typename HM, typename K, typename V>
+	struct iterator_base {
+		HM* hm;
+		u32 idx;
+
+		template <typename HM2, typename K2, typename V2>
+		bool operator !=(const iterator_base<HM2, K2, V2>& rhs) const {
+			ASSERT(hm == rhs.hm);
+			return idx != rhs.idx;
+		}
+
+		template <typename HM2, typename K2, typename V2>
+		bool operator ==(const iterator_base<HM2, K2, V2>& rhs) const {
+			ASSERT(hm == rhs.hm);
+			return idx == rhs.idx;
+		}
+
+		void operator++() { idx = hm->nextFull(idx + 1); }
+
+		K& key() {
+			ASSERT(hm->isFull(idx));
+			return hm->m_keys[idx];
+		}
+
+		const V& value() const {
+			ASSERT(hm->isFull(idx));
+			return hm->m_values[idx];
+		}
+
+		V& value() {
+			ASSERT(hm->isFull(idx));
+			return hm->m_values[idx];
+		}
+
+		V& operator*() {
+			ASSERT(hm->isFull(idx));
+			return hm->m_values[idx];
+		}
+
+		bool isValid() const { return idx != hm->m_capacity; }
+	};
+
+public:
+	using iterator = iterator_base<HashMap, Key, Value>;
+	using const_iterator = iterator_base<const HashMap, const Key, const Value>;
+
+	explicit HashMap(IAllocator& allocator)
+		: m_allocator(allocator)
+	{
+	}
+
+	HashMap(u32 size, IAllocator& allocator)
+		: m_allocator(allocator)
+	{
+		init(size);
+	}
+
+	HashMap(HashMap&& rhs)
+		: m_allocator(rhs.m_allocator)
+	{
+		m_ctrl = rhs.m_ctrl;
+		m_overflows = rhs.m_overflows;
+		m_keys = rhs.m_keys;
+		m_values = rhs.m_values;
+		m_capacity = rhs.m_capacity;
+		m_size = rhs.m_size;
+		m_group_mask = rhs.m_group_mask;
+
+		rhs.m_ctrl = nullptr;
+		rhs.m_overflows = nullptr;
+		rhs.m_keys = nullptr;
+		rhs.m_values = nullptr;
+		rhs.m_capacity = 0;
+		rhs.m_size = 0;
+		rhs.m_group_mask = 0;
+	}
+
+	~HashMap()
+	{
+		destroyAll();
+		deallocate();
+	}
+
+	void operator =(HashMap&& rhs) = delete;
+
+	iterator begin() { return { this, nextFull(0) }; }
+	const_iterator begin() const { return { this, nextFull(0) }; }
+	iterator end() { return iterator { this, m_capacity }; }
+	const_iterator end() const { return const_iterator { this, m_capacity }; }
+
+	void clear() {
+		destroyAll();
+		deallocate();
+		init(Group::SIZE);
+	}
+
+	const_iterator find(const Key& key) const {
+		return { this, findPos(key) };
+	}
+
+	iterator find(const Key& key) {
+		return { this, findPos(key) };
+	}
+
+	Value& operator[](const Key& key) {
+		const u32 pos = findPos(key);
+		ASSERT(pos < m_capacity);
+		return m_values[pos];
+	}
+
+	const Value& operator[](const Key& key) const {
+		const u32 pos = findPos(key);
+		ASSERT(pos < m_capacity);
+		return m_values[pos];
+	}
+
+	Value& insert(const Key& key) {
+		auto iter = insert(key, {});
+		return iter.value();
+	}
+
+	iterator insert(const Key& key, Value&& value) {
+		const u32 pos = allocSlot(key);
+		new (NewPlaceholder(), &m_keys[pos]) Key(key);
+		new (NewPlaceholder(), &m_values[pos]) Value(static_cast<Value&&>(value));
+		return { this, pos };
+	}
+
+	iterator insert(const Key& key, const Value& value) {
+		const u32 pos = allocSlot(key);
+		new (NewPlaceholder(), &m_keys[pos]) Key(key);
+		new (NewPlaceholder(), &m_values[pos]) Value(value);
+		return { this, pos };
+	}
+
+	template <typename F>
+	void eraseIf(F predicate) {
+		for (u32 i = nextFull(0); i != m_capacity; i = nextFull(i + 1)) {
+			if (predicate(m_values[i])) erase(iterator{this, i});
+		}
+	}
+
+	void erase(const iterator& key) {
+		ASSERT(key.isValid());
+		const u32 pos = key.idx;
+
+		// undo overflow counts left by insert on the way from home group to this slot's group
+		const u32 hash = Hasher::get(m_keys[pos]);
+		const u32 last_group = pos / Group::SIZE;
+		u32 group = (hash >> 7) & m_group_mask;
+		for (u32 step = 1; group != last_group; ++step) {
+			if (m_overflows[group] != 0xff) --m_overflows[group];
+			group = (group + step) & m_group_mask;
+		}
+
+		m_keys[pos].~Key();
+		m_values[pos].~Value();
+		m_ctrl[pos] = Group::EMPTY;
+		--m_size;
+	}
+
+	void erase(const Key& key) {
+		const u32 pos = findPos(key);
+		if (pos != m_capacity) erase({this, pos});
+	}
+
+	bool empty() const { return m_size == 0; }
+	u32 size() const { return m_size; }
+
+	void reserve(u32 new_capacity) {
+		if (new_capacity > m_capacity) grow(nextPow2(new_capacity));
+	}
+
+private:
+	template <typename T>
+	static void swap(T& a, T& b) {
+		T tmp = a;
+		a = b;
+		b = tmp;
+	}
+
+	static u32 nextPow2(u32 v) {
+		v--;
+		v |= v >> 1;
+		v |= v >> 2;
+		v |= v >> 4;
+		v |= v >> 8;
+		v |= v >> 16;
+		v++;
+		return v;
+	}
+
+	static u8 h2(u32 hash) { return u8(hash & 0x7f); }
+
+	bool isFull(u32 idx) const { return idx < m_capacity && (m_ctrl[idx] & Group::EMPTY) == 0; }
+
+	u32 nextFull(u32 from) const {
+		if (from >= m_capacity) return m_capacity;
+		u32 group = from & ~(Group::SIZE - 1);
+		u32 mask = Group::matchFull(m_ctrl + group) & (0xffFF << (from - group));
+		for (;;) {
+			if (mask) return group + Group::firstBit(mask);
+			group += Group::SIZE;
+			if (group >= m_capacity) return m_capacity;
+			mask = Group::matchFull(m_ctrl + group);
+		}
+	}
+
+	void grow(u32 new_capacity) {
+		HashMap tmp(new_capacity, m_allocator);
+		for (u32 i = nextFull(0); i != m_capacity; i = nextFull(i + 1)) {
+			tmp.insert(m_keys[i], static_cast<Value&&>(m_values[i]));
+		}
+
+		swap(m_ctrl, tmp.m_ctrl);
+		swap(m_overflows, tmp.m_overflows);
+		swap(m_keys, tmp.m_keys);
+		swap(m_values, tmp.m_values);
+		swap(m_capacity, tmp.m_capacity);
+		swap(m_size, tmp.m_size);
+		swap(m_group_mask, tmp.m_group_mask);
+	}
+
+	u32 allocSlot(const Key& key) {
+		// grow at 7/8 load
+		if (m_size >= m_capacity - m_capacity / 8) {
+			grow(m_capacity < Group::SIZE ? Group::SIZE : m_capacity << 1);
+		}
+
+		const u32 hash = Hasher::get(key);
+		u32 group = (hash >> 7) & m_group_mask;
+		for (u32 step = 1; ; ++step) {
+			const u32 empty = Group::matchEmpty(m_ctrl + group * Group::SIZE);
+			if (empty) {
+				const u32 pos = group * Group::SIZE + Group::firstBit(empty);
+				m_ctrl[pos] = h2(hash);
+				++m_size;
+				return pos;
+			}
+			// saturated counter stays forever, lookups just probe further
+			if (m_overflows[group] != 0xff) ++m_overflows[group];
+			group = (group + step) & m_group_mask;
+		}
+	}
+
+	u32 findPos(const Key& key) const {
+		if (!m_ctrl) {
+			ASSERT(m_capacity == 0);
+			return 0;
+		}
+
+		const u32 hash = Hasher::get(key);
+		const u8 tag = h2(hash);
+		u32 group = (hash >> 7) & m_group_mask;
+		// triangular probing visits every group exactly once since group count is power of 2
+		for (u32 step = 1; step <= m_group_mask + 1; ++step) {
+			const u32 base = group * Group::SIZE;
+			u32 mask = Group::match(m_ctrl + base, tag);
+			while (mask) {
+				const u32 pos = base + Group::firstBit(mask);
+				if (m_keys[pos] == key) return pos;
+				mask &= mask - 1;
+			}
+			if (m_overflows[group] == 0) return m_capacity;
+			group = (group + step) & m_group_mask;
+		}
+		return m_capacity;
+	}
+
+	void destroyAll() {
+		for (u32 i = nextFull(0); i != m_capacity; i = nextFull(i + 1)) {
+			m_keys[i].~Key();
+			m_values[i].~Value();
+		}
+	}
+
+	void deallocate() {
+		m_allocator.deallocate(m_ctrl);
+		m_allocator.deallocate(m_keys);
+		m_allocator.deallocate(m_values);
+		m_ctrl = nullptr;
+		m_overflows = nullptr;
+		m_keys = nullptr;
+		m_values = nullptr;
+	}
+
+	void init(u32 capacity) {
+		if (capacity < Group::SIZE) capacity = Group::SIZE;
+		const bool is_pow_2 = !(capacity & (capacity - 1));
+		ASSERT(is_pow_2);
+		const u32 group_count = capacity / Group::SIZE;
+		m_size = 0;
+		m_group_mask = group_count - 1;
+		m_capacity = capacity;
+		m_ctrl = (u8*)m_allocator.allocate(capacity + group_count);
+		m_overflows = m_ctrl + capacity;
+		memset(m_ctrl, Group::EMPTY, capacity);
+		memset(m_overflows, 0, group_count);
+		m_keys = (Key*)m_allocator.allocate(sizeof(Key) * capacity);
+		m_values = (Value*)m_allocator.allocate(sizeof(Value) * capacity);
+	}
+
+	IAllocator& m_allocator;
+	u8* m_ctrl = nullptr;
+	u8* m_overflows = nullptr;
+	Key* m_keys = nullptr;
+	Value* m_values = nullptr;
+	u32 m_capacity = 0;
+	u32 m_size = 0;
+	u32 m_group_mask = 0;
+};
+
+
+} // namespace Lumix
@@ -125,8 +125,17 @@ struct HashFuncDirect {
 	static u32 get(T key) { return key; }
 };
 
-template<typename Key, typename Value, typename Hasher = HashFunc<Key>>
-struct HashMap
+// HashMap probing strategies
+// linear probing over slots, the default
+struct LinearProbing;
+// swiss table with 16 slots per group probed with SIMD, see group_hash_map.h
+struct GroupProbing;
+
+template<typename Key, typename Value, typename Hasher = HashFunc<Key>, typename Probing = LinearProbing>
+struct HashMap;
+
+template<typename Key, typename Value, typename Hasher>
+struct HashMap<Key, Value, Hasher, LinearProbing>
 {
 private:
 	struct Slot {
@@ -865,17 +865,21 @@ u32 getMemPageSize() {
 }
 
 void* memReserve(size_t size) {
-	void* mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-	ASSERT(mem);
-	return mem;
+	void* mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	ASSERT(mem != MAP_FAILED);
+	return mem == MAP_FAILED ? nullptr : mem;
 }
 
 void memCommit(void* ptr, size_t size) {
 	// noop on linux
 }
 
-void memRelease(void* ptr) {
-	free(ptr);
+void memDecommit(void* ptr, size_t size) {
+	madvise(ptr, size, MADV_DONTNEED);
+}
+
+void memRelease(void* ptr, size_t size) {
+	if (ptr) munmap(ptr, size);
 }
 
 struct FileIterator {};
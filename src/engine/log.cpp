@@ -1,31 +1,71 @@
 #include "engine/allocators.h"
+#include "engine/atomic.h"
 #include "engine/crt.h"
 #include "engine/delegate_list.h"
 #include "engine/log.h"
+#include "engine/os.h"
 #include "engine/path.h"
+#include "engine/profiler.h"
 #include "engine/stream.h"
 #include "engine/string.h"
 #include "engine/sync.h"
+#include "engine/thread.h"
 
 
 namespace Lumix
 {
 
-void fatal(bool cond, const char* msg)
-{
-	if (!cond) {
-		logError(msg, " is false.");
-		abort();
-	}
-}
-
 namespace detail {
+	struct LogNode {
+		LogNode* next;
+		u64 timestamp;
+		u64 thread_id;
+		u32 length;
+		LogLevel level;
+
+		const char* text() const { return (const char*)(this + 1); }
+	};
+
+	struct LogThread final : Thread {
+		LogThread(IAllocator& allocator) : Thread(allocator) {}
+		int task() override;
+	};
+
 	struct Logger {
-		Logger() : callback(allocator) {}
+		// flush file at most this often while messages keep coming
+		static constexpr u32 FLUSH_INTERVAL_MS = 100;
+
+		Logger()
+			: callback(allocator)
+			, file_buffer(allocator)
+			, last_message(allocator)
+			, semaphore(0, 0x7fffFFFF)
+		{}
 
 		Mutex mutex;
 		DefaultAllocator allocator;
 		LogCallback callback;
+		os::OutputFile file;
+		bool is_file_open = false;
+		bool is_binary = false;
+		OutputMemoryStream file_buffer;
+
+		// rate limiting of consecutive duplicates, only with log thread
+		OutputMemoryStream last_message;
+		LogLevel last_level = LogLevel::COUNT;
+		u32 repeat_count = 0;
+
+		LogNode* volatile queue = nullptr;
+		volatile i32 queued_count = 0;
+		volatile i32 dispatched_count = 0;
+		volatile i32 flushed_count = 0;
+		volatile i32 flush_requested = 0;
+		volatile bool is_async = false;
+		volatile bool finished = false;
+		// producers which saw is_async and did not push yet, stopLogThread waits for them
+		volatile i32 pushing = 0;
+		Semaphore semaphore;
+		LogThread* thread = nullptr;
 	};
 
 	struct Log {
@@ -36,6 +76,8 @@ namespace detail {
 
 	static Logger g_logger;
 	thread_local Log g_log;
+	// > 0 while this thread runs log callbacks, it holds g_logger.mutex then
+	thread_local u32 g_callback_depth = 0;
 
 	void addLog(const char* val) { g_log.message << val; }
 	void addLog(const Path& val) { g_log.message << val.c_str(); }
@@ -47,11 +89,182 @@ namespace detail {
 	void lock() { g_logger.mutex.enter(); }
 	void unlock() { g_logger.mutex.exit(); }
 
+	// must hold g_logger.mutex
+	static void writeFile(LogLevel level, const char* text, u32 length, u64 timestamp, u64 thread_id, u32 repeat_count) {
+		if (!g_logger.is_file_open) return;
+		OutputMemoryStream& blob = g_logger.file_buffer;
+		if (g_logger.is_binary) {
+			LogRecord record;
+			record.timestamp = timestamp;
+			record.thread_id = thread_id;
+			record.length = length;
+			record.repeat_count = repeat_count;
+			record.level = (u8)level;
+			blob.write(record);
+			blob.write(text, length);
+			return;
+		}
+		if (level == LogLevel::ERROR) blob << "Error: ";
+		if (repeat_count > 0) {
+			blob << "Previous message repeated " << repeat_count << " times";
+		}
+		else {
+			blob.write(text, length);
+		}
+		blob << "\n";
+	}
+
+	// must hold g_logger.mutex
+	static void flushFile(bool flush_to_disk) {
+		if (!g_logger.is_file_open || g_logger.file_buffer.empty()) return;
+		if (!g_logger.file.write(g_logger.file_buffer.data(), g_logger.file_buffer.size())) {
+			ASSERT(false);
+		}
+		g_logger.file_buffer.clear();
+		if (flush_to_disk) g_logger.file.flush();
+	}
+
+	// must hold g_logger.mutex
+	static void invokeCallback(LogLevel level, const char* text) {
+		++g_callback_depth;
+		g_logger.callback.invoke(level, text);
+		--g_callback_depth;
+	}
+
+	// must hold g_logger.mutex
+	static void flushRepeats() {
+		if (g_logger.repeat_count == 0) return;
+
+		char tmp[64];
+		copyString(tmp, "Previous message repeated ");
+		toCString(g_logger.repeat_count, Span(tmp + stringLength(tmp), tmp + lengthOf(tmp)));
+		catString(tmp, " times");
+		invokeCallback(g_logger.last_level, tmp);
+		writeFile(g_logger.last_level, "", 0, os::Timer::getRawTimestamp(), os::getCurrentThreadID(), g_logger.repeat_count);
+		g_logger.repeat_count = 0;
+	}
+
+	// must hold g_logger.mutex
+	static void dispatch(const LogNode& node) {
+		OutputMemoryStream& last = g_logger.last_message;
+		if (node.level == g_logger.last_level 
+			&& last.size() == node.length + 1
+			&& memcmp(last.data(), node.text(), node.length) == 0)
+		{
+			++g_logger.repeat_count;
+			return;
+		}
+		flushRepeats();
+		last.clear();
+		last.write(node.text(), node.length + 1);
+		g_logger.last_level = node.level;
+
+		invokeCallback(node.level, node.text());
+		writeFile(node.level, node.text(), node.length, node.timestamp, node.thread_id, 0);
+	}
+
+	// must hold g_logger.mutex, returns number of dispatched messages
+	static u32 dispatchQueued(bool* has_error) {
+		LogNode* list;
+		for (;;) {
+			list = g_logger.queue;
+			if (!list) return 0;
+			if (compareAndExchange64((volatile i64*)&g_logger.queue, 0, (i64)list)) break;
+		}
+
+		// queue is LIFO
+		LogNode* ordered = nullptr;
+		while (list) {
+			LogNode* next = list->next;
+			list->next = ordered;
+			ordered = list;
+			list = next;
+		}
+
+		u32 count = 0;
+		while (ordered) {
+			LogNode* next = ordered->next;
+			dispatch(*ordered);
+			if (ordered->level == LogLevel::ERROR) *has_error = true;
+			g_logger.allocator.deallocate(ordered);
+			ordered = next;
+			++count;
+		}
+		flushFile(false);
+		atomicAdd(&g_logger.dispatched_count, count);
+		return count;
+	}
+
+	int LogThread::task() {
+		profiler::setThreadName("Log");
+		bool is_dirty = false;
+		u64 last_flush = os::Timer::getRawTimestamp();
+		const u64 flush_interval = os::Timer::getFrequency() * Logger::FLUSH_INTERVAL_MS / 1000;
+		while (!g_logger.finished) {
+			// give producers time to fill a batch while there's something to flush
+			if (is_dirty) os::sleep(Logger::FLUSH_INTERVAL_MS);
+			else g_logger.semaphore.wait();
+
+			bool has_error = false;
+			const i32 flush_requested = g_logger.flush_requested;
+			MutexGuard lock(g_logger.mutex);
+			const u32 count = dispatchQueued(&has_error);
+			if (count > 0) is_dirty = true;
+
+			const u64 now = os::Timer::getRawTimestamp();
+			if (is_dirty && (count == 0 || has_error || flush_requested || now - last_flush > flush_interval)) {
+				flushRepeats();
+				flushFile(true);
+				is_dirty = false;
+				last_flush = now;
+			}
+			if (flush_requested) {
+				g_logger.flushed_count = g_logger.dispatched_count;
+				g_logger.flush_requested = 0;
+			}
+		}
+		return 0;
+	}
+
+	static void push(LogLevel level) {
+		const u32 length = (u32)g_log.message.size() - 1;
+		LogNode* node = (LogNode*)g_logger.allocator.allocate(sizeof(LogNode) + length + 1);
+		node->timestamp = os::Timer::getRawTimestamp();
+		node->thread_id = (u64)os::getCurrentThreadID();
+		node->length = length;
+		node->level = level;
+		memcpy((char*)node->text(), g_log.message.data(), length + 1);
+
+		for (;;) {
+			LogNode* head = g_logger.queue;
+			node->next = head;
+			if (compareAndExchange64((volatile i64*)&g_logger.queue, (i64)node, (i64)head)) {
+				atomicIncrement(&g_logger.queued_count);
+				// log thread drains the whole queue on each wake up
+				if (!head) g_logger.semaphore.signal();
+				return;
+			}
+		}
+	}
+
 	void emitLog(LogLevel level) {
 		g_log.message.write('\0');
-		{
+		atomicIncrement(&g_logger.pushing);
+		if (g_logger.is_async) {
+			push(level);
+			atomicDecrement(&g_logger.pushing);
+		}
+		else {
+			atomicDecrement(&g_logger.pushing);
 			MutexGuard lock(g_logger.mutex);
-			g_logger.callback.invoke(level, (const char*)g_log.message.data());
+			// messages queued before the log thread stopped go first
+			bool has_error;
+			dispatchQueued(&has_error);
+			flushRepeats();
+			const char* text = (const char*)g_log.message.data();
+			invokeCallback(level, text);
+			writeFile(level, text, (u32)g_log.message.size() - 1, os::Timer::getRawTimestamp(), os::getCurrentThreadID(), 0);
+			flushFile(true);
 		}
 		g_log.message.clear();
 	}
@@ -60,4 +273,107 @@ namespace detail {
 } // namespace detail
 
 
+void fatal(bool cond, const char* msg)
+{
+	if (!cond) {
+		logError(msg, " is false.");
+		flushLog();
+		abort();
+	}
+}
+
+
+void startLogThread() {
+	using namespace detail;
+	ASSERT(!g_logger.thread);
+	g_logger.finished = false;
+	g_logger.thread = LUMIX_NEW(g_logger.allocator, LogThread)(g_logger.allocator);
+	if (!g_logger.thread->create("log", true)) {
+		LUMIX_DELETE(g_logger.allocator, g_logger.thread);
+		g_logger.thread = nullptr;
+		logError("Failed to create log thread, logging synchronously.");
+		return;
+	}
+	g_logger.is_async = true;
+}
+
+
+void stopLogThread() {
+	using namespace detail;
+	if (!g_logger.thread) return;
+	
+	// new messages are written synchronously, wait for producers which already decided to push
+	g_logger.is_async = false;
+	memoryBarrier();
+	while (g_logger.pushing > 0) os::sleep(0);
+
+	g_logger.finished = true;
+	g_logger.semaphore.signal();
+	g_logger.thread->destroy();
+	LUMIX_DELETE(g_logger.allocator, g_logger.thread);
+	g_logger.thread = nullptr;
+
+	// nothing is pushed anymore, dispatch what the thread did not
+	MutexGuard lock(g_logger.mutex);
+	bool has_error;
+	dispatchQueued(&has_error);
+	flushRepeats();
+	flushFile(true);
+}
+
+
+void flushLog() {
+	using namespace detail;
+	// called from a log callback, e.g. on the log thread, the mutex is held and the log thread can not wait for itself
+	if (g_callback_depth > 0) {
+		bool has_error;
+		dispatchQueued(&has_error);
+		flushRepeats();
+		flushFile(true);
+		return;
+	}
+
+	if (!g_logger.is_async) {
+		MutexGuard lock(g_logger.mutex);
+		flushFile(true);
+		return;
+	}
+
+	const i32 target = g_logger.queued_count;
+	while (g_logger.flushed_count < target && g_logger.is_async) {
+		g_logger.flush_requested = 1;
+		g_logger.semaphore.signal();
+		os::sleep(1);
+	}
+}
+
+
+bool openLogFile(const char* path, bool binary) {
+	using namespace detail;
+	MutexGuard lock(g_logger.mutex);
+	ASSERT(!g_logger.is_file_open);
+	if (!g_logger.file.open(path)) return false;
+
+	g_logger.is_file_open = true;
+	g_logger.is_binary = binary;
+	if (binary) {
+		LogFileHeader header;
+		header.timer_frequency = os::Timer::getFrequency();
+		g_logger.file_buffer.write(header);
+		flushFile(true);
+	}
+	return true;
+}
+
+
+void closeLogFile() {
+	using namespace detail;
+	MutexGuard lock(g_logger.mutex);
+	if (!g_logger.is_file_open) return;
+	flushFile(true);
+	g_logger.file.close();
+	g_logger.is_file_open = false;
+}
+
+
 } // namespace Lumix
@@ -22,8 +22,39 @@ enum class LogLevel {
 	COUNT
 };
 
+// binary log file is LogFileHeader followed by LogRecords, each one followed by `length` bytes of text
+struct LogFileHeader {
+	static constexpr u32 MAGIC = '_LLG';
+	static constexpr u32 VERSION = 0;
+
+	u32 magic = MAGIC;
+	u32 version = VERSION;
+	u64 timer_frequency;
+};
+
+#pragma pack(1)
+struct LogRecord {
+	u64 timestamp;
+	u64 thread_id;
+	u32 length;
+	// >0 for records which only say that the previous message was repeated `repeat_count` times
+	u32 repeat_count;
+	u8 level;
+};
+#pragma pack()
+
 LUMIX_ENGINE_API void fatal(bool cond, const char* msg);
 
+// Without log thread, messages are passed to callbacks and log file on the thread which logs them.
+// With log thread, they are pushed to a lock-free queue and dispatched in batches on the log thread, 
+// consecutive duplicates are collapsed and log file is flushed periodically.
+LUMIX_ENGINE_API void startLogThread();
+LUMIX_ENGINE_API void stopLogThread();
+// blocks until everything logged so far is dispatched and written to disk
+LUMIX_ENGINE_API void flushLog();
+LUMIX_ENGINE_API bool openLogFile(const char* path, bool binary);
+LUMIX_ENGINE_API void closeLogFile();
+
 namespace detail {
 	using LogCallback = DelegateList<void (LogLevel, const char*)>;
 	LUMIX_ENGINE_API void addLog(const char* val);
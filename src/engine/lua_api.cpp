@@ -630,6 +630,7 @@ static void LUA_logInfo(const char* text) { logInfo(text); }
 static void LUA_pause(Engine* engine, bool pause) { engine->pause(pause); }
 static void LUA_nextFrame(Engine* engine) { engine->nextFrame(); }
 static void LUA_setTimeMultiplier(Engine* engine, float multiplier) { engine->setTimeMultiplier(multiplier); }
+static void LUA_setLuaGCBudget(Engine* engine, float ms) { engine->setLuaGCBudget(ms); }
 static Vec4 LUA_multMatrixVec(const Matrix& m, const Vec4& v) { return m * v; }
 static Quat LUA_multQuat(const Quat& a, const Quat& b) { return a * b; }
 
@@ -783,6 +784,7 @@ void registerEngineAPI(lua_State* L, Engine* engine)
 	REGISTER_FUNCTION(setEntityPosition);
 	REGISTER_FUNCTION(setEntityRotation);
 	REGISTER_FUNCTION(setEntityScale);
+	REGISTER_FUNCTION(setLuaGCBudget);
 	//REGISTER_FUNCTION(setTimeMultiplier);
 	//REGISTER_FUNCTION(startGame);
 	REGISTER_FUNCTION(unloadResource);
@@ -959,6 +961,110 @@ void registerEngineAPI(lua_State* L, Engine* engine)
 			end
 		end
 
+		local ffi_loaded, ffi = pcall(require, "ffi")
+		if ffi_loaded then
+			ffi.cdef[[
+				typedef struct { double x, y, z; } LumixVec3;
+				typedef struct { double x, y, z, w; } LumixQuat;
+			]]
+
+			-- vectors can be mixed with {x, y, z} tables
+			local function comps(v)
+				if type(v) == "table" then return v[1], v[2], v[3] end
+				return v.x, v.y, v.z
+			end
+
+			local Vec3
+			local vec3_fields = { "x", "y", "z" }
+			local vec3_methods = {
+				length = function(a) return math.sqrt(a.x * a.x + a.y * a.y + a.z * a.z) end,
+				normalized = function(a)
+					local inv = 1 / math.sqrt(a.x * a.x + a.y * a.y + a.z * a.z)
+					return Vec3(a.x * inv, a.y * inv, a.z * inv)
+				end,
+				dot = function(a, b)
+					local bx, by, bz = comps(b)
+					return a.x * bx + a.y * by + a.z * bz
+				end,
+				cross = function(a, b)
+					local bx, by, bz = comps(b)
+					return Vec3(a.y * bz - a.z * by, a.z * bx - a.x * bz, a.x * by - a.y * bx)
+				end
+			}
+			Vec3 = ffi.metatype("LumixVec3", {
+				__add = function(a, b)
+					local ax, ay, az = comps(a)
+					local bx, by, bz = comps(b)
+					return Vec3(ax + bx, ay + by, az + bz)
+				end,
+				__sub = function(a, b)
+					local ax, ay, az = comps(a)
+					local bx, by, bz = comps(b)
+					return Vec3(ax - bx, ay - by, az - bz)
+				end,
+				__mul = function(a, b)
+					if type(a) == "number" then return Vec3(a * b.x, a * b.y, a * b.z) end
+					if type(b) == "number" then return Vec3(a.x * b, a.y * b, a.z * b) end
+					local ax, ay, az = comps(a)
+					local bx, by, bz = comps(b)
+					return Vec3(ax * bx, ay * by, az * bz)
+				end,
+				__div = function(a, b) return Vec3(a.x / b, a.y / b, a.z / b) end,
+				__unm = function(a) return Vec3(-a.x, -a.y, -a.z) end,
+				__eq = function(a, b)
+					-- `v == nil` must not fail
+					local ta, tb = type(a), type(b)
+					if (ta ~= "cdata" and ta ~= "table") or (tb ~= "cdata" and tb ~= "table") then return false end
+					local ax, ay, az = comps(a)
+					local bx, by, bz = comps(b)
+					return ax == bx and ay == by and az == bz
+				end,
+				__len = function() return 3 end,
+				__index = function(v, key)
+					local field = vec3_fields[key]
+					if field then return v[field] end
+					return vec3_methods[key]
+				end,
+				__newindex = function(v, key, value) v[vec3_fields[key]] = value end,
+				__tostring = function(v) return "{" .. v.x .. ", " .. v.y .. ", " .. v.z .. "}" end
+			})
+
+			local Quat
+			local quat_fields = { "x", "y", "z", "w" }
+			local quat_methods = {
+				rotate = function(q, v)
+					local vx, vy, vz = comps(v)
+					-- t = 2 * cross(q.xyz, v), v + q.w * t + cross(q.xyz, t)
+					local tx = 2 * (q.y * vz - q.z * vy)
+					local ty = 2 * (q.z * vx - q.x * vz)
+					local tz = 2 * (q.x * vy - q.y * vx)
+					return Vec3(vx + q.w * tx + q.y * tz - q.z * ty
+						, vy + q.w * ty + q.z * tx - q.x * tz
+						, vz + q.w * tz + q.x * ty - q.y * tx)
+				end,
+				conjugated = function(q) return Quat(-q.x, -q.y, -q.z, q.w) end
+			}
+			Quat = ffi.metatype("LumixQuat", {
+				__mul = function(a, b)
+					return Quat(a.w * b[1] + b[4] * a.x + a.y * b[3] - b[2] * a.z
+						, a.w * b[2] + b[4] * a.y + a.z * b[1] - b[3] * a.x
+						, a.w * b[3] + b[4] * a.z + a.x * b[2] - b[1] * a.y
+						, a.w * b[4] - a.x * b[1] - a.y * b[2] - a.z * b[3])
+				end,
+				__len = function() return 4 end,
+				__index = function(q, key)
+					local field = quat_fields[key]
+					if field then return q[field] end
+					return quat_methods[key]
+				end,
+				__newindex = function(q, key, value) q[quat_fields[key]] = value end,
+				__tostring = function(q) return "{" .. q.x .. ", " .. q.y .. ", " .. q.z .. ", " .. q.w .. "}" end
+			})
+
+			Lumix.Vec3 = Vec3
+			Lumix.Quat = Quat
+		end
+
 		Lumix.Universe = {}
 		function Lumix.Universe:create() 
 			local u = LumixAPI.createUniverse(LumixAPI.engine)
@@ -1007,6 +1113,7 @@ void registerEngineAPI(lua_State* L, Engine* engine)
 	if (!LuaWrapper::execute(L, Span(entity_src, stringLength(entity_src)), __FILE__ "(" TO_STR(__LINE__) ")", 0)) {
 		logError("Failed to init entity api");
 	}
+	LuaWrapper::registerValueTypes(L);
 
 	installLuaPackageLoader(L);
 }
@@ -48,9 +48,26 @@ int traceback (lua_State *L) {
 }
 
 
-bool pcall(lua_State* L, int nargs, int nres)
+// key in registry, address is used as unique lightuserdata
+static u8 s_traceback_key;
+
+// lua_pushcfunction creates a new closure, pcall is called every frame for every script, so the closure is kept in registry
+static void pushTraceback(lua_State* L)
 {
+	lua_pushlightuserdata(L, &s_traceback_key);
+	lua_rawget(L, LUA_REGISTRYINDEX);
+	if (!lua_isnil(L, -1)) return;
+
+	lua_pop(L, 1);
 	lua_pushcfunction(L, traceback);
+	lua_pushlightuserdata(L, &s_traceback_key);
+	lua_pushvalue(L, -2);
+	lua_rawset(L, LUA_REGISTRYINDEX);
+}
+
+bool pcall(lua_State* L, int nargs, int nres)
+{
+	pushTraceback(L);
 	lua_insert(L, -2 - nargs);
 	if (lua_pcall(L, nargs, nres, -2 - nargs) != 0) {
 		logError(lua_tostring(L, -1));
@@ -67,7 +84,7 @@ bool execute(lua_State* L
 	, const char* name
 	, int nresults)
 {
-	lua_pushcfunction(L, traceback);
+	pushTraceback(L);
 	if (luaL_loadbuffer(L, content.begin(), content.length(), name) != 0) {
 		logError(name, ": ", lua_tostring(L, -1));
 		lua_pop(L, 2);
@@ -118,12 +135,146 @@ bool toEntity(lua_State* L, int idx, Universe*& universe, EntityRef& entity) {
 	return true;
 }
 
+// keys in registry, address is used as unique lightuserdata
+static u8 s_vec3_ctype_key;
+static u8 s_quat_ctype_key;
+static u8 s_entity_mt_key;
+static u8 s_value_type_of_key;
+
+// LuaJIT's type of cdata, it's not in lua.h
+static constexpr int LUA_TCDATA = 10;
+
+void registerValueTypes(lua_State* L) {
+	auto reg = [L](const char* name, void* key){
+		lua_getglobal(L, "Lumix");
+		lua_pushlightuserdata(L, key);
+		if (lua_istable(L, -2)) {
+			lua_getfield(L, -2, name);
+		}
+		else {
+			lua_pushnil(L);
+		}
+		lua_rawset(L, LUA_REGISTRYINDEX);
+		lua_pop(L, 1);
+	};
+	reg("Vec3", &s_vec3_ctype_key);
+	reg("Quat", &s_quat_ctype_key);
+	reg("Entity", &s_entity_mt_key);
+
+	// cdata can be of any FFI type, indexing it by a missing field raises an error,
+	// so the ctype id is checked first, ctype ids are per lua_State
+	static const char value_type_of_src[] = R"#(
+		local Vec3, Quat = ...
+		if Vec3 == nil or Quat == nil then return nil end
+		local typeof = require("ffi").typeof
+		local vec3_id, quat_id = tonumber(Vec3), tonumber(Quat)
+		return function(v)
+			local id = tonumber(typeof(v))
+			if id == vec3_id then return 3 end
+			if id == quat_id then return 4 end
+			return 0
+		end
+	)#";
+	lua_pushlightuserdata(L, &s_value_type_of_key);
+	if (luaL_loadbuffer(L, value_type_of_src, sizeof(value_type_of_src) - 1, "value_type_of") != 0) {
+		logError(lua_tostring(L, -1));
+		lua_pop(L, 2);
+		return;
+	}
+	lua_pushlightuserdata(L, &s_vec3_ctype_key);
+	lua_rawget(L, LUA_REGISTRYINDEX);
+	lua_pushlightuserdata(L, &s_quat_ctype_key);
+	lua_rawget(L, LUA_REGISTRYINDEX);
+	if (!pcall(L, 2, 1)) lua_pushnil(L);
+	lua_rawset(L, LUA_REGISTRYINDEX);
+}
+
+// number of components of Lumix.Vec3 or Lumix.Quat cdata, 0 for any other cdata
+static u32 getValueTypeComponents(lua_State* L, int idx) {
+	if (idx < 0 && idx > LUA_REGISTRYINDEX) idx = lua_gettop(L) + idx + 1;
+	lua_pushlightuserdata(L, &s_value_type_of_key);
+	lua_rawget(L, LUA_REGISTRYINDEX);
+	if (!lua_isfunction(L, -1)) {
+		lua_pop(L, 1);
+		return 0;
+	}
+	lua_pushvalue(L, idx);
+	lua_call(L, 1, 1);
+	const u32 res = (u32)lua_tointeger(L, -1);
+	lua_pop(L, 1);
+	return res;
+}
+
+bool isValueType(lua_State* L, int idx, u32 components) {
+	switch (lua_type(L, idx)) {
+		case LUA_TTABLE: return lua_objlen(L, idx) == components;
+		case LUA_TCDATA: return getValueTypeComponents(L, idx) == components;
+		default: return false;
+	}
+}
+
+void toValueType(lua_State* L, int idx, double* out, u32 components) {
+	ASSERT(components <= 4);
+	if (lua_type(L, idx) == LUA_TCDATA) {
+		// lua_topointer returns cdata's payload, which is LumixVec3 or LumixQuat, i.e. doubles,
+		// this is much cheaper than indexing the fields through the metatype
+		const double* values = getValueTypeComponents(L, idx) == components ? (const double*)lua_topointer(L, idx) : nullptr;
+		for (u32 i = 0; i < components; ++i) {
+			out[i] = values ? values[i] : 0;
+		}
+		return;
+	}
+
+	for (u32 i = 0; i < components; ++i) {
+		lua_rawgeti(L, idx, i + 1);
+		out[i] = lua_tonumber(L, -1);
+		lua_pop(L, 1);
+	}
+}
+
+void pushValueType(lua_State* L, const double* values, u32 components) {
+	ASSERT(components == 3 || components == 4);
+	lua_pushlightuserdata(L, components == 3 ? &s_vec3_ctype_key : &s_quat_ctype_key);
+	lua_rawget(L, LUA_REGISTRYINDEX);
+	if (lua_isnil(L, -1)) {
+		// value types are not registered in this state, fallback to tables
+		lua_pop(L, 1);
+		lua_createtable(L, components, 0);
+		for (u32 i = 0; i < components; ++i) {
+			lua_pushnumber(L, values[i]);
+			lua_rawseti(L, -2, i + 1);
+		}
+		return;
+	}
+
+	for (u32 i = 0; i < components; ++i) {
+		lua_pushnumber(L, values[i]);
+	}
+	lua_call(L, components, 1);
+}
+
 void pushEntity(lua_State* L, EntityPtr value, Universe* universe) {
 	if (!value.isValid()) {
 		lua_newtable(L); // [env, {}]
 		return;
 	}
 
+	lua_pushlightuserdata(L, &s_entity_mt_key);		// [key]
+	lua_rawget(L, LUA_REGISTRYINDEX);				// [Lumix.Entity]
+	if (lua_istable(L, -1)) {
+		// same as Lumix.Entity:new, without calling into lua
+		lua_createtable(L, 0, 2);					// [Lumix.Entity, entity]
+		lua_pushnumber(L, value.index);				// [Lumix.Entity, entity, entity_index]
+		lua_setfield(L, -2, "_entity");				// [Lumix.Entity, entity]
+		lua_pushlightuserdata(L, universe);			// [Lumix.Entity, entity, universe]
+		lua_setfield(L, -2, "_universe");			// [Lumix.Entity, entity]
+		lua_pushvalue(L, -2);						// [Lumix.Entity, entity, Lumix.Entity]
+		lua_setmetatable(L, -2);					// [Lumix.Entity, entity]
+		lua_remove(L, -2);							// [entity]
+		return;
+	}
+	lua_pop(L, 1);
+
 	lua_getglobal(L, "Lumix");						// [Lumix]
 	lua_getfield(L, -1, "Entity");					// [Lumix, Lumix.Entity]
 	lua_remove(L, -2);								// [Lumix.Entity]
@@ -237,4 +388,4 @@ void argError(lua_State* L, int index, const char* expected_type) {
 }
 
 
-} // namespace Lumix::LuaWrapper
\ No newline at end of file
+} // namespace Lumix::LuaWrapper
@@ -54,6 +54,13 @@ LUMIX_ENGINE_API bool pcall(lua_State* L, int nargs, int nres);
 LUMIX_ENGINE_API bool execute(lua_State* L, Span<const char> content, const char* name, int nresults);
 LUMIX_ENGINE_API int getField(lua_State* L, int idx, const char* k);
 
+// vectors and quaternions are pushed as LuaJIT FFI cdata (Lumix.Vec3, Lumix.Quat) once registerValueTypes is called,
+// tables with 3 or 4 numbers are still accepted wherever a vector or a quaternion is expected
+LUMIX_ENGINE_API void registerValueTypes(lua_State* L);
+LUMIX_ENGINE_API bool isValueType(lua_State* L, int idx, u32 components);
+LUMIX_ENGINE_API void toValueType(lua_State* L, int idx, double* out, u32 components);
+LUMIX_ENGINE_API void pushValueType(lua_State* L, const double* values, u32 components);
+
 template <typename T> inline bool isType(lua_State* L, int index)
 {
 	return lua_islightuserdata(L, index) != 0;
@@ -95,11 +102,11 @@ template <> inline bool isType<ComponentType>(lua_State* L, int index)
 }
 template <> inline bool isType<Vec3>(lua_State* L, int index)
 {
-	return lua_istable(L, index) != 0 && lua_objlen(L, index) == 3;
+	return isValueType(L, index, 3);
 }
 template <> inline bool isType<DVec3>(lua_State* L, int index)
 {
-	return lua_istable(L, index) != 0 && lua_objlen(L, index) == 3;
+	return isValueType(L, index, 3);
 }
 template <> inline bool isType<Vec4>(lua_State* L, int index)
 {
@@ -115,7 +122,7 @@ template <> inline bool isType<Matrix>(lua_State* L, int index)
 }
 template <> inline bool isType<Quat>(lua_State* L, int index)
 {
-	return lua_istable(L, index) != 0 && lua_objlen(L, index) == 4;
+	return isValueType(L, index, 4);
 }
 template <> inline bool isType<u32>(lua_State* L, int index)
 {
@@ -181,17 +188,9 @@ template <> inline EntityPtr toType(lua_State* L, int index) {
 }
 
 template <> inline Vec3 toType(lua_State* L, int index) {
-	Vec3 v;
-	lua_rawgeti(L, index, 1);
-	v.x = (float)lua_tonumber(L, -1);
-	lua_pop(L, 1);
-	lua_rawgeti(L, index, 2);
-	v.y = (float)lua_tonumber(L, -1);
-	lua_pop(L, 1);
-	lua_rawgeti(L, index, 3);
-	v.z = (float)lua_tonumber(L, -1);
-	lua_pop(L, 1);
-	return v;
+	double v[3];
+	toValueType(L, index, v, 3);
+	return Vec3((float)v[0], (float)v[1], (float)v[2]);
 }
 
 template <> inline IVec3 toType(lua_State* L, int index) {
@@ -209,17 +208,9 @@ template <> inline IVec3 toType(lua_State* L, int index) {
 }
 
 template <> inline DVec3 toType(lua_State* L, int index) {
-	DVec3 v;
-	lua_rawgeti(L, index, 1);
-	v.x = (double)lua_tonumber(L, -1);
-	lua_pop(L, 1);
-	lua_rawgeti(L, index, 2);
-	v.y = (double)lua_tonumber(L, -1);
-	lua_pop(L, 1);
-	lua_rawgeti(L, index, 3);
-	v.z = (double)lua_tonumber(L, -1);
-	lua_pop(L, 1);
-	return v;
+	double v[3];
+	toValueType(L, index, v, 3);
+	return DVec3(v[0], v[1], v[2]);
 }
 
 template <> inline Vec4 toType(lua_State* L, int index) {
@@ -240,20 +231,9 @@ template <> inline Vec4 toType(lua_State* L, int index) {
 }
 
 template <> inline Quat toType(lua_State* L, int index) {
-	Quat v;
-	lua_rawgeti(L, index, 1);
-	v.x = (float)lua_tonumber(L, -1);
-	lua_pop(L, 1);
-	lua_rawgeti(L, index, 2);
-	v.y = (float)lua_tonumber(L, -1);
-	lua_pop(L, 1);
-	lua_rawgeti(L, index, 3);
-	v.z = (float)lua_tonumber(L, -1);
-	lua_pop(L, 1);
-	lua_rawgeti(L, index, 4);
-	v.w = (float)lua_tonumber(L, -1);
-	lua_pop(L, 1);
-	return v;
+	double v[4];
+	toValueType(L, index, v, 4);
+	return Quat((float)v[0], (float)v[1], (float)v[2], (float)v[3]);
 }
 
 template <> inline Vec2 toType(lua_State* L, int index) {
@@ -449,29 +429,13 @@ inline void push(lua_State* L, const IVec3& value)
 }
 inline void push(lua_State* L, const Vec3& value)
 {
-	lua_createtable(L, 3, 0);
-
-	lua_pushnumber(L, value.x);
-	lua_rawseti(L, -2, 1);
-
-	lua_pushnumber(L, value.y);
-	lua_rawseti(L, -2, 2);
-
-	lua_pushnumber(L, value.z);
-	lua_rawseti(L, -2, 3);
+	const double v[] = { value.x, value.y, value.z };
+	pushValueType(L, v, 3);
 }
 inline void push(lua_State* L, const DVec3& value)
 {
-	lua_createtable(L, 3, 0);
-
-	lua_pushnumber(L, value.x);
-	lua_rawseti(L, -2, 1);
-
-	lua_pushnumber(L, value.y);
-	lua_rawseti(L, -2, 2);
-
-	lua_pushnumber(L, value.z);
-	lua_rawseti(L, -2, 3);
+	const double v[] = { value.x, value.y, value.z };
+	pushValueType(L, v, 3);
 }
 inline void push(lua_State* L, const Vec4& value)
 {
@@ -491,19 +455,8 @@ inline void push(lua_State* L, const Vec4& value)
 }
 inline void push(lua_State* L, const Quat& value)
 {
-	lua_createtable(L, 4, 0);
-
-	lua_pushnumber(L, value.x);
-	lua_rawseti(L, -2, 1);
-
-	lua_pushnumber(L, value.y);
-	lua_rawseti(L, -2, 2);
-
-	lua_pushnumber(L, value.z);
-	lua_rawseti(L, -2, 3);
-
-	lua_pushnumber(L, value.w);
-	lua_rawseti(L, -2, 4);
+	const double v[] = { value.x, value.y, value.z, value.w };
+	pushValueType(L, v, 4);
 }
 inline void push(lua_State* L, bool value)
 {
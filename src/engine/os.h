@@ -164,7 +164,10 @@ LUMIX_ENGINE_API ThreadID getCurrentThreadID();
 
 LUMIX_ENGINE_API void* memReserve(size_t size);
 LUMIX_ENGINE_API void memCommit(void* ptr, size_t size);
-LUMIX_ENGINE_API void memRelease(void* ptr);
+// gives committed pages back to the system, the range stays reserved and can be committed again
+LUMIX_ENGINE_API void memDecommit(void* ptr, size_t size);
+// size must be the size passed to memReserve
+LUMIX_ENGINE_API void memRelease(void* ptr, size_t size);
 LUMIX_ENGINE_API u32 getMemPageSize();
 
 LUMIX_ENGINE_API FileIterator* createFileIterator(const char* path, IAllocator& allocator);
@@ -1,10 +1,12 @@
 #include "engine/lumix.h"
 #include "engine/path.h"
 
+#include "engine/allocators.h"
+#include "engine/atomic.h"
 #include "engine/crc32.h"
+#include "engine/crt.h"
 #include "engine/hash_map.h"
 #include "engine/sync.h"
-#include "engine/path.h"
 #include "engine/stream.h"
 #include "engine/string.h"
 
@@ -13,37 +15,141 @@ namespace Lumix
 {
 
 
-Path::Path()
-	: m_hash(0)
-	, m_path{}
-{}
+namespace {
+
+struct PathTable {
+	PathTable() : map(allocator) {}
+
+	DefaultAllocator allocator;
+	// buckets are keyed by crc32, entries with colliding hashes are chained in `next`
+	HashMap<u32, Path::Entry*> map;
+	Mutex mutex;
+	u32 count = 0;
+	size_t size = 0;
+};
+
+// entries are allocated with the string right after them
+static const char* getString(const Path::Entry* e) { return (const char*)(e + 1); }
+
+static_assert(sizeof(Path::Entry) % alignof(Path::Entry) == 0);
+
+}
+
+// paths are used in globals, so the table is created on first use and never destroyed
+static PathTable& getPathTable() {
+	alignas(PathTable) static u8 mem[sizeof(PathTable)];
+	static PathTable* table = new (NewPlaceholder(), mem) PathTable;
+	return *table;
+}
+
+static Path::Entry* intern(const char* normalized) {
+	if (!normalized[0]) return nullptr;
+
+	const u32 hash = crc32(normalized);
+	PathTable& table = getPathTable();
+	MutexGuard lock(table.mutex);
+	auto iter = table.map.find(hash);
+	Path::Entry* head = iter.isValid() ? iter.value() : nullptr;
+	for (Path::Entry* e = head; e; e = e->next) {
+		if (equalStrings(getString(e), normalized)) {
+			atomicIncrement(&e->ref_count);
+			return e;
+		}
+	}
+
+	const u32 len = stringLength(normalized);
+	const size_t size = sizeof(Path::Entry) + len + 1;
+	Path::Entry* e = new (NewPlaceholder(), table.allocator.allocate(size)) Path::Entry;
+	e->hash = hash;
+	e->length = len;
+	e->ref_count = 1;
+	e->next = head;
+	memcpy((char*)getString(e), normalized, len + 1);
+	if (iter.isValid()) iter.value() = e;
+	else table.map.insert(hash, e);
+	++table.count;
+	table.size += size;
+	return e;
+}
+
+static void release(Path::Entry* entry) {
+	if (!entry) return;
+	
+	const u32 hash = entry->hash;
+	if (atomicDecrement(&entry->ref_count) > 0) return;
+
+	// entry can be revived by intern() or freed by other thread before we get the lock,
+	// so free anything unreferenced in the bucket instead of touching `entry`
+	PathTable& table = getPathTable();
+	MutexGuard lock(table.mutex);
+	auto iter = table.map.find(hash);
+	if (!iter.isValid()) return;
+
+	Path::Entry* head = iter.value();
+	Path::Entry** prev = &head;
+	while (*prev) {
+		Path::Entry* e = *prev;
+		if (e->ref_count == 0) {
+			*prev = e->next;
+			--table.count;
+			table.size -= sizeof(Path::Entry) + e->length + 1;
+			table.allocator.deallocate(e);
+		}
+		else {
+			prev = &e->next;
+		}
+	}
+	if (head) iter.value() = head;
+	else table.map.erase(iter);
+}
+
+u32 Path::getInternedCount() {
+	PathTable& table = getPathTable();
+	MutexGuard lock(table.mutex);
+	return table.count;
+}
 
-//Path::Path(const Path& rhs)
-//	: m_hash(rhs.m_hash)
-//{
-//	copyString(m_path, rhs.m_path);
-//}
+size_t Path::getInternedSize() {
+	PathTable& table = getPathTable();
+	MutexGuard lock(table.mutex);
+	return table.size;
+}
 
 Path::Path(const char* path) {
-	normalize(path, Span(m_path));
-	m_hash = crc32(m_path);
+	char tmp[LUMIX_MAX_PATH];
+	normalize(path, Span(tmp));
+	m_entry = intern(tmp);
 }
 
-i32 Path::length() const {
-	return stringLength(m_path);
+Path::Path(const Path& rhs)
+	: m_entry(rhs.m_entry)
+{
+	if (m_entry) atomicIncrement(&m_entry->ref_count);
+}
+
+Path::~Path() {
+	release(m_entry);
 }
 
 void Path::operator =(const char* rhs) {
-	normalize(rhs, Span(m_path));
-	m_hash = crc32(m_path);
+	char tmp[LUMIX_MAX_PATH];
+	normalize(rhs, Span(tmp));
+	Entry* old = m_entry;
+	m_entry = intern(tmp);
+	release(old);
 }
 
-bool Path::operator==(const Path& rhs) const {
-	return m_hash == rhs.m_hash;
+void Path::operator =(const Path& rhs) {
+	if (rhs.m_entry) atomicIncrement(&rhs.m_entry->ref_count);
+	release(m_entry);
+	m_entry = rhs.m_entry;
 }
 
-bool Path::operator!=(const Path& rhs) const {
-	return m_hash != rhs.m_hash;
+void Path::operator =(Path&& rhs) {
+	if (&rhs == this) return;
+	release(m_entry);
+	m_entry = rhs.m_entry;
+	rhs.m_entry = nullptr;
 }
 
 void Path::normalize(const char* path, Span<char> output)
@@ -15,29 +15,45 @@ struct LUMIX_ENGINE_API PathInfo
 	char m_dir[LUMIX_MAX_PATH];
 };
 
+// Handle to an interned, refcounted entry in a global path table, copies and comparisons do not touch the string
 struct LUMIX_ENGINE_API Path {
+	// normalized string follows the entry in memory
+	struct Entry {
+		u32 hash;
+		u32 length;
+		volatile i32 ref_count;
+		Entry* next; // entries with colliding hashes, owned by the path table
+	};
+
 	static void normalize(const char* path, Span<char> out);
 	static Span<const char> getDir(const char* src);
 	static Span<const char> getBasename(const char* src);
 	static Span<const char> getExtension(Span<const char> src);
 	static bool hasExtension(const char* filename, const char* ext);
 	static bool replaceExtension(char* path, const char* ext);
+	// number of interned paths and bytes used by them
+	static u32 getInternedCount();
+	static size_t getInternedSize();
 
-	Path();
+	Path() : m_entry(nullptr) {}
 	explicit Path(const char* path);
+	Path(const Path& rhs);
+	Path(Path&& rhs) : m_entry(rhs.m_entry) { rhs.m_entry = nullptr; }
+	~Path();
 
 	void operator=(const char* rhs);
-	bool operator==(const Path& rhs) const;
-	bool operator!=(const Path& rhs) const;
+	void operator=(const Path& rhs);
+	void operator=(Path&& rhs);
+	bool operator==(const Path& rhs) const { return m_entry == rhs.m_entry; }
+	bool operator!=(const Path& rhs) const { return m_entry != rhs.m_entry; }
 
-	i32 length() const;
-	u32 getHash() const { return m_hash; }
-	const char* c_str() const { return m_path; }
-	bool isEmpty() const { return m_path[0] == '\0'; }
+	i32 length() const { return m_entry ? m_entry->length : 0; }
+	u32 getHash() const { return m_entry ? m_entry->hash : 0; }
+	const char* c_str() const { return m_entry ? (const char*)(m_entry + 1) : ""; }
+	bool isEmpty() const { return !m_entry; }
 
 private:
-	char m_path[LUMIX_MAX_PATH];
-	u32 m_hash;
+	Entry* m_entry;
 };
 
 
@@ -37,6 +37,9 @@ struct LUMIX_ENGINE_API IScene
 	virtual void init() {}
 	virtual void serialize(struct OutputMemoryStream& serializer) = 0;
 	virtual void deserialize(struct InputMemoryStream& serialize, const struct EntityMap& entity_map, i32 version) = 0;
+	// deserialize touches only the scene's own data, resources (through ResourceManagerHub) and Universe::onComponentCreated,
+	// such scenes are deserialized in parallel with the rest; scenes after it still see its components
+	virtual bool isDeserializeIndependent() const { return false; }
 	virtual IPlugin& getPlugin() const = 0;
 	virtual void update(float time_delta, bool paused) = 0;
 	virtual void lateUpdate(float time_delta, bool paused) {}
@@ -4,15 +4,29 @@
 	#define WIN32_LEAN_AND_MEAN
 	#include <Windows.h>
 	#include <evntcons.h>
+	#include <intrin.h>
+#elif defined(__x86_64__)
+	#include <x86intrin.h>
+#endif
+#ifdef __linux__
+	#include <dirent.h>
+	#include <fcntl.h>
+	#include <linux/perf_event.h>
+	#include <sys/mman.h>
+	#include <sys/syscall.h>
+	#include <time.h>
+	#include <unistd.h>
 #endif
 
 #include "engine/array.h"
 #include "engine/crt.h"
 #include "engine/hash_map.h"
 #include "engine/allocators.h"
+#include "engine/lz4.h"
 #include "engine/atomic.h"
 #include "engine/math.h"
 #include "engine/string.h"
+#include "engine/stream.h"
 #include "engine/sync.h"
 #include "engine/thread.h"
 #include "engine/os.h"
@@ -26,24 +40,84 @@ namespace profiler
 {
 
 
+static LUMIX_FORCE_INLINE void storeRelease(volatile i32* ptr, i32 value)
+{
+	#ifdef _MSC_VER
+		_ReadWriteBarrier();
+		*ptr = value;
+	#else
+		__atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+	#endif
+}
+
+
+static LUMIX_FORCE_INLINE i32 loadAcquire(const volatile i32* ptr)
+{
+	#ifdef _MSC_VER
+		const i32 value = *ptr;
+		_ReadWriteBarrier();
+		return value;
+	#else
+		return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+	#endif
+}
+
+
+// raw TSC where available, converted to seconds using frequency(), which is calibrated against os::Timer
+static LUMIX_FORCE_INLINE u64 getTimestamp()
+{
+	#if defined(_M_X64) || defined(__x86_64__)
+		return __rdtsc();
+	#else
+		return os::Timer::getRawTimestamp();
+	#endif
+}
+
+
+// Events are written to a ring of chunks. Only the owning thread writes, without any locks.
+// Readers copy whole chunks and use `generation` to detect chunks recycled while they were copied.
 struct ThreadContext
 {
+	static constexpr u32 CHUNK_SIZE = 32 * 1024;
+	static constexpr u32 CHUNKS_COUNT = 16;
+
+	struct Chunk
+	{
+		volatile i32 generation;
+		volatile i32 size;
+		u8 data[CHUNK_SIZE];
+	};
+
 	ThreadContext(IAllocator& allocator) 
-		: buffer(allocator)
+		: allocator(allocator)
 		, open_blocks(allocator)
 	{
-		buffer.resize(1024 * 512);
+		chunks = (Chunk*)allocator.allocate(sizeof(Chunk) * CHUNKS_COUNT);
+		for (u32 i = 0; i < CHUNKS_COUNT; ++i) {
+			chunks[i].generation = -1;
+			chunks[i].size = 0;
+		}
+		chunks[0].generation = 0;
 		open_blocks.reserve(64);
 	}
 
+	~ThreadContext() { allocator.deallocate(chunks); }
+
+	IAllocator& allocator;
 	Array<const char*> open_blocks;
-	OutputMemoryStream buffer;
-	u32 begin = 0;
-	u32 end = 0;
+	Chunk* chunks;
+	volatile i32 current_chunk = 0;
+	// chunks overwritten before the headless capture read them
+	volatile i32 overflow_count = 0;
+	// first chunk with events the headless capture did not read yet, -1 if there is no capture
+	volatile i32 unread_chunk = -1;
 	Mutex mutex;
 	StaticString<64> name;
 	bool show_in_profiler = false;
 	u32 thread_id;
+	// how far the headless capture read, accessed only by the capture thread
+	i32 capture_chunk = 0;
+	u32 capture_offset = 0;
 };
 
 #ifdef _WIN32
@@ -84,30 +158,115 @@ struct ThreadContext
 
 		TRACEHANDLE open_handle;
 	};
+#elif defined(__linux__)
+	// sched:sched_switch tracepoint on every CPU through perf_event_open, this needs CAP_PERFMON
+	// or kernel.perf_event_paranoid <= 0; if not available, /proc/self/task/*/schedstat is sampled,
+	// which can only tell that a thread did not run during a whole sampling period
+	struct TraceTask : Thread {
+		static constexpr u32 RING_PAGES = 64;
+		static constexpr u32 SCHEDSTAT_PERIOD_US = 1000;
+
+		struct Ring {
+			int fd;
+			perf_event_mmap_page* header;
+			u8* data;
+			u64 data_size;
+		};
+
+		struct SampledThread {
+			u64 run_time;
+			u64 last_seen;
+			bool running;
+		};
+
+		TraceTask(IAllocator& allocator);
+
+		bool openTracepoints();
+		bool canSampleSchedstat();
+		void closeTracepoints();
+		void readTracepoints();
+		void readRecord(const Ring& ring, u64 offset, u8* out, u32 size);
+		bool isOwnThread(u32 tid);
+		void sampleSchedstat();
+		// wakes the task up after pause(false) or destroy
+		void wakeup();
+		int task() override;
+		void destroy();
+
+		Array<Ring> rings;
+		HashMap<u32, bool> own_threads;
+		HashMap<u32, SampledThread> sampled_threads;
+		u32 prev_pid_offset = 0;
+		u32 prev_state_offset = 0;
+		u32 next_pid_offset = 0;
+		u64 schedstat_frame = 0;
+		// own_threads are valid only for this session, see Instance::session
+		i32 own_threads_session = 0;
+		volatile bool finished = false;
+		bool is_created = false;
+		// the task sleeps while the profiler is paused
+		Mutex wakeup_mutex;
+		ConditionVariable wakeup_cv;
+	};
 #else
 	struct TraceTask {
 		TraceTask(IAllocator&) {}
 		void destroy() {}
-		int open_handle;
 	};
-	void CloseTrace(int) {}
 #endif
 
 static struct Instance
 {
 	Instance()
 		: contexts(allocator)
+		, interned_strings(allocator)
 		, trace_task(allocator)
 		, global_context(allocator)
 	{
+		calibrate();
 		startTrace();
 	}
 
 
+	// first estimate, refined in frame() as the measured interval gets longer
+	void calibrate()
+	{
+		timestamp_base = getTimestamp();
+		timer_base = os::Timer::getRawTimestamp();
+		const u64 timer_freq = os::Timer::getFrequency();
+		u64 timer_now;
+		do {
+			timer_now = os::Timer::getRawTimestamp();
+		} while (timer_now - timer_base < timer_freq / 1000);
+		timestamps_per_tick = double(getTimestamp() - timestamp_base) / double(timer_now - timer_base);
+		last_calibration = timer_now;
+	}
+
+
+	void recalibrate()
+	{
+		const u64 timer_now = os::Timer::getRawTimestamp();
+		if (timer_now - last_calibration < os::Timer::getFrequency()) return;
+		last_calibration = timer_now;
+		timestamps_per_tick = double(getTimestamp() - timestamp_base) / double(timer_now - timer_base);
+	}
+
+
+	// os::Timer timestamp (GPU and context switch events) to profiler timestamp
+	u64 fromTimerTimestamp(u64 timer_timestamp) const
+	{
+		return timestamp_base + u64(double(i64(timer_timestamp - timer_base)) * timestamps_per_tick);
+	}
+
+
 	~Instance()
 	{
-		CloseTrace(trace_task.open_handle);
+		stopCapture();
+		#ifdef _WIN32
+			CloseTrace(trace_task.open_handle);
+		#endif
 		trace_task.destroy();
+		for (char* str : interned_strings) allocator.deallocate(str);
 	}
 
 
@@ -146,6 +305,11 @@ static struct Instance
 			trace.EventRecordCallback = TraceTask::callback;
 			trace_task.open_handle = OpenTrace(&trace);
 			trace_task.create("profiler trace", true);
+		#elif defined(__linux__)
+			context_switches_enabled = trace_task.openTracepoints() || trace_task.canSampleSchedstat();
+			if (context_switches_enabled) {
+				trace_task.is_created = trace_task.create("profiler trace", true);
+			}
 		#endif
 	}
 
@@ -154,7 +318,12 @@ static struct Instance
 	{
 		thread_local ThreadContext* ctx = [&](){
 			ThreadContext* new_ctx = LUMIX_NEW(allocator, ThreadContext)(allocator);
-			new_ctx->thread_id = os::getCurrentThreadID();
+			#ifdef __linux__
+				// kernel thread id, so it matches context switch records
+				new_ctx->thread_id = (u32)syscall(SYS_gettid);
+			#else
+				new_ctx->thread_id = os::getCurrentThreadID();
+			#endif
 			MutexGuard lock(mutex);
 			contexts.push(new_ctx);
 			return new_ctx;
@@ -167,128 +336,94 @@ static struct Instance
 	DefaultAllocator allocator;
 	Array<ThreadContext*> contexts;
 	Mutex mutex;
-	os::Timer timer;
+	u64 timestamp_base;
+	u64 timer_base;
+	u64 last_calibration;
+	double timestamps_per_tick = 1;
 	bool paused = false;
 	bool context_switches_enabled = false;
 	u64 paused_time = 0;
 	u64 last_frame_duration = 0;
 	u64 last_frame_time = 0;
 	volatile i32 fiber_wait_id = 0;
+	struct CaptureTask* capture_task = nullptr;
+	u64 outlier_frame_duration = 0;
+	volatile i32 outlier_pending = 0;
+	// incremented when a capture starts or the profiler resumes, tids cached by the trace task are dropped then
+	volatile i32 session = 0;
+	// see internString, protected by `mutex`
+	Array<char*> interned_strings;
 	TraceTask trace_task;
 	ThreadContext global_context;
 } g_instance;
 
 
-template <typename T>
-void write(ThreadContext& ctx, u64 timestamp, EventType type, const T& value)
+static void write(ThreadContext& ctx, u64 timestamp, EventType type, const u8* data, u32 size)
 {
-	if (g_instance.paused && timestamp > g_instance.paused_time) return;
-
-	#pragma pack(1)
-		struct {
-			EventHeader header;
-			T value;
-		} v;
-	#pragma pack()
-	v.header.type = type;
-	v.header.size = sizeof(v);
-	v.header.time = timestamp;
-	v.value = value;
-
-	MutexGuard lock(ctx.mutex);
-	u8* buf = ctx.buffer.getMutableData();
-	const u32 buf_size = (u32)ctx.buffer.size();
-
-	while (sizeof(v) + ctx.end - ctx.begin > buf_size) {
-		const u8 size = buf[ctx.begin % buf_size];
-		ctx.begin += size;
+	EventHeader header;
+	header.type = type;
+	header.size = u16(sizeof(header) + size);
+	header.time = timestamp;
+	if (sizeof(header) + size > ThreadContext::CHUNK_SIZE) {
+		ASSERT(false);
+		return;
 	}
 
-	const u32 lend = ctx.end % buf_size;
-	if (buf_size - lend >= sizeof(v)) {
-		memcpy(buf + lend, &v, sizeof(v));
-	}
-	else {
-		memcpy(buf + lend, &v, buf_size - lend);
-		memcpy(buf, ((u8*)&v) + buf_size - lend, sizeof(v) - (buf_size - lend));
+	ThreadContext::Chunk* chunk = &ctx.chunks[u32(ctx.current_chunk) % ThreadContext::CHUNKS_COUNT];
+	if (u32(chunk->size) + header.size > ThreadContext::CHUNK_SIZE) {
+		const i32 next = ctx.current_chunk + 1;
+		chunk = &ctx.chunks[u32(next) % ThreadContext::CHUNKS_COUNT];
+		// recycling a chunk is an overflow only if the capture did not read it yet
+		const i32 recycled = chunk->generation;
+		const i32 unread = loadAcquire(&ctx.unread_chunk);
+		if (recycled >= 0 && unread >= 0 && recycled >= unread) storeRelease(&ctx.overflow_count, ctx.overflow_count + 1);
+		storeRelease(&chunk->generation, -1);
+		// readers must see the chunk is invalid before we overwrite its data
+		memoryBarrier();
+		chunk->size = 0;
+		storeRelease(&chunk->generation, next);
+		storeRelease(&ctx.current_chunk, next);
 	}
 
-	ctx.end += sizeof(v);
-};
+	u8* dst = chunk->data + chunk->size;
+	memcpy(dst, &header, sizeof(header));
+	memcpy(dst + sizeof(header), data, size);
+	storeRelease(&chunk->size, chunk->size + header.size);
+}
+
 
 template <typename T>
-void write(ThreadContext& ctx, EventType type, const T& value)
+static void write(ThreadContext& ctx, EventType type, const T& value)
 {
 	if (g_instance.paused) return;
-
-#pragma pack(1)
-	struct {
-		EventHeader header;
-		T value;
-	} v;
-#pragma pack()
-	v.header.type = type;
-	v.header.size = sizeof(v);
-	v.header.time = os::Timer::getRawTimestamp();
-	v.value = value;
-
-	MutexGuard lock(ctx.mutex);
-	u8* buf = ctx.buffer.getMutableData();
-	const u32 buf_size = (u32)ctx.buffer.size();
-
-	while (sizeof(v) + ctx.end - ctx.begin > buf_size) {
-		const u8 size = buf[ctx.begin % buf_size];
-		ctx.begin += size;
-	}
-
-	const u32 lend = ctx.end % buf_size;
-	if (buf_size - lend >= sizeof(v)) {
-		memcpy(buf + lend, &v, sizeof(v));
-	}
-	else {
-		memcpy(buf + lend, &v, buf_size - lend);
-		memcpy(buf, ((u8*)&v) + buf_size - lend, sizeof(v) - (buf_size - lend));
-	}
-
-	ctx.end += sizeof(v);
-};
+	write(ctx, getTimestamp(), type, (const u8*)&value, sizeof(value));
+}
 
 
-void write(ThreadContext& ctx, EventType type, const u8* data, int size)
+static void write(ThreadContext& ctx, EventType type, const u8* data, int size)
 {
 	if (g_instance.paused) return;
+	write(ctx, getTimestamp(), type, data, size);
+}
 
-	EventHeader header;
-	header.type = type;
-	ASSERT(sizeof(header) + size <= 0xffff);
-	header.size = u16(sizeof(header) + size);
-	header.time = os::Timer::getRawTimestamp();
 
+// global context is shared by several threads (render, trace, main), so writes to it are serialized
+template <typename T>
+static void writeGlobal(u64 timestamp, EventType type, const T& value)
+{
+	if (g_instance.paused && timestamp > g_instance.paused_time) return;
+	ThreadContext& ctx = g_instance.global_context;
 	MutexGuard lock(ctx.mutex);
-	u8* buf = ctx.buffer.getMutableData();
-	const u32 buf_size = (u32)ctx.buffer.size();
+	write(ctx, timestamp, type, (const u8*)&value, sizeof(value));
+}
 
-	while (header.size + ctx.end - ctx.begin > buf_size) {
-		const u8 size = buf[ctx.begin % buf_size];
-		ctx.begin += size;
-	}
 
-	auto cpy = [&](const u8* ptr, u32 size) {
-		const u32 lend = ctx.end % buf_size;
-		if (buf_size - lend >= size) {
-			memcpy(buf + lend, ptr, size);
-		}
-		else {
-			memcpy(buf + lend, ptr, buf_size - lend);
-			memcpy(buf, ((u8*)ptr) + buf_size - lend, size - (buf_size - lend));
-		}
+template <typename T>
+static void writeGlobal(EventType type, const T& value)
+{
+	writeGlobal(getTimestamp(), type, value);
+}
 
-		ctx.end += size;
-	};
-
-	cpy((u8*)&header, sizeof(header));
-	cpy(data, size);
-};
 
 #ifdef _WIN32
 	TraceTask::TraceTask(IAllocator& allocator)
@@ -308,14 +443,278 @@ void write(ThreadContext& ctx, EventType type, const u8* data, int size)
 
 		const CSwitch* cs = reinterpret_cast<CSwitch*>(event->UserData);
 		ContextSwitchRecord rec;
-		rec.timestamp = event->EventHeader.TimeStamp.QuadPart;
+		rec.timestamp = g_instance.fromTimerTimestamp(event->EventHeader.TimeStamp.QuadPart);
 		rec.new_thread_id = cs->NewThreadId;
 		rec.old_thread_id = cs->OldThreadId;
 		rec.reason = cs->OldThreadWaitReason;
-		write(g_instance.global_context, rec.timestamp, profiler::EventType::CONTEXT_SWITCH, rec);
+		writeGlobal(rec.timestamp, profiler::EventType::CONTEXT_SWITCH, rec);
 	};
+#elif defined(__linux__)
+	TraceTask::TraceTask(IAllocator& allocator)
+		: Thread(allocator)
+		, rings(allocator)
+		, own_threads(allocator)
+		, sampled_threads(allocator)
+	{}
+
+
+	static bool readFile(const char* path, Span<char> out) {
+		const int fd = open(path, O_RDONLY);
+		if (fd < 0) return false;
+		const ssize_t size = read(fd, out.begin(), out.length() - 1);
+		close(fd);
+		if (size <= 0) return false;
+		out[(u32)size] = '\0';
+		return true;
+	}
+
+
+	// finds `offset:N;` of `field` in tracepoint's format description
+	static bool getFieldOffset(const char* format, const char* field, u32& offset) {
+		const char* c = strstr(format, field);
+		if (!c) return false;
+		c = strstr(c, "offset:");
+		if (!c) return false;
+		offset = (u32)atoi(c + stringLength("offset:"));
+		return true;
+	}
+
+
+	bool TraceTask::openTracepoints() {
+		const char* roots[] = { "/sys/kernel/tracing", "/sys/kernel/debug/tracing" };
+		char id_str[32];
+		static char format[4096];
+		bool found = false;
+		for (const char* root : roots) {
+			const StaticString<256> id_path(root, "/events/sched/sched_switch/id");
+			const StaticString<256> format_path(root, "/events/sched/sched_switch/format");
+			if (readFile(id_path, Span(id_str)) && readFile(format_path, Span(format))) {
+				found = true;
+				break;
+			}
+		}
+		if (!found) return false;
+		if (!getFieldOffset(format, "prev_pid;", prev_pid_offset)) return false;
+		if (!getFieldOffset(format, "prev_state;", prev_state_offset)) return false;
+		if (!getFieldOffset(format, "next_pid;", next_pid_offset)) return false;
+
+		perf_event_attr attr = {};
+		attr.size = sizeof(attr);
+		attr.type = PERF_TYPE_TRACEPOINT;
+		attr.config = (u64)atoll(id_str);
+		attr.sample_period = 1;
+		attr.sample_type = PERF_SAMPLE_TIME | PERF_SAMPLE_RAW;
+		// same clock as os::Timer
+		attr.use_clockid = 1;
+		attr.clockid = CLOCK_REALTIME;
+
+		const long cpus = sysconf(_SC_NPROCESSORS_CONF);
+		const u64 page_size = (u64)sysconf(_SC_PAGESIZE);
+		for (long cpu = 0; cpu < cpus; ++cpu) {
+			const int fd = (int)syscall(SYS_perf_event_open, &attr, -1, (int)cpu, -1, 0);
+			if (fd < 0) {
+				closeTracepoints();
+				return false;
+			}
+			void* mem = mmap(nullptr, (RING_PAGES + 1) * page_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			if (mem == MAP_FAILED) {
+				close(fd);
+				closeTracepoints();
+				return false;
+			}
+			Ring& ring = rings.emplace();
+			ring.fd = fd;
+			ring.header = (perf_event_mmap_page*)mem;
+			ring.data = (u8*)mem + page_size;
+			ring.data_size = RING_PAGES * page_size;
+		}
+		return !rings.empty();
+	}
+
+
+	bool TraceTask::canSampleSchedstat() {
+		char tmp[128];
+		return readFile("/proc/thread-self/schedstat", Span(tmp));
+	}
+
+
+	void TraceTask::closeTracepoints() {
+		const u64 page_size = (u64)sysconf(_SC_PAGESIZE);
+		for (const Ring& ring : rings) {
+			munmap(ring.header, (RING_PAGES + 1) * page_size);
+			close(ring.fd);
+		}
+		rings.clear();
+	}
+
+
+	void TraceTask::readRecord(const Ring& ring, u64 offset, u8* out, u32 size) {
+		const u64 start = offset % ring.data_size;
+		const u64 first = minimum(ring.data_size - start, (u64)size);
+		memcpy(out, ring.data + start, first);
+		memcpy(out + first, ring.data, size - first);
+	}
+
+
+	bool TraceTask::isOwnThread(u32 tid) {
+		if (tid == 0) return false;
+		auto iter = own_threads.find(tid);
+		if (iter.isValid()) return iter.value();
+		const StaticString<64> path("/proc/self/task/", tid);
+		const bool own = access(path, F_OK) == 0;
+		own_threads.insert(tid, own);
+		return own;
+	}
+
+
+	void TraceTask::readTracepoints() {
+		// tids are reused after threads exit, do not trust what we learned in previous sessions
+		const i32 session = loadAcquire(&g_instance.session);
+		if (session != own_threads_session) {
+			own_threads.clear();
+			own_threads_session = session;
+		}
+
+		u8 record[1024];
+		for (const Ring& ring : rings) {
+			const u64 head = __atomic_load_n(&ring.header->data_head, __ATOMIC_ACQUIRE);
+			u64 tail = ring.header->data_tail;
+			while (tail < head) {
+				perf_event_header header;
+				readRecord(ring, tail, (u8*)&header, sizeof(header));
+				if (header.type == PERF_RECORD_SAMPLE && header.size <= sizeof(record)) {
+					readRecord(ring, tail, record, header.size);
+					// PERF_SAMPLE_TIME, PERF_SAMPLE_RAW
+					const u8* sample = record + sizeof(header);
+					u64 time;
+					u32 raw_size;
+					memcpy(&time, sample, sizeof(time));
+					memcpy(&raw_size, sample + sizeof(time), sizeof(raw_size));
+					const u8* raw = sample + sizeof(time) + sizeof(raw_size);
+					i32 prev_pid, next_pid;
+					i64 prev_state;
+					memcpy(&prev_pid, raw + prev_pid_offset, sizeof(prev_pid));
+					memcpy(&next_pid, raw + next_pid_offset, sizeof(next_pid));
+					memcpy(&prev_state, raw + prev_state_offset, sizeof(prev_state));
+					if (isOwnThread(prev_pid) || isOwnThread(next_pid)) {
+						ContextSwitchRecord rec;
+						rec.timestamp = g_instance.fromTimerTimestamp(time);
+						rec.old_thread_id = prev_pid;
+						rec.new_thread_id = next_pid;
+						// see profiler_ui.cpp
+						if (prev_state == 0) rec.reason = 0; // preempted
+						else if (prev_state & 1) rec.reason = 1; // sleeping
+						else if (prev_state & 2) rec.reason = 2; // uninterruptible
+						else rec.reason = 3;
+						writeGlobal(rec.timestamp, profiler::EventType::CONTEXT_SWITCH, rec);
+					}
+				}
+				tail += header.size;
+			}
+			__atomic_store_n(&ring.header->data_tail, tail, __ATOMIC_RELEASE);
+		}
+	}
+
+
+	void TraceTask::sampleSchedstat() {
+		DIR* dir = opendir("/proc/self/task");
+		if (!dir) return;
+
+		++schedstat_frame;
+		const u64 now = getTimestamp();
+		while (dirent* entry = readdir(dir)) {
+			if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+			const StaticString<128> path("/proc/self/task/", entry->d_name, "/schedstat");
+			char tmp[128];
+			if (!readFile(path, Span(tmp))) continue;
+
+			const u32 tid = (u32)atoi(entry->d_name);
+			const u64 run_time = (u64)atoll(tmp);
+			auto iter = sampled_threads.find(tid);
+			if (!iter.isValid()) {
+				sampled_threads.insert(tid, { run_time, schedstat_frame, false });
+				continue;
+			}
+
+			SampledThread& t = iter.value();
+			t.last_seen = schedstat_frame;
+			const bool running = run_time != t.run_time;
+			t.run_time = run_time;
+			if (running == t.running) continue;
+
+			t.running = running;
+			ContextSwitchRecord rec;
+			rec.timestamp = now;
+			rec.old_thread_id = running ? 0 : tid;
+			rec.new_thread_id = running ? tid : 0;
+			rec.reason = running ? 0 : 1;
+			writeGlobal(rec.timestamp, profiler::EventType::CONTEXT_SWITCH, rec);
+		}
+		closedir(dir);
+
+		// forget exited threads
+		const u64 frame = schedstat_frame;
+		sampled_threads.eraseIf([frame](const SampledThread& t){ return t.last_seen != frame; });
+	}
+
+
+	void TraceTask::wakeup() {
+		MutexGuard lock(wakeup_mutex);
+		wakeup_cv.wakeup();
+	}
+
+
+	int TraceTask::task() {
+		while (!finished) {
+			bool slept = false;
+			{
+				MutexGuard lock(wakeup_mutex);
+				while (!finished && g_instance.paused) {
+					wakeup_cv.sleep(wakeup_mutex);
+					slept = true;
+				}
+			}
+			if (finished) break;
+			if (slept) {
+				// drop what happened while paused, schedstat needs a new baseline
+				for (const Ring& ring : rings) {
+					const u64 head = __atomic_load_n(&ring.header->data_head, __ATOMIC_ACQUIRE);
+					__atomic_store_n(&ring.header->data_tail, head, __ATOMIC_RELEASE);
+				}
+				sampled_threads.clear();
+			}
+
+			if (rings.empty()) sampleSchedstat();
+			else readTracepoints();
+			usleep(SCHEDSTAT_PERIOD_US);
+		}
+		closeTracepoints();
+		return 0;
+	}
+
+
+	void TraceTask::destroy() {
+		finished = true;
+		wakeup();
+		if (is_created) Thread::destroy();
+		else closeTracepoints();
+	}
 #endif
 
+const char* internString(const char* value)
+{
+	MutexGuard lock(g_instance.mutex);
+	for (const char* str : g_instance.interned_strings) {
+		if (equalStrings(str, value)) return str;
+	}
+	const int len = stringLength(value);
+	char* str = (char*)g_instance.allocator.allocate(len + 1);
+	memcpy(str, value, len + 1);
+	g_instance.interned_strings.push(str);
+	return str;
+}
+
+
 void pushInt(const char* key, int value)
 {
 	ThreadContext* ctx = g_instance.getThreadContext();
@@ -352,10 +751,10 @@ void beginBlock(const char* name)
 void beginGPUBlock(const char* name, u64 timestamp, i64 profiler_link)
 {
 	GPUBlock data;
-	data.timestamp = timestamp;
+	data.timestamp = g_instance.fromTimerTimestamp(timestamp);
 	copyString(data.name, name);
 	data.profiler_link = profiler_link;
-	write(g_instance.global_context, EventType::BEGIN_GPU_BLOCK, data);
+	writeGlobal(EventType::BEGIN_GPU_BLOCK, data);
 }
 
 void gpuMemStats(u64 total, u64 current, u64 dedicated) {
@@ -363,12 +762,12 @@ void gpuMemStats(u64 total, u64 current, u64 dedicated) {
 	data.total = total;
 	data.current = current;
 	data.dedicated = dedicated;
-	write(g_instance.global_context, EventType::GPU_MEM_STATS, data);
+	writeGlobal(EventType::GPU_MEM_STATS, data);
 }
 
 void endGPUBlock(u64 timestamp)
 {
-	write(g_instance.global_context, EventType::END_GPU_BLOCK, timestamp);
+	writeGlobal(EventType::END_GPU_BLOCK, g_instance.fromTimerTimestamp(timestamp));
 }
 
 
@@ -388,7 +787,7 @@ void link(i64 link)
 
 void gpuFrame()
 {
-	write(g_instance.global_context, EventType::GPU_FRAME, (int)0);
+	writeGlobal(EventType::GPU_FRAME, (int)0);
 
 }
 
@@ -468,7 +867,7 @@ void endBlock()
 
 u64 frequency()
 {
-	return g_instance.timer.getFrequency();
+	return u64(os::Timer::getFrequency() * g_instance.timestamps_per_tick);
 }
 
 
@@ -480,12 +879,16 @@ bool contextSwitchesEnabled()
 
 void frame()
 {
-	const u64 n = os::Timer::getRawTimestamp();
+	g_instance.recalibrate();
+	const u64 n = getTimestamp();
 	if (g_instance.last_frame_time != 0) {
 		g_instance.last_frame_duration = n - g_instance.last_frame_time;
 	}
 	g_instance.last_frame_time = n;
-	write(g_instance.global_context, EventType::FRAME, 0);
+	writeGlobal(n, EventType::FRAME, 0);
+	if (g_instance.outlier_frame_duration && g_instance.last_frame_duration > g_instance.outlier_frame_duration) {
+		g_instance.outlier_pending = 1;
+	}
 }
 
 
@@ -506,34 +909,18 @@ void setThreadName(const char* name)
 	ctx->name = name;
 }
 
-template <typename T>
-static void read(const ThreadContext& ctx, u32 p, T& value)
-{
-	const u8* buf = ctx.buffer.data();
-	const u32 buf_size = (u32)ctx.buffer.size();
-	const u32 l = p % buf_size;
-	if (l + sizeof(value) <= buf_size) {
-		memcpy(&value, buf + l, sizeof(value));
-		return;
-	}
-
-	memcpy(&value, buf + l, buf_size - l);
-	memcpy((u8*)&value + (buf_size - l), buf, sizeof(value) - (buf_size - l));
-}
-
-static void saveStrings(OutputMemoryStream& blob) {
+static void saveStrings(OutputMemoryStream& blob, Span<const Span<const u8>> buffers) {
 	HashMap<const char*, const char*> map(g_instance.allocator);
 	map.reserve(512);
-	auto gather = [&](const ThreadContext& ctx){
-		u32 p = ctx.begin;
-		const u32 end = ctx.end;
-		while (p != end) {
+	for (const Span<const u8>& buffer : buffers) {
+		const u8* p = buffer.begin();
+		while (p != buffer.end()) {
 			profiler::EventHeader header;
-			read(ctx, p, header);
+			memcpy(&header, p, sizeof(header));
 			switch (header.type) {
 				case profiler::EventType::BEGIN_BLOCK: {
 					const char* name;
-					read(ctx, p + sizeof(profiler::EventHeader), name);
+					memcpy(&name, p + sizeof(header), sizeof(name));
 					if (!map.find(name).isValid()) {
 						map.insert(name, name);
 					}
@@ -541,7 +928,7 @@ static void saveStrings(OutputMemoryStream& blob) {
 				}
 				case profiler::EventType::INT: {
 					IntRecord r;
-					read(ctx, p + sizeof(profiler::EventHeader), r);
+					memcpy(&r, p + sizeof(header), sizeof(r));
 					if (!map.find(r.key).isValid()) {
 						map.insert(r.key, r.key);
 					}
@@ -551,11 +938,6 @@ static void saveStrings(OutputMemoryStream& blob) {
 			}
 			p += header.size;
 		}
-	};
-
-	gather(g_instance.global_context);
-	for (const ThreadContext* ctx : g_instance.contexts) {
-		gather(*ctx);
 	}
 
 	blob.write(map.size());
@@ -565,32 +947,567 @@ static void saveStrings(OutputMemoryStream& blob) {
 	}
 }
 
-void serialize(OutputMemoryStream& blob, ThreadContext& ctx) {
-	MutexGuard lock(ctx.mutex);
-	blob.writeString(ctx.name);
-	blob.write(ctx.thread_id);
-	blob.write(ctx.begin);
-	blob.write(ctx.end);
+// copies events of `ctx` to `blob` as one linear buffer, returns offset of the events in `blob`
+// if `incremental`, only events not yet seen by the capture are copied
+static u64 serialize(OutputMemoryStream& blob, ThreadContext& ctx, bool incremental) {
+	{
+		MutexGuard lock(ctx.mutex);
+		blob.writeString(ctx.name);
+		blob.write(ctx.thread_id);
+	}
+	const u64 header_offset = blob.size();
+	blob.write((u32)0); // begin
+	blob.write((u32)0); // end
 	blob.write((u8)ctx.show_in_profiler);
-	blob.write((u32)ctx.buffer.size());
-	blob.write(ctx.buffer.data(), ctx.buffer.size());
+	blob.write((u32)loadAcquire(&ctx.overflow_count));
+	blob.write((u32)0); // buffer size
+	const u64 data_offset = blob.size();
+
+	const i32 current = loadAcquire(&ctx.current_chunk);
+	i32 first = maximum(0, current - (i32)ThreadContext::CHUNKS_COUNT + 1);
+	if (incremental && ctx.capture_chunk >= first) first = ctx.capture_chunk;
+	for (i32 i = first; i <= current; ++i) {
+		const ThreadContext::Chunk& chunk = ctx.chunks[u32(i) % ThreadContext::CHUNKS_COUNT];
+		if (loadAcquire(&chunk.generation) != i) continue;
+
+		const u32 from = incremental && i == ctx.capture_chunk ? ctx.capture_offset : 0;
+		const u32 to = loadAcquire(&chunk.size);
+		const u64 chunk_offset = blob.size();
+		blob.write(chunk.data + from, to - from);
+		memoryBarrier();
+		// recycled while we were copying it
+		if (chunk.generation != i) {
+			blob.resize(chunk_offset);
+			continue;
+		}
+		if (incremental) {
+			ctx.capture_chunk = i;
+			ctx.capture_offset = to;
+		}
+	}
+	if (incremental) storeRelease(&ctx.unread_chunk, ctx.capture_chunk);
+
+	const u32 size = u32(blob.size() - data_offset);
+	u8* header = blob.getMutableData() + header_offset;
+	memcpy(header + sizeof(u32), &size, sizeof(size));
+	memcpy(header + sizeof(u32) * 2 + sizeof(u8) + sizeof(u32), &size, sizeof(size));
+	return data_offset;
 }
 
-void serialize(OutputMemoryStream& blob) {
+static void serialize(OutputMemoryStream& blob, bool incremental) {
 	MutexGuard lock(g_instance.mutex);
-	blob.write<u32>(0); // version
+	blob.write(SerializedVersion::LATEST);
 	blob.write((u32)g_instance.contexts.size());
-	serialize(blob, g_instance.global_context);
+	
+	Array<u64> offsets(g_instance.allocator);
+	offsets.reserve(g_instance.contexts.size() + 1);
+	offsets.push(serialize(blob, g_instance.global_context, incremental));
 	for (ThreadContext* ctx : g_instance.contexts) {
-		serialize(blob, *ctx);
-	}	
-	saveStrings(blob);
+		offsets.push(serialize(blob, *ctx, incremental));
+	}
+
+	Array<Span<const u8>> buffers(g_instance.allocator);
+	buffers.reserve(offsets.size());
+	for (u64 offset : offsets) {
+		u32 size;
+		memcpy(&size, blob.data() + offset - sizeof(size), sizeof(size));
+		buffers.push(Span(blob.data() + offset, size));
+	}
+	saveStrings(blob, buffers);
+}
+
+void serialize(OutputMemoryStream& blob) {
+	serialize(blob, false);
+}
+
+
+static constexpr u32 CAPTURE_MAGIC = '_LPC';
+static constexpr u32 CAPTURE_VERSION = 0;
+static constexpr u32 CAPTURE_FLUSH_PERIOD_MS = 50;
+
+// each block is lz4 compressed output of serialize() with events since the previous block
+#pragma pack(1)
+struct CaptureBlockHeader
+{
+	u64 frequency;
+	u32 size;
+	u32 compressed_size;
+};
+#pragma pack()
+
+
+struct CaptureTask : Thread
+{
+	struct HistoryBlock
+	{
+		u64 timestamp;
+		OutputMemoryStream data;
+	};
+
+	CaptureTask(IAllocator& allocator, const CaptureConfig& config)
+		: Thread(allocator)
+		, allocator(allocator)
+		, config(config)
+		, path(config.path ? config.path : "")
+		, outlier_path(config.outlier_path ? config.outlier_path : "")
+		, blob(allocator)
+		, compressed(allocator)
+		, history(allocator)
+	{}
+
+	static bool writeHeader(os::OutputFile& file)
+	{
+		return file.write(CAPTURE_MAGIC) && file.write(CAPTURE_VERSION);
+	}
+
+	bool openFile()
+	{
+		const StaticString<LUMIX_MAX_PATH> file_path(path, "_", file_index, ".lpc");
+		if (!file.open(file_path) || !writeHeader(file)) {
+			file.close();
+			return false;
+		}
+		file_size = 0;
+		// 0 means keep all files
+		if (config.max_files > 0 && file_index >= config.max_files) {
+			const StaticString<LUMIX_MAX_PATH> old_path(path, "_", file_index - config.max_files, ".lpc");
+			os::deleteFile(old_path);
+		}
+		++file_index;
+		return true;
+	}
+
+	void flush()
+	{
+		blob.clear();
+		serialize(blob, true);
+
+		compressed.clear();
+		CaptureBlockHeader header;
+		header.frequency = frequency();
+		header.size = (u32)blob.size();
+		const i32 cap = LZ4_compressBound((i32)blob.size());
+		compressed.resize(sizeof(header) + cap);
+		const i32 compressed_size = LZ4_compress_default((const char*)blob.data(), (char*)compressed.getMutableData() + sizeof(header), (i32)blob.size(), cap);
+		if (compressed_size <= 0) return;
+		header.compressed_size = (u32)compressed_size;
+		compressed.resize(sizeof(header) + compressed_size);
+		memcpy(compressed.getMutableData(), &header, sizeof(header));
+
+		if (!path.empty()) {
+			if (file_size > config.max_file_size) {
+				file.close();
+				is_file_open = false;
+			}
+			if (!is_file_open) is_file_open = openFile();
+			if (is_file_open) {
+				if (file.write(compressed.data(), compressed.size())) {
+					file_size += compressed.size();
+				}
+				else {
+					file.close();
+					is_file_open = false;
+				}
+			}
+		}
+
+		if (!outlier_path.empty()) {
+			const u64 now = getTimestamp();
+			const u64 max_age = u64(config.outlier_seconds * frequency());
+			while (!history.empty() && now - history[0].timestamp > max_age) history.erase(0);
+			history.push({now, static_cast<OutputMemoryStream&&>(compressed)});
+			compressed = OutputMemoryStream(allocator);
+
+			if (g_instance.outlier_pending) {
+				g_instance.outlier_pending = 0;
+				dumpHistory();
+			}
+		}
+	}
+
+	void dumpHistory()
+	{
+		const StaticString<LUMIX_MAX_PATH> dump_path(outlier_path, "_", outlier_index, ".lpc");
+		++outlier_index;
+		os::OutputFile dump;
+		if (!dump.open(dump_path)) return;
+		bool success = writeHeader(dump);
+		for (const HistoryBlock& block : history) {
+			success = success && dump.write(block.data.data(), block.data.size());
+		}
+		dump.close();
+		// the same events are not dumped twice
+		history.clear();
+		if (!success) os::deleteFile(dump_path);
+	}
+
+	int task() override
+	{
+		while (!finished) {
+			flush();
+			os::sleep(CAPTURE_FLUSH_PERIOD_MS);
+		}
+		flush();
+		if (is_file_open) file.close();
+		return 0;
+	}
+
+	IAllocator& allocator;
+	CaptureConfig config;
+	StaticString<LUMIX_MAX_PATH> path;
+	StaticString<LUMIX_MAX_PATH> outlier_path;
+	OutputMemoryStream blob;
+	OutputMemoryStream compressed;
+	Array<HistoryBlock> history;
+	os::OutputFile file;
+	bool is_file_open = false;
+	u64 file_size = 0;
+	u32 file_index = 0;
+	u32 outlier_index = 0;
+	volatile bool finished = false;
+};
+
+
+bool startCapture(const CaptureConfig& config)
+{
+	stopCapture();
+	if (!config.path && !config.outlier_path) return false;
+
+	// drop whatever previous captures did not read
+	{
+		MutexGuard lock(g_instance.mutex);
+		auto skip = [](ThreadContext& ctx){
+			ctx.capture_chunk = loadAcquire(&ctx.current_chunk);
+			ctx.capture_offset = loadAcquire(&ctx.chunks[u32(ctx.capture_chunk) % ThreadContext::CHUNKS_COUNT].size);
+			storeRelease(&ctx.unread_chunk, ctx.capture_chunk);
+		};
+		skip(g_instance.global_context);
+		for (ThreadContext* ctx : g_instance.contexts) skip(*ctx);
+	}
+
+	atomicIncrement(&g_instance.session);
+	CaptureTask* task = LUMIX_NEW(g_instance.allocator, CaptureTask)(g_instance.allocator, config);
+	if (!task->create("profiler capture", true)) {
+		LUMIX_DELETE(g_instance.allocator, task);
+		return false;
+	}
+	g_instance.capture_task = task;
+	g_instance.outlier_pending = 0;
+	if (config.outlier_path) {
+		g_instance.outlier_frame_duration = u64(config.outlier_frame_ms * 0.001f * frequency());
+	}
+	return true;
+}
+
+
+void stopCapture()
+{
+	CaptureTask* task = g_instance.capture_task;
+	if (!task) return;
+
+	g_instance.outlier_frame_duration = 0;
+	task->finished = true;
+	task->destroy();
+	LUMIX_DELETE(g_instance.allocator, task);
+	g_instance.capture_task = nullptr;
+
+	MutexGuard lock(g_instance.mutex);
+	storeRelease(&g_instance.global_context.unread_chunk, -1);
+	for (ThreadContext* ctx : g_instance.contexts) storeRelease(&ctx->unread_chunk, -1);
+}
+
+
+static void writeJSONString(IOutputStream& json, const char* value)
+{
+	json << "\"";
+	for (const char* c = value; *c; ++c) {
+		if (*c == '"' || *c == '\\') json << "\\";
+		if ((u8)*c < 0x20) continue;
+		json.write(c, 1);
+	}
+	json << "\"";
+}
+
+
+// microseconds with ns precision
+static void writeJSONTime(IOutputStream& json, u64 ns)
+{
+	const u32 fraction = u32(ns % 1000);
+	json << ns / 1000 << (fraction < 100 ? (fraction < 10 ? ".00" : ".0") : ".") << fraction;
+}
+
+
+struct ChromeTraceExporter
+{
+	// jobs::INVALID_HANDLE
+	static constexpr u32 INVALID_SIGNAL = 0xffFFffFF;
+	static constexpr u32 GPU_THREAD_ID = 0;
+
+	struct Context {
+		const char* name;
+		u32 thread_id;
+		const u8* data;
+		u32 size;
+	};
+
+	ChromeTraceExporter(IOutputStream& json, IAllocator& allocator)
+		: json(json)
+		, contexts(allocator)
+		, strings(allocator)
+		, depths(allocator)
+		, named_threads(allocator)
+	{}
+
+	void beginEvent(const char* phase, u32 tid, u64 timestamp)
+	{
+		json << (first_event ? "\n" : ",\n") << "{\"ph\":\"" << phase << "\",\"pid\":0,\"tid\":" << tid << ",\"ts\":";
+		writeJSONTime(json, u64(double(timestamp - base) * 1e9 / frequency));
+		first_event = false;
+	}
+
+	void writeThreadName(u32 tid, const char* name)
+	{
+		json << (first_event ? "\n" : ",\n") << "{\"ph\":\"M\",\"pid\":0,\"tid\":" << tid << ",\"name\":\"thread_name\",\"args\":{\"name\":";
+		writeJSONString(json, name);
+		json << "}}";
+		first_event = false;
+	}
+
+	const char* getString(const void* key)
+	{
+		auto iter = strings.find(key);
+		return iter.isValid() ? iter.value() : "N/A";
+	}
+
+	void exportEvents(u32 tid, const u8* begin, const u8* end)
+	{
+		auto depth_iter = depths.find(tid);
+		u32& depth = depth_iter.isValid() ? depth_iter.value() : depths.insert(tid);
+		for (const u8* p = begin; p < end;) {
+			EventHeader header;
+			memcpy(&header, p, sizeof(header));
+			if (header.size < sizeof(header)) break;
+			const u8* data = p + sizeof(header);
+			p += header.size;
+			if (header.time < base) continue;
+
+			switch (header.type) {
+				case EventType::BEGIN_BLOCK: {
+					const void* name;
+					memcpy(&name, data, sizeof(name));
+					beginEvent("B", tid, header.time);
+					json << ",\"name\":";
+					writeJSONString(json, getString(name));
+					json << "}";
+					++depth;
+					break;
+				}
+				case EventType::END_BLOCK:
+					// block started before the capture
+					if (depth == 0) break;
+					--depth;
+					beginEvent("E", tid, header.time);
+					json << "}";
+					break;
+				case EventType::INT: {
+					IntRecord r;
+					memcpy(&r, data, sizeof(r));
+					beginEvent("C", tid, header.time);
+					json << ",\"name\":";
+					writeJSONString(json, getString(r.key));
+					json << ",\"args\":{\"value\":" << r.value << "}}";
+					break;
+				}
+				case EventType::STRING:
+					beginEvent("i", tid, header.time);
+					json << ",\"s\":\"t\",\"name\":";
+					writeJSONString(json, (const char*)data);
+					json << "}";
+					break;
+				case EventType::JOB_INFO: {
+					JobRecord r;
+					memcpy(&r, data, sizeof(r));
+					if (r.precondition != INVALID_SIGNAL) {
+						beginEvent("f", tid, header.time);
+						json << ",\"bp\":\"e\",\"cat\":\"job\",\"name\":\"job\",\"id\":" << r.precondition << "}";
+					}
+					if (r.signal_on_finish != INVALID_SIGNAL) {
+						beginEvent("s", tid, header.time);
+						json << ",\"cat\":\"job\",\"name\":\"job\",\"id\":" << r.signal_on_finish << "}";
+					}
+					break;
+				}
+				case EventType::LINK: {
+					i64 link;
+					memcpy(&link, data, sizeof(link));
+					beginEvent("s", tid, header.time);
+					json << ",\"cat\":\"link\",\"name\":\"link\",\"id\":" << link << "}";
+					break;
+				}
+				case EventType::BEGIN_FIBER_WAIT:
+				case EventType::END_FIBER_WAIT: {
+					// fiber can resume on other thread, so these are async events
+					FiberWaitRecord r;
+					memcpy(&r, data, sizeof(r));
+					beginEvent(header.type == EventType::BEGIN_FIBER_WAIT ? "b" : "e", tid, header.time);
+					json << ",\"cat\":\"fiber\",\"name\":\"fiber wait\",\"id\":" << r.id << ",\"args\":{\"signal\":" << r.job_system_signal << "}}";
+					break;
+				}
+				case EventType::FRAME:
+					beginEvent("i", tid, header.time);
+					json << ",\"s\":\"g\",\"name\":\"frame\"}";
+					break;
+				case EventType::BEGIN_GPU_BLOCK: {
+					GPUBlock r;
+					memcpy(&r, data, sizeof(r));
+					if (r.timestamp < base) break;
+					beginEvent("B", GPU_THREAD_ID, r.timestamp);
+					json << ",\"name\":";
+					r.name[lengthOf(r.name) - 1] = '\0';
+					writeJSONString(json, r.name);
+					json << "}";
+					++gpu_depth;
+					if (r.profiler_link) {
+						beginEvent("f", GPU_THREAD_ID, r.timestamp);
+						json << ",\"bp\":\"e\",\"cat\":\"link\",\"name\":\"link\",\"id\":" << r.profiler_link << "}";
+					}
+					break;
+				}
+				case EventType::END_GPU_BLOCK: {
+					u64 timestamp;
+					memcpy(&timestamp, data, sizeof(timestamp));
+					if (gpu_depth == 0 || timestamp < base) break;
+					--gpu_depth;
+					beginEvent("E", GPU_THREAD_ID, timestamp);
+					json << "}";
+					break;
+				}
+				case EventType::GPU_MEM_STATS: {
+					GPUMemStatsBlock r;
+					memcpy(&r, data, sizeof(r));
+					beginEvent("C", GPU_THREAD_ID, header.time);
+					json << ",\"name\":\"GPU memory (MB)\",\"args\":{\"current\":" << r.current / (1024 * 1024) << ",\"total\":" << r.total / (1024 * 1024) << "}}";
+					break;
+				}
+				default: break;
+			}
+		}
+	}
+
+	// `blob` is output of serialize()
+	bool exportBlob(InputMemoryStream& blob)
+	{
+		const u32 version = blob.read<u32>();
+		if (version > (u32)SerializedVersion::LATEST) return false;
+		const u32 count = blob.read<u32>();
+
+		// count comes from the file, contexts are added only while there is data for them
+		contexts.clear();
+		for (u32 i = 0; i <= count; ++i) {
+			if (blob.getPosition() >= blob.size()) return false;
+			Context& ctx = contexts.emplace();
+			ctx.name = blob.readString();
+			blob.read(ctx.thread_id);
+			blob.read<u32>(); // begin
+			blob.read<u32>(); // end
+			blob.read<u8>(); // show in profiler
+			if (version > (u32)SerializedVersion::OVERFLOW_COUNT) blob.read<u32>(); // overflow count
+			blob.read(ctx.size);
+			if (blob.getPosition() + ctx.size > blob.size()) return false;
+			ctx.data = (const u8*)blob.skip(ctx.size);
+		}
+
+		strings.clear();
+		const u32 strings_count = blob.read<u32>();
+		for (u32 i = 0; i < strings_count; ++i) {
+			const void* key = (const void*)(uintptr)blob.read<u64>();
+			strings.insert(key, blob.readString());
+		}
+
+		if (!has_base) {
+			has_base = true;
+			base = 0xffFFffFFffFFffFF;
+			for (u32 i = 0; i <= count; ++i) {
+				if (contexts[i].size < sizeof(EventHeader)) continue;
+				EventHeader header;
+				memcpy(&header, contexts[i].data, sizeof(header));
+				base = minimum(base, header.time);
+			}
+			writeThreadName(GPU_THREAD_ID, "GPU");
+		}
+
+		// first context is the global one (frames, GPU, context switches)
+		exportEvents(GPU_THREAD_ID, contexts[0].data, contexts[0].data + contexts[0].size);
+		for (u32 i = 1; i <= count; ++i) {
+			const Context& ctx = contexts[i];
+			if (!named_threads.find(ctx.thread_id).isValid()) {
+				named_threads.insert(ctx.thread_id, true);
+				writeThreadName(ctx.thread_id, ctx.name[0] ? ctx.name : "Unknown");
+			}
+			exportEvents(ctx.thread_id, ctx.data, ctx.data + ctx.size);
+		}
+		return true;
+	}
+
+	IOutputStream& json;
+	Array<Context> contexts;
+	HashMap<const void*, const char*> strings;
+	HashMap<u32, u32> depths;
+	HashMap<u32, bool> named_threads;
+	u32 gpu_depth = 0;
+	u64 base = 0;
+	bool has_base = false;
+	double frequency = 1;
+	bool first_event = true;
+};
+
+
+bool exportChromeTrace(Span<const u8> capture, IOutputStream& json)
+{
+	IAllocator& allocator = g_instance.allocator;
+	InputMemoryStream stream(capture.begin(), capture.length());
+	if (stream.read<u32>() != CAPTURE_MAGIC) return false;
+	if (stream.read<u32>() > CAPTURE_VERSION) return false;
+
+	ChromeTraceExporter exporter(json, allocator);
+	OutputMemoryStream blob(allocator);
+	json << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool success = true;
+	while (stream.getPosition() + sizeof(CaptureBlockHeader) <= stream.size()) {
+		CaptureBlockHeader header;
+		stream.read(header);
+		if (stream.getPosition() + header.compressed_size > stream.size()) {
+			success = false;
+			break;
+		}
+		const void* compressed = stream.skip(header.compressed_size);
+
+		blob.resize(header.size);
+		const i32 res = LZ4_decompress_safe((const char*)compressed, (char*)blob.getMutableData(), (i32)header.compressed_size, (i32)header.size);
+		if (res != (i32)header.size) {
+			success = false;
+			break;
+		}
+
+		exporter.frequency = (double)header.frequency;
+		InputMemoryStream tmp(blob);
+		if (!exporter.exportBlob(tmp)) {
+			success = false;
+			break;
+		}
+	}
+	json << "\n]}\n";
+	return success;
 }
 
 void pause(bool paused)
 {
+	if (g_instance.paused && !paused) atomicIncrement(&g_instance.session);
 	g_instance.paused = paused;
-	if (paused) g_instance.paused_time = os::Timer::getRawTimestamp();
+	if (paused) g_instance.paused_time = getTimestamp();
+	#ifdef __linux__
+		if (!paused) g_instance.trace_task.wakeup();
+	#endif
 }
 
 
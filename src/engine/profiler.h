@@ -4,6 +4,7 @@
 
 namespace Lumix {
 
+struct IOutputStream;
 struct OutputMemoryStream;
 
 namespace profiler {
@@ -21,6 +22,8 @@ LUMIX_ENGINE_API void frame();
 LUMIX_ENGINE_API void pushJobInfo(u32 signal_on_finish, u32 precondition);
 LUMIX_ENGINE_API void pushString(const char* value);
 LUMIX_ENGINE_API void pushInt(const char* key_literal, int value);
+// returns a copy of `value` which lives as long as the profiler, use it as pushInt's key if the key is not a literal
+LUMIX_ENGINE_API const char* internString(const char* value);
 
 LUMIX_ENGINE_API void beginGPUBlock(const char* name, u64 timestamp, i64 profiler_link);
 LUMIX_ENGINE_API void endGPUBlock(u64 timestamp);
@@ -30,6 +33,13 @@ LUMIX_ENGINE_API void link(i64 link);
 LUMIX_ENGINE_API i64 createNewLinkID();
 LUMIX_ENGINE_API void serialize(OutputMemoryStream& blob);
 
+// version of the data written by serialize, data added by X are present if version > X
+enum class SerializedVersion : u32 {
+	OVERFLOW_COUNT,
+
+	LATEST
+};
+
 struct FiberSwitchData {
 	i32 id;
 	const char* blocks[16];
@@ -41,6 +51,27 @@ LUMIX_ENGINE_API FiberSwitchData beginFiberWait(u32 job_system_signal);
 LUMIX_ENGINE_API void endFiberWait(u32 job_system_signal, const FiberSwitchData& switch_data);
 LUMIX_ENGINE_API float getLastFrameDuration();
 
+// headless capture, new events are periodically lz4 compressed and written to files, without profiler UI
+struct CaptureConfig
+{
+	// events are streamed to `path`_0.lpc, `path`_1.lpc, ..., nullptr disables streaming
+	const char* path = nullptr;
+	// a new file is started once the current one is bigger than this
+	u64 max_file_size = 64 * 1024 * 1024;
+	// older files are deleted, 0 keeps all files
+	u32 max_files = 4;
+	// last `outlier_seconds` of events are kept in memory and written to `outlier_path`_N.lpc
+	// whenever a frame takes longer than `outlier_frame_ms`, nullptr disables outlier dumps
+	const char* outlier_path = nullptr;
+	float outlier_frame_ms = 100;
+	float outlier_seconds = 5;
+};
+
+LUMIX_ENGINE_API bool startCapture(const CaptureConfig& config);
+LUMIX_ENGINE_API void stopCapture();
+// converts content of a .lpc file to Chrome Trace Event JSON (chrome://tracing, ui.perfetto.dev)
+LUMIX_ENGINE_API bool exportChromeTrace(Span<const u8> capture, IOutputStream& json);
+
 struct Scope
 {
 	explicit Scope(const char* name_literal) { beginBlock(name_literal); }
@@ -216,7 +216,14 @@ void Resource::removeDependency(Resource& dependent_resource)
 	checkState();
 }
 
+u32 Resource::incRefCount() {
+	ResourceManagerHub::LoadGuard guard(m_resource_manager.getOwner());
+	return ++m_ref_count;
+}
+
+
 u32 Resource::decRefCount() {
+	ResourceManagerHub::LoadGuard guard(m_resource_manager.getOwner());
 	ASSERT(m_ref_count > 0);
 	--m_ref_count;
 	if (m_ref_count == 0 && m_resource_manager.m_is_unload_enabled) {
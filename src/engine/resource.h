@@ -46,7 +46,7 @@ struct LUMIX_ENGINE_API Resource {
 	const Path& getPath() const { return m_path; }
 	struct ResourceManager& getResourceManager() { return m_resource_manager; }
 	u32 decRefCount();
-	u32 incRefCount() { return ++m_ref_count; }
+	u32 incRefCount();
 	bool wantReady() const { return m_desired_state == State::READY; }
 
 	template <auto Function, typename C> void onLoaded(C* instance)
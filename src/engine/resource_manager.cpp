@@ -8,6 +8,24 @@ namespace Lumix
 {
 
 
+// LoadGuard can be nested, e.g. unloading a resource releases its dependencies; there's one hub per engine
+static thread_local u32 s_load_guard_depth = 0;
+
+
+ResourceManagerHub::LoadGuard::LoadGuard(ResourceManagerHub& hub)
+	: m_hub(hub)
+	, m_locked(hub.m_parallel_loads)
+{
+	if (m_locked && s_load_guard_depth++ == 0) m_hub.m_load_mutex.enter();
+}
+
+
+ResourceManagerHub::LoadGuard::~LoadGuard()
+{
+	if (m_locked && --s_load_guard_depth == 0) m_hub.m_load_mutex.exit();
+}
+
+
 void ResourceManager::create(ResourceType type, ResourceManagerHub& owner)
 {
 	owner.add(type, this);
@@ -30,6 +48,7 @@ void ResourceManager::destroy()
 
 Resource* ResourceManager::get(const Path& path)
 {
+	ResourceManagerHub::LoadGuard guard(*m_owner);
 	ResourceTable::iterator it = m_resources.find(path.getHash());
 
 	if(m_resources.end() != it)
@@ -43,6 +62,7 @@ Resource* ResourceManager::get(const Path& path)
 Resource* ResourceManager::load(const Path& path)
 {
 	if (path.isEmpty()) return nullptr;
+	ResourceManagerHub::LoadGuard guard(*m_owner);
 	Resource* resource = get(path);
 
 	if(nullptr == resource)
@@ -210,6 +230,18 @@ void ResourceManagerHub::enableUnload(bool enable)
 	}
 }
 
+void ResourceManagerHub::beginParallelLoads()
+{
+	ASSERT(!m_parallel_loads);
+	m_parallel_loads = true;
+}
+
+void ResourceManagerHub::endParallelLoads()
+{
+	ASSERT(m_parallel_loads);
+	m_parallel_loads = false;
+}
+
 void ResourceManagerHub::reloadAll() {
 	while (m_file_system->hasWork()) m_file_system->processCallbacks();
 	
@@ -1,7 +1,8 @@
 #pragma once
 
 
-#include "engine/hash_map.h"
+#include "engine/group_hash_map.h"
+#include "engine/sync.h"
 
 
 namespace Lumix
@@ -11,7 +12,7 @@ namespace Lumix
 struct LUMIX_ENGINE_API ResourceManager {
 	friend struct Resource;
 	friend struct ResourceManagerHub;
-	using ResourceTable = HashMap<u32, struct Resource*, HashFuncDirect<u32>>;
+	using ResourceTable = HashMap<u32, struct Resource*, HashFuncDirect<u32>, GroupProbing>;
 
 	void create(struct ResourceType type, struct ResourceManagerHub& owner);
 	void destroy();
@@ -43,8 +44,23 @@ protected:
 
 
 struct LUMIX_ENGINE_API ResourceManagerHub {
+	friend struct ResourceManager;
+
 	using ResourceManagerTable = HashMap<u32, ResourceManager*>;
 
+	// loading, lookups and reference counting hold this guard; it locks only between
+	// beginParallelLoads and endParallelLoads, when resources can be requested and released from jobs
+	struct LUMIX_ENGINE_API LoadGuard {
+		explicit LoadGuard(ResourceManagerHub& hub);
+		~LoadGuard();
+		LoadGuard(const LoadGuard&) = delete;
+		void operator=(const LoadGuard&) = delete;
+
+	private:
+		ResourceManagerHub& m_hub;
+		bool m_locked;
+	};
+
 	struct LUMIX_ENGINE_API LoadHook {
 		enum class Action { IMMEDIATE, DEFERRED };
 		virtual ~LoadHook() {}
@@ -78,6 +94,9 @@ struct LUMIX_ENGINE_API ResourceManagerHub {
 	void reloadAll();
 	void removeUnreferenced();
 	void enableUnload(bool enable);
+	// call on the main thread while no job uses resources
+	void beginParallelLoads();
+	void endParallelLoads();
 
 	FileSystem& getFileSystem() { return *m_file_system; }
 
@@ -87,6 +106,9 @@ private:
 	ResourceManagerTable m_resource_managers;
 	FileSystem* m_file_system;
 	LoadHook* m_load_hook;
+	// see LoadGuard
+	Mutex m_load_mutex;
+	bool m_parallel_loads = false;
 };
 
 
@@ -29,7 +29,11 @@ EntityPtr EntityMap::get(EntityPtr e) const {
 }
 
 EntityRef EntityMap::get(EntityRef e) const {
-	return (EntityRef)m_map[e.index];
+	if (u32(e.index) < u32(m_map.size()) && m_map[e.index].isValid()) return (EntityRef)m_map[e.index];
+	// only corrupted data references an entity which was not mapped; keep the original so we do not read past m_map
+	ASSERT(false);
+	logError("Entity ", e.index, " is referenced but it does not exist");
+	return e;
 }
 
 void EntityMap::set(EntityRef src, EntityRef dst) {
@@ -57,6 +61,7 @@ Universe::Universe(Engine& engine, IAllocator& allocator)
 	, m_scenes(m_allocator)
 	, m_hierarchy(m_allocator)
 	, m_transforms(m_allocator)
+	, m_deferred_components(m_allocator)
 	, m_name("")
 {
 	m_entities.reserve(RESERVED_ENTITIES_COUNT);
@@ -375,6 +380,44 @@ EntityRef Universe::createEntity(const DVec3& position, const Quat& rotation)
 }
 
 
+void Universe::createEntities(Span<EntityRef> entities)
+{
+	u32 created = 0;
+	while (m_first_free_slot >= 0 && created < entities.length()) {
+		EntityData& data = m_entities[m_first_free_slot];
+		entities[created].index = m_first_free_slot;
+		if (data.next >= 0) m_entities[data.next].prev = -1;
+		m_first_free_slot = data.next;
+		++created;
+	}
+
+	const u32 old_size = m_entities.size();
+	const u32 new_size = old_size + entities.length() - created;
+	m_entities.resize(new_size);
+	m_transforms.resize(new_size);
+	for (u32 i = old_size; i < new_size; ++i) {
+		entities[created].index = i;
+		++created;
+	}
+
+	for (EntityRef e : entities) {
+		Transform& tr = m_transforms[e.index];
+		tr.pos = DVec3(0, 0, 0);
+		tr.rot.set(0, 0, 0, 1);
+		tr.scale = 1;
+		EntityData& data = m_entities[e.index];
+		data.name = -1;
+		data.hierarchy = -1;
+		data.components = 0;
+		data.valid = true;
+	}
+
+	for (EntityRef e : entities) {
+		m_entity_created.invoke(e);
+	}
+}
+
+
 void Universe::destroyEntity(EntityRef entity)
 {
 	EntityData& entity_data = m_entities[entity.index];
@@ -673,17 +716,40 @@ void Universe::setName(const char* name) {
 	copyString(m_name, name);
 }
 
-void Universe::deserialize(InputMemoryStream& serializer, EntityMap& entity_map)
+bool Universe::deserialize(InputMemoryStream& serializer, EntityMap& entity_map)
 {
 	u32 to_reserve;
 	serializer.read(to_reserve);
 	entity_map.reserve(to_reserve);
 
-	for (EntityPtr e = serializer.read<EntityPtr>(); e.isValid(); e = serializer.read<EntityPtr>()) {
-		EntityRef orig = (EntityRef)e;
-		const EntityRef new_e = createEntity({0, 0, 0}, {0, 0, 0, 1});
-		entity_map.set(orig, new_e);
-		serializer.read(m_transforms[new_e.index]);
+	// entities are stored as (EntityRef, Transform) records terminated by INVALID_ENTITY
+	const u64 record_size = sizeof(EntityRef) + sizeof(Transform);
+	const u8* records = (const u8*)serializer.getData() + serializer.getPosition();
+	const u64 available = serializer.size() - serializer.getPosition();
+	u32 entities_count = 0;
+	for (;;) {
+		const u64 offset = entities_count * record_size;
+		if (offset + sizeof(EntityPtr) > available) break;
+		EntityPtr e;
+		memcpy(&e, records + offset, sizeof(e));
+		if (!e.isValid() || offset + record_size > available) break;
+		++entities_count;
+	}
+	serializer.skip(entities_count * record_size);
+	if (serializer.read<EntityPtr>().isValid()) {
+		logError("Corrupted universe");
+		return false;
+	}
+
+	Array<EntityRef> new_entities(m_allocator);
+	new_entities.resize(entities_count);
+	createEntities(new_entities);
+	for (u32 i = 0; i < entities_count; ++i) {
+		const u8* record = records + i * record_size;
+		EntityRef orig;
+		memcpy(&orig, record, sizeof(orig));
+		entity_map.set(orig, new_entities[i]);
+		memcpy(&m_transforms[new_entities[i].index], record + sizeof(EntityRef), sizeof(Transform));
 	}
 
 	u32 count;
@@ -710,6 +776,7 @@ void Universe::deserialize(InputMemoryStream& serializer, EntityMap& entity_map)
 			m_entities[m_hierarchy[i].entity.index].hierarchy = i;
 		}
 	}
+	return true;
 }
 
 
@@ -805,9 +872,45 @@ void Universe::destroyComponent(EntityRef entity, ComponentType type)
 }
 
 
+void Universe::beginDeferredComponentEvents(Span<IScene* const> scenes)
+{
+	ASSERT(m_deferred_components.empty());
+	for (IScene* scene : scenes) {
+		m_deferred_components.emplace(m_allocator).scene = scene;
+	}
+}
+
+
+void Universe::endDeferredComponentEvents(IScene& scene)
+{
+	// jobs of other scenes still read m_deferred_components, so it's cleared only once all scenes ended
+	bool all_ended = true;
+	for (DeferredComponents& deferred : m_deferred_components) {
+		if (deferred.scene == &scene) {
+			ASSERT(!deferred.ended);
+			deferred.ended = true;
+			for (const ComponentUID& cmp : deferred.components) {
+				m_entities[cmp.entity.index].components |= (u64)1 << cmp.type.index;
+				m_component_added.invoke(cmp);
+			}
+			deferred.components.clear();
+		}
+		all_ended = all_ended && deferred.ended;
+	}
+	if (all_ended) m_deferred_components.clear();
+}
+
+
 void Universe::onComponentCreated(EntityRef entity, ComponentType component_type, IScene* scene)
 {
 	ComponentUID cmp(entity, component_type, scene);
+	// each deferred scene is deserialized by a single job, so it's safe to push without locking
+	for (DeferredComponents& deferred : m_deferred_components) {
+		if (deferred.scene == scene && !deferred.ended) {
+			deferred.components.push(cmp);
+			return;
+		}
+	}
 	m_entities[entity.index].components |= (u64)1 << component_type.index;
 	m_component_added.invoke(cmp);
 }
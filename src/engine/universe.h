@@ -49,10 +49,16 @@ struct LUMIX_ENGINE_API Universe {
 	const Transform* getTransforms() const { return m_transforms.begin(); }
 	void emplaceEntity(EntityRef entity);
 	EntityRef createEntity(const DVec3& position, const Quat& rotation);
+	// creates entities.length() entities with identity transforms, reuses free slots first
+	void createEntities(Span<EntityRef> entities);
 	void destroyEntity(EntityRef entity);
 	void createComponent(ComponentType type, EntityRef entity);
 	void destroyComponent(EntityRef entity, ComponentType type);
 	void onComponentCreated(EntityRef entity, ComponentType component_type, IScene* scene);
+	// components created by `scenes` are queued, so the scenes can be deserialized in parallel;
+	// they are not visible in hasComponent until endDeferredComponentEvents(scene) reports them
+	void beginDeferredComponentEvents(Span<IScene* const> scenes);
+	void endDeferredComponentEvents(IScene& scene);
 	void onComponentDestroyed(EntityRef entity, ComponentType component_type, IScene* scene);
     u64 getComponentsMask(EntityRef entity) const;
     bool hasComponent(EntityRef entity, ComponentType component_type) const;
@@ -103,7 +109,7 @@ struct LUMIX_ENGINE_API Universe {
 	DelegateList<void(const ComponentUID&)>& componentAdded() { return m_component_added; }
 
 	void serialize(struct OutputMemoryStream& serializer);
-	void deserialize(struct InputMemoryStream& serializer, EntityMap& entity_map);
+	bool deserialize(struct InputMemoryStream& serializer, EntityMap& entity_map);
 
 	IScene* getScene(ComponentType type) const;
 	IScene* getScene(u32 hash) const;
@@ -134,6 +140,13 @@ private:
 		void (*destroy)(IScene*, EntityRef);
 	};
 
+	struct DeferredComponents {
+		DeferredComponents(IAllocator& allocator) : components(allocator) {}
+		IScene* scene;
+		Array<ComponentUID> components;
+		bool ended = false;
+	};
+
 	IAllocator& m_allocator;
 	Engine& m_engine;
 	ComponentTypeEntry m_component_type_map[ComponentType::MAX_TYPES_COUNT];
@@ -147,6 +160,7 @@ private:
 	DelegateList<void(EntityRef)> m_entity_destroyed;
 	DelegateList<void(const ComponentUID&)> m_component_destroyed;
 	DelegateList<void(const ComponentUID&)> m_component_added;
+	Array<DeferredComponents> m_deferred_components;
 	int m_first_free_slot;
 	char m_name[64];
 };
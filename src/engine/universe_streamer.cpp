@@ -0,0 +1,410 @@
+#include "universe_streamer.h"
+#include "engine/allocator.h"
+#include "engine/array.h"
+#include "engine/crc32.h"
+#include "engine/crt.h"
+#include "engine/delegate.h"
+#include "engine/engine.h"
+#include "engine/file_system.h"
+#include "engine/log.h"
+#include "engine/os.h"
+#include "engine/path.h"
+#include "engine/profiler.h"
+#include "engine/reflection.h"
+#include "engine/stream.h"
+#include "engine/string.h"
+#include "engine/universe.h"
+
+namespace Lumix {
+
+struct UniverseStreamerImpl;
+
+namespace {
+
+// SectorEntityRef with the property resolved
+struct SectorRef {
+	u32 entity;
+	u32 target;
+	ComponentType cmp_type;
+	const reflection::Property<EntityPtr>* prop;
+	i32 array_index;
+};
+
+// reference from another sector, refs[ref] of sectors[sector]
+struct IncomingRef {
+	u32 sector;
+	u32 ref;
+};
+
+struct Sector {
+	enum class State {
+		UNLOADED,
+		LOADING,	// waiting for file system
+		LOADED,		// data are in memory, waiting for instantiation
+		READY,		// entities exist in the universe
+		FAILED
+	};
+
+	Sector(UniverseStreamerImpl& streamer, IAllocator& allocator)
+		: streamer(streamer)
+		, entities(allocator)
+		, refs(allocator)
+		, incoming(allocator)
+		, data(allocator)
+	{}
+
+	void onLoaded(u64 size, const u8* mem, bool success);
+
+	UniverseStreamerImpl& streamer;
+	IVec2 coord;
+	u32 flags;
+	Array<u32> entities;
+	Array<SectorRef> refs;
+	Array<IncomingRef> incoming;
+	OutputMemoryStream data;
+	FileSystem::AsyncHandle handle = FileSystem::AsyncHandle::invalid();
+	State state = State::UNLOADED;
+};
+
+} // anonymous namespace
+
+struct UniverseStreamerImpl final : UniverseStreamer {
+	static constexpr u32 NO_SECTOR = 0xffFFffFF;
+
+	UniverseStreamerImpl(Engine& engine, Universe& universe, IAllocator& allocator)
+		: m_engine(engine)
+		, m_universe(universe)
+		, m_allocator(allocator)
+		, m_sectors(allocator)
+		, m_focus_points(allocator)
+		, m_entity_map(allocator)
+		, m_entity_sectors(allocator)
+	{}
+
+	~UniverseStreamerImpl() {
+		FileSystem& fs = m_engine.getFileSystem();
+		for (Sector& sector : m_sectors) {
+			if (sector.state == Sector::State::LOADING) fs.cancel(sector.handle);
+		}
+	}
+
+	bool load(const char* basename) override {
+		PROFILE_FUNCTION();
+		ASSERT(m_sectors.empty());
+		copyString(m_basename, basename);
+		const StaticString<LUMIX_MAX_PATH> path("universes/", basename, "/sectors.lsm");
+		OutputMemoryStream data(m_allocator);
+		if (!m_engine.getFileSystem().getContentSync(Path(path), data)) {
+			logError("Could not read ", path);
+			return false;
+		}
+
+		InputMemoryStream blob(data);
+		SectorManifestHeader header;
+		blob.read(header);
+		if (header.magic != SectorManifestHeader::MAGIC || header.version > SectorManifestHeader::Version::LATEST) {
+			logError("Unsupported or corrupted sector manifest ", path);
+			return false;
+		}
+
+		m_sector_size = header.sector_size;
+		// sectors must not move, file system callbacks keep pointers to them
+		m_sectors.reserve(header.sectors_count);
+		Array<SectorEntityRef> refs(m_allocator);
+		for (u32 i = 0; i < header.sectors_count; ++i) {
+			SectorManifestEntry entry;
+			blob.read(entry);
+			if (blob.getPosition() + entry.entities_count * sizeof(u32) > blob.size()) {
+				logError("Corrupted sector manifest ", path);
+				m_sectors.clear();
+				return false;
+			}
+			Sector& sector = m_sectors.emplace(*this, m_allocator);
+			sector.coord = entry.coord;
+			sector.flags = entry.flags;
+			sector.entities.resize(entry.entities_count);
+			blob.read(sector.entities.begin(), sector.entities.byte_size());
+			for (u32 e : sector.entities) {
+				while ((u32)m_entity_sectors.size() <= e) m_entity_sectors.push(NO_SECTOR);
+				m_entity_sectors[e] = i;
+			}
+
+			if (header.version > SectorManifestHeader::Version::ENTITY_REFS) {
+				const u32 refs_count = blob.read<u32>();
+				if (blob.getPosition() + refs_count * sizeof(SectorEntityRef) > blob.size()) {
+					logError("Corrupted sector manifest ", path);
+					m_sectors.clear();
+					m_entity_sectors.clear();
+					return false;
+				}
+				refs.resize(refs_count);
+				blob.read(refs.begin(), refs.byte_size());
+				resolveRefs(sector, refs);
+			}
+		}
+
+		for (u32 i = 0, c = m_sectors.size(); i < c; ++i) {
+			const Array<SectorRef>& sector_refs = m_sectors[i].refs;
+			for (u32 j = 0, cj = sector_refs.size(); j < cj; ++j) {
+				const u32 target_sector = getSectorIndex(sector_refs[j].target);
+				if (target_sector != NO_SECTOR) m_sectors[target_sector].incoming.push({i, j});
+			}
+		}
+
+		for (Sector& sector : m_sectors) {
+			if (sector.flags & SectorManifestEntry::GLOBAL) request(sector);
+		}
+		return true;
+	}
+
+	void setFocusPoints(Span<const DVec3> points) override {
+		m_focus_points.clear();
+		for (const DVec3& p : points) m_focus_points.push(p);
+	}
+
+	void setDistances(float load_distance, float unload_distance) override {
+		ASSERT(unload_distance >= load_distance);
+		m_load_distance = load_distance;
+		m_unload_distance = unload_distance;
+	}
+
+	void setBudget(float ms) override { m_budget_ms = ms; }
+
+	bool isLoading() const override {
+		for (const Sector& sector : m_sectors) {
+			if (sector.state == Sector::State::LOADING || sector.state == Sector::State::LOADED) return true;
+		}
+		return false;
+	}
+
+	const EntityMap& getEntityMap() const override { return m_entity_map; }
+
+	u32 getSectorIndex(u32 entity) const {
+		return entity < (u32)m_entity_sectors.size() ? m_entity_sectors[entity] : NO_SECTOR;
+	}
+
+	static const reflection::Property<EntityPtr>* findEntityProperty(const reflection::ComponentBase& cmp, u32 array_hash, u32 prop_hash) {
+		struct : reflection::IEmptyPropertyVisitor {
+			void visit(const reflection::Property<EntityPtr>& prop) override {
+				if (in_array == (array_hash != 0) && crc32(prop.name) == prop_hash) result = &prop;
+			}
+			void visit(const reflection::ArrayProperty& prop) override {
+				if (array_hash == 0 || crc32(prop.name) != array_hash) return;
+				in_array = true;
+				prop.visitChildren(*this);
+				in_array = false;
+			}
+			u32 array_hash;
+			u32 prop_hash;
+			bool in_array = false;
+			const reflection::Property<EntityPtr>* result = nullptr;
+		} visitor;
+		visitor.array_hash = array_hash;
+		visitor.prop_hash = prop_hash;
+		cmp.visit(visitor);
+		return visitor.result;
+	}
+
+	void resolveRefs(Sector& sector, Span<const SectorEntityRef> refs) {
+		const Span<const reflection::RegisteredComponent> cmps = reflection::getComponents();
+		for (const SectorEntityRef& ref : refs) {
+			const reflection::RegisteredComponent* cmp = nullptr;
+			for (const reflection::RegisteredComponent& c : cmps) {
+				if (c.name_hash == ref.cmp_hash && c.cmp) {
+					cmp = &c;
+					break;
+				}
+			}
+			const reflection::Property<EntityPtr>* prop = cmp ? findEntityProperty(*cmp->cmp, ref.array_hash, ref.prop_hash) : nullptr;
+			if (!prop) {
+				logWarning("Unknown entity property in sector ", getSectorPath(sector), ", reference is ignored");
+				continue;
+			}
+			SectorRef& r = sector.refs.emplace();
+			r.entity = ref.entity;
+			r.target = ref.target;
+			r.cmp_type = cmp->cmp->component_type;
+			r.prop = prop;
+			r.array_index = ref.array_index;
+		}
+	}
+
+	// sets the property to the target's current entity, INVALID_ENTITY if the target's sector is not instantiated
+	void applyRef(const SectorRef& ref) {
+		const EntityPtr owner = m_entity_map.get(EntityPtr{(i32)ref.entity});
+		if (!owner.isValid() || !m_universe.hasComponent((EntityRef)owner, ref.cmp_type)) return;
+
+		IScene* scene = m_universe.getScene(ref.cmp_type);
+		const ComponentUID cmp(owner, ref.cmp_type, scene);
+		const EntityPtr target = m_entity_map.get(EntityPtr{(i32)ref.target});
+		ref.prop->set(cmp, ref.array_index, target);
+	}
+
+	void applyIncomingRefs(const Sector& sector) {
+		for (const IncomingRef& ref : sector.incoming) {
+			if (m_sectors[ref.sector].state == Sector::State::READY) applyRef(m_sectors[ref.sector].refs[ref.ref]);
+		}
+	}
+
+	double getSquaredDistance(const Sector& sector) const {
+		const double min_x = sector.coord.x * (double)m_sector_size;
+		const double min_z = sector.coord.y * (double)m_sector_size;
+		double res = DBL_MAX;
+		for (const DVec3& p : m_focus_points) {
+			const double dx = maximum(min_x - p.x, 0.0, p.x - min_x - m_sector_size);
+			const double dz = maximum(min_z - p.z, 0.0, p.z - min_z - m_sector_size);
+			res = minimum(res, dx * dx + dz * dz);
+		}
+		return res;
+	}
+
+	void request(Sector& sector) {
+		const StaticString<LUMIX_MAX_PATH> path = getSectorPath(sector);
+		sector.state = Sector::State::LOADING;
+		FileSystem::ContentCallback cb;
+		cb.bind<&Sector::onLoaded>(&sector);
+		sector.handle = m_engine.getFileSystem().getContent(Path(path), cb);
+	}
+
+	StaticString<LUMIX_MAX_PATH> getSectorPath(const Sector& sector) const {
+		if (sector.flags & SectorManifestEntry::GLOBAL) return StaticString<LUMIX_MAX_PATH>("universes/", m_basename, "/global.sec");
+		return StaticString<LUMIX_MAX_PATH>("universes/", m_basename, "/", sector.coord.x, "_", sector.coord.y, ".sec");
+	}
+
+	void instantiate(Sector& sector) {
+		PROFILE_FUNCTION();
+		InputMemoryStream blob(sector.data);
+		const bool success = m_engine.deserialize(m_universe, blob, m_entity_map);
+		sector.data.free();
+		if (!success) {
+			logError("Failed to deserialize ", getSectorPath(sector));
+			destroyEntities(sector);
+			sector.state = Sector::State::FAILED;
+			return;
+		}
+
+		sector.state = Sector::State::READY;
+		for (const SectorRef& ref : sector.refs) applyRef(ref);
+		applyIncomingRefs(sector);
+	}
+
+	void destroyEntities(Sector& sector) {
+		Array<EntityRef> entities(m_allocator);
+		entities.reserve(sector.entities.size());
+		for (u32 idx : sector.entities) {
+			const EntityPtr e = m_entity_map.get(EntityPtr{(i32)idx});
+			if (!e.isValid()) continue;
+			// the runtime entity's index can be reused, so the persistent ID must not point to it anymore
+			m_entity_map.m_map[idx] = INVALID_ENTITY;
+			if (m_universe.hasEntity((EntityRef)e)) entities.push((EntityRef)e);
+		}
+		// other sectors must not keep references to entities which are going to be destroyed
+		applyIncomingRefs(sector);
+		for (EntityRef e : entities) m_universe.destroyEntity(e);
+	}
+
+	void destroy(Sector& sector) {
+		PROFILE_FUNCTION();
+		sector.state = Sector::State::UNLOADED;
+		destroyEntities(sector);
+	}
+
+	void update() override {
+		PROFILE_FUNCTION();
+		const double load_distance2 = (double)m_load_distance * m_load_distance;
+		const double unload_distance2 = (double)m_unload_distance * m_unload_distance;
+		FileSystem& fs = m_engine.getFileSystem();
+		for (Sector& sector : m_sectors) {
+			if (sector.flags & SectorManifestEntry::GLOBAL) continue;
+
+			const double d2 = getSquaredDistance(sector);
+			switch (sector.state) {
+				case Sector::State::UNLOADED:
+					if (d2 < load_distance2) request(sector);
+					break;
+				case Sector::State::LOADING:
+					if (d2 > unload_distance2) {
+						fs.cancel(sector.handle);
+						sector.state = Sector::State::UNLOADED;
+					}
+					break;
+				case Sector::State::LOADED:
+					if (d2 > unload_distance2) {
+						sector.data.free();
+						sector.state = Sector::State::UNLOADED;
+					}
+					break;
+				case Sector::State::READY:
+				case Sector::State::FAILED:
+					break;
+			}
+		}
+
+		// creating and destroying components is the expensive part, spread it over several frames
+		os::Timer timer;
+		bool any_processed = false;
+		auto has_budget = [&](){ return !any_processed || timer.getTimeSinceStart() * 1000 < m_budget_ms; };
+		for (Sector& sector : m_sectors) {
+			if (!has_budget()) return;
+			if (sector.state != Sector::State::READY || (sector.flags & SectorManifestEntry::GLOBAL)) continue;
+			if (getSquaredDistance(sector) <= unload_distance2) continue;
+			destroy(sector);
+			any_processed = true;
+		}
+		// other sectors can reference global entities, so the global sector goes first
+		bool global_pending = false;
+		for (Sector& sector : m_sectors) {
+			if (!(sector.flags & SectorManifestEntry::GLOBAL)) continue;
+			if (sector.state == Sector::State::LOADED && has_budget()) {
+				instantiate(sector);
+				any_processed = true;
+			}
+			if (sector.state == Sector::State::LOADING || sector.state == Sector::State::LOADED) global_pending = true;
+		}
+		if (global_pending) return;
+
+		for (Sector& sector : m_sectors) {
+			if (!has_budget()) return;
+			if (sector.state != Sector::State::LOADED) continue;
+			instantiate(sector);
+			any_processed = true;
+		}
+	}
+
+	void onLoaded(Sector& sector, u64 size, const u8* mem, bool success) {
+		sector.handle = FileSystem::AsyncHandle::invalid();
+		if (!success) {
+			logError("Failed to load ", getSectorPath(sector));
+			sector.state = Sector::State::FAILED;
+			return;
+		}
+		sector.data.clear();
+		sector.data.write(mem, size);
+		sector.state = Sector::State::LOADED;
+	}
+
+	Engine& m_engine;
+	Universe& m_universe;
+	IAllocator& m_allocator;
+	Array<Sector> m_sectors;
+	Array<DVec3> m_focus_points;
+	// persistent ID -> runtime entity
+	EntityMap m_entity_map;
+	// persistent ID -> index in m_sectors
+	Array<u32> m_entity_sectors;
+	char m_basename[LUMIX_MAX_PATH] = "";
+	float m_sector_size = 0;
+	float m_load_distance = 200;
+	float m_unload_distance = 250;
+	float m_budget_ms = 2;
+};
+
+void Sector::onLoaded(u64 size, const u8* mem, bool success) {
+	streamer.onLoaded(*this, size, mem, success);
+}
+
+UniquePtr<UniverseStreamer> UniverseStreamer::create(Engine& engine, Universe& universe, IAllocator& allocator) {
+	return UniquePtr<UniverseStreamerImpl>::create(allocator, engine, universe, allocator);
+}
+
+} // namespace Lumix
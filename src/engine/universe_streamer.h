@@ -0,0 +1,75 @@
+#pragma once
+
+#include "engine/lumix.h"
+#include "engine/math.h"
+
+namespace Lumix {
+
+template <typename T> struct UniquePtr;
+
+// universes/<name>/sectors.lsm, lists sectors exported by the editor
+// each sector is an engine serialized universe in universes/<name>/<x>_<z>.sec (global.sec for the global one),
+// entity indices in sector files are persistent IDs shared by all sectors of the universe
+struct SectorManifestHeader {
+	static constexpr u32 MAGIC = '_LSM';
+	enum class Version : u32 {
+		FIRST,
+		ENTITY_REFS,
+
+		LATEST // keep this last
+	};
+
+	u32 magic = MAGIC;
+	Version version = Version::LATEST;
+	float sector_size;
+	u32 sectors_count;
+};
+
+// followed by entities_count u32 persistent IDs of the sector's entities,
+// then by u32 refs_count and refs_count SectorEntityRef
+struct SectorManifestEntry {
+	enum Flags : u32 {
+		NONE = 0,
+		GLOBAL = 1 << 0 // always loaded, before any other sector
+	};
+
+	IVec2 coord; // sector's min corner is coord * sector_size on XZ plane
+	u32 flags;
+	u32 entities_count;
+};
+
+// reflected entity property of a sector's entity pointing to an entity in another sector
+struct SectorEntityRef {
+	u32 entity;			// persistent ID of the component's owner
+	u32 cmp_hash;		// crc32 of the component's name
+	u32 array_hash;		// crc32 of the array property's name, 0 if the property is not in an array
+	u32 prop_hash;		// crc32 of the property's name
+	i32 array_index;	// -1 if the property is not in an array
+	u32 target;			// persistent ID of the referenced entity
+};
+
+// loads and unloads sectors of a universe around focus points
+// file IO runs in background, deserialization happens in update() and is limited by a time budget
+// the global sector is instantiated before any other sector
+// reflected entity properties pointing to other sectors are set when both sectors are instantiated
+// and reset to INVALID_ENTITY when the target's sector is destroyed,
+// other references (e.g. scene-internal ones) are resolved only if the target exists when the sector is instantiated,
+// so targets of such references belong to the global sector
+struct LUMIX_ENGINE_API UniverseStreamer {
+	static UniquePtr<UniverseStreamer> create(struct Engine& engine, struct Universe& universe, struct IAllocator& allocator);
+
+	virtual ~UniverseStreamer() {}
+	// reads universes/<basename>/sectors.lsm and requests the global sector
+	virtual bool load(const char* basename) = 0;
+	virtual void setFocusPoints(Span<const DVec3> points) = 0;
+	// sectors closer than load_distance to any focus point are loaded,
+	// sectors farther than unload_distance from all focus points are unloaded
+	virtual void setDistances(float load_distance, float unload_distance) = 0;
+	// time in ms spent each frame by instantiating and destroying sectors, at least one sector is processed each frame
+	virtual void setBudget(float ms) = 0;
+	virtual void update() = 0;
+	virtual bool isLoading() const = 0;
+	virtual const struct EntityMap& getEntityMap() const = 0;
+};
+
+} // namespace Lumix
@@ -798,7 +798,11 @@ void memCommit(void* ptr, size_t size) {
 	VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE);
 }
 
-void memRelease(void* ptr) {
+void memDecommit(void* ptr, size_t size) {
+	VirtualFree(ptr, size, MEM_DECOMMIT);
+}
+
+void memRelease(void* ptr, size_t) {
 	VirtualFree(ptr, 0, MEM_RELEASE);
 }
 
@@ -1,7 +1,7 @@
 ﻿#include "gui_system.h"
 #include "engine/crc32.h"
 #include "engine/engine.h"
-#include "engine/allocator.h"
+#include "engine/allocators.h"
 #include "engine/input_system.h"
 #include "engine/math.h"
 #include "engine/path.h"
@@ -61,8 +61,9 @@ struct GUISystemImpl final : GUISystem
 
 	explicit GUISystemImpl(Engine& engine)
 		: m_engine(engine)
+		, m_allocator(engine.getAllocator(), "gui")
 		, m_interface(nullptr)
-		, m_sprite_manager(engine.getAllocator())
+		, m_sprite_manager(m_allocator)
 	{
 		GUIScene::reflect();
 		LUMIX_GLOBAL_FUNC(GUISystem::enableCursor);
@@ -76,8 +77,7 @@ struct GUISystemImpl final : GUISystem
 
 	void createScenes(Universe& universe) override
 	{
-		IAllocator& allocator = m_engine.getAllocator();
-		UniquePtr<GUIScene> scene = GUIScene::createInstance(*this, universe, allocator);
+		UniquePtr<GUIScene> scene = GUIScene::createInstance(*this, universe, m_allocator);
 		universe.addScene(scene.move());
 	}
 
@@ -127,6 +127,7 @@ struct GUISystemImpl final : GUISystem
 	bool deserialize(u32 version, InputMemoryStream& stream) override { return version == 0; }
 
 	Engine& m_engine;
+	TagAllocator m_allocator;
 	SpriteManager m_sprite_manager;
 	Interface* m_interface;
 };
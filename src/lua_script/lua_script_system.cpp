@@ -1,13 +1,17 @@
 #include "lua_script_system.h"
 #include "animation/animation_scene.h"
+#include "engine/allocators.h"
 #include "engine/array.h"
 #include "engine/associative_array.h"
+#include "engine/atomic.h"
 #include "engine/crc32.h"
 #include "engine/debug.h"
 #include "engine/engine.h"
 #include "engine/flag_set.h"
 #include "engine/allocator.h"
+#include "engine/hash_map.h"
 #include "engine/input_system.h"
+#include "engine/job_system.h"
 #include "engine/metaprogramming.h"
 #include "engine/plugin.h"
 #include "engine/log.h"
@@ -17,6 +21,7 @@
 #include "engine/resource_manager.h"
 #include "engine/stream.h"
 #include "engine/string.h"
+#include "engine/sync.h"
 #include "engine/universe.h"
 #include "gui/gui_scene.h"
 #include "lua_script/lua_script.h"
@@ -205,10 +210,12 @@ namespace Lumix
 	}
 
 	static const ComponentType LUA_SCRIPT_TYPE = reflection::getComponentType("lua_script");
+	static const ComponentType LUA_JOB_SCRIPT_TYPE = reflection::getComponentType("lua_job_script");
 
 
 	enum class LuaSceneVersion : i32
 	{
+		JOB_SCRIPTS,
 		LATEST
 	};
 
@@ -283,25 +290,177 @@ namespace Lumix
 		bool deserialize(u32 version, InputMemoryStream& stream) override { return version == 0; }
 
 		Engine& m_engine;
-		IAllocator& m_allocator;
+		TagAllocator m_allocator;
 		LuaScriptManager m_script_manager;
 	};
 
 
-	struct LuaScriptSceneImpl final : LuaScriptScene
+	// hierarchical timer wheel, add, cancel and per tick work are O(1)
+	struct LuaTimerWheel
 	{
-		struct TimerData
+		static constexpr double TICK = 1 / 64.0;
+		static constexpr u32 SLOT_BITS = 6;
+		static constexpr u32 SLOTS = 1 << SLOT_BITS;
+		static constexpr u32 LEVELS = 4;
+		static constexpr u32 INVALID = 0xffFFffFF;
+
+		struct Timer
 		{
-			float time;
+			u64 deadline;
 			lua_State* state;
 			int func;
+			u32 prev;
+			u32 next;
+			u32 slot;
 		};
 
+		explicit LuaTimerWheel(IAllocator& allocator)
+			: m_timers(allocator)
+			, m_func_to_timer(allocator)
+		{
+			clear();
+		}
+
+		void clear()
+		{
+			m_timers.clear();
+			m_func_to_timer.clear();
+			m_free_list = INVALID;
+			m_time = 0;
+			m_tick = 0;
+			for (u32& head : m_slots) head = INVALID;
+		}
+
+		void add(float time, lua_State* state, int func)
+		{
+			u32 idx = m_free_list;
+			if (idx == INVALID) {
+				idx = m_timers.size();
+				m_timers.emplace();
+			}
+			else {
+				m_free_list = m_timers[idx].next;
+			}
+
+			Timer& timer = m_timers[idx];
+			// never fire before `time` elapses, rounding up to ticks
+			const u64 deadline = u64(ceil((m_time + maximum(time, 0.f)) / TICK));
+			timer.deadline = maximum(deadline, m_tick + 1);
+			timer.state = state;
+			timer.func = func;
+			m_func_to_timer.insert(func, idx);
+			link(idx);
+		}
+
+		bool cancel(int func)
+		{
+			auto iter = m_func_to_timer.find(func);
+			if (!iter.isValid()) return false;
+			release(iter.value());
+			return true;
+		}
+
+		template <typename F>
+		void cancelIf(F predicate)
+		{
+			for (u32 i = 0, c = m_timers.size(); i < c; ++i) {
+				const Timer& timer = m_timers[i];
+				if (timer.slot != INVALID && predicate(timer)) release(i);
+			}
+		}
+
+		// expired timers are removed and passed to `f`
+		template <typename F>
+		void advance(float time_delta, F f)
+		{
+			m_time += time_delta;
+			const u64 tick = u64(m_time / TICK);
+			while (m_tick < tick) {
+				++m_tick;
+				// higher levels first, they can move timers to lower levels' current slots
+				u32 wrapped_levels = 1;
+				while (wrapped_levels < LEVELS && (m_tick & ((u64(1) << (SLOT_BITS * wrapped_levels)) - 1)) == 0) ++wrapped_levels;
+				for (u32 level = wrapped_levels - 1; level > 0; --level) cascade(level);
+
+				u32& head = m_slots[m_tick & (SLOTS - 1)];
+				while (head != INVALID) {
+					const u32 idx = head;
+					const Timer timer = m_timers[idx];
+					unlink(idx);
+					m_func_to_timer.erase(timer.func);
+					m_timers[idx].next = m_free_list;
+					m_free_list = idx;
+					f(timer);
+				}
+			}
+		}
+
+		void link(u32 idx)
+		{
+			Timer& timer = m_timers[idx];
+			const u64 delta = timer.deadline - m_tick;
+			u32 level = 0;
+			while (level < LEVELS - 1 && delta >= (u64(1) << (SLOT_BITS * (level + 1)))) ++level;
+			// too far in future, park it in the last slot reachable, it's relinked when cascaded
+			const u64 max_delta = (u64(1) << (SLOT_BITS * LEVELS)) - 1;
+			const u64 deadline = delta > max_delta ? m_tick + max_delta : timer.deadline;
+			const u32 slot = level * SLOTS + u32((deadline >> (SLOT_BITS * level)) & (SLOTS - 1));
+
+			timer.slot = slot;
+			timer.prev = INVALID;
+			timer.next = m_slots[slot];
+			if (timer.next != INVALID) m_timers[timer.next].prev = idx;
+			m_slots[slot] = idx;
+		}
+
+		void unlink(u32 idx)
+		{
+			Timer& timer = m_timers[idx];
+			if (timer.prev != INVALID) m_timers[timer.prev].next = timer.next;
+			else m_slots[timer.slot] = timer.next;
+			if (timer.next != INVALID) m_timers[timer.next].prev = timer.prev;
+			timer.slot = INVALID;
+		}
+
+		void release(u32 idx)
+		{
+			Timer& timer = m_timers[idx];
+			luaL_unref(timer.state, LUA_REGISTRYINDEX, timer.func);
+			m_func_to_timer.erase(timer.func);
+			unlink(idx);
+			timer.next = m_free_list;
+			m_free_list = idx;
+		}
+
+		void cascade(u32 level)
+		{
+			const u32 slot = level * SLOTS + u32((m_tick >> (SLOT_BITS * level)) & (SLOTS - 1));
+			u32 idx = m_slots[slot];
+			m_slots[slot] = INVALID;
+			while (idx != INVALID) {
+				const u32 next = m_timers[idx].next;
+				link(idx);
+				idx = next;
+			}
+		}
+
+		Array<Timer> m_timers;
+		HashMap<int, u32> m_func_to_timer;
+		u32 m_slots[SLOTS * LEVELS];
+		u32 m_free_list;
+		double m_time;
+		u64 m_tick;
+	};
+
+
+	struct LuaScriptSceneImpl final : LuaScriptScene
+	{
 		struct CallbackData
 		{
 			LuaScript* script;
 			lua_State* state;
 			int environment;
+			int func; // cached reference to the callback, resolved when script starts
 		};
 
 		struct ScriptComponent;
@@ -537,6 +696,375 @@ namespace Lumix
 		};
 
 
+		// value of a reflected property, as read or written by job scripts
+		struct JobValue
+		{
+			enum Type : u8 {
+				NONE,
+				FLOAT,
+				I32,
+				U32,
+				BOOL,
+				ENTITY,
+				VEC2,
+				VEC3,
+				VEC4
+			};
+
+			static u32 getComponentsCount(Type type) {
+				switch (type) {
+					case VEC2: return 2;
+					case VEC3: return 3;
+					case VEC4: return 4;
+					case NONE: return 0;
+					default: return 1;
+				}
+			}
+
+			Type type = NONE;
+			// entities are stored in `i`
+			union {
+				float f;
+				i32 i;
+				u32 u;
+				bool b;
+				float v[4];
+			};
+		};
+
+
+		struct JobPropertyFinder : reflection::IEmptyPropertyVisitor
+		{
+			template <typename T>
+			void find(const reflection::Property<T>& p, JobValue::Type t) {
+				if (prop || !LuaPropGetterVisitor::isSameProperty(p.name, prop_name)) return;
+				prop = &p;
+				type = t;
+			}
+
+			void visit(const reflection::Property<float>& p) override { find(p, JobValue::FLOAT); }
+			void visit(const reflection::Property<int>& p) override { find(p, JobValue::I32); }
+			void visit(const reflection::Property<u32>& p) override { find(p, JobValue::U32); }
+			void visit(const reflection::Property<bool>& p) override { find(p, JobValue::BOOL); }
+			void visit(const reflection::Property<EntityPtr>& p) override { find(p, JobValue::ENTITY); }
+			void visit(const reflection::Property<Vec2>& p) override { find(p, JobValue::VEC2); }
+			void visit(const reflection::Property<Vec3>& p) override { find(p, JobValue::VEC3); }
+			void visit(const reflection::Property<Vec4>& p) override { find(p, JobValue::VEC4); }
+
+			const char* prop_name;
+			const reflection::PropertyBase* prop = nullptr;
+			JobValue::Type type = JobValue::NONE;
+		};
+
+
+		// property declared in job script's `inputs`, e.g. inputs = { "rigid_actor.velocity" }
+		struct JobInput
+		{
+			StaticString<64> component;
+			StaticString<64> property;
+			ComponentType cmp_type;
+			const reflection::PropertyBase* prop;
+			JobValue::Type type;
+		};
+
+
+		// job script resource shared by all job script components using it,
+		// its `inputs` are parsed once per load, not once per component
+		struct JobScriptInfo
+		{
+			JobScriptInfo(IAllocator& allocator) : inputs(allocator) {}
+
+			Array<JobInput> inputs;
+			u32 users = 0; // job script components using the script
+		};
+
+
+		// state of a job script's entity, taken on the main thread before job scripts are dispatched,
+		// so jobs never call into scenes
+		struct JobSnapshot
+		{
+			bool valid;
+			Transform transform;
+			const Array<JobInput>* inputs;
+			u32 values_offset; // index of the first input's value in m_job_input_values
+		};
+
+
+		// write requested by a job script, applied on the main thread after all job scripts finish
+		struct JobCommand
+		{
+			enum Type : u8 {
+				POSITION,
+				ROTATION,
+				SCALE,
+				PROPERTY
+			};
+
+			Type type;
+			EntityRef entity;
+			ComponentType cmp_type;
+			const reflection::PropertyBase* prop;
+			JobValue value;
+			DVec3 pos;
+			Quat rot;
+		};
+
+
+		// isolated lua_State, used by one job at a time, job scripts see only the `Job` API
+		struct JobVM
+		{
+			JobVM(LuaScriptSceneImpl& scene, IAllocator& allocator)
+				: m_scene(scene)
+				, m_commands(allocator)
+				, m_update_refs(allocator)
+			{
+				L = luaL_newstate();
+				luaL_openlibs(L);
+
+				lua_newtable(L); // [Job]
+				auto reg = [&](const char* name, lua_CFunction f){
+					lua_pushlightuserdata(L, this); // [Job, vm]
+					lua_pushcclosure(L, f, 1); // [Job, f]
+					lua_setfield(L, -2, name); // [Job]
+				};
+				reg("getPosition", &JobVM::getPosition);
+				reg("getRotation", &JobVM::getRotation);
+				reg("getScale", &JobVM::getScale);
+				reg("getProperty", &JobVM::getProperty);
+				reg("setPosition", &JobVM::setPosition);
+				reg("setRotation", &JobVM::setRotation);
+				reg("setScale", &JobVM::setScale);
+				reg("setProperty", &JobVM::setProperty);
+				lua_setglobal(L, "Job"); // []
+			}
+
+			~JobVM() { lua_close(L); }
+
+			static JobVM& getVM(lua_State* L) {
+				return *LuaWrapper::toType<JobVM*>(L, lua_upvalueindex(1));
+			}
+
+			// reads are limited to the script's own entity, they are served from its snapshot
+			static const JobSnapshot& checkOwnEntity(lua_State* L, JobVM& vm) {
+				const i32 e = LuaWrapper::checkArg<i32>(L, 1);
+				if (e != vm.m_entity.index) luaL_error(L, "Job scripts can read only their own entity, %d requested", e);
+				return vm.m_scene.m_job_snapshots[vm.m_snapshot_idx];
+			}
+
+			// writes are validated when they are applied on the main thread
+			static EntityRef checkEntity(lua_State* L) {
+				const EntityRef e = {LuaWrapper::checkArg<i32>(L, 1)};
+				if (e.index < 0) luaL_error(L, "Invalid entity %d", e.index);
+				return e;
+			}
+
+			static int getPosition(lua_State* L) {
+				JobVM& vm = getVM(L);
+				const DVec3& p = checkOwnEntity(L, vm).transform.pos;
+				lua_pushnumber(L, p.x);
+				lua_pushnumber(L, p.y);
+				lua_pushnumber(L, p.z);
+				return 3;
+			}
+
+			static int getRotation(lua_State* L) {
+				JobVM& vm = getVM(L);
+				const Quat& r = checkOwnEntity(L, vm).transform.rot;
+				lua_pushnumber(L, r.x);
+				lua_pushnumber(L, r.y);
+				lua_pushnumber(L, r.z);
+				lua_pushnumber(L, r.w);
+				return 4;
+			}
+
+			static int getScale(lua_State* L) {
+				JobVM& vm = getVM(L);
+				lua_pushnumber(L, checkOwnEntity(L, vm).transform.scale);
+				return 1;
+			}
+
+			template <typename T>
+			static T getValue(const reflection::PropertyBase* prop, const ComponentUID& cmp) {
+				return static_cast<const reflection::Property<T>*>(prop)->get(cmp, -1);
+			}
+
+			static int getProperty(lua_State* L) {
+				JobVM& vm = getVM(L);
+				const JobSnapshot& snapshot = checkOwnEntity(L, vm);
+				const char* cmp_name = LuaWrapper::checkArg<const char*>(L, 2);
+				const char* prop_name = LuaWrapper::checkArg<const char*>(L, 3);
+				const Array<JobInput>& inputs = *snapshot.inputs;
+				for (i32 i = 0, c = inputs.size(); i < c; ++i) {
+					if (!equalStrings(inputs[i].component, cmp_name) || !equalStrings(inputs[i].property, prop_name)) continue;
+
+					const JobValue& v = vm.m_scene.m_job_input_values[snapshot.values_offset + i];
+					switch (v.type) {
+						case JobValue::FLOAT: lua_pushnumber(L, v.f); return 1;
+						case JobValue::I32: lua_pushinteger(L, v.i); return 1;
+						case JobValue::U32: lua_pushnumber(L, v.u); return 1;
+						case JobValue::BOOL: lua_pushboolean(L, v.b); return 1;
+						case JobValue::ENTITY: lua_pushinteger(L, v.i); return 1;
+						case JobValue::VEC2:
+						case JobValue::VEC3:
+						case JobValue::VEC4: {
+							const u32 count = JobValue::getComponentsCount(v.type);
+							for (u32 j = 0; j < count; ++j) lua_pushnumber(L, v.v[j]);
+							return count;
+						}
+						case JobValue::NONE: luaL_error(L, "Entity %d does not have %s", vm.m_entity.index, cmp_name); break;
+					}
+					ASSERT(false);
+					return 0;
+				}
+				luaL_error(L, "`%s.%s` is not in script's inputs", cmp_name, prop_name);
+				return 0;
+			}
+
+			static int setPosition(lua_State* L) {
+				JobVM& vm = getVM(L);
+				const EntityRef e = checkEntity(L);
+				const DVec3 pos(luaL_checknumber(L, 2), luaL_checknumber(L, 3), luaL_checknumber(L, 4));
+				JobCommand& cmd = vm.m_commands.emplace();
+				cmd.type = JobCommand::POSITION;
+				cmd.entity = e;
+				cmd.pos = pos;
+				return 0;
+			}
+
+			static int setRotation(lua_State* L) {
+				JobVM& vm = getVM(L);
+				const EntityRef e = checkEntity(L);
+				const Quat rot(LuaWrapper::checkArg<float>(L, 2)
+					, LuaWrapper::checkArg<float>(L, 3)
+					, LuaWrapper::checkArg<float>(L, 4)
+					, LuaWrapper::checkArg<float>(L, 5));
+				JobCommand& cmd = vm.m_commands.emplace();
+				cmd.type = JobCommand::ROTATION;
+				cmd.entity = e;
+				cmd.rot = rot;
+				return 0;
+			}
+
+			static int setScale(lua_State* L) {
+				JobVM& vm = getVM(L);
+				const EntityRef e = checkEntity(L);
+				const float scale = LuaWrapper::checkArg<float>(L, 2);
+				JobCommand& cmd = vm.m_commands.emplace();
+				cmd.type = JobCommand::SCALE;
+				cmd.entity = e;
+				cmd.value.type = JobValue::FLOAT;
+				cmd.value.f = scale;
+				return 0;
+			}
+
+			static int setProperty(lua_State* L) {
+				JobVM& vm = getVM(L);
+				const EntityRef e = checkEntity(L);
+				const char* cmp_name = LuaWrapper::checkArg<const char*>(L, 2);
+				JobPropertyFinder finder;
+				finder.prop_name = LuaWrapper::checkArg<const char*>(L, 3);
+				auto iter = vm.m_scene.m_job_components.find(crc32(cmp_name));
+				if (!iter.isValid()) luaL_error(L, "Unknown component %s", cmp_name);
+				const reflection::ComponentBase* cmp = iter.value();
+				cmp->visit(finder);
+				if (!finder.prop) luaL_error(L, "Property `%s` does not exist or is not accessible from jobs", finder.prop_name);
+				JobValue value;
+				value.type = finder.type;
+				switch (finder.type) {
+					case JobValue::FLOAT: value.f = LuaWrapper::checkArg<float>(L, 4); break;
+					case JobValue::I32: value.i = LuaWrapper::checkArg<i32>(L, 4); break;
+					case JobValue::U32: value.u = LuaWrapper::checkArg<u32>(L, 4); break;
+					case JobValue::BOOL: value.b = LuaWrapper::checkArg<bool>(L, 4); break;
+					case JobValue::ENTITY: value.i = LuaWrapper::checkArg<i32>(L, 4); break;
+					case JobValue::VEC2:
+					case JobValue::VEC3:
+					case JobValue::VEC4: {
+						for (u32 i = 0, c = JobValue::getComponentsCount(finder.type); i < c; ++i) {
+							value.v[i] = LuaWrapper::checkArg<float>(L, 4 + i);
+						}
+						break;
+					}
+					case JobValue::NONE: ASSERT(false); break;
+				}
+				JobCommand& cmd = vm.m_commands.emplace();
+				cmd.type = JobCommand::PROPERTY;
+				cmd.entity = e;
+				cmd.cmp_type = cmp->component_type;
+				cmd.prop = finder.prop;
+				cmd.value = value;
+				return 0;
+			}
+
+			// scripts are compiled once per VM, their globals are shared by all entities using the script
+			int getUpdateRef(LuaScript* script) {
+				if (m_generation != m_scene.m_job_scripts_generation) {
+					for (int ref : m_update_refs) luaL_unref(L, LUA_REGISTRYINDEX, ref);
+					m_update_refs.clear();
+					m_generation = m_scene.m_job_scripts_generation;
+				}
+
+				auto iter = m_update_refs.find(script);
+				if (iter.isValid()) return iter.value();
+
+				LuaWrapper::DebugGuard guard(L);
+				int ref = LUA_NOREF;
+				const char* src = script->getSourceCode();
+				lua_newtable(L); // [env]
+				lua_newtable(L); // [env, meta]
+				lua_pushvalue(L, LUA_GLOBALSINDEX); // [env, meta, _G]
+				lua_setfield(L, -2, "__index"); // [env, meta]
+				lua_setmetatable(L, -2); // [env]
+				if (luaL_loadbuffer(L, src, stringLength(src), script->getPath().c_str()) != 0) { // [env, func] | [env, error]
+					logError(script->getPath(), ": ", lua_tostring(L, -1));
+					lua_pop(L, 2);
+					m_update_refs.insert(script, ref);
+					return ref;
+				}
+				lua_pushvalue(L, -2); // [env, func, env]
+				lua_setfenv(L, -2); // [env, func]
+				if (lua_pcall(L, 0, 0, 0) != 0) { // [env] | [env, error]
+					logError(script->getPath(), ": ", lua_tostring(L, -1));
+					lua_pop(L, 2);
+					m_update_refs.insert(script, ref);
+					return ref;
+				}
+				lua_getfield(L, -1, "update"); // [env, update]
+				if (lua_type(L, -1) == LUA_TFUNCTION) {
+					ref = luaL_ref(L, LUA_REGISTRYINDEX); // [env]
+				}
+				else {
+					logError(script->getPath(), ": job script does not have update function");
+					lua_pop(L, 1); // [env]
+				}
+				lua_pop(L, 1); // []
+				m_update_refs.insert(script, ref);
+				return ref;
+			}
+
+			void update(LuaScript* script, EntityRef entity, u32 snapshot_idx, float time_delta) {
+				const int ref = getUpdateRef(script);
+				if (ref == LUA_NOREF) return;
+
+				m_entity = entity;
+				m_snapshot_idx = snapshot_idx;
+
+				LuaWrapper::DebugGuard guard(L);
+				lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
+				lua_pushinteger(L, entity.index);
+				lua_pushnumber(L, time_delta);
+				LuaWrapper::pcall(L, 2, 0);
+			}
+
+			LuaScriptSceneImpl& m_scene;
+			lua_State* L;
+			Array<JobCommand> m_commands;
+			HashMap<LuaScript*, int> m_update_refs;
+			u32 m_generation = 0;
+			EntityRef m_entity;
+			u32 m_snapshot_idx;
+		};
+
+
 		struct FunctionCall : IFunctionCall
 		{
 			void add(int parameter) override
@@ -596,6 +1124,13 @@ namespace Lumix
 			, m_input_handlers(system.m_allocator)
 			, m_timers(system.m_allocator)
 			, m_property_names(system.m_allocator)
+			, m_job_scripts(system.m_allocator)
+			, m_job_vms(system.m_allocator)
+			, m_free_job_vms(system.m_allocator)
+			, m_job_script_infos(system.m_allocator)
+			, m_job_components(system.m_allocator)
+			, m_job_snapshots(system.m_allocator)
+			, m_job_input_values(system.m_allocator)
 			, m_is_game_running(false)
 			, m_is_api_registered(false)
 			, m_animation_scene(nullptr)
@@ -606,6 +1141,12 @@ namespace Lumix
 		}
 
 
+		~LuaScriptSceneImpl()
+		{
+			for (JobVM* vm : m_job_vms) LUMIX_DELETE(m_system.m_allocator, vm);
+		}
+
+
 		int getVersion() const override { return (int)LuaSceneVersion::LATEST; }
 
 
@@ -682,6 +1223,15 @@ namespace Lumix
 				LUMIX_DELETE(m_system.m_allocator, script_cmp);
 			}
 			m_scripts.clear();
+
+			for (LuaScript* script : m_job_scripts) {
+				if (script) script->decRefCount();
+			}
+			for (auto iter = m_job_script_infos.begin(), end = m_job_script_infos.end(); iter != end; ++iter) {
+				iter.key()->getObserverCb().unbind<&LuaScriptSceneImpl::onJobScriptLoaded>(this);
+			}
+			m_job_scripts.clear();
+			m_job_script_infos.clear();
 		}
 
 
@@ -780,22 +1330,7 @@ namespace Lumix
 				lua_pop(instance.m_state, 1);
 				return 0;
 			}
-			lua_getfield(instance.m_state, -1, "update");
-			if (lua_type(instance.m_state, -1) == LUA_TFUNCTION) {
-				auto& update_data = scene->m_updates.emplace();
-				update_data.script = instance.m_script;
-				update_data.state = instance.m_state;
-				update_data.environment = instance.m_environment;
-			}
-			lua_pop(instance.m_state, 1);
-			lua_getfield(instance.m_state, -1, "onInputEvent");
-			if (lua_type(instance.m_state, -1) == LUA_TFUNCTION) {
-				auto& callback = scene->m_input_handlers.emplace();
-				callback.script = instance.m_script;
-				callback.state = instance.m_state;
-				callback.environment = instance.m_environment;
-			}
-			lua_pop(instance.m_state, 1);
+			scene->registerCallbacks(instance);
 			lua_pop(instance.m_state, 1);
 
 			return 0;
@@ -1154,14 +1689,7 @@ namespace Lumix
 
 		void cancelTimer(int timer_func)
 		{
-			for (int i = 0, c = m_timers.size(); i < c; ++i)
-			{
-				if (m_timers[i].func == timer_func)
-				{
-					m_timers.swapAndPop(i);
-					break;
-				}
-			}
+			m_timers.cancel(timer_func);
 		}
 
 
@@ -1170,13 +1698,10 @@ namespace Lumix
 			auto* scene = LuaWrapper::checkArg<LuaScriptSceneImpl*>(L, 1);
 			float time = LuaWrapper::checkArg<float>(L, 2);
 			if (!lua_isfunction(L, 3)) LuaWrapper::argError(L, 3, "function");
-			TimerData& timer = scene->m_timers.emplace();
-			timer.time = time;
-			timer.state = L;
 			lua_pushvalue(L, 3);
-			timer.func = luaL_ref(L, LUA_REGISTRYINDEX);
-			lua_pop(L, 1);
-			LuaWrapper::push(L, timer.func);
+			const int func = luaL_ref(L, LUA_REGISTRYINDEX);
+			scene->m_timers.add(time, L, func);
+			LuaWrapper::push(L, func);
 			return 1;
 		}
 
@@ -1401,20 +1926,13 @@ namespace Lumix
 
 		void disableScript(ScriptInstance& inst)
 		{
-			for (int i = 0; i < m_timers.size(); ++i)
-			{
-				if (m_timers[i].state == inst.m_state)
-				{
-					luaL_unref(m_timers[i].state, LUA_REGISTRYINDEX, m_timers[i].func);
-					m_timers.swapAndPop(i);
-					--i;
-				}
-			}
+			m_timers.cancelIf([&](const LuaTimerWheel::Timer& timer){ return timer.state == inst.m_state; });
 
 			for (int i = 0; i < m_updates.size(); ++i)
 			{
 				if (m_updates[i].state == inst.m_state)
 				{
+					luaL_unref(m_updates[i].state, LUA_REGISTRYINDEX, m_updates[i].func);
 					m_updates.swapAndPop(i);
 					break;
 				}
@@ -1424,6 +1942,7 @@ namespace Lumix
 			{
 				if (m_input_handlers[i].state == inst.m_state)
 				{
+					luaL_unref(m_input_handlers[i].state, LUA_REGISTRYINDEX, m_input_handlers[i].func);
 					m_input_handlers.swapAndPop(i);
 					break;
 				}
@@ -1431,6 +1950,27 @@ namespace Lumix
 		}
 
 
+		// environment of the instance must be on top of the stack
+		void registerCallbacks(const ScriptInstance& instance)
+		{
+			lua_State* L = instance.m_state;
+			auto add = [&](Array<CallbackData>& callbacks, const char* name){
+				lua_getfield(L, -1, name);
+				if (lua_type(L, -1) != LUA_TFUNCTION) {
+					lua_pop(L, 1);
+					return;
+				}
+				CallbackData& callback = callbacks.emplace();
+				callback.script = instance.m_script;
+				callback.state = L;
+				callback.environment = instance.m_environment;
+				callback.func = luaL_ref(L, LUA_REGISTRYINDEX);
+			};
+			add(m_updates, "update");
+			add(m_input_handlers, "onInputEvent");
+		}
+
+
 		void setPath(ScriptComponent& cmp, ScriptInstance& inst, const Path& path)
 		{
 			registerAPI();
@@ -1461,24 +2001,7 @@ namespace Lumix
 				lua_pop(instance.m_state, 1);
 				return;
 			}
-			lua_getfield(instance.m_state, -1, "update");
-			if (lua_type(instance.m_state, -1) == LUA_TFUNCTION)
-			{
-				auto& update_data = m_updates.emplace();
-				update_data.script = instance.m_script;
-				update_data.state = instance.m_state;
-				update_data.environment = instance.m_environment;
-			}
-			lua_pop(instance.m_state, 1);
-			lua_getfield(instance.m_state, -1, "onInputEvent");
-			if (lua_type(instance.m_state, -1) == LUA_TFUNCTION)
-			{
-				auto& callback = m_input_handlers.emplace();
-				callback.script = instance.m_script;
-				callback.state = instance.m_state;
-				callback.environment = instance.m_environment;
-			}
-			lua_pop(instance.m_state, 1);
+			registerCallbacks(instance);
 
 			if (!is_reload)
 			{
@@ -1555,6 +2078,9 @@ namespace Lumix
 			m_gui_scene = nullptr;
 			m_scripts_start_called = false;
 			m_is_game_running = false;
+			for (const CallbackData& cb : m_updates) luaL_unref(cb.state, LUA_REGISTRYINDEX, cb.func);
+			for (const CallbackData& cb : m_input_handlers) luaL_unref(cb.state, LUA_REGISTRYINDEX, cb.func);
+			m_timers.cancelIf([](const LuaTimerWheel::Timer&){ return true; });
 			m_updates.clear();
 			m_input_handlers.clear();
 			m_timers.clear();
@@ -1576,6 +2102,271 @@ namespace Lumix
 			m_universe.onComponentDestroyed(entity, LUA_SCRIPT_TYPE, this);
 		}
 
+		void createJobScript(EntityRef entity) {
+			m_job_scripts.insert(entity, nullptr);
+			m_universe.onComponentCreated(entity, LUA_JOB_SCRIPT_TYPE, this);
+		}
+
+		void destroyJobScript(EntityRef entity) {
+			setJobScriptPath(entity, Path());
+			m_job_scripts.erase(entity);
+			m_universe.onComponentDestroyed(entity, LUA_JOB_SCRIPT_TYPE, this);
+		}
+
+		Path getJobScriptPath(EntityRef entity) override {
+			LuaScript* script = m_job_scripts[entity];
+			return script ? script->getPath() : Path();
+		}
+
+		void setJobScriptPath(EntityRef entity, const Path& path) override {
+			LuaScript*& script = m_job_scripts[entity];
+			if (script) {
+				releaseJobScript(*script);
+				script->decRefCount();
+			}
+			ResourceManagerHub& rm = m_system.m_engine.getResourceManager();
+			script = path.isEmpty() ? nullptr : rm.load<LuaScript>(path);
+			if (script) acquireJobScript(*script);
+		}
+
+		// the first user binds the observer, so inputs are parsed once per load no matter how many entities use the script
+		void acquireJobScript(LuaScript& script) {
+			auto iter = m_job_script_infos.find(&script);
+			if (iter.isValid()) {
+				++iter.value().users;
+				return;
+			}
+			m_job_script_infos.insert(&script, JobScriptInfo(m_system.m_allocator)).value().users = 1;
+			script.onLoaded<&LuaScriptSceneImpl::onJobScriptLoaded>(this);
+		}
+
+		void releaseJobScript(LuaScript& script) {
+			auto iter = m_job_script_infos.find(&script);
+			ASSERT(iter.isValid());
+			--iter.value().users;
+			if (iter.value().users > 0) return;
+			script.getObserverCb().unbind<&LuaScriptSceneImpl::onJobScriptLoaded>(this);
+			m_job_script_infos.erase(iter);
+		}
+
+		void onJobScriptLoaded(Resource::State, Resource::State new_state, Resource& resource) {
+			// job VMs recompile their scripts
+			++m_job_scripts_generation;
+			if (new_state == Resource::State::READY) parseJobInputs(static_cast<LuaScript&>(resource));
+		}
+
+		// job scripts can not look up components by name, reflection::getComponentType registers unknown names
+		void initJobComponents() {
+			if (!m_job_components.empty()) return;
+			for (const reflection::RegisteredComponent& c : reflection::getComponents()) {
+				if (c.cmp) m_job_components.insert(crc32(c.cmp->name), c.cmp);
+			}
+		}
+
+		// runs script's top level in a sandbox on the main thread to read its `inputs`
+		void parseJobInputs(LuaScript& script) {
+			PROFILE_FUNCTION();
+			initJobComponents();
+			auto iter = m_job_script_infos.find(&script);
+			ASSERT(iter.isValid());
+			Array<JobInput>& inputs = iter.value().inputs;
+			inputs.clear();
+
+			lua_State* L = m_system.m_engine.getState();
+			LuaWrapper::DebugGuard guard(L);
+			const char* src = script.getSourceCode();
+			lua_newtable(L); // [env]
+			lua_newtable(L); // [env, Job]
+			lua_setfield(L, -2, "Job"); // [env]
+			lua_newtable(L); // [env, meta]
+			lua_pushvalue(L, LUA_GLOBALSINDEX); // [env, meta, _G]
+			lua_setfield(L, -2, "__index"); // [env, meta]
+			lua_setmetatable(L, -2); // [env]
+			if (luaL_loadbuffer(L, src, stringLength(src), script.getPath().c_str()) != 0) { // [env, func] | [env, error]
+				logError(script.getPath(), ": ", lua_tostring(L, -1));
+				lua_pop(L, 2);
+				return;
+			}
+			lua_pushvalue(L, -2); // [env, func, env]
+			lua_setfenv(L, -2); // [env, func]
+			if (lua_pcall(L, 0, 0, 0) != 0) { // [env] | [env, error]
+				logError(script.getPath(), ": ", lua_tostring(L, -1));
+				lua_pop(L, 2);
+				return;
+			}
+			lua_getfield(L, -1, "inputs"); // [env, inputs]
+			if (lua_istable(L, -1)) {
+				for (int i = 1, c = (int)lua_objlen(L, -1); i <= c; ++i) {
+					lua_rawgeti(L, -1, i); // [env, inputs, input]
+					if (lua_type(L, -1) == LUA_TSTRING) parseJobInput(script, lua_tostring(L, -1), inputs);
+					lua_pop(L, 1); // [env, inputs]
+				}
+			}
+			lua_pop(L, 2); // []
+		}
+
+		void parseJobInput(LuaScript& script, const char* name, Array<JobInput>& inputs) {
+			const char* dot = name;
+			while (*dot && *dot != '.') ++dot;
+			if (!*dot) {
+				logError(script.getPath(), ": input `", name, "` is not in `component.property` format");
+				return;
+			}
+
+			JobInput input;
+			copyNString(Span(input.component.data), name, int(dot - name));
+			copyString(Span(input.property.data), dot + 1);
+			auto iter = m_job_components.find(crc32(input.component));
+			if (!iter.isValid()) {
+				logError(script.getPath(), ": unknown component ", input.component);
+				return;
+			}
+			JobPropertyFinder finder;
+			finder.prop_name = input.property;
+			iter.value()->visit(finder);
+			if (!finder.prop) {
+				logError(script.getPath(), ": property `", name, "` does not exist or is not accessible from jobs");
+				return;
+			}
+			input.cmp_type = iter.value()->component_type;
+			input.prop = finder.prop;
+			input.type = finder.type;
+			inputs.push(input);
+		}
+
+		JobValue readJobInput(const JobInput& input, EntityRef entity) {
+			JobValue v; // NONE if the entity does not have the component
+			if (!m_universe.hasComponent(entity, input.cmp_type)) return v;
+
+			const ComponentUID cmp = {entity, input.cmp_type, m_universe.getScene(input.cmp_type)};
+			const reflection::PropertyBase* p = input.prop;
+			v.type = input.type;
+			switch (input.type) {
+				case JobValue::FLOAT: v.f = JobVM::getValue<float>(p, cmp); break;
+				case JobValue::I32: v.i = JobVM::getValue<i32>(p, cmp); break;
+				case JobValue::U32: v.u = JobVM::getValue<u32>(p, cmp); break;
+				case JobValue::BOOL: v.b = JobVM::getValue<bool>(p, cmp); break;
+				case JobValue::ENTITY: v.i = JobVM::getValue<EntityPtr>(p, cmp).index; break;
+				case JobValue::VEC2: {
+					const Vec2 tmp = JobVM::getValue<Vec2>(p, cmp);
+					memcpy(v.v, &tmp, sizeof(tmp));
+					break;
+				}
+				case JobValue::VEC3: {
+					const Vec3 tmp = JobVM::getValue<Vec3>(p, cmp);
+					memcpy(v.v, &tmp, sizeof(tmp));
+					break;
+				}
+				case JobValue::VEC4: {
+					const Vec4 tmp = JobVM::getValue<Vec4>(p, cmp);
+					memcpy(v.v, &tmp, sizeof(tmp));
+					break;
+				}
+				case JobValue::NONE: ASSERT(false); break;
+			}
+			return v;
+		}
+
+		void snapshotJobScripts() {
+			PROFILE_FUNCTION();
+			m_job_snapshots.resize(m_job_scripts.size());
+			m_job_input_values.clear();
+			for (i32 i = 0, c = m_job_scripts.size(); i < c; ++i) {
+				LuaScript* script = m_job_scripts.at(i);
+				JobSnapshot& snapshot = m_job_snapshots[i];
+				auto iter = script ? m_job_script_infos.find(script) : m_job_script_infos.end();
+				snapshot.valid = script && script->isReady() && iter.isValid();
+				if (!snapshot.valid) continue;
+
+				const EntityRef e = m_job_scripts.getKey(i);
+				snapshot.transform = m_universe.getTransform(e);
+				snapshot.inputs = &iter.value().inputs;
+				snapshot.values_offset = m_job_input_values.size();
+				for (const JobInput& input : iter.value().inputs) {
+					m_job_input_values.push(readJobInput(input, e));
+				}
+			}
+		}
+
+		JobVM* acquireJobVM() {
+			MutexGuard lock(m_job_vms_mutex);
+			if (m_free_job_vms.empty()) {
+				JobVM* vm = LUMIX_NEW(m_system.m_allocator, JobVM)(*this, m_system.m_allocator);
+				m_job_vms.push(vm);
+				return vm;
+			}
+			JobVM* vm = m_free_job_vms.back();
+			m_free_job_vms.pop();
+			return vm;
+		}
+
+		void releaseJobVM(JobVM* vm) {
+			MutexGuard lock(m_job_vms_mutex);
+			m_free_job_vms.push(vm);
+		}
+
+		void applyJobCommands() {
+			PROFILE_FUNCTION();
+			u32 count = 0;
+			for (JobVM* vm : m_job_vms) {
+				for (const JobCommand& cmd : vm->m_commands) {
+					if (!m_universe.hasEntity(cmd.entity)) continue;
+					switch (cmd.type) {
+						case JobCommand::POSITION: m_universe.setPosition(cmd.entity, cmd.pos); break;
+						case JobCommand::ROTATION: m_universe.setRotation(cmd.entity, cmd.rot); break;
+						case JobCommand::SCALE: m_universe.setScale(cmd.entity, cmd.value.f); break;
+						case JobCommand::PROPERTY: applyJobProperty(cmd); break;
+					}
+				}
+				count += vm->m_commands.size();
+				vm->m_commands.clear();
+			}
+			profiler::pushInt("Commands", count);
+		}
+
+		template <typename T>
+		static void setJobProperty(const JobCommand& cmd, const ComponentUID& cmp, const T& value) {
+			static_cast<const reflection::Property<T>*>(cmd.prop)->set(cmp, -1, value);
+		}
+
+		void applyJobProperty(const JobCommand& cmd) {
+			if (!m_universe.hasComponent(cmd.entity, cmd.cmp_type)) return;
+			const ComponentUID cmp = {cmd.entity, cmd.cmp_type, m_universe.getScene(cmd.cmp_type)};
+			const JobValue& v = cmd.value;
+			switch (v.type) {
+				case JobValue::FLOAT: setJobProperty(cmd, cmp, v.f); break;
+				case JobValue::I32: setJobProperty(cmd, cmp, v.i); break;
+				case JobValue::U32: setJobProperty(cmd, cmp, v.u); break;
+				case JobValue::BOOL: setJobProperty(cmd, cmp, v.b); break;
+				case JobValue::ENTITY: setJobProperty(cmd, cmp, EntityPtr{v.i}); break;
+				case JobValue::VEC2: setJobProperty(cmd, cmp, Vec2(v.v[0], v.v[1])); break;
+				case JobValue::VEC3: setJobProperty(cmd, cmp, Vec3(v.v[0], v.v[1], v.v[2])); break;
+				case JobValue::VEC4: setJobProperty(cmd, cmp, Vec4(v.v[0], v.v[1], v.v[2], v.v[3])); break;
+				case JobValue::NONE: ASSERT(false); break;
+			}
+		}
+
+		// job scripts run in parallel, they read a snapshot of their entities taken at the beginning of this function
+		// and their writes are applied only after all of them are finished
+		void updateJobScripts(float time_delta) {
+			if (m_job_scripts.size() == 0) return;
+
+			PROFILE_FUNCTION();
+			profiler::pushInt("Job scripts", m_job_scripts.size());
+			initJobComponents();
+			snapshotJobScripts();
+			jobs::forEach(m_job_scripts.size(), 64, [&](i32 from, i32 to){
+				PROFILE_BLOCK("lua job scripts");
+				JobVM* vm = acquireJobVM();
+				for (i32 i = from; i < to; ++i) {
+					if (!m_job_snapshots[i].valid) continue;
+					vm->update(m_job_scripts.at(i), m_job_scripts.getKey(i), i, time_delta);
+				}
+				releaseJobVM(vm);
+			});
+			applyJobCommands();
+		}
+
 		template <typename T>
 		T getPropertyValue(EntityRef entity, int scr_index, const char* property_name) {
 			u32 hash = crc32(property_name);
@@ -1741,6 +2532,13 @@ namespace Lumix
 					}
 				}
 			}
+
+			serializer.write(m_job_scripts.size());
+			for (int i = 0, c = m_job_scripts.size(); i < c; ++i) {
+				LuaScript* script = m_job_scripts.at(i);
+				serializer.write(m_job_scripts.getKey(i));
+				serializer.writeString(script ? script->getPath().c_str() : "");
+			}
 		}
 
 
@@ -1791,6 +2589,19 @@ namespace Lumix
 				}
 				m_universe.onComponentCreated(script->m_entity, LUA_SCRIPT_TYPE, this);
 			}
+
+			if (version <= (i32)LuaSceneVersion::JOB_SCRIPTS) return;
+
+			const int job_scripts_count = serializer.read<int>();
+			for (int i = 0; i < job_scripts_count; ++i) {
+				EntityRef entity;
+				serializer.read(entity);
+				entity = entity_map.get(entity);
+				const char* path = serializer.readString();
+				m_job_scripts.insert(entity, nullptr);
+				setJobScriptPath(entity, Path(path));
+				m_universe.onComponentCreated(entity, LUA_JOB_SCRIPT_TYPE, this);
+			}
 		}
 
 
@@ -1821,40 +2632,21 @@ namespace Lumix
 
 		void updateTimers(float time_delta)
 		{
-			int timers_to_remove[1024];
-			u32 timers_to_remove_count = 0;
-			for (int i = 0, c = m_timers.size(); i < c; ++i)
-			{
-				auto& timer = m_timers[i];
-				timer.time -= time_delta;
-				if (timer.time < 0)
+			PROFILE_FUNCTION();
+			m_timers.advance(time_delta, [](const LuaTimerWheel::Timer& timer){
+				lua_rawgeti(timer.state, LUA_REGISTRYINDEX, timer.func);
+				if (lua_type(timer.state, -1) != LUA_TFUNCTION)
 				{
-					lua_rawgeti(timer.state, LUA_REGISTRYINDEX, timer.func);
-					if (lua_type(timer.state, -1) != LUA_TFUNCTION)
-					{
-						ASSERT(false);
-					}
+					ASSERT(false);
+				}
 
-					if (lua_pcall(timer.state, 0, 0, 0) != 0)
-					{
-						logError(lua_tostring(timer.state, -1));
-						lua_pop(timer.state, 1);
-					}
-					timers_to_remove[timers_to_remove_count] = i;
-					++timers_to_remove_count;
-					if (timers_to_remove_count >= lengthOf(timers_to_remove))
-					{
-						logError("Too many lua timers in one frame, some are not executed");
-						break;
-					}
+				if (lua_pcall(timer.state, 0, 0, 0) != 0)
+				{
+					logError(lua_tostring(timer.state, -1));
+					lua_pop(timer.state, 1);
 				}
-			}
-			for (u32 i = timers_to_remove_count - 1; i != 0xffFFffFF; --i)
-			{
-				auto& timer = m_timers[timers_to_remove[i]];
 				luaL_unref(timer.state, LUA_REGISTRYINDEX, timer.func);
-				m_timers.swapAndPop(timers_to_remove[i]);
-			}
+			});
 		}
 
 
@@ -1909,26 +2701,15 @@ namespace Lumix
 			}
 
 
-			lua_rawgeti(L, LUA_REGISTRYINDEX, callback.environment);
-			if (lua_type(L, -1) != LUA_TTABLE) // [lua_event, environment]
-			{
-				ASSERT(false);
-			}
-			lua_getfield(L, -1, "onInputEvent");
-			if (lua_type(L, -1) != LUA_TFUNCTION)  // [lua_event, environment, func]
-			{
-				lua_pop(L, 3); // []
-				return;
-			}
-
-			lua_pushvalue(L, -3); // [lua_event, environment, func, lua_event]
+			lua_rawgeti(L, LUA_REGISTRYINDEX, callback.func); // [lua_event, func]
+			lua_pushvalue(L, -2); // [lua_event, func, lua_event]
 			
-			if (lua_pcall(L, 1, 0, 0) != 0)// [lua_event, environment]
+			if (lua_pcall(L, 1, 0, 0) != 0)// [lua_event]
 			{
 				logError(lua_tostring(L, -1));
-				lua_pop(L, 1); // []
+				lua_pop(L, 1); // [lua_event]
 			}
-			lua_pop(L, 2); // []
+			lua_pop(L, 1); // []
 		}
 
 
@@ -1961,24 +2742,14 @@ namespace Lumix
 
 			for (int i = 0; i < m_updates.size(); ++i)
 			{
-				CallbackData update_item = m_updates[i];
+				const CallbackData update_item = m_updates[i];
 				LuaWrapper::DebugGuard guard(update_item.state, 0);
-				lua_rawgeti(update_item.state, LUA_REGISTRYINDEX, update_item.environment);
-				if (lua_type(update_item.state, -1) != LUA_TTABLE)
-				{
-					ASSERT(false);
-				}
-				lua_getfield(update_item.state, -1, "update");
-				if (lua_type(update_item.state, -1) != LUA_TFUNCTION)
-				{
-					lua_pop(update_item.state, 2);
-					continue;
-				}
-
+				lua_rawgeti(update_item.state, LUA_REGISTRYINDEX, update_item.func);
 				lua_pushnumber(update_item.state, time_delta);
 				LuaWrapper::pcall(update_item.state, 1, 0);
-				lua_pop(update_item.state, 1);
 			}
+
+			updateJobScripts(time_delta);
 		}
 
 
@@ -2100,7 +2871,7 @@ namespace Lumix
 		Array<CallbackData> m_input_handlers;
 		Universe& m_universe;
 		Array<CallbackData> m_updates;
-		Array<TimerData> m_timers;
+		LuaTimerWheel m_timers;
 		FunctionCall m_function_call;
 		ScriptInstance* m_current_script_instance;
 		bool m_scripts_start_called = false;
@@ -2108,6 +2879,15 @@ namespace Lumix
 		bool m_is_game_running = false;
 		GUIScene* m_gui_scene = nullptr;
 		AnimationScene* m_animation_scene;
+		AssociativeArray<EntityRef, LuaScript*> m_job_scripts;
+		Array<JobVM*> m_job_vms;
+		Array<JobVM*> m_free_job_vms;
+		Mutex m_job_vms_mutex;
+		u32 m_job_scripts_generation = 0;
+		HashMap<LuaScript*, JobScriptInfo> m_job_script_infos;
+		HashMap<u32, const reflection::ComponentBase*> m_job_components;
+		Array<JobSnapshot> m_job_snapshots;
+		Array<JobValue> m_job_input_values;
 	};
 
 	void LuaScriptSceneImpl::ScriptInstance::onScriptLoaded(LuaScriptSceneImpl& scene, struct ScriptComponent& cmp, int scr_index) {
@@ -2275,7 +3055,7 @@ namespace Lumix
 
 	LuaScriptSystemImpl::LuaScriptSystemImpl(Engine& engine)
 		: m_engine(engine)
-		, m_allocator(engine.getAllocator())
+		, m_allocator(engine.getAllocator(), "lua_script")
 		, m_script_manager(m_allocator)
 	{
 		m_script_manager.create(LuaScript::TYPE, engine.getResourceManager());
@@ -2286,7 +3066,9 @@ namespace Lumix
 				.prop<&LuaScriptScene::isScriptEnabled, &LuaScriptScene::enableScript>("Enabled")
 				.LUMIX_PROP(ScriptPath, "Path").resourceAttribute(LuaScript::TYPE)
 				.property<LuaProperties>()
-			.end_array();
+			.end_array()
+			.LUMIX_CMP(JobScript, "lua_job_script", "Lua job script")
+				.LUMIX_PROP(JobScriptPath, "Path").resourceAttribute(LuaScript::TYPE);
 	}
 
 	void LuaScriptSystemImpl::init() {
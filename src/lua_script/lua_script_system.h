@@ -78,6 +78,8 @@ struct LuaScriptScene : IScene
 	virtual const char* getPropertyName(EntityRef entity, int scr_index, int prop_index) = 0;
 	virtual Property::Type getPropertyType(EntityRef entity, int scr_index, int prop_index) = 0;
 	virtual ResourceType getPropertyResourceType(EntityRef entity, int scr_index, int prop_index) = 0;
+	virtual Path getJobScriptPath(EntityRef entity) = 0;
+	virtual void setJobScriptPath(EntityRef entity, const Path& path) = 0;
 };
 
 
@@ -2,7 +2,7 @@
 #include "engine/array.h"
 #include "engine/crt.h"
 #include "engine/geometry.h"
-#include "engine/hash_map.h"
+#include "engine/group_hash_map.h"
 #include "engine/allocator.h"
 #include "engine/atomic.h"
 #include "engine/job_system.h"
@@ -391,7 +391,7 @@ struct CullingSystemImpl final : CullingSystem
 
 	IAllocator& m_allocator;
 	PageAllocator& m_page_allocator;
-	HashMap<CellIndices, CellPage*, CellIndicesHasher> m_cell_map;
+	HashMap<CellIndices, CellPage*, CellIndicesHasher, GroupProbing> m_cell_map;
 	Array<CellPage*> m_cells;
 	Array<Sphere*> m_entity_to_cell;
 	float m_cell_size;
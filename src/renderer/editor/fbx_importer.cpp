@@ -616,6 +616,15 @@ const FBXImporter::ImportGeometry& FBXImporter::getImportGeometry(const ofbx::Ge
 	return m_geometries[0];
 }
 
+static void optimizeMesh(FBXImporter::ImportMesh& mesh, u32 vertex_size) {
+	u32* indices = (u32*)mesh.indices.begin();
+	const u32 index_count = mesh.indices.size();
+	const u32 vertex_count = u32(mesh.vertex_data.size() / vertex_size);
+	meshopt_optimizeVertexCache(indices, indices, index_count, vertex_count);
+	const size_t used_count = meshopt_optimizeVertexFetch(mesh.vertex_data.getMutableData(), indices, index_count, mesh.vertex_data.data(), vertex_count, vertex_size);
+	mesh.vertex_data.resize(used_count * vertex_size);
+}
+
 void FBXImporter::postprocessMeshes(const ImportConfig& cfg, const char* path)
 {
 	jobs::forEach(m_geometries.size(), 1, [&](i32 geom_idx, i32){
@@ -756,6 +765,8 @@ void FBXImporter::postprocessMeshes(const ImportConfig& cfg, const char* path)
 			}
 		}
 
+		if (!import_mesh.indices.empty()) optimizeMesh(import_mesh, vertex_size);
+
 		import_mesh.aabb = aabb;
 		import_mesh.origin_radius_squared = origin_radius_squared;
 		import_mesh.center_radius_squared = 0;
@@ -781,6 +792,147 @@ void FBXImporter::postprocessMeshes(const ImportConfig& cfg, const char* path)
 }
 
 
+void FBXImporter::generateLODs(const ImportConfig& cfg, const char* path)
+{
+	PROFILE_FUNCTION();
+	for (const ImportMesh& mesh : m_meshes) {
+		if (mesh.lod > 0) {
+			logWarning(path, " has authored LODs, automatic LODs are not generated");
+			return;
+		}
+	}
+
+	// last LOD slot is reserved for impostor
+	const u32 max_lods = cfg.create_impostor ? lengthOf(cfg.autolod_coefs) - 1 : lengthOf(cfg.autolod_coefs);
+	const u32 lod_count = minimum(cfg.autolod_count, max_lods);
+	const i32 src_count = m_meshes.size();
+	m_meshes.reserve(src_count * (lod_count + 1));
+	for (u32 lod = 1; lod <= lod_count; ++lod) {
+		for (i32 i = 0; i < src_count; ++i) {
+			const ImportMesh& src = m_meshes[i];
+			ImportMesh& mesh = m_meshes.emplace(m_allocator);
+			mesh.fbx = src.fbx;
+			mesh.fbx_mat = src.fbx_mat;
+			mesh.is_skinned = src.is_skinned;
+			mesh.bone_idx = src.bone_idx;
+			mesh.import = src.import;
+			mesh.lod = lod;
+			mesh.submesh = src.submesh;
+			mesh.aabb = src.aabb;
+			mesh.origin_radius_squared = src.origin_radius_squared;
+			mesh.center_radius_squared = src.center_radius_squared;
+			mesh.transform_matrix = src.transform_matrix;
+			mesh.origin = src.origin;
+		}
+	}
+
+	jobs::forEach(src_count * (i32)lod_count, 1, [&](i32 idx, i32){
+		ImportMesh& mesh = m_meshes[src_count + idx];
+		const ImportMesh& src = m_meshes[idx % src_count];
+		const u32 vertex_size = getVertexSize(*src.fbx->getGeometry(), src.is_skinned, cfg.import_vertex_colors);
+		const u32 vertex_count = u32(src.vertex_data.size() / vertex_size);
+		const float coef = cfg.autolod_coefs[mesh.lod - 1];
+		const float error = cfg.autolod_errors[mesh.lod - 1];
+		const size_t target_count = size_t(src.indices.size() * coef) / 3 * 3;
+		
+		mesh.indices.resize(src.indices.size());
+		// vertices are not modified, so skinning and attributes are preserved as they are
+		// position is the first attribute, simplifier uses only positions
+		size_t count = meshopt_simplify((u32*)mesh.indices.begin()
+			, (const u32*)src.indices.begin()
+			, src.indices.size()
+			, (const float*)src.vertex_data.data()
+			, vertex_count
+			, vertex_size
+			, target_count
+			, error);
+		
+		if (count > target_count * 2) {
+			// topology prevents simplification (e.g. lots of seams), ignore topology
+			count = meshopt_simplifySloppy((u32*)mesh.indices.begin()
+				, (const u32*)src.indices.begin()
+				, src.indices.size()
+				, (const float*)src.vertex_data.data()
+				, vertex_count
+				, vertex_size
+				, target_count);
+		}
+		mesh.indices.resize((i32)count);
+		if (count == 0) {
+			mesh.import = false;
+			return;
+		}
+
+		mesh.vertex_data.write(src.vertex_data.data(), src.vertex_data.size());
+		optimizeMesh(mesh, vertex_size);
+	});
+
+	for (i32 i = m_meshes.size() - 1; i >= src_count; --i) {
+		if (m_meshes[i].indices.empty()) m_meshes.swapAndPop(i);
+	}
+
+	for (u32 lod = 0; lod <= lod_count; ++lod) {
+		u32 tri_count = 0;
+		for (const ImportMesh& mesh : m_meshes) {
+			if (mesh.lod == lod && mesh.import) tri_count += mesh.indices.size() / 3;
+		}
+		logInfo(path, ": LOD ", lod, " - ", tri_count, " triangles");
+	}
+}
+
+
+void FBXImporter::buildClusters(const ImportConfig& cfg)
+{
+	PROFILE_FUNCTION();
+	// small meshes are cheaper to draw whole than to cull
+	static constexpr u32 MIN_TRIANGLES = 4096;
+	static constexpr u32 MAX_VERTICES = 64;
+	static constexpr u32 MAX_TRIANGLES = 124;
+
+	jobs::forEach(m_meshes.size(), 1, [&](i32 mesh_idx, i32){
+		ImportMesh& mesh = m_meshes[mesh_idx];
+		mesh.clusters.clear();
+		// skinned meshes move, bind pose bounds are useless
+		if (!mesh.import || mesh.is_skinned) return;
+		if (mesh.indices.size() / 3 < (i32)MIN_TRIANGLES) return;
+
+		const u32 vertex_size = getVertexSize(*mesh.fbx->getGeometry(), mesh.is_skinned, cfg.import_vertex_colors);
+		const u32 vertex_count = u32(mesh.vertex_data.size() / vertex_size);
+		const u32* indices = (const u32*)mesh.indices.begin();
+		const u32 index_count = mesh.indices.size();
+
+		Array<meshopt_Meshlet> meshlets(m_allocator);
+		meshlets.resize((u32)meshopt_buildMeshletsBound(index_count, MAX_VERTICES, MAX_TRIANGLES));
+		const u32 meshlet_count = (u32)meshopt_buildMeshlets(meshlets.begin(), indices, index_count, vertex_count, MAX_VERTICES, MAX_TRIANGLES);
+
+		// reorder triangles so each meshlet is a continuous range in index buffer
+		Array<int> new_indices(m_allocator);
+		new_indices.reserve(index_count);
+		mesh.clusters.reserve(meshlet_count);
+		for (u32 i = 0; i < meshlet_count; ++i) {
+			const meshopt_Meshlet& meshlet = meshlets[i];
+			const meshopt_Bounds bounds = meshopt_computeMeshletBounds(&meshlet, (const float*)mesh.vertex_data.data(), vertex_count, vertex_size);
+
+			ImportCluster& cluster = mesh.clusters.emplace();
+			cluster.center = Vec3(bounds.center[0], bounds.center[1], bounds.center[2]);
+			cluster.radius = bounds.radius;
+			cluster.cone_axis = Vec3(bounds.cone_axis[0], bounds.cone_axis[1], bounds.cone_axis[2]);
+			cluster.cone_cutoff = bounds.cone_cutoff;
+			cluster.indices_offset = new_indices.size();
+			cluster.indices_count = meshlet.triangle_count * 3;
+
+			for (u32 t = 0; t < meshlet.triangle_count; ++t) {
+				new_indices.push(meshlet.vertices[meshlet.indices[t][0]]);
+				new_indices.push(meshlet.vertices[meshlet.indices[t][1]]);
+				new_indices.push(meshlet.vertices[meshlet.indices[t][2]]);
+			}
+		}
+		ASSERT(new_indices.size() == (i32)index_count);
+		memcpy(mesh.indices.begin(), new_indices.begin(), new_indices.byte_size());
+	});
+}
+
+
 static int detectMeshLOD(const FBXImporter::ImportMesh& mesh)
 {
 	const char* node_name = mesh.fbx->name;
@@ -1822,14 +1974,69 @@ void FBXImporter::writeImpostorVertices(const AABB& aabb)
 		{{center.x + max.x, center.y + min.y, center.z},	{128, 255, 128, 0},	 {255, 128, 128, 0}, {1, 0}}
 	};
 
-	const u32 vertex_data_size = sizeof(vertices);
-	write(vertex_data_size);
-	for (const Vertex& vertex : vertices) {
-		write(vertex.pos);
-		write(vertex.normal);
-		write(vertex.tangent);
-		write(vertex.uv);
+	writeEncodedVertices((const u8*)vertices, sizeof(vertices), sizeof(vertices[0]));
+}
+
+
+void FBXImporter::writeEncodedIndices(const u32* indices, u32 count, u32 vertex_count, bool is_16bit)
+{
+	const i32 index_size = is_16bit ? sizeof(u16) : sizeof(u32);
+	write(index_size);
+	write((i32)count);
+	
+	Array<u8> encoded(m_allocator);
+	encoded.resize((i32)meshopt_encodeIndexBufferBound(count, vertex_count));
+	const u32 encoded_size = (u32)meshopt_encodeIndexBuffer(encoded.begin(), encoded.size(), indices, count);
+	write(encoded_size);
+	write(encoded.begin(), encoded_size);
+}
+
+
+void FBXImporter::writeEncodedVertices(const u8* vertices, u32 size, u32 vertex_size)
+{
+	ASSERT(vertex_size % 4 == 0);
+	const u32 vertex_count = size / vertex_size;
+	write((i32)size);
+
+	Array<u8> encoded(m_allocator);
+	encoded.resize((i32)meshopt_encodeVertexBufferBound(vertex_count, vertex_size));
+	const u32 encoded_size = (u32)meshopt_encodeVertexBuffer(encoded.begin(), encoded.size(), vertices, vertex_count, vertex_size);
+	write(encoded_size);
+	write(encoded.begin(), encoded_size);
+}
+
+
+void FBXImporter::writeIndices(const ImportMesh& mesh, const ImportConfig& cfg)
+{
+	const u32 vertex_size = getVertexSize(*mesh.fbx->getGeometry(), mesh.is_skinned, cfg.import_vertex_colors);
+	const u32 vertex_count = u32(mesh.vertex_data.size() / vertex_size);
+	writeEncodedIndices((const u32*)mesh.indices.begin(), mesh.indices.size(), vertex_count, areIndices16Bit(mesh, cfg.import_vertex_colors));
+}
+
+
+void FBXImporter::writeVertices(const ImportMesh& mesh, const ImportConfig& cfg)
+{
+	const u32 vertex_size = getVertexSize(*mesh.fbx->getGeometry(), mesh.is_skinned, cfg.import_vertex_colors);
+	if (!cfg.quantize_positions) {
+		writeEncodedVertices(mesh.vertex_data.data(), (u32)mesh.vertex_data.size(), vertex_size);
+		return;
+	}
+
+	// position is the first attribute, replace 3 floats with 4 halfs to keep 4B alignment
+	const u32 vertex_count = u32(mesh.vertex_data.size() / vertex_size);
+	const u32 quantized_size = vertex_size - sizeof(Vec3) + sizeof(u16) * 4;
+	OutputMemoryStream quantized(m_allocator);
+	quantized.reserve(quantized_size * vertex_count);
+	const u8* src = mesh.vertex_data.data();
+	for (u32 i = 0; i < vertex_count; ++i) {
+		Vec3 pos;
+		memcpy(&pos, src, sizeof(pos));
+		const u16 halfs[4] = { meshopt_quantizeHalf(pos.x), meshopt_quantizeHalf(pos.y), meshopt_quantizeHalf(pos.z), 0 };
+		quantized.write(halfs, sizeof(halfs));
+		quantized.write(src + sizeof(pos), vertex_size - sizeof(pos));
+		src += vertex_size;
 	}
+	writeEncodedVertices(quantized.data(), (u32)quantized.size(), quantized_size);
 }
 
 
@@ -1840,31 +2047,11 @@ void FBXImporter::writeGeometry(int mesh_idx, const ImportConfig& cfg)
 	OutputMemoryStream vertices_blob(m_allocator);
 	const ImportMesh& import_mesh = m_meshes[mesh_idx];
 	
-	bool are_indices_16_bit = areIndices16Bit(import_mesh, cfg.import_vertex_colors);
-	if (are_indices_16_bit)
-	{
-		int index_size = sizeof(u16);
-		write(index_size);
-		write(import_mesh.indices.size());
-		for (int i : import_mesh.indices)
-		{
-			ASSERT(i <= (1 << 16));
-			u16 index = (u16)i;
-			write(index);
-		}
-	}
-	else
-	{
-		int index_size = sizeof(import_mesh.indices[0]);
-		write(index_size);
-		write(import_mesh.indices.size());
-		write(&import_mesh.indices[0], sizeof(import_mesh.indices[0]) * import_mesh.indices.size());
-	}
+	writeIndices(import_mesh, cfg);
 	origin_radius_squared = maximum(origin_radius_squared, import_mesh.origin_radius_squared);
 	center_radius_squared = maximum(center_radius_squared, import_mesh.center_radius_squared);
 
-	write((i32)import_mesh.vertex_data.size());
-	write(import_mesh.vertex_data.data(), import_mesh.vertex_data.size());
+	writeVertices(import_mesh, cfg);
 
 	write(sqrtf(origin_radius_squared));
 	write(sqrtf(center_radius_squared));
@@ -1881,45 +2068,21 @@ void FBXImporter::writeGeometry(const ImportConfig& cfg)
 	for (const ImportMesh& import_mesh : m_meshes)
 	{
 		if (!import_mesh.import) continue;
-		bool are_indices_16_bit = areIndices16Bit(import_mesh, cfg.import_vertex_colors);
-		if (are_indices_16_bit)
-		{
-			int index_size = sizeof(u16);
-			write(index_size);
-			write(import_mesh.indices.size());
-			for (int i : import_mesh.indices)
-			{
-				ASSERT(i <= (1 << 16));
-				u16 index = (u16)i;
-				write(index);
-			}
-		}
-		else
-		{
-			int index_size = sizeof(import_mesh.indices[0]);
-			write(index_size);
-			write(import_mesh.indices.size());
-			write(&import_mesh.indices[0], sizeof(import_mesh.indices[0]) * import_mesh.indices.size());
-		}
+		writeIndices(import_mesh, cfg);
 		aabb.merge(import_mesh.aabb);
 		origin_radius_squared = maximum(origin_radius_squared, import_mesh.origin_radius_squared);
 		center_radius_squared = maximum(center_radius_squared, import_mesh.center_radius_squared);
 	}
 
 	if (cfg.create_impostor) {
-		const int index_size = sizeof(u16);
-		write(index_size);
-		const u16 indices[] = {0, 1, 2, 0, 2, 3};
-		const u32 len = lengthOf(indices);
-		write(len);
-		write(indices, sizeof(indices));
+		const u32 indices[] = {0, 1, 2, 0, 2, 3};
+		writeEncodedIndices(indices, lengthOf(indices), 4, true);
 	}
 
 	for (const ImportMesh& import_mesh : m_meshes)
 	{
 		if (!import_mesh.import) continue;
-		write((i32)import_mesh.vertex_data.size());
-		write(import_mesh.vertex_data.data(), import_mesh.vertex_data.size());
+		writeVertices(import_mesh, cfg);
 	}
 	if (cfg.create_impostor) {
 		writeImpostorVertices(aabb);
@@ -1986,8 +2149,14 @@ void FBXImporter::writeMeshes(const char* src, int mesh_idx, const ImportConfig&
 		write(attribute_count);
 
 		write(Mesh::AttributeSemantic::POSITION);
-		write(gpu::AttributeType::FLOAT);
-		write((u8)3);
+		if (cfg.quantize_positions) {
+			write(gpu::AttributeType::HALF);
+			write((u8)4);
+		}
+		else {
+			write(gpu::AttributeType::FLOAT);
+			write((u8)3);
+		}
 		write(Mesh::AttributeSemantic::NORMAL);
 		write(gpu::AttributeType::I8);
 		write((u8)4);
@@ -2120,6 +2289,26 @@ void FBXImporter::writeLODs(const ImportConfig& cfg)
 }
 
 
+void FBXImporter::writeClusters(i32 mesh_idx, const ImportConfig& cfg)
+{
+	static_assert(sizeof(ImportCluster) == sizeof(Mesh::Cluster), "cluster layout mismatch");
+	auto writeMeshClusters = [&](const ImportMesh& mesh){
+		write(mesh.clusters.size());
+		if (!mesh.clusters.empty()) write(mesh.clusters.begin(), mesh.clusters.byte_size());
+	};
+
+	if (mesh_idx >= 0) {
+		writeMeshClusters(m_meshes[mesh_idx]);
+		return;
+	}
+
+	for (const ImportMesh& mesh : m_meshes) {
+		if (mesh.import) writeMeshClusters(mesh);
+	}
+	if (cfg.create_impostor) write((u32)0);
+}
+
+
 int FBXImporter::getAttributeCount(const ImportMesh& mesh, bool import_vertex_colors) const
 {
 	int count = 2; // position & normals
@@ -2250,6 +2439,7 @@ void FBXImporter::writeSubmodels(const char* src, const ImportConfig& cfg)
 {
 	PROFILE_FUNCTION();
 	postprocessMeshes(cfg, src);
+	if (cfg.meshlets) buildClusters(cfg);
 
 	for (int i = 0; i < m_meshes.size(); ++i) {
 		char name[256];
@@ -2276,6 +2466,8 @@ void FBXImporter::writeSubmodels(const char* src, const ImportConfig& cfg)
 		write(to_mesh);
 		write(factor);
 
+		writeClusters(i, cfg);
+
 		StaticString<LUMIX_MAX_PATH> resource_locator(name, ".fbx:", src);
 
 		m_compiler.writeCompiledResource(resource_locator, Span(out_file.data(), (i32)out_file.size()));
@@ -2287,6 +2479,8 @@ void FBXImporter::writeModel(const char* src, const ImportConfig& cfg)
 {
 	PROFILE_FUNCTION();
 	postprocessMeshes(cfg, src);
+	if (cfg.autolod_count > 0) generateLODs(cfg, src);
+	if (cfg.meshlets) buildClusters(cfg);
 
 	auto cmpMeshes = [](const void* a, const void* b) -> int {
 		auto a_mesh = static_cast<const ImportMesh*>(a);
@@ -2307,6 +2501,7 @@ void FBXImporter::writeModel(const char* src, const ImportConfig& cfg)
 	writeGeometry(cfg);
 	writeSkeleton(cfg);
 	writeLODs(cfg);
+	writeClusters(-1, cfg);
 
 	m_compiler.writeCompiledResource(src, Span(out_file.data(), (i32)out_file.size()));
 }
@@ -34,8 +34,13 @@ struct FBXImporter
 		bool create_impostor = false;
 		bool mikktspace_tangents = false;
 		bool import_vertex_colors = true;
+		bool quantize_positions = false;
+		bool meshlets = false; // split big static meshes to clusters, which can be culled separately
 		Physics physics = Physics::NONE;
 		float lods_distances[4] = {-10, -100, -1000, -10000};
+		u32 autolod_count = 0; // number of LODs generated from LOD0, 0 == use only authored LODs
+		float autolod_coefs[3] = {0.5f, 0.25f, 0.125f}; // target triangle ratio of each generated LOD
+		float autolod_errors[3] = {0.01f, 0.02f, 0.05f}; // max error of each generated LOD, relative to mesh extents
 		float position_error = 0.02f;
 		float rotation_error = 0.001f;
 		float radius_scale = 1.f;
@@ -119,11 +124,23 @@ struct FBXImporter
 		u32 unique_vertex_count;
 	};
 
+	// same layout as Mesh::Cluster
+	struct ImportCluster
+	{
+		Vec3 center;
+		float radius;
+		Vec3 cone_axis;
+		float cone_cutoff;
+		u32 indices_offset;
+		u32 indices_count;
+	};
+
 	struct ImportMesh
 	{
 		ImportMesh(IAllocator& allocator)
 			: vertex_data(allocator)
 			, indices(allocator)
+			, clusters(allocator)
 		{
 		}
 
@@ -136,6 +153,7 @@ struct FBXImporter
 		int submesh = -1;
 		OutputMemoryStream vertex_data;
 		Array<int> indices;
+		Array<ImportCluster> clusters;
 		AABB aabb;
 		float origin_radius_squared;
 		float center_radius_squared;
@@ -172,6 +190,8 @@ private:
 	void gatherAnimations(const ofbx::IScene& scene);
 	void writePackedVec3(const ofbx::Vec3& vec, const Matrix& mtx, OutputMemoryStream* blob) const;
 	void postprocessMeshes(const ImportConfig& cfg, const char* path);
+	void generateLODs(const ImportConfig& cfg, const char* path);
+	void buildClusters(const ImportConfig& cfg);
 	void gatherMeshes(ofbx::IScene* scene);
 	void gatherGeometries(ofbx::IScene* scene);
 	void insertHierarchy(Array<const ofbx::Object*>& bones, const ofbx::Object* node);
@@ -184,12 +204,17 @@ private:
 	Vec3 fixOrientation(const Vec3& v) const;
 	Quat fixOrientation(const Quat& v) const;
 	void writeImpostorVertices(const AABB& aabb);
+	void writeEncodedIndices(const u32* indices, u32 count, u32 vertex_count, bool is_16bit);
+	void writeEncodedVertices(const u8* vertices, u32 size, u32 vertex_size);
+	void writeIndices(const ImportMesh& mesh, const ImportConfig& cfg);
+	void writeVertices(const ImportMesh& mesh, const ImportConfig& cfg);
 	void writeGeometry(const ImportConfig& cfg);
 	void writeGeometry(int mesh_idx, const ImportConfig& cfg);
 	void writeImpostorMesh(const char* dir, const char* model_name);
 	void writeMeshes(const char* src, int mesh_idx, const ImportConfig& cfg);
 	void writeSkeleton(const ImportConfig& cfg);
 	void writeLODs(const ImportConfig& cfg);
+	void writeClusters(i32 mesh_idx, const ImportConfig& cfg);
 	int getAttributeCount(const ImportMesh& mesh, bool import_vertex_colors) const;
 	bool areIndices16Bit(const ImportMesh& mesh, bool import_vertex_colors) const;
 	void writeModelHeader();
@@ -221,6 +221,11 @@ void GameView::onStatsGUI(const ImVec2& view_pos)
 		char buf[30];
 		toCStringPretty(stats.triangle_count, Span(buf));
 		ImGui::LabelText("Triangles", "%s", buf);
+		toCStringPretty(stats.culled_triangle_count, Span(buf));
+		ImGui::LabelText("Culled triangles", "%s", buf);
+		ImGui::LabelText("Clustered lights", "%u", stats.clustered_lights_count);
+		ImGui::LabelText("Cluster links", "%u", stats.cluster_links_count);
+		ImGui::LabelText("Fill clusters", "%.2f ms", stats.fill_clusters_time * 1000.f);
 		ImGui::LabelText("Resolution", "%dx%d", (int)m_size.x, (int)m_size.y);
 	}
 	ImGui::End();
@@ -1631,7 +1631,12 @@ struct ModelPlugin final : AssetBrowser::IPlugin, AssetCompiler::IPlugin
 		bool use_mikktspace = false;
 		bool force_skin = false;
 		bool import_vertex_colors = false;
+		bool quantize_positions = false;
+		bool meshlets = false;
 		float lods_distances[4] = { -1, -1, -1, -1 };
+		u32 autolod_count = 0;
+		float autolod_coefs[3] = { 0.5f, 0.25f, 0.125f };
+		float autolod_errors[3] = { 0.01f, 0.02f, 0.05f };
 		float position_error = 0.02f;
 		float rotation_error = 0.001f;
 		FBXImporter::ImportConfig::Origin origin = FBXImporter::ImportConfig::Origin::SOURCE;
@@ -1684,6 +1689,8 @@ struct ModelPlugin final : AssetBrowser::IPlugin, AssetCompiler::IPlugin
 			LuaWrapper::getOptionalField(L, LUA_GLOBALSINDEX, "split", &meta.split);
 			LuaWrapper::getOptionalField(L, LUA_GLOBALSINDEX, "create_impostor", &meta.create_impostor);
 			LuaWrapper::getOptionalField(L, LUA_GLOBALSINDEX, "import_vertex_colors", &meta.import_vertex_colors);
+			LuaWrapper::getOptionalField(L, LUA_GLOBALSINDEX, "quantize_positions", &meta.quantize_positions);
+			LuaWrapper::getOptionalField(L, LUA_GLOBALSINDEX, "meshlets", &meta.meshlets);
 			
 			char tmp[64];
 			if (LuaWrapper::getOptionalStringField(L, LUA_GLOBALSINDEX, "physics", Span(tmp))) {
@@ -1696,6 +1703,12 @@ struct ModelPlugin final : AssetBrowser::IPlugin, AssetCompiler::IPlugin
 			for (u32 i = 0; i < lengthOf(meta.lods_distances); ++i) {
 				LuaWrapper::getOptionalField(L, LUA_GLOBALSINDEX, StaticString<32>("lod", i, "_distance"), &meta.lods_distances[i]);
 			}
+
+			LuaWrapper::getOptionalField(L, LUA_GLOBALSINDEX, "autolod_count", &meta.autolod_count);
+			for (u32 i = 0; i < lengthOf(meta.autolod_coefs); ++i) {
+				LuaWrapper::getOptionalField(L, LUA_GLOBALSINDEX, StaticString<32>("autolod_coef", i), &meta.autolod_coefs[i]);
+				LuaWrapper::getOptionalField(L, LUA_GLOBALSINDEX, StaticString<32>("autolod_error", i), &meta.autolod_errors[i]);
+			}
 		});
 		return meta;
 	}
@@ -1768,7 +1781,12 @@ struct ModelPlugin final : AssetBrowser::IPlugin, AssetCompiler::IPlugin
 		cfg.radius_scale = meta.culling_scale;
 		cfg.physics = meta.physics;
 		cfg.import_vertex_colors = meta.import_vertex_colors;
+		cfg.quantize_positions = meta.quantize_positions;
+		cfg.meshlets = meta.meshlets;
 		memcpy(cfg.lods_distances, meta.lods_distances, sizeof(meta.lods_distances));
+		cfg.autolod_count = meta.autolod_count;
+		memcpy(cfg.autolod_coefs, meta.autolod_coefs, sizeof(meta.autolod_coefs));
+		memcpy(cfg.autolod_errors, meta.autolod_errors, sizeof(meta.autolod_errors));
 		cfg.create_impostor = meta.create_impostor;
 		const PathInfo src_info(filepath);
 		m_fbx_importer.setSource(filepath, false, meta.force_skin);
@@ -2220,6 +2238,10 @@ struct ModelPlugin final : AssetBrowser::IPlugin, AssetCompiler::IPlugin
 			ImGui::Checkbox("##creimp", &m_meta.create_impostor);
 			ImGuiEx::Label("Import vertex colors");
 			ImGui::Checkbox("##vercol", &m_meta.import_vertex_colors);
+			ImGuiEx::Label("Quantize positions");
+			ImGui::Checkbox("##quantpos", &m_meta.quantize_positions);
+			ImGuiEx::Label("Meshlets");
+			ImGui::Checkbox("##meshlets", &m_meta.meshlets);
 			
 			ImGuiEx::Label("Physics");
 			if (ImGui::BeginCombo("##phys", toString(m_meta.physics))) {
@@ -2242,6 +2264,15 @@ struct ModelPlugin final : AssetBrowser::IPlugin, AssetCompiler::IPlugin
 					ImGui::DragFloat(StaticString<32>("##lod", i), &m_meta.lods_distances[i]);
 				}
 			}
+
+			ImGuiEx::Label("Generated LODs");
+			ImGui::SliderInt("##autolod_count", (int*)&m_meta.autolod_count, 0, lengthOf(m_meta.autolod_coefs));
+			for (u32 i = 0; i < m_meta.autolod_count; ++i) {
+				ImGuiEx::Label(StaticString<32>("LOD ", i + 1, " triangles ratio"));
+				ImGui::SliderFloat(StaticString<32>("##autolod_coef", i), &m_meta.autolod_coefs[i], 0, 1);
+				ImGuiEx::Label(StaticString<32>("LOD ", i + 1, " max error"));
+				ImGui::InputFloat(StaticString<32>("##autolod_error", i), &m_meta.autolod_errors[i]);
+			}
 			
 			if (ImGui::Button(ICON_FA_CHECK "Apply")) {
 				String src(m_app.getAllocator());
@@ -2254,7 +2285,9 @@ struct ModelPlugin final : AssetBrowser::IPlugin, AssetCompiler::IPlugin
 					.cat("\nscale = ").cat(m_meta.scale)
 					.cat("\nculling_scale = ").cat(m_meta.culling_scale)
 					.cat("\nsplit = ").cat(m_meta.split ? "true\n" : "false\n")
-					.cat("\nimport_vertex_colors = ").cat(m_meta.import_vertex_colors ? "true\n" : "false\n");
+					.cat("\nimport_vertex_colors = ").cat(m_meta.import_vertex_colors ? "true\n" : "false\n")
+					.cat("\nquantize_positions = ").cat(m_meta.quantize_positions ? "true\n" : "false\n")
+					.cat("\nmeshlets = ").cat(m_meta.meshlets ? "true\n" : "false\n");
 
 				for (u32 i = 0; i < lengthOf(m_meta.lods_distances); ++i) {
 					if (m_meta.lods_distances[i] > 0) {
@@ -2262,6 +2295,12 @@ struct ModelPlugin final : AssetBrowser::IPlugin, AssetCompiler::IPlugin
 					}
 				}
 
+				src.cat("autolod_count = ").cat(m_meta.autolod_count).cat("\n");
+				for (u32 i = 0; i < lengthOf(m_meta.autolod_coefs); ++i) {
+					src.cat("autolod_coef").cat(i).cat(" = ").cat(m_meta.autolod_coefs[i]).cat("\n");
+					src.cat("autolod_error").cat(i).cat(" = ").cat(m_meta.autolod_errors[i]).cat("\n");
+				}
+
 				compiler.updateMeta(model->getPath(), src.c_str());
 			}
 			ImGui::SameLine();
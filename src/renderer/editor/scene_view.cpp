@@ -1291,6 +1291,11 @@ void SceneView::statsUI(float x, float y) {
 		char buf[30];
 		toCStringPretty(stats.triangle_count, Span(buf));
 		ImGui::LabelText("Triangles (scene view only)", "%s", buf);
+		toCStringPretty(stats.culled_triangle_count, Span(buf));
+		ImGui::LabelText("Culled triangles (scene view only)", "%s", buf);
+		ImGui::LabelText("Clustered lights (scene view only)", "%u", stats.clustered_lights_count);
+		ImGui::LabelText("Cluster links (scene view only)", "%u", stats.cluster_links_count);
+		ImGui::LabelText("Fill clusters (scene view only)", "%.2f ms", stats.fill_clusters_time * 1000.f);
 		ImGui::LabelText("Resolution", "%dx%d", m_width, m_height);
 	}
 	ImGui::End();
@@ -17,6 +17,7 @@
 #include "engine/prefab.h"
 #include "engine/profiler.h"
 #include "engine/resource_manager.h"
+#include "engine/stream.h"
 #include "engine/universe.h"
 #include "physics/physics_scene.h"
 #include "renderer/culling_system.h"
@@ -126,6 +127,26 @@ struct PaintTerrainCommand final : IEditorCommand
 	}
 
 
+	void releasePayload(OutputMemoryStream& blob) override
+	{
+		blob.write(m_new_data.size());
+		blob.write(m_new_data.begin(), m_new_data.byte_size());
+		blob.write(m_old_data.size());
+		blob.write(m_old_data.begin(), m_old_data.byte_size());
+		m_new_data.free();
+		m_old_data.free();
+	}
+
+
+	void restorePayload(InputMemoryStream& blob) override
+	{
+		m_new_data.resize(blob.read<u32>());
+		blob.read(m_new_data.begin(), m_new_data.byte_size());
+		m_old_data.resize(blob.read<u32>());
+		blob.read(m_old_data.begin(), m_old_data.byte_size());
+	}
+
+
 	bool merge(IEditorCommand& command) override
 	{
 		if (!m_can_be_merged)
@@ -482,6 +503,9 @@ private:
 
 		if (m_action_type != TerrainEditor::LAYER && m_action_type != TerrainEditor::REMOVE_GRASS)
 		{
+			RenderScene* render_scene = (RenderScene*)m_world_editor.getUniverse()->getScene(TERRAIN_TYPE);
+			render_scene->getTerrain(m_terrain)->updateHeightTree(m_x, m_y, m_width, m_height);
+
 			IScene* scene = m_world_editor.getUniverse()->getScene(crc32("physics"));
 			if (!scene) return;
 
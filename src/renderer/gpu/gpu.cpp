@@ -426,6 +426,7 @@ int getSize(AttributeType type)
 		case AttributeType::I8: return 1;
 		case AttributeType::U8: return 1;
 		case AttributeType::I16: return 2;
+		case AttributeType::HALF: return 2;
 		default: ASSERT(false); return 0;
 	}
 }
@@ -475,6 +476,7 @@ static void setVAO(const VertexDecl& decl) {
 			case AttributeType::FLOAT: gl_attr_type = GL_FLOAT; break;
 			case AttributeType::I8: gl_attr_type = GL_BYTE; break;
 			case AttributeType::U8: gl_attr_type = GL_UNSIGNED_BYTE; break;
+			case AttributeType::HALF: gl_attr_type = GL_HALF_FLOAT; break;
 			default: ASSERT(false); break;
 		}
 
@@ -107,7 +107,8 @@ enum class AttributeType : u8 {
 	U8,
 	FLOAT,
 	I16,
-	I8
+	I8,
+	HALF
 };
 
 
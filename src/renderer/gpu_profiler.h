@@ -0,0 +1,207 @@
+#pragma once
+
+#include "engine/array.h"
+#include "engine/log.h"
+#include "engine/os.h"
+#include "engine/profiler.h"
+#include "engine/string.h"
+#include "engine/sync.h"
+#include "renderer/gpu/gpu.h"
+
+
+namespace Lumix
+{
+
+
+// query calls go through this table, so the bookkeeping can run against a stub backend without a device
+struct GPUQueryBackend
+{
+	gpu::QueryHandle (*createQuery)() = &gpu::createQuery;
+	void (*destroyQuery)(gpu::QueryHandle) = [](gpu::QueryHandle q) { gpu::destroy(q); };
+	void (*queryTimestamp)(gpu::QueryHandle) = &gpu::queryTimestamp;
+	bool (*isQueryReady)(gpu::QueryHandle) = &gpu::isQueryReady;
+	u64 (*getQueryResult)(gpu::QueryHandle) = &gpu::getQueryResult;
+	u64 (*getQueryFrequency)() = &gpu::getQueryFrequency;
+};
+
+
+struct GPUProfiler
+{
+	struct Query
+	{
+		StaticString<32> name;
+		gpu::QueryHandle handle;
+		i64 profiler_link;
+		bool is_end;
+	};
+
+	// queries recorded during one CPU frame, resolved together once the GPU is done with them
+	struct FrameQueries
+	{
+		FrameQueries(IAllocator& allocator) : queries(allocator) {}
+		Array<Query> queries;
+		u32 frames = 0;
+	};
+
+	static constexpr u32 MAX_FRAMES_IN_FLIGHT = 8;
+
+
+	GPUProfiler(IAllocator& allocator, const GPUQueryBackend& backend = GPUQueryBackend()) 
+		: m_frames(allocator)
+		, m_pool(allocator)
+		, m_handles(allocator)
+		, m_backend(backend)
+		, m_gpu_to_cpu_offset(0)
+	{
+		m_frames.reserve(MAX_FRAMES_IN_FLIGHT);
+		for (u32 i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
+			m_frames.emplace(allocator);
+		}
+	}
+
+
+	~GPUProfiler()
+	{
+		ASSERT(m_pool.empty());
+		for (const FrameQueries& f : m_frames) {
+			ASSERT(f.queries.empty());
+		}
+	}
+
+
+	u64 toCPUTimestamp(u64 gpu_timestamp) const
+	{
+		return u64(gpu_timestamp * m_gpu_to_cpu_scale) + m_gpu_to_cpu_offset;
+	}
+
+
+	void init()
+	{
+		m_gpu_to_cpu_scale = os::Timer::getFrequency() / double(m_backend.getQueryFrequency());
+
+		gpu::QueryHandle q = m_backend.createQuery();
+		m_backend.queryTimestamp(q);
+		const u64 cpu_timestamp = os::Timer::getRawTimestamp();
+
+		u32 try_num = 0;
+		while (!m_backend.isQueryReady(q) && try_num < 10) {
+			gpu::swapBuffers();
+			++try_num;
+		}
+		if (try_num == 10) {
+			logError("Failed to get GPU timestamp, timings are unreliable.");
+			m_gpu_to_cpu_offset = 0;
+		}
+		else {
+			const u64 gpu_timestamp = m_backend.getQueryResult(q);
+			m_gpu_to_cpu_offset = cpu_timestamp - u64(gpu_timestamp * m_gpu_to_cpu_scale);
+		}
+		m_backend.destroyQuery(q);
+	}
+
+
+	void clear()
+	{
+		for (FrameQueries& f : m_frames) {
+			for (const Query& q : f.queries) m_backend.destroyQuery(q.handle);
+			f.queries.clear();
+			f.frames = 0;
+		}
+		m_read = m_write = 0;
+
+		for(const gpu::QueryHandle h : m_pool) {
+			m_backend.destroyQuery(h);
+		}
+		m_pool.clear();
+	}
+
+
+	gpu::QueryHandle allocQuery()
+	{
+		if(!m_pool.empty()) {
+			const gpu::QueryHandle res = m_pool.back();
+			m_pool.pop();
+			return res;
+		}
+		return m_backend.createQuery();
+	}
+
+
+	void beginQuery(const char* name, i64 profiler_link)
+	{
+		MutexGuard lock(m_mutex);
+		Query& q = m_frames[m_write % MAX_FRAMES_IN_FLIGHT].queries.emplace();
+		q.profiler_link = profiler_link;
+		q.name = name;
+		q.is_end = false;
+		q.handle = allocQuery();
+		m_backend.queryTimestamp(q.handle);
+	}
+
+
+	void endQuery()
+	{
+		MutexGuard lock(m_mutex);
+		Query& q = m_frames[m_write % MAX_FRAMES_IN_FLIGHT].queries.emplace();
+		q.profiler_link = 0;
+		q.is_end = true;
+		q.handle = allocQuery();
+		m_backend.queryTimestamp(q.handle);
+	}
+
+
+	// closes the frame being recorded and resolves every finished frame in one pass;
+	// only the slot at m_write is shared with begin/endQuery, the rest belong to frame()
+	void frame()
+	{
+		PROFILE_FUNCTION();
+		{
+			MutexGuard lock(m_mutex);
+			++m_frames[m_write % MAX_FRAMES_IN_FLIGHT].frames;
+			// ring is full - keep recording into the current slot, it's resolved with several frame markers
+			if (m_write - m_read + 1 < MAX_FRAMES_IN_FLIGHT) ++m_write;
+		}
+
+		while (m_read != m_write) {
+			FrameQueries& f = m_frames[m_read % MAX_FRAMES_IN_FLIGHT];
+			// timestamps are written in submission order, so the last one being ready means the whole frame is
+			if (!f.queries.empty() && !m_backend.isQueryReady(f.queries.back().handle)) break;
+
+			for (const Query& q : f.queries) {
+				const u64 timestamp = toCPUTimestamp(m_backend.getQueryResult(q.handle));
+				if (q.is_end) {
+					profiler::endGPUBlock(timestamp);
+				}
+				else {
+					profiler::beginGPUBlock(q.name, timestamp, q.profiler_link);
+				}
+				m_handles.push(q.handle);
+			}
+			for (u32 i = 0; i < f.frames; ++i) profiler::gpuFrame();
+
+			f.queries.clear();
+			f.frames = 0;
+			++m_read;
+		}
+
+		if (!m_handles.empty()) {
+			MutexGuard lock(m_mutex);
+			for (gpu::QueryHandle h : m_handles) m_pool.push(h);
+		}
+		m_handles.clear();
+	}
+
+
+	Array<FrameQueries> m_frames;
+	Array<gpu::QueryHandle> m_pool;
+	Array<gpu::QueryHandle> m_handles;
+	GPUQueryBackend m_backend;
+	u32 m_read = 0;
+	u32 m_write = 0;
+	Mutex m_mutex;
+	i64 m_gpu_to_cpu_offset;
+	double m_gpu_to_cpu_scale = 1;
+};
+
+
+} // namespace Lumix
@@ -1,9 +1,11 @@
 #include "engine/lumix.h"
 
 #include "engine/array.h"
+#include "engine/atomic.h"
 #include "engine/crc32.h"
 #include "engine/crt.h"
 #include "engine/file_system.h"
+#include "engine/job_system.h"
 #include "engine/log.h"
 #include "engine/math.h"
 #include "engine/path.h"
@@ -14,6 +16,7 @@
 #include "renderer/model.h"
 #include "renderer/pose.h"
 #include "renderer/renderer.h"
+#include "meshoptimizer/meshoptimizer.h"
 
 
 namespace Lumix
@@ -41,6 +44,7 @@ Mesh::Mesh(Material* mat,
 	, indices(allocator)
 	, vertices(allocator)
 	, skin(allocator)
+	, clusters(allocator)
 	, vertex_decl(vertex_decl)
 	, renderer(renderer)
 {
@@ -66,6 +70,7 @@ Mesh::Mesh(Mesh&& rhs)
 	, indices(rhs.indices)
 	, vertices(rhs.vertices.move())
 	, skin(rhs.skin.move())
+	, clusters(rhs.clusters.move())
 	, flags(rhs.flags)
 	, sort_key(rhs.sort_key)
 	, layer(rhs.layer)
@@ -452,6 +457,147 @@ static int getAttributeOffset(Mesh& mesh, Mesh::AttributeSemantic attr)
 }
 
 
+static gpu::AttributeType getAttributeType(Mesh& mesh, Mesh::AttributeSemantic attr)
+{
+	for (u32 i = 0; i < lengthOf(mesh.attributes_semantic); ++i) {
+		if(mesh.attributes_semantic[i] == attr) {
+			return mesh.vertex_decl.attributes[i].type;
+		}
+	}
+	return gpu::AttributeType::FLOAT;
+}
+
+
+static float halfToFloat(u16 h)
+{
+	const u32 sign = u32(h & 0x8000) << 16;
+	const u32 em = h & 0x7fff;
+	// denormals are flushed to zero by quantization, so we can ignore them here
+	u32 bits = em == 0 ? 0 : (em << 13) + ((127 - 15) << 23);
+	if (em >= 0x7c00) bits = (em << 13) | (255 << 23); // inf / nan
+	bits |= sign;
+	float res;
+	memcpy(&res, &bits, sizeof(res));
+	return res;
+}
+
+
+// copy positions and skinning to CPU-side arrays, used for raycasts and skinning
+static void extractCPUData(Mesh& mesh, const u8* vertices, int mesh_vertex_count)
+{
+	const int position_attribute_offset = getAttributeOffset(mesh, Mesh::AttributeSemantic::POSITION);
+	const bool half_positions = getAttributeType(mesh, Mesh::AttributeSemantic::POSITION) == gpu::AttributeType::HALF;
+	const int weights_attribute_offset = getAttributeOffset(mesh, Mesh::AttributeSemantic::WEIGHTS);
+	const int bone_indices_attribute_offset = getAttributeOffset(mesh, Mesh::AttributeSemantic::INDICES);
+	const bool keep_skin = hasAttribute(mesh, Mesh::AttributeSemantic::WEIGHTS) && hasAttribute(mesh, Mesh::AttributeSemantic::INDICES);
+
+	const int vertex_size = mesh.render_data->vb_stride;
+	for (int j = 0; j < mesh_vertex_count; ++j)
+	{
+		int offset = j * vertex_size;
+		if (keep_skin)
+		{
+			mesh.skin[j].weights = *(const Vec4*)&vertices[offset + weights_attribute_offset];
+			memcpy(mesh.skin[j].indices,
+				&vertices[offset + bone_indices_attribute_offset],
+				sizeof(mesh.skin[j].indices));
+		}
+		if (half_positions) {
+			u16 tmp[3];
+			memcpy(tmp, &vertices[offset + position_attribute_offset], sizeof(tmp));
+			mesh.vertices[j] = Vec3(halfToFloat(tmp[0]), halfToFloat(tmp[1]), halfToFloat(tmp[2]));
+		}
+		else {
+			mesh.vertices[j] = *(const Vec3*)&vertices[offset + position_attribute_offset];
+		}
+	}
+}
+
+
+bool Model::parseCompressedGeometry(InputMemoryStream& file)
+{
+	struct Stream {
+		const u8* indices;
+		u32 indices_size;
+		const u8* vertices;
+		u32 vertices_size;
+		Renderer::MemRef vertices_mem;
+		bool decoded;
+	};
+
+	Array<Stream> streams(m_allocator);
+	streams.resize(m_meshes.size());
+	for (int i = 0; i < m_meshes.size(); ++i)
+	{
+		Mesh& mesh = m_meshes[i];
+		int index_size;
+		int indices_count;
+		u32 encoded_size;
+		file.read(index_size);
+		if (index_size != 2 && index_size != 4) return false;
+		file.read(indices_count);
+		if (indices_count <= 0) return false;
+		file.read(encoded_size);
+		if (file.getPosition() + encoded_size > file.size()) return false;
+		mesh.indices.resize(index_size * indices_count);
+		mesh.render_data->indices_count = indices_count;
+		if (index_size == 2) mesh.flags.set(Mesh::Flags::INDICES_16_BIT);
+		streams[i].indices = (const u8*)file.skip(encoded_size);
+		streams[i].indices_size = encoded_size;
+	}
+
+	for (int i = 0; i < m_meshes.size(); ++i)
+	{
+		Mesh& mesh = m_meshes[i];
+		int data_size;
+		u32 encoded_size;
+		file.read(data_size);
+		file.read(encoded_size);
+		if (data_size <= 0 || file.getPosition() + encoded_size > file.size()) {
+			for (int j = 0; j < i; ++j) m_renderer.free(streams[j].vertices_mem);
+			return false;
+		}
+		const int vertex_count = data_size / mesh.render_data->vb_stride;
+		mesh.vertices.resize(vertex_count);
+		if (hasAttribute(mesh, Mesh::AttributeSemantic::WEIGHTS) && hasAttribute(mesh, Mesh::AttributeSemantic::INDICES)) {
+			mesh.skin.resize(vertex_count);
+		}
+		streams[i].vertices_mem = m_renderer.allocate(data_size);
+		streams[i].vertices = (const u8*)file.skip(encoded_size);
+		streams[i].vertices_size = encoded_size;
+	}
+
+	jobs::forEach(m_meshes.size(), 1, [&](i32 i, i32){
+		PROFILE_BLOCK("decode mesh");
+		Mesh& mesh = m_meshes[i];
+		Stream& stream = streams[i];
+		const u32 vertex_size = mesh.render_data->vb_stride;
+		const u32 vertex_count = stream.vertices_mem.size / vertex_size;
+		const u32 index_size = mesh.areIndices16() ? 2 : 4;
+		stream.decoded = meshopt_decodeIndexBuffer(mesh.indices.getMutableData(), mesh.render_data->indices_count, index_size, stream.indices, stream.indices_size) == 0
+			&& meshopt_decodeVertexBuffer(stream.vertices_mem.data, vertex_count, vertex_size, stream.vertices, stream.vertices_size) == 0;
+		if (stream.decoded) extractCPUData(mesh, (const u8*)stream.vertices_mem.data, vertex_count);
+	});
+	
+	bool res = true;
+	for (int i = 0; i < m_meshes.size(); ++i) {
+		Mesh& mesh = m_meshes[i];
+		Stream& stream = streams[i];
+		if (!res || !stream.decoded) {
+			m_renderer.free(stream.vertices_mem);
+			res = false;
+			continue;
+		}
+		const Renderer::MemRef mem = m_renderer.copy(mesh.indices.data(), (u32)mesh.indices.size());
+		mesh.render_data->index_buffer_handle = m_renderer.createBuffer(mem, gpu::BufferFlags::IMMUTABLE);
+		mesh.render_data->index_type = mesh.areIndices16() ? gpu::DataType::U16 : gpu::DataType::U32;
+		mesh.render_data->vertex_buffer_handle = m_renderer.createBuffer(stream.vertices_mem, gpu::BufferFlags::IMMUTABLE);
+		if (!mesh.render_data->index_buffer_handle || !mesh.render_data->vertex_buffer_handle) res = false;
+	}
+	return res;
+}
+
+
 bool Model::parseMeshes(InputMemoryStream& file, FileVersion version)
 {
 	int object_count = 0;
@@ -489,6 +635,14 @@ bool Model::parseMeshes(InputMemoryStream& file, FileVersion version)
 		addDependency(*material);
 	}
 
+	if (version > FileVersion::COMPRESSED_STREAMS) {
+		if (!parseCompressedGeometry(file)) return false;
+		file.read(m_origin_bounding_radius);
+		file.read(m_center_bounding_radius);
+		file.read(m_aabb);
+		return true;
+	}
+
 	for (int i = 0; i < object_count; ++i)
 	{
 		Mesh& mesh = m_meshes[i];
@@ -517,28 +671,13 @@ bool Model::parseMeshes(InputMemoryStream& file, FileVersion version)
 		Renderer::MemRef vertices_mem = m_renderer.allocate(data_size);
 		file.read(vertices_mem.data, data_size);
 
-		int position_attribute_offset = getAttributeOffset(mesh, Mesh::AttributeSemantic::POSITION);
-		int weights_attribute_offset = getAttributeOffset(mesh, Mesh::AttributeSemantic::WEIGHTS);
-		int bone_indices_attribute_offset = getAttributeOffset(mesh, Mesh::AttributeSemantic::INDICES);
 		bool keep_skin = hasAttribute(mesh, Mesh::AttributeSemantic::WEIGHTS) && hasAttribute(mesh, Mesh::AttributeSemantic::INDICES);
 
 		int vertex_size = mesh.render_data->vb_stride;
 		int mesh_vertex_count = data_size / vertex_size;
 		mesh.vertices.resize(mesh_vertex_count);
 		if (keep_skin) mesh.skin.resize(mesh_vertex_count);
-		const u8* vertices = (const u8*)vertices_mem.data;
-		for (int j = 0; j < mesh_vertex_count; ++j)
-		{
-			int offset = j * vertex_size;
-			if (keep_skin)
-			{
-				mesh.skin[j].weights = *(const Vec4*)&vertices[offset + weights_attribute_offset];
-				memcpy(mesh.skin[j].indices,
-					&vertices[offset + bone_indices_attribute_offset],
-					sizeof(mesh.skin[j].indices));
-			}
-			mesh.vertices[j] = *(const Vec3*)&vertices[offset + position_attribute_offset];
-		}
+		extractCPUData(mesh, (const u8*)vertices_mem.data, mesh_vertex_count);
 		mesh.render_data->vertex_buffer_handle = m_renderer.createBuffer(vertices_mem, gpu::BufferFlags::IMMUTABLE);
 		if (!mesh.render_data->vertex_buffer_handle) return false;
 	}
@@ -568,6 +707,31 @@ bool Model::parseLODs(InputMemoryStream& file)
 }
 
 
+bool Model::parseClusters(InputMemoryStream& file)
+{
+	for (Mesh& mesh : m_meshes) {
+		u32 count;
+		file.read(count);
+		if (count == 0) continue;
+		if (file.getPosition() + count * sizeof(Mesh::Cluster) > file.size()) return false;
+		mesh.clusters.resize(count);
+		file.read(mesh.clusters.begin(), mesh.clusters.byte_size());
+
+		const bool is16 = mesh.flags.isSet(Mesh::Flags::INDICES_16_BIT);
+		const u32 vertex_count = (u32)mesh.vertices.size();
+		for (const Mesh::Cluster& cluster : mesh.clusters) {
+			if (cluster.indices_offset % 3 != 0 || cluster.indices_count % 3 != 0) return false;
+			if ((u64)cluster.indices_offset + cluster.indices_count > (u64)mesh.render_data->indices_count) return false;
+			for (u32 i = cluster.indices_offset, end = cluster.indices_offset + cluster.indices_count; i < end; ++i) {
+				const u32 idx = is16 ? ((const u16*)mesh.indices.data())[i] : ((const u32*)mesh.indices.data())[i];
+				if (idx >= vertex_count) return false;
+			}
+		}
+	}
+	return true;
+}
+
+
 bool Model::load(u64 size, const u8* mem)
 {
 	PROFILE_FUNCTION();
@@ -589,7 +753,8 @@ bool Model::load(u64 size, const u8* mem)
 
 	if (parseMeshes(file, (FileVersion)header.version)
 		&& parseBones(file)
-		&& parseLODs(file))
+		&& parseLODs(file)
+		&& (header.version <= (u32)FileVersion::MESHLETS || parseClusters(file)))
 	{
 		m_size = file.size();
 		return true;
@@ -4,7 +4,7 @@
 #include "engine/array.h"
 #include "engine/flag_set.h"
 #include "engine/geometry.h"
-#include "engine/hash_map.h"
+#include "engine/group_hash_map.h"
 #include "engine/math.h"
 #include "engine/resource.h"
 #include "engine/stream.h"
@@ -70,6 +70,16 @@ struct LUMIX_RENDERER_API Mesh {
 		i16 indices[4];
 	};
 
+	// meshlet, used for CPU culling of parts of big meshes
+	struct Cluster {
+		Vec3 center;
+		float radius;
+		Vec3 cone_axis;
+		float cone_cutoff;
+		u32 indices_offset;
+		u32 indices_count;
+	};
+
 	enum Type : u8 {
 		RIGID,
 		SKINNED,
@@ -98,6 +108,7 @@ struct LUMIX_RENDERER_API Mesh {
 	OutputMemoryStream indices;
 	Array<Vec3> vertices;
 	Array<Skin> skin;
+	Array<Cluster> clusters;
 	FlagSet<Flags, u8> flags;
 	u32 sort_key;
 	u8 layer;
@@ -121,7 +132,7 @@ struct LODMeshIndices
 struct LUMIX_RENDERER_API Model final : Resource
 {
 public:
-	using BoneMap = HashMap<u32, int, HashFuncDirect<u32>>;
+	using BoneMap = HashMap<u32, int, HashFuncDirect<u32>, GroupProbing>;
 	
 #pragma pack(1)
 	struct FileHeader
@@ -133,6 +144,9 @@ public:
 
 	enum class FileVersion : u32
 	{
+		FIRST,
+		COMPRESSED_STREAMS, // vertex and index buffers encoded with meshoptimizer codecs
+		MESHLETS,
 		LATEST // keep this last
 	};
 
@@ -199,7 +213,9 @@ private:
 
 	bool parseBones(InputMemoryStream& file);
 	bool parseMeshes(InputMemoryStream& file, FileVersion version);
+	bool parseCompressedGeometry(InputMemoryStream& file);
 	bool parseLODs(InputMemoryStream& file);
+	bool parseClusters(InputMemoryStream& file);
 	int getBoneIdx(const char* name);
 
 	void unload() override;
@@ -49,6 +49,8 @@ static constexpr u64 SORT_KEY_BUCKET_SHIFT = 56;
 static constexpr u64 SORT_KEY_INSTANCED_FLAG = (u64)1 << 55;
 static constexpr u64 SORT_KEY_DEPTH_MASK = 0xffFFffFF;
 static constexpr u64 SORT_KEY_INSTANCER_SHIFT = 16;
+static constexpr u32 MAX_CLUSTER_RANGES = 32;
+static constexpr u32 MAX_MESH_CMD_SIZE = 42 + MAX_CLUSTER_RANGES * sizeof(u32) * 2;
 
 struct CameraParams
 {
@@ -2514,7 +2516,7 @@ struct PipelineImpl final : Pipeline
 
 				PROFILE_FUNCTION();
 				if(m_cmds->header.size == 0 && m_cmds->header.next == nullptr) {
-					m_pipeline->m_renderer.getEngine().getPageAllocator().deallocate(m_cmds, true);
+					m_pipeline->m_renderer.freeCmdPage(m_cmds);
 					return;
 				}
 				
@@ -2552,7 +2554,7 @@ struct PipelineImpl final : Pipeline
 						}
 					}
 					CmdPage* next = page->header.next;
-					m_pipeline->m_renderer.getEngine().getPageAllocator().deallocate(page, true);
+					m_pipeline->m_renderer.freeCmdPage(page);
 					page = next;
 				}
 				#undef READ
@@ -2630,11 +2632,11 @@ struct PipelineImpl final : Pipeline
 		return rs;
 	}
 
-	// TODO optimize
 	struct FillClustersJob : Renderer::RenderJob {
 		FillClustersJob(IAllocator& allocator)
 			: m_clusters(allocator)
 			, m_map(allocator)
+			, m_ranges(allocator)
 			, m_point_lights(allocator)
 			, m_env_probes(allocator)
 			, m_refl_probes(allocator)
@@ -2642,6 +2644,7 @@ struct PipelineImpl final : Pipeline
 
 		void setup() override {
 			PROFILE_FUNCTION();
+			os::Timer timer;
 			const IVec3 size = {
 				(m_pipeline->m_viewport.w + 63) / 64,
 				(m_pipeline->m_viewport.h + 63) / 64,
@@ -2774,109 +2777,120 @@ struct PipelineImpl final : Pipeline
 				return range;
 			};
 
-			// TODO tighter fit
-			auto for_each_light_pair = [&](auto f){
-				for (i32 i = 0, c = point_lights.size(); i < c; ++i) {
-					ClusterPointLight& light = point_lights[i];
-					const float r = light.radius;
-					const Vec3 p = light.pos;
-
-					const IVec2 xrange = range(p, r, size.x, xplanes);
-					const IVec2 yrange = range(p, r, size.y, yplanes);
-					const IVec2 zrange = range(p, r, size.z, zplanes);
-
-					for (i32 z = zrange.x; z < zrange.y; ++z) {
-						for (i32 y = yrange.x; y < yrange.y; ++y) {
-							for (i32 x = xrange.x; x < xrange.y; ++x) {
-								const u32 idx = x + y * size.x + z * size.x * size.y;
-								Cluster& cluster = clusters[idx];
-								f(cluster, i);
-							}
-						}
+			const i32 lights_count = point_lights.size();
+			const i32 env_probes_count = env_probes.size();
+			const i32 items_count = lights_count + env_probes_count + refl_probes.size();
+			Array<ItemRange>& ranges = m_ranges;
+			ranges.resize(items_count);
+
+			// compute cluster-space bounds of every light and probe
+			jobs::forEach(items_count, 256, [&](i32 from, i32 to){
+				PROFILE_BLOCK("cluster ranges");
+				for (i32 i = from; i < to; ++i) {
+					Vec3 p;
+					float r;
+					if (i < lights_count) {
+						p = point_lights[i].pos;
+						r = point_lights[i].radius;
 					}
-				}
-			};
-			
-			auto for_each_env_probe_pair = [&](auto f){
-				for (i32 i = 0, c = env_probes.size(); i < c; ++i) {
-					const Vec3 p = env_probes[i].pos;
-					const float r = length(env_probes[i].outer_range);
-				
-					const IVec2 xrange = range(p, r, size.x, xplanes);
-					const IVec2 yrange = range(p, r, size.y, yplanes);
-					const IVec2 zrange = range(p, r, size.z, zplanes);
-
-					for (i32 z = zrange.x; z < zrange.y; ++z) {
-						for (i32 y = yrange.x; y < yrange.y; ++y) {
-							for (i32 x = xrange.x; x < xrange.y; ++x) {
-								const u32 idx = x + y * size.x + z * size.x * size.y;
-								Cluster& cluster = clusters[idx];
-								f(cluster, i);
-							}
-						}
+					else if (i < lights_count + env_probes_count) {
+						const ClusterEnvProbe& probe = env_probes[i - lights_count];
+						p = probe.pos;
+						r = length(probe.outer_range);
 					}
+					else {
+						const ClusterReflProbe& probe = refl_probes[i - lights_count - env_probes_count];
+						p = probe.pos;
+						r = length(probe.half_extents);
+					}
+					
+					ItemRange& res = ranges[i];
+					res.z = range(p, r, size.z, zplanes);
+					if (res.z.x < 0) continue;
+					res.y = range(p, r, size.y, yplanes);
+					if (res.y.x < 0) {
+						res.z = IVec2(-1, -1);
+						continue;
+					}
+					res.x = range(p, r, size.x, xplanes);
+					if (res.x.x < 0) res.z = IVec2(-1, -1);
 				}
-			};
+			});
 
-			auto for_each_refl_probe_pair = [&](auto f){
-				for (i32 i = 0, c = refl_probes.size(); i < c; ++i) {
-					const Vec3 p = refl_probes[i].pos;
-					const float r = length(refl_probes[i].half_extents);
-				
-					const IVec2 xrange = range(p, r, size.x, xplanes);
-					const IVec2 yrange = range(p, r, size.y, yplanes);
-					const IVec2 zrange = range(p, r, size.z, zplanes);
-
-					for (i32 z = zrange.x; z < zrange.y; ++z) {
-						for (i32 y = yrange.x; y < yrange.y; ++y) {
-							for (i32 x = xrange.x; x < xrange.y; ++x) {
-								const u32 idx = x + y * size.x + z * size.x * size.y;
-								Cluster& cluster = clusters[idx];
-								f(cluster, i);
-							}
+			// each z slice is binned by a single job, so clusters need no atomics
+			u32 slice_counts[17] = {};
+			auto for_each_in_slice = [&](i32 z, auto f){
+				const i32 slice_offset = z * size.x * size.y;
+				for (i32 i = 0; i < items_count; ++i) {
+					const ItemRange& r = ranges[i];
+					if (z < r.z.x || z >= r.z.y) continue;
+					for (i32 y = r.y.x; y < r.y.y; ++y) {
+						for (i32 x = r.x.x; x < r.x.y; ++x) {
+							f(clusters[slice_offset + x + y * size.x], i);
 						}
 					}
 				}
 			};
 
-			for_each_light_pair([](Cluster& cluster, i32 light_idx){
-				++cluster.point_lights_count;
-			});
-
-			for_each_env_probe_pair([](Cluster& cluster, i32){
-				++cluster.env_probes_count;
-			});
-
-			for_each_refl_probe_pair([](Cluster& cluster, i32){
-				++cluster.refl_probes_count;
+			jobs::forEach(size.z, 1, [&](i32 z, i32){
+				PROFILE_BLOCK("count cluster items");
+				u32 count = 0;
+				for_each_in_slice(z, [&](Cluster& cluster, i32 item_idx){
+					if (item_idx < lights_count) ++cluster.point_lights_count;
+					else if (item_idx < lights_count + env_probes_count) ++cluster.env_probes_count;
+					else ++cluster.refl_probes_count;
+					++count;
+				});
+				slice_counts[z] = count;
 			});
 
-			u32 offset = 0;
-			for (Cluster& cluster : clusters) {
-				cluster.offset = offset;
-				offset += cluster.point_lights_count + cluster.env_probes_count + cluster.refl_probes_count;
+			u32 total = 0;
+			for (i32 z = 0; z < size.z; ++z) {
+				const u32 tmp = slice_counts[z];
+				slice_counts[z] = total;
+				total += tmp;
 			}
-			
-			map.resize(offset);
-			
-			for_each_light_pair([&](Cluster& cluster, i32 light_idx){
-				map[cluster.offset] = light_idx;
-				++cluster.offset;
-			});
+			map.resize(total);
+
+			jobs::forEach(size.z, 1, [&](i32 z, i32){
+				PROFILE_BLOCK("fill cluster map");
+				const i32 slice_size = size.x * size.y;
+				Cluster* slice = clusters.begin() + z * slice_size;
+				u32 offset = slice_counts[z];
+				for (i32 i = 0; i < slice_size; ++i) {
+					Cluster& cluster = slice[i];
+					cluster.offset = offset;
+					offset += cluster.point_lights_count + cluster.env_probes_count + cluster.refl_probes_count;
+					// reuse counts as write cursors, restored below
+					cluster.refl_probes_count = cluster.point_lights_count + cluster.env_probes_count;
+					cluster.env_probes_count = cluster.point_lights_count;
+					cluster.point_lights_count = 0;
+				}
 
-			for_each_env_probe_pair([&](Cluster& cluster, i32 probe_idx){
-				map[cluster.offset] = probe_idx;
-				++cluster.offset;
-			});
+				for_each_in_slice(z, [&](Cluster& cluster, i32 item_idx){
+					if (item_idx < lights_count) {
+						map[cluster.offset + cluster.point_lights_count] = item_idx;
+						++cluster.point_lights_count;
+					}
+					else if (item_idx < lights_count + env_probes_count) {
+						map[cluster.offset + cluster.env_probes_count] = item_idx - lights_count;
+						++cluster.env_probes_count;
+					}
+					else {
+						map[cluster.offset + cluster.refl_probes_count] = item_idx - lights_count - env_probes_count;
+						++cluster.refl_probes_count;
+					}
+				});
 
-			for_each_refl_probe_pair([&](Cluster& cluster, i32 probe_idx){
-				map[cluster.offset] = probe_idx;
-				++cluster.offset;
+				for (i32 i = 0; i < slice_size; ++i) {
+					Cluster& cluster = slice[i];
+					cluster.refl_probes_count -= cluster.env_probes_count;
+					cluster.env_probes_count -= cluster.point_lights_count;
+				}
 			});
 
-			for (Cluster& cluster : clusters) {
-				cluster.offset -= cluster.point_lights_count + cluster.env_probes_count + cluster.refl_probes_count;
-			}
+			m_cluster_links_count = total;
+			m_setup_time = timer.getTimeSinceStart();
 		}
 
 		void execute() override {
@@ -2904,6 +2918,12 @@ struct PipelineImpl final : Pipeline
 			bind(m_pipeline->m_cluster_buffers.maps, m_map, 13);
 			bind(m_pipeline->m_cluster_buffers.env_probes, m_env_probes, 14);
 			bind(m_pipeline->m_cluster_buffers.refl_probes, m_refl_probes, 15);
+
+			profiler::pushInt("cluster links", m_cluster_links_count);
+			Pipeline::Stats& stats = m_pipeline->m_stats;
+			stats.clustered_lights_count += m_point_lights.size();
+			stats.cluster_links_count += m_cluster_links_count;
+			stats.fill_clusters_time += m_setup_time;
 		}
 
 
@@ -2944,7 +2964,15 @@ struct PipelineImpl final : Pipeline
 			float pad1;
 		};
 
+		// [from, to) cluster indices touched by a light or probe, z.x < 0 if culled
+		struct ItemRange {
+			IVec2 x;
+			IVec2 y;
+			IVec2 z;
+		};
+
 		Array<i32> m_map;
+		Array<ItemRange> m_ranges;
 		Array<Cluster> m_clusters;
 		Array<ClusterPointLight> m_point_lights;
 		Array<ClusterEnvProbe> m_env_probes;
@@ -2953,6 +2981,8 @@ struct PipelineImpl final : Pipeline
 		PipelineImpl* m_pipeline;
 		CameraParams m_camera_params;
 		bool m_is_clear = false;
+		u32 m_cluster_links_count = 0;
+		float m_setup_time = 0;
 		Matrix m_shadow_atlas_matrices[128];
 	};
 	
@@ -3037,7 +3067,7 @@ struct PipelineImpl final : Pipeline
 				do {} while(false)
 			PROFILE_FUNCTION();
 			if(m_cmds->header.size == 0 && !m_cmds->header.next) {
-				m_pipeline->m_renderer.getEngine().getPageAllocator().deallocate(m_cmds, true);
+				m_pipeline->m_renderer.freeCmdPage(m_cmds);
 				return;
 			}
 
@@ -3065,6 +3095,9 @@ struct PipelineImpl final : Pipeline
 							READ(u32, instances_count);
 							READ(gpu::BufferHandle, buffer);
 							READ(u32, offset);
+							READ(u32, ranges_count);
+							const u32* ranges = (const u32*)cmd;
+							cmd += ranges_count * sizeof(u32) * 2;
 
 							gpu::bindTextures(material->textures, 0, material->textures_count);
 							gpu::setState(material->render_states | render_states);
@@ -3079,9 +3112,23 @@ struct PipelineImpl final : Pipeline
 							gpu::bindVertexBuffer(0, mesh->vertex_buffer_handle, 0, mesh->vb_stride);
 							gpu::bindVertexBuffer(1, buffer, offset, 36);
 
-							gpu::drawTrianglesInstanced(mesh->indices_count, instances_count, mesh->index_type);
-							++stats.draw_call_count;
-							stats.triangle_count += instances_count * mesh->indices_count / 3;
+							if (ranges_count == 0) {
+								gpu::drawTrianglesInstanced(mesh->indices_count, instances_count, mesh->index_type);
+								++stats.draw_call_count;
+								stats.triangle_count += instances_count * mesh->indices_count / 3;
+							}
+							else {
+								// only single instances are split to clusters, see createCommands
+								u32 drawn_indices = 0;
+								for (u32 j = 0; j < ranges_count; ++j) {
+									if (ranges[j * 2 + 1] == 0) continue;
+									gpu::drawTriangles(ranges[j * 2], ranges[j * 2 + 1], mesh->index_type);
+									drawn_indices += ranges[j * 2 + 1];
+									++stats.draw_call_count;
+								}
+								stats.triangle_count += drawn_indices / 3;
+								stats.culled_triangle_count += (mesh->indices_count - drawn_indices) / 3;
+							}
 							stats.instance_count += instances_count;
 							break;
 						}
@@ -3228,16 +3275,18 @@ struct PipelineImpl final : Pipeline
 					}
 				}
 				CmdPage* next = page->header.next;
-				m_pipeline->m_renderer.getEngine().getPageAllocator().deallocate(page, true);
+				m_pipeline->m_renderer.freeCmdPage(page);
 				page = next;
 			}
 			#undef READ
 			profiler::pushInt("drawcalls", stats.draw_call_count);
 			profiler::pushInt("instances", stats.instance_count);
 			profiler::pushInt("triangles", stats.triangle_count);
+			profiler::pushInt("culled triangles", stats.culled_triangle_count);
 			m_pipeline->m_stats.draw_call_count += stats.draw_call_count;
 			m_pipeline->m_stats.instance_count += stats.instance_count;
 			m_pipeline->m_stats.triangle_count += stats.triangle_count;		
+			m_pipeline->m_stats.culled_triangle_count += stats.culled_triangle_count;
 		}
 
 		CmdPage* m_cmds;
@@ -3268,7 +3317,6 @@ struct PipelineImpl final : Pipeline
 		const Universe& universe = m_scene->getUniverse();
 		Renderer& renderer = m_renderer;
 		RenderScene* scene = m_scene;
-		PageAllocator& page_allocator = m_renderer.getEngine().getPageAllocator();
 		const ShiftedFrustum frustum = view.cp.frustum;
 		const ModelInstance* LUMIX_RESTRICT model_instances = scene->getModelInstances().begin();
 		const Transform* LUMIX_RESTRICT entity_data = universe.getTransforms(); 
@@ -3278,7 +3326,7 @@ struct PipelineImpl final : Pipeline
 		while (cmd_page->header.next) cmd_page = cmd_page->header.next;
 
 		if (cmd_page->header.size > 0 && cmd_page->header.bucket != sort_keys[0] >> 56) {
-			cmd_page->header.next = new (NewPlaceholder(), page_allocator.allocate(true))(CmdPage);
+			cmd_page->header.next = new (NewPlaceholder(), renderer.allocCmdPage()) CmdPage;
 			cmd_page = cmd_page->header.next;
 		}
 
@@ -3294,7 +3342,7 @@ struct PipelineImpl final : Pipeline
 
 		auto new_page = [&](u8 bucket){
 			cmd_page->header.size = int(out - cmd_page->data);
-			CmdPage* new_page = new (NewPlaceholder(), page_allocator.allocate(true)) CmdPage;
+			CmdPage* new_page = new (NewPlaceholder(), renderer.allocCmdPage()) CmdPage;
 			cmd_page->header.next = new_page;
 			cmd_page = new_page;
 			new_page->header.bucket = bucket;
@@ -3308,6 +3356,57 @@ struct PipelineImpl final : Pipeline
 		};
 
 		const Mesh** sort_key_to_mesh = m_renderer.getSortKeyToMeshMap();
+		const Frustum rel_frustum = frustum.getRelative(camera_pos);
+		const bool meshlet_culling = m_meshlet_culling;
+
+		// writes index ranges of visible clusters, 0 ranges == draw the whole mesh
+		auto write_clusters = [&](const Mesh& mesh, const Material* material, EntityRef e) {
+			u32 ranges_count = 0;
+			if (!meshlet_culling || mesh.clusters.empty()) {
+				WRITE(ranges_count);
+				return;
+			}
+
+			const Transform& tr = entity_data[e.index];
+			const Vec3 pos = Vec3(tr.pos - camera_pos);
+			// camera position in model space
+			const Vec3 local_cam = tr.rot.conjugated().rotate(-pos) / tr.scale;
+			const bool cone_culling = !view.cp.is_shadow && (material->getRenderStates() & gpu::StateFlags::CULL_BACK) != gpu::StateFlags::NONE;
+			const u32 index_size = mesh.areIndices16() ? sizeof(u16) : sizeof(u32);
+
+			u32* ranges = (u32*)(out + sizeof(ranges_count));
+			for (const Mesh::Cluster& cluster : mesh.clusters) {
+				if (cone_culling) {
+					const Vec3 d = cluster.center - local_cam;
+					if (dot(d, cluster.cone_axis) >= cluster.cone_cutoff * length(d) + cluster.radius) continue;
+				}
+				const Vec3 center = tr.rot.rotate(cluster.center * tr.scale) + pos;
+				if (!rel_frustum.isSphereInside(center, cluster.radius * tr.scale)) continue;
+
+				const u32 offset = cluster.indices_offset * index_size;
+				if (ranges_count > 0 && ranges[ranges_count * 2 - 2] + ranges[ranges_count * 2 - 1] * index_size == offset) {
+					ranges[ranges_count * 2 - 1] += cluster.indices_count;
+				}
+				else if (ranges_count == MAX_CLUSTER_RANGES) {
+					// extend the last range over the gap, we draw some culled clusters, but save drawcalls
+					ranges[ranges_count * 2 - 1] = (offset - ranges[ranges_count * 2 - 2]) / index_size + cluster.indices_count;
+				}
+				else {
+					ranges[ranges_count * 2] = offset;
+					ranges[ranges_count * 2 + 1] = cluster.indices_count;
+					++ranges_count;
+				}
+			}
+
+			if (ranges_count == 0) {
+				// everything is culled, draw nothing
+				ranges[0] = 0;
+				ranges[1] = 0;
+				ranges_count = 1;
+			}
+			WRITE(ranges_count);
+			out += ranges_count * sizeof(u32) * 2;
+		};
 
 		for (u32 i = 0, c = count; i < c; ++i) {
 			const EntityRef e = {int(renderables[i] & 0xFFffFFff)};
@@ -3337,7 +3436,7 @@ struct PipelineImpl final : Pipeline
 					const float lod_d = model_instances[e.index].lod - mesh.lod;
 					memcpy(instance_data, &lod_d, sizeof(lod_d));
 					instance_data += sizeof(lod_d);
-					if ((cmd_page->data + sizeof(cmd_page->data) - out) < 38) {
+					if ((cmd_page->data + sizeof(cmd_page->data) - out) < MAX_MESH_CMD_SIZE) {
 						new_page(bucket);
 					}
 
@@ -3353,6 +3452,7 @@ struct PipelineImpl final : Pipeline
 						WRITE(count);
 						WRITE(slice.buffer);
 						WRITE(slice.offset);
+						write_clusters(mesh, mi->custom_material, e);
 					}
 							
 					break;
@@ -3366,7 +3466,7 @@ struct PipelineImpl final : Pipeline
 						const u32 total_count = instances.end->offset + instances.end->count;
 						const Mesh& mesh = *sort_key_to_mesh[group_idx];
 						const float mesh_lod = mesh.lod;
-						if ((cmd_page->data + sizeof(cmd_page->data) - out) < 38) {
+						if ((cmd_page->data + sizeof(cmd_page->data) - out) < MAX_MESH_CMD_SIZE) {
 							new_page(bucket);
 						}
 
@@ -3380,6 +3480,14 @@ struct PipelineImpl final : Pipeline
 						WRITE(total_count);
 						WRITE(instances.slice.buffer);
 						WRITE(instances.slice.offset);
+						if (total_count == 1) {
+							const EntityRef instance_e = {int(instances.begin->renderables[0] & 0xFFffFFff)};
+							write_clusters(mesh, mesh.material, instance_e);
+						}
+						else {
+							const u32 ranges_count = 0;
+							WRITE(ranges_count);
+						}
 					}
 					else {
 						const u32 mesh_idx = renderables[i] >> 40;
@@ -3408,7 +3516,7 @@ struct PipelineImpl final : Pipeline
 							memcpy(instance_data, &lod_d, sizeof(lod_d));
 							instance_data += sizeof(lod_d);
 						}
-						if ((cmd_page->data + sizeof(cmd_page->data) - out) < 38) {
+						if ((cmd_page->data + sizeof(cmd_page->data) - out) < MAX_MESH_CMD_SIZE) {
 							new_page(bucket);
 						}
 
@@ -3422,6 +3530,13 @@ struct PipelineImpl final : Pipeline
 						WRITE(count);
 						WRITE(slice.buffer);
 						WRITE(slice.offset);
+						if (count == 1) {
+							write_clusters(mesh, mesh.material, e);
+						}
+						else {
+							const u32 ranges_count = 0;
+							WRITE(ranges_count);
+						}
 							
 						--i;
 					}
@@ -3645,7 +3760,7 @@ struct PipelineImpl final : Pipeline
 		const int size = view.sorter.keys.size();
 		constexpr i32 STEP = 4096;
 		const i32 steps = (size + STEP - 1) / STEP;
-		PageAllocator& page_allocator = m_renderer.getEngine().getPageAllocator();
+		Renderer& renderer = m_renderer;
 
 		Array<CmdPage*> pages(m_allocator);
 		pages.resize(steps);
@@ -3658,7 +3773,7 @@ struct PipelineImpl final : Pipeline
 				if (from >= size) return;
 
 				const u32 step = from / STEP;
-				pages[step] = new (NewPlaceholder(), page_allocator.allocate(true))(CmdPage);
+				pages[step] = new (NewPlaceholder(), renderer.allocCmdPage()) CmdPage;
 				const i32 s = minimum(STEP, size - from);
 				createCommands(view, pages[step], renderables + from, sort_keys + from, s);
 			}
@@ -4704,6 +4819,10 @@ struct PipelineImpl final : Pipeline
 		m_output = tex.renderbuffer;
 	}
 
+	void enableMeshletCulling(bool enable) {
+		m_meshlet_culling = enable;
+	}
+
 	bool environmentCastShadows() {
 		if (!m_scene) return false;
 		const EntityPtr env = m_scene->getActiveEnvironment();
@@ -4828,6 +4947,7 @@ struct PipelineImpl final : Pipeline
 		REGISTER_FUNCTION(cull);
 		REGISTER_FUNCTION(dispatch);
 		REGISTER_FUNCTION(drawArray);
+		REGISTER_FUNCTION(enableMeshletCulling);
 		REGISTER_FUNCTION(endBlock);
 		REGISTER_FUNCTION(environmentCastShadows);
 		REGISTER_FUNCTION(executeCustomCommand);
@@ -4923,6 +5043,7 @@ struct PipelineImpl final : Pipeline
 	Shader* m_draw2d_shader;
 	Stats m_last_frame_stats;
 	Stats m_stats; // accessed from render thread
+	bool m_meshlet_culling = true;
 	Array<View> m_views;
 	Array<Bucket> m_buckets;
 	jobs::SignalHandle m_buckets_ready;
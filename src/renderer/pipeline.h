@@ -65,6 +65,10 @@ struct LUMIX_RENDERER_API Pipeline
 		u32 draw_call_count;
 		u32 instance_count;
 		u32 triangle_count;
+		u32 culled_triangle_count;
+		u32 clustered_lights_count;
+		u32 cluster_links_count;
+		float fill_clusters_time;
 	};
 
 	struct CustomCommandHandler
@@ -1302,6 +1302,12 @@ struct RenderSceneImpl final : RenderScene {
 	}
 
 
+	void getTerrainHeightsAt(EntityRef entity, Span<const Vec2> xz, Span<float> heights) override
+	{
+		m_terrains[entity]->getHeights(xz, heights);
+	}
+
+
 	AABB getTerrainAABB(EntityRef entity) override
 	{
 		return m_terrains[entity]->getAABB();
@@ -343,6 +343,7 @@ struct LUMIX_RENDERER_API RenderScene : IScene
 	virtual const HashMap<EntityRef, Terrain*>& getTerrains() = 0;
 	virtual void getTerrainInfos(Array<TerrainInfo>& infos) = 0;
 	virtual float getTerrainHeightAt(EntityRef entity, float x, float z) = 0;
+	virtual void getTerrainHeightsAt(EntityRef entity, Span<const Vec2> xz, Span<float> heights) = 0;
 	virtual Vec3 getTerrainNormalAt(EntityRef entity, float x, float z) = 0;
 	virtual void setTerrainMaterialPath(EntityRef entity, const Path& path) = 0;
 	virtual Path getTerrainMaterialPath(EntityRef entity) = 0;
@@ -1,5 +1,6 @@
 #include "renderer.h"
 
+#include "engine/allocators.h"
 #include "engine/array.h"
 #include "engine/command_line_parser.h"
 #include "engine/crc32.h"
@@ -11,12 +12,14 @@
 #include "engine/sync.h"
 #include "engine/thread.h"
 #include "engine/os.h"
+#include "engine/page_allocator.h"
 #include "engine/profiler.h"
 #include "engine/reflection.h"
 #include "engine/resource_manager.h"
 #include "engine/string.h"
 #include "engine/universe.h"
 #include "renderer/font.h"
+#include "renderer/gpu_profiler.h"
 #include "renderer/material.h"
 #include "renderer/model.h"
 #include "renderer/pipeline.h"
@@ -55,6 +58,7 @@ static const char* downscale_src = R"#(
 
 struct TransientBuffer {
 	static constexpr u32 INIT_SIZE = 1024 * 1024;
+	static constexpr u32 OVERFLOW_RESERVE = 512 * 1024 * 1024;
 	
 	void init() {
 		m_buffer = gpu::allocBufferHandle();
@@ -78,7 +82,7 @@ struct TransientBuffer {
 		MutexGuard lock(m_mutex);
 		if (!m_overflow.buffer) {
 			m_overflow.buffer = gpu::allocBufferHandle();
-			m_overflow.data = (u8*)os::memReserve(512 * 1024 * 1024);
+			m_overflow.data = (u8*)os::memReserve(OVERFLOW_RESERVE);
 			m_overflow.size = 0;
 			m_overflow.commit = 0;
 		}
@@ -101,7 +105,7 @@ struct TransientBuffer {
 		if (m_overflow.buffer) {
 			gpu::createBuffer(m_overflow.buffer, gpu::BufferFlags::NONE, nextPow2(m_overflow.size + m_size), nullptr);
 			gpu::update(m_overflow.buffer, m_overflow.data, m_overflow.size);
-			os::memRelease(m_overflow.data);
+			os::memRelease(m_overflow.data, OVERFLOW_RESERVE);
 			m_overflow.data = nullptr;
 			m_overflow.commit = 0;
 		}
@@ -137,8 +141,12 @@ struct TransientBuffer {
 
 
 struct FrameData {
+	// render jobs and command pages, reset when GPU is done with the frame
+	static constexpr u32 ARENA_SIZE = 64 * 1024 * 1024;
+
 	FrameData(struct RendererImpl& renderer, IAllocator& allocator) 
 		: jobs(allocator)
+		, arena(ARENA_SIZE)
 		, renderer(renderer)
 		, to_compile_shaders(allocator)
 		, material_updates(allocator)
@@ -162,6 +170,7 @@ struct FrameData {
 
 	Array<MaterialUpdates> material_updates;
 	Array<Renderer::RenderJob*> jobs;
+	LinearAllocator arena;
 	Mutex shader_mutex;
 	Array<ShaderToCompile> to_compile_shaders;
 	RendererImpl& renderer;
@@ -194,152 +203,11 @@ struct RenderResourceManager : ResourceManager
 };
 
 
-struct GPUProfiler
-{
-	struct Query
-	{
-		StaticString<32> name;
-		gpu::QueryHandle handle;
-		u64 result;
-		i64 profiler_link;
-		bool is_end;
-		bool is_frame;
-	};
-
-
-	GPUProfiler(IAllocator& allocator) 
-		: m_queries(allocator)
-		, m_pool(allocator)
-		, m_gpu_to_cpu_offset(0)
-	{
-	}
-
-
-	~GPUProfiler()
-	{
-		ASSERT(m_pool.empty());
-		ASSERT(m_queries.empty());
-	}
-
-
-	u64 toCPUTimestamp(u64 gpu_timestamp) const
-	{
-		return u64(gpu_timestamp * (os::Timer::getFrequency() / double(gpu::getQueryFrequency()))) + m_gpu_to_cpu_offset;
-	}
-
-
-	void init()
-	{
-		gpu::QueryHandle q = gpu::createQuery();
-		gpu::queryTimestamp(q);
-		const u64 cpu_timestamp = os::Timer::getRawTimestamp();
-
-		u32 try_num = 0;
-		while (!gpu::isQueryReady(q) && try_num < 10) {
-			gpu::swapBuffers();
-			++try_num;
-		}
-		if (try_num == 10) {
-			logError("Failed to get GPU timestamp, timings are unreliable.");
-			m_gpu_to_cpu_offset = 0;
-		}
-		else {
-			const u64 gpu_timestamp = gpu::getQueryResult(q);
-			m_gpu_to_cpu_offset = cpu_timestamp - u64(gpu_timestamp * (os::Timer::getFrequency() / double(gpu::getQueryFrequency())));
-			gpu::destroy(q);
-		}
-	}
-
-
-	void clear()
-	{
-		m_queries.clear();
-
-		for(const gpu::QueryHandle h : m_pool) {
-			gpu::destroy(h);
-		}
-		m_pool.clear();
-	}
-
-
-	gpu::QueryHandle allocQuery()
-	{
-		if(!m_pool.empty()) {
-			const gpu::QueryHandle res = m_pool.back();
-			m_pool.pop();
-			return res;
-		}
-		return gpu::createQuery();
-	}
-
-
-	void beginQuery(const char* name, i64 profiler_link)
-	{
-		MutexGuard lock(m_mutex);
-		Query& q = m_queries.emplace();
-		q.profiler_link = profiler_link;
-		q.name = name;
-		q.is_end = false;
-		q.is_frame = false;
-		q.handle = allocQuery();
-		gpu::queryTimestamp(q.handle);
-	}
-
-
-	void endQuery()
-	{
-		MutexGuard lock(m_mutex);
-		Query& q = m_queries.emplace();
-		q.is_end = true;
-		q.is_frame = false;
-		q.handle = allocQuery();
-		gpu::queryTimestamp(q.handle);
-	}
-
-
-	void frame()
-	{
-		PROFILE_FUNCTION();
-		MutexGuard lock(m_mutex);
-		Query frame_query;
-		frame_query.is_frame = true;
-		m_queries.push(frame_query);
-		while (!m_queries.empty()) {
-			Query q = m_queries[0];
-			if (q.is_frame) {
-				profiler::gpuFrame();
-				m_queries.erase(0);
-				continue;
-			}
-			
-			if (!gpu::isQueryReady(q.handle)) break;
-
-			if (q.is_end) {
-				const u64 timestamp = toCPUTimestamp(gpu::getQueryResult(q.handle));
-				profiler::endGPUBlock(timestamp);
-			}
-			else {
-				const u64 timestamp = toCPUTimestamp(gpu::getQueryResult(q.handle));
-				profiler::beginGPUBlock(q.name, timestamp, q.profiler_link);
-			}
-			m_pool.push(q.handle);
-			m_queries.erase(0);
-		}
-	}
-
-
-	Array<Query> m_queries;
-	Array<gpu::QueryHandle> m_pool;
-	Mutex m_mutex;
-	i64 m_gpu_to_cpu_offset;
-};
-
-
 struct RendererImpl final : Renderer
 {
 	explicit RendererImpl(Engine& engine)
 		: m_engine(engine)
-		, m_allocator(engine.getAllocator())
+		, m_allocator(engine.getAllocator(), "renderer")
 		, m_texture_manager(*this, m_allocator)
 		, m_pipeline_manager(*this, m_allocator)
 		, m_model_manager(*this, m_allocator)
@@ -537,6 +405,14 @@ struct RendererImpl final : Renderer
 	}
 
 
+	bool isInFrameArena(const void* ptr) const {
+		for (const Local<FrameData>& frame : m_frames) {
+			if (frame->arena.owns(ptr)) return true;
+		}
+		return false;
+	}
+
+
 	void free(const MemRef& memory) override
 	{
 		ASSERT(memory.own);
@@ -1042,13 +918,27 @@ struct RendererImpl final : Renderer
 	}
 
 	void* allocJob(u32 size, u32 align) override {
+		void* job = m_cpu_frame->arena.allocate_aligned(size, align);
+		if (job) return job;
 		return m_allocator.allocate_aligned(size, align);
 	}
 
 	void deallocJob(void* job) override {
+		if (isInFrameArena(job)) return;
 		m_allocator.deallocate_aligned(job);
 	}
 
+	void* allocCmdPage() override {
+		void* page = m_cpu_frame->arena.allocate_aligned(PageAllocator::PAGE_SIZE, PageAllocator::PAGE_SIZE);
+		if (page) return page;
+		return m_engine.getPageAllocator().allocate(true);
+	}
+
+	void freeCmdPage(void* page) override {
+		if (isInFrameArena(page)) return;
+		m_engine.getPageAllocator().deallocate(page, true);
+	}
+
 	const char* getName() const override { return "renderer"; }
 	Engine& getEngine() override { return m_engine; }
 	int getShaderDefinesCount() const override { return m_shader_defines.size(); }
@@ -1123,6 +1013,8 @@ struct RendererImpl final : Renderer
 	void render() {
 		FrameData& frame = *m_gpu_frame;
 		frame.transient_buffer.prepareToRender();
+		profiler::pushInt("Render arena KB", frame.arena.getAllocated() / 1024);
+		profiler::pushInt("Render arena peak KB", frame.arena.getHighWater() / 1024);
 		
 		gpu::MemoryStats mem_stats;
 		if (gpu::getMemoryStats(mem_stats)) {
@@ -1165,6 +1057,7 @@ struct RendererImpl final : Renderer
 		if (check_frame.gpu_frame != 0xffFFffFF && gpu::frameFinished(check_frame.gpu_frame)) {
 			check_frame.gpu_frame = 0xffFFffFF;
 			check_frame.transient_buffer.renderDone();
+			check_frame.arena.reset();
 			jobs::decSignal(check_frame.can_setup);
 		}
 
@@ -1172,6 +1065,7 @@ struct RendererImpl final : Renderer
 			gpu::waitFrame(m_gpu_frame->gpu_frame);
 			m_gpu_frame->gpu_frame = 0xFFffFFff;   
 			m_gpu_frame->transient_buffer.renderDone();
+			m_gpu_frame->arena.reset();
 			jobs::decSignal(m_gpu_frame->can_setup);
 		}
 	}
@@ -1217,7 +1111,7 @@ struct RendererImpl final : Renderer
 	}
 
 	Engine& m_engine;
-	IAllocator& m_allocator;
+	TagAllocator m_allocator;
 	Array<StaticString<32>> m_shader_defines;
 	Mutex m_shader_defines_mutex;
 	Array<StaticString<32>> m_layers;
@@ -82,6 +82,9 @@ struct LUMIX_RENDERER_API Renderer : IPlugin {
 	virtual void destroy(gpu::TextureHandle tex) = 0;
 	
 	virtual void queue(RenderJob& cmd, i64 profiler_link) = 0;
+	// PageAllocator::PAGE_SIZE block, reclaimed when the current frame is rendered
+	virtual void* allocCmdPage() = 0;
+	virtual void freeCmdPage(void* page) = 0;
 
 	virtual void beginProfileBlock(const char* name, i64 link) = 0;
 	virtual void endProfileBlock() = 0;
@@ -44,6 +44,7 @@ Terrain::Terrain(Renderer& renderer, EntityPtr entity, RenderScene& scene, IAllo
 	, m_allocator(allocator)
 	, m_grass_types(m_allocator)
 	, m_renderer(renderer)
+	, m_height_tree(m_allocator)
 {
 }
 
@@ -327,6 +328,142 @@ float Terrain::getHeight(int x, int z) const
 }
 
 
+static LUMIX_FORCE_INLINE float getNormalizedHeight(const Texture& t, int idx)
+{
+	if (t.format == gpu::TextureFormat::R16) return ((const u16*)t.getData())[idx] * (1.0f / 65535.0f);
+	ASSERT(t.format == gpu::TextureFormat::RGBA8);
+	return (((const u32*)t.getData())[idx] & 0xff) * (1.0f / 255.0f);
+}
+
+
+void Terrain::getHeights(Span<const Vec2> xz, Span<float> heights) const
+{
+	PROFILE_FUNCTION();
+	ASSERT(xz.length() == heights.length());
+	if (!m_heightmap || !m_heightmap->getData()) {
+		for (float& h : heights) h = 0;
+		return;
+	}
+
+	const Texture& t = *m_heightmap;
+	const float inv_scale = 1.0f / m_scale.x;
+	const float y_scale = m_scale.y;
+	const int max_x = m_width - 1;
+	const int max_z = m_height - 1;
+	auto sample = [&](int x, int z){
+		return getNormalizedHeight(t, clamp(x, 0, max_x) + clamp(z, 0, max_z) * m_width);
+	};
+
+	for (u32 i = 0, c = xz.length(); i < c; ++i) {
+		const float fx = xz[i].x * inv_scale;
+		const float fz = xz[i].y * inv_scale;
+		const int int_x = (int)fx;
+		const int int_z = (int)fz;
+		const float dec_x = fx - int_x;
+		const float dec_z = fz - int_z;
+		const float h0 = sample(int_x, int_z);
+		float h;
+		if (dec_x > dec_z) {
+			const float h1 = sample(int_x + 1, int_z);
+			const float h2 = sample(int_x + 1, int_z + 1);
+			h = h0 + (h1 - h0) * dec_x + (h2 - h1) * dec_z;
+		}
+		else {
+			const float h1 = sample(int_x + 1, int_z + 1);
+			const float h2 = sample(int_x, int_z + 1);
+			h = h0 + (h2 - h0) * dec_z + (h1 - h2) * dec_x;
+		}
+		heights[i] = h * y_scale;
+	}
+}
+
+
+void Terrain::buildHeightTree()
+{
+	PROFILE_FUNCTION();
+	m_height_tree.clear();
+	m_height_tree_levels_count = 0;
+	if (!m_heightmap || !m_heightmap->getData() || m_width < 2 || m_height < 2) return;
+
+	i32 w = (m_width - 1 + HEIGHT_TREE_LEAF_SIZE - 1) / HEIGHT_TREE_LEAF_SIZE;
+	i32 h = (m_height - 1 + HEIGHT_TREE_LEAF_SIZE - 1) / HEIGHT_TREE_LEAF_SIZE;
+	u32 size = 0;
+	for (;;) {
+		ASSERT(m_height_tree_levels_count < lengthOf(m_height_tree_levels));
+		HeightTreeLevel& level = m_height_tree_levels[m_height_tree_levels_count];
+		++m_height_tree_levels_count;
+		level.offset = size;
+		level.width = w;
+		level.height = h;
+		size += w * h;
+		if (w == 1 && h == 1) break;
+		w = (w + 1) / 2;
+		h = (h + 1) / 2;
+	}
+	m_height_tree.resize(size);
+	updateHeightTree(0, 0, m_width, m_height);
+}
+
+
+void Terrain::updateHeightTreeLeaf(i32 x, i32 z)
+{
+	const Texture& t = *m_heightmap;
+	const i32 from_x = x * HEIGHT_TREE_LEAF_SIZE;
+	const i32 from_z = z * HEIGHT_TREE_LEAF_SIZE;
+	const i32 to_x = minimum(from_x + HEIGHT_TREE_LEAF_SIZE, m_width - 1);
+	const i32 to_z = minimum(from_z + HEIGHT_TREE_LEAF_SIZE, m_height - 1);
+	HeightRange range = {FLT_MAX, -FLT_MAX};
+	for (i32 j = from_z; j <= to_z; ++j) {
+		for (i32 i = from_x; i <= to_x; ++i) {
+			const float h = getNormalizedHeight(t, i + j * m_width);
+			range.min = minimum(range.min, h);
+			range.max = maximum(range.max, h);
+		}
+	}
+	m_height_tree[x + z * m_height_tree_levels[0].width] = range;
+}
+
+
+void Terrain::updateHeightTree(int x, int z, int w, int h)
+{
+	if (m_height_tree_levels_count == 0) return;
+
+	// cell (i, j) uses texels (i, j) to (i + 1, j + 1)
+	const HeightTreeLevel& leaves = m_height_tree_levels[0];
+	i32 from_x = clamp((x - 1) / HEIGHT_TREE_LEAF_SIZE, 0, leaves.width - 1);
+	i32 from_z = clamp((z - 1) / HEIGHT_TREE_LEAF_SIZE, 0, leaves.height - 1);
+	i32 to_x = clamp((x + w - 1) / HEIGHT_TREE_LEAF_SIZE, 0, leaves.width - 1);
+	i32 to_z = clamp((z + h - 1) / HEIGHT_TREE_LEAF_SIZE, 0, leaves.height - 1);
+	for (i32 j = from_z; j <= to_z; ++j) {
+		for (i32 i = from_x; i <= to_x; ++i) {
+			updateHeightTreeLeaf(i, j);
+		}
+	}
+
+	for (u32 l = 1; l < m_height_tree_levels_count; ++l) {
+		const HeightTreeLevel& children = m_height_tree_levels[l - 1];
+		const HeightTreeLevel& level = m_height_tree_levels[l];
+		from_x >>= 1;
+		from_z >>= 1;
+		to_x >>= 1;
+		to_z >>= 1;
+		for (i32 j = from_z; j <= to_z; ++j) {
+			for (i32 i = from_x; i <= to_x; ++i) {
+				HeightRange range = {FLT_MAX, -FLT_MAX};
+				for (i32 cj = j * 2; cj < minimum(j * 2 + 2, children.height); ++cj) {
+					for (i32 ci = i * 2; ci < minimum(i * 2 + 2, children.width); ++ci) {
+						const HeightRange& child = m_height_tree[children.offset + ci + cj * children.width];
+						range.min = minimum(range.min, child.min);
+						range.max = maximum(range.max, child.max);
+					}
+				}
+				m_height_tree[level.offset + i + j * level.width] = range;
+			}
+		}
+	}
+}
+
+
 void Terrain::setXZScale(float scale) 
 {
 	m_scale.x = scale;
@@ -348,11 +485,75 @@ void Terrain::setHeight(int x, int z, float h)
 	ASSERT(t->format == gpu::TextureFormat::R16);
 	int idx = clamp(x, 0, m_width) + clamp(z, 0, m_height) * m_width;
 	((u16*)t->getData())[idx] = (u16)(h * (65535.0f / m_scale.y));
+	updateHeightTree(x, z, 1, 1);
+}
+
+
+static bool getRayBoxInterval(const Vec3& origin, const Vec3& inv_dir, const Vec3& min, const Vec3& max, float& tmin)
+{
+	const Vec3 t0 = (min - origin) * inv_dir;
+	const Vec3 t1 = (max - origin) * inv_dir;
+	const float t_near = maximum(maximum(minimum(t0.x, t1.x), minimum(t0.y, t1.y)), minimum(t0.z, t1.z));
+	const float t_far = minimum(minimum(maximum(t0.x, t1.x), maximum(t0.y, t1.y)), maximum(t0.z, t1.z));
+	if (t_far < maximum(t_near, 0.f)) return false;
+	tmin = maximum(t_near, 0.f);
+	return true;
+}
+
+
+void Terrain::castRayNode(u32 level, i32 x, i32 z, const Vec3& origin, const Vec3& dir, const Vec3& inv_dir, float& best_t) const
+{
+	const HeightTreeLevel& l = m_height_tree_levels[level];
+	const HeightRange& range = m_height_tree[l.offset + x + z * l.width];
+	const i32 cells = HEIGHT_TREE_LEAF_SIZE << level;
+	const i32 from_x = x * cells;
+	const i32 from_z = z * cells;
+	const i32 to_x = minimum(from_x + cells, m_width - 1);
+	const i32 to_z = minimum(from_z + cells, m_height - 1);
+	const float s = m_scale.x;
+
+	const Vec3 min(from_x * s, range.min * m_scale.y, from_z * s);
+	const Vec3 max(to_x * s, range.max * m_scale.y, to_z * s);
+	float tmin;
+	if (!getRayBoxInterval(origin, inv_dir, min, max, tmin)) return;
+	if (tmin >= best_t) return;
+
+	if (level == 0) {
+		for (i32 j = from_z; j < to_z; ++j) {
+			for (i32 i = from_x; i < to_x; ++i) {
+				const float x0 = i * s;
+				const float z0 = j * s;
+				const Vec3 p0(x0, getHeight(i, j), z0);
+				const Vec3 p1(x0 + s, getHeight(i + 1, j), z0);
+				const Vec3 p2(x0 + s, getHeight(i + 1, j + 1), z0 + s);
+				const Vec3 p3(x0, getHeight(i, j + 1), z0 + s);
+				float t;
+				if (getRayTriangleIntersection(origin, dir, p0, p1, p2, &t) && t < best_t) best_t = t;
+				if (getRayTriangleIntersection(origin, dir, p0, p2, p3, &t) && t < best_t) best_t = t;
+			}
+		}
+		return;
+	}
+
+	// visit children roughly front to back, so far children are rejected by best_t
+	const HeightTreeLevel& children = m_height_tree_levels[level - 1];
+	const i32 first_x = dir.x < 0 ? 1 : 0;
+	const i32 first_z = dir.z < 0 ? 1 : 0;
+	for (i32 j = 0; j < 2; ++j) {
+		const i32 cz = z * 2 + (j ^ first_z);
+		if (cz >= children.height) continue;
+		for (i32 i = 0; i < 2; ++i) {
+			const i32 cx = x * 2 + (i ^ first_x);
+			if (cx >= children.width) continue;
+			castRayNode(level - 1, cx, cz, origin, dir, inv_dir, best_t);
+		}
+	}
 }
 
 
 RayCastModelHit Terrain::castRay(const DVec3& origin, const Vec3& dir)
 {
+	PROFILE_FUNCTION();
 	RayCastModelHit hit;
 	hit.is_hit = false;
 	if (!m_heightmap || !m_heightmap->isReady()) return hit;
@@ -364,55 +565,20 @@ RayCastModelHit Terrain::castRay(const DVec3& origin, const Vec3& dir)
 	const Vec3 terrain_to_ray = Vec3(origin - pos);
 	const Vec3 rel_origin = rot.conjugated().rotate(terrain_to_ray);
 
-	Vec3 start;
-	const Vec3 size(m_width * m_scale.x, m_scale.y * 65535.0f, m_height * m_scale.x);
-	if (!getRayAABBIntersection(rel_origin, rel_dir, Vec3::ZERO, size, start)) return hit;
-
-	int hx = (int)(start.x / m_scale.x);
-	int hz = (int)(start.z / m_scale.x);
-
-	float next_x = fabs(rel_dir.x) < 0.01f ? hx : ((hx + (rel_dir.x < 0 ? 0 : 1)) * m_scale.x - rel_origin.x) / rel_dir.x;
-	float next_z = fabs(rel_dir.z) < 0.01f ? hz : ((hz + (rel_dir.z < 0 ? 0 : 1)) * m_scale.x - rel_origin.z) / rel_dir.z;
-
-	float delta_x = fabsf(rel_dir.x) < 0.01f ? 0 : m_scale.x / fabsf(rel_dir.x);
-	float delta_z = fabsf(rel_dir.z) < 0.01f ? 0 : m_scale.z / fabsf(rel_dir.z);
-	int step_x = (int)signum(rel_dir.x);
-	int step_z = (int)signum(rel_dir.z);
-
-	while (hx >= 0 && hz >= 0 && hx + step_x < m_width && hz + step_z < m_height) {
-		float t;
-		float x = hx * m_scale.x;
-		float z = hz * m_scale.x;
-		Vec3 p0(x, getHeight(x, z), z);
-		Vec3 p1(x + m_scale.x, getHeight(x + m_scale.x, z), z);
-		Vec3 p2(x + m_scale.x, getHeight(x + m_scale.x, z + m_scale.x), z + m_scale.x);
-		Vec3 p3(x, getHeight(x, z + m_scale.x), z + m_scale.x);
-		if (getRayTriangleIntersection(rel_origin, rel_dir, p0, p1, p2, &t)) {
-			hit.is_hit = true;
-			hit.origin = origin;
-			hit.dir = dir;
-			hit.t = t;
-			return hit;
-		}
-		if (getRayTriangleIntersection(rel_origin, rel_dir, p0, p2, p3, &t)) {
-			hit.is_hit = true;
-			hit.origin = origin;
-			hit.dir = dir;
-			hit.t = t;
-			return hit;
-		}
-		if (next_x < next_z && step_x != 0) {
-			next_x += delta_x;
-			hx += step_x;
-		}
-		else {
-			next_z += delta_z;
-			hz += step_z;
-		}
-		if (delta_x == 0 && delta_z == 0) {
-			return hit;
-		}
-	}
+	if (m_height_tree_levels_count == 0) buildHeightTree();
+	if (m_height_tree_levels_count == 0) return hit;
+
+	// hierarchical traversal, subtrees with height range the ray does not hit are skipped
+	const Vec3 inv_dir(1 / rel_dir.x, 1 / rel_dir.y, 1 / rel_dir.z);
+	const u32 root = m_height_tree_levels_count - 1;
+	float t = FLT_MAX;
+	castRayNode(root, 0, 0, rel_origin, rel_dir, inv_dir, t);
+	if (t == FLT_MAX) return hit;
+
+	hit.is_hit = true;
+	hit.origin = origin;
+	hit.dir = dir;
+	hit.t = t;
 	return hit;
 }
 
@@ -434,6 +600,8 @@ void Terrain::onMaterialLoaded(Resource::State, Resource::State new_state, Resou
 			m_width = m_heightmap->width;
 			m_height = m_heightmap->height;
 		}
+		// if data is not ready yet, tree is built on first use
+		buildHeightTree();
 
 		m_albedomap = m_material->getTextureByName("Detail albedo");
 		m_splatmap = m_material->getTextureByName("Splatmap");
@@ -463,6 +631,8 @@ void Terrain::onMaterialLoaded(Resource::State, Resource::State new_state, Resou
 	}
 	else
 	{
+		m_height_tree.clear();
+		m_height_tree_levels_count = 0;
 		//LUMIX_DELETE(m_allocator, m_root);
 		//m_root = nullptr;
 	}
@@ -32,6 +32,8 @@ struct Terrain
 {
 	public:
 		enum { TEXTURES_COUNT = 6 };
+		// cells per side of height tree leaf
+		enum { HEIGHT_TREE_LEAF_SIZE = 8 };
 
 		struct GrassType
 		{
@@ -79,7 +81,10 @@ struct Terrain
 		int getGrassTypeCount() const { return m_grass_types.size(); }
 
 		float getHeight(int x, int z) const;
+		void getHeights(Span<const Vec2> xz, Span<float> heights) const;
 		void setHeight(int x, int z, float height);
+		// call when heightmap data in rectangle [x, x + w) x [z, z + h) changed
+		void updateHeightTree(int x, int z, int w, int h);
 		void setXZScale(float scale);
 		void setYScale(float scale);
 		void setGrassTypePath(int index, const Path& path);
@@ -98,7 +103,21 @@ struct Terrain
 		void removeGrassType(int index);
 
 	private: 
+		struct HeightRange {
+			float min;
+			float max;
+		};
+
+		struct HeightTreeLevel {
+			u32 offset;
+			i32 width;
+			i32 height;
+		};
+
 		void onMaterialLoaded(Resource::State, Resource::State new_state, Resource&);
+		void buildHeightTree();
+		void updateHeightTreeLeaf(i32 x, i32 z);
+		void castRayNode(u32 level, i32 x, i32 z, const Vec3& origin, const Vec3& dir, const Vec3& inv_dir, float& best_t) const;
 
 	public:
 		IAllocator& m_allocator;
@@ -114,6 +133,10 @@ struct Terrain
 		RenderScene& m_scene;
 		Array<GrassType> m_grass_types;
 		Renderer& m_renderer;
+		// min/max heights (normalized) of heightmap blocks, level 0 are leaves, last level is root
+		Array<HeightRange> m_height_tree;
+		HeightTreeLevel m_height_tree_levels[16];
+		u32 m_height_tree_levels_count = 0;
 };
 
 